@@ -86,20 +86,21 @@ function set_compiler( settings, config )
     elseif compiler == "gcc" then
         SetDriversGCC( settings )
 	settings.cc.flags:Add( "-Wconversion", "-Wextra", "-Wall", "-Werror", "-Wstrict-aliasing=2" )
-	settings.link.flags:Add( '-rdynamic' )
+	settings.link.flags:Add( "-pthread" ) -- callstack uses pthreads, libpthread is separate before glibc 2.34
         if config == "release" then
 	    settings.cc.flags:Add( "-O2" )
         end
     elseif compiler == "clang" then
         SetDriversClang( settings )
 	settings.cc.flags:Add( "-Wconversion", "-Wextra", "-Wall", "-Werror", "-Wstrict-aliasing=2" )
-	settings.link.flags:Add( '-rdynamic' )
+	settings.link.flags:Add( "-pthread" )
         if config == "release" then
 	    settings.cc.flags:Add( "-O2" )
         end
     end
 end
 
+host_platform = platform -- set by bam to the os building, i.e. "linux" or "macosx", before it is replaced by the target.
 config   = get_config()
 platform = get_platform()
 settings = get_base_settings()
@@ -117,16 +118,106 @@ settings.cc.includes:Add( 'include' )
 
 local debugger_obj  = Compile( settings, 'src/debugger.cpp' )
 local callstack_obj = Compile( settings, 'src/callstack.cpp' )
+local cs_intern_obj = Compile( settings, 'src/callstack_intern.cpp' )
+local cs_prof_obj   = Compile( settings, 'src/callstack_profiler.cpp' )
+local cs_export_obj = Compile( settings, 'src/callstack_export.cpp' )
 local assert_obj    = Compile( settings, 'src/assert.cpp' )
 local fpe_ctrl_obj  = Compile( settings, 'src/fpe_ctrl.cpp' )
 local hw_breok_obj  = Compile( settings, 'src/hw_breakpoint.cpp' )
 
+-- tests unwinding their own functions by frame-pointers keep them when optimized, see README.
+local fp_settings = TableDeepCopy( settings )
+if family ~= "windows" then
+    fp_settings.cc.flags:Add( "-fno-omit-frame-pointer" )
+end
+
+-- the profiler uses posix timers, in librt before glibc 2.17, and pthreads.
+local prof_settings = TableDeepCopy( settings )
+if host_platform == "linux" then
+    prof_settings.link.libs:Add( "rt" )
+end
+if family ~= "windows" then
+    prof_settings.link.flags:Add( "-pthread" )
+end
+
+-- tests checking files, lines or inlined functions need debug-info, also in release.
+local debug_settings = TableDeepCopy( settings )
+debug_settings.debug = 1
+
 Compile( settings, 'test/test_static_assert.c' )
 Compile( settings, 'test/test_static_assert_cpp.cpp' )
 
 Link( settings, 'test_debugger',      debugger_obj,  Compile( settings, 'test/test_debugger_present.c' ) )
-Link( settings, 'test_callstack',     callstack_obj, Compile( settings, 'test/test_callstack.c' ) )
-Link( settings, 'test_callstack_cpp', callstack_obj, Compile( settings, 'test/test_callstack_cpp.cpp' ) )
+local test_callstack     = Link( settings, 'test_callstack',     callstack_obj, Compile( settings, 'test/test_callstack.c' ) )
+local test_callstack_cpp = Link( settings, 'test_callstack_cpp', callstack_obj, Compile( settings, 'test/test_callstack_cpp.cpp' ) )
+Link( settings, 'test_callstack_signal', callstack_obj, Compile( fp_settings, 'test/test_callstack_signal.c' ) )
+local test_callstack_inline = Link( debug_settings, 'test_callstack_inline', callstack_obj, Compile( debug_settings, 'test/test_callstack_inline.c' ) )
+if host_platform == "linux" then
+    -- the inline-test again with debug-info as the compiler can lay it out, objects suffixed to not collide with test_callstack_inline.
+    local function DebugInfoTest( name, flag )
+        local dbg_settings = TableDeepCopy( debug_settings )
+        dbg_settings.cc.flags:Add( flag )
+        dbg_settings.link.flags:Add( flag )
+        dbg_settings.cc.Output = function(settings, path) return PathJoin(output_path, PathFilename(PathBase(path)) .. "_" .. name .. settings.config_ext) end
+        return Link( dbg_settings, 'test_callstack_inline_' .. name, callstack_obj, Compile( dbg_settings, 'test/test_callstack_inline.c' ) )
+    end
+
+    -- compressed .debug_* sections (SHF_COMPRESSED).
+    DebugInfoTest( "gz", "-gz" )
+    -- split dwarf, the inlined functions only exist in the .dwo written next to the object.
+    DebugInfoTest( "split", "-gsplit-dwarf" )
+
+    -- debug-info stripped out to test_callstack_inline_debuglink.debug next to the executable, found via .gnu_debuglink.
+    local stripped   = PathJoin( output_path, "test_callstack_inline_debuglink" )
+    local debug_file = stripped .. ".debug"
+    AddJob( stripped, "debuglink " .. PathFilename( stripped ),
+            "objcopy --only-keep-debug " .. test_callstack_inline .. " " .. debug_file .. " && " ..
+            "objcopy --strip-debug --add-gnu-debuglink=" .. debug_file .. " " .. test_callstack_inline .. " " .. stripped )
+    AddDependency( stripped, test_callstack_inline )
+end
+if family ~= "windows" then
+    -- shared library loaded by test_callstack_shlib, expected to be next to the executable.
+    local shlib_settings = TableDeepCopy( debug_settings )
+    shlib_settings.cc.flags:Add( "-fPIC" )
+    shlib_settings.dll.Output = function(settings, path) return PathJoin(output_path, "lib" .. PathFilename(PathBase(path)) .. settings.config_ext) end
+    SharedLibrary( shlib_settings, 'callstack_shlib', Compile( shlib_settings, 'test/callstack_shlib.c' ) )
+
+    local dl_settings = TableDeepCopy( debug_settings )
+    dl_settings.link.libs:Add( "dl" )
+    Link( dl_settings, 'test_callstack_shlib', callstack_obj, Compile( debug_settings, 'test/test_callstack_shlib.c' ) )
+    Link( debug_settings, 'test_callstack_batch', callstack_obj, Compile( debug_settings, 'test/test_callstack_batch.c' ) )
+    Link( settings, 'test_callstack_server', callstack_obj, Compile( settings, 'test/test_callstack_server.c' ) )
+    Link( settings, 'test_callstack_index',  callstack_obj, Compile( settings, 'test/test_callstack_index.c' ) )
+    Link( prof_settings, 'test_callstack_profiler', callstack_obj, cs_intern_obj, cs_prof_obj, Compile( fp_settings, 'test/test_callstack_profiler.c' ) )
+end
+Link( settings, 'test_callstack_intern', callstack_obj, cs_intern_obj, Compile( settings, 'test/test_callstack_intern.cpp' ) )
+Link( settings, 'test_callstack_dump',   callstack_obj, Compile( settings, 'test/test_callstack_dump.c' ) )
+Link( settings, 'test_callstack_export', callstack_obj, cs_intern_obj, cs_export_obj, Compile( settings, 'test/test_callstack_export.c' ) )
 Link( settings, 'test_assert',        assert_obj,    Compile( settings, 'test/test_assert.cpp' ) )
 Link( settings, 'test_fpe_ctrl',      fpe_ctrl_obj,  Compile( settings, 'test/test_fpe_ctrl.cpp' ) )
 Link( settings, 'test_hw_breakpoint', hw_breok_obj,  Compile( settings, 'test/test_hw_breakpoint.c' ) )
+
+Link( settings, 'bench_callstack',    callstack_obj, Compile( settings, 'test/bench_callstack.cpp' ) )
+-- includes callstack.cpp to reach the internal address search-tree, so linked without callstack_obj.
+Link( settings, 'bench_addr_tree',    Compile( settings, 'test/bench_addr_tree.cpp' ) )
+
+-- offline symbolizer for dumps written with callstack_dump_write().
+Link( settings, 'callstack_symbolize', callstack_obj, Compile( settings, 'tools/callstack_symbolize.cpp' ) )
+if family ~= "windows" then
+    -- symbol-server daemon used by callstack_symbols_set_server().
+    Link( settings, 'callstack_symbold', callstack_obj, Compile( settings, 'tools/callstack_symbold.cpp' ) )
+
+    -- precomputed symbol-index written next to a binary as <binary>.csidx, mapped by the symbolizer instead of parsing debug-info.
+    local callstack_index = Link( settings, 'callstack_index', callstack_obj, Compile( settings, 'tools/callstack_index.cpp' ) )
+    function SymbolIndex( binary )
+        local index = binary .. ".csidx"
+        AddJob( index, "symbol-index " .. PathFilename( binary ), callstack_index .. " " .. binary .. " " .. index )
+        AddDependency( index, binary, callstack_index )
+        return index
+    end
+
+    -- converts profiles written by the profiler to folded stacks or pprof and diffs two profiles.
+    Link( prof_settings, 'callstack_profile', callstack_obj, cs_intern_obj, cs_prof_obj, cs_export_obj, Compile( settings, 'tools/callstack_profile.cpp' ) )
+
+    PseudoTarget( "symbol_index", SymbolIndex( test_callstack ), SymbolIndex( test_callstack_cpp ) )
+end
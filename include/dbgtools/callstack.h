@@ -39,8 +39,33 @@ typedef struct
 	const char*  file;     ///< file where symbol is defined, might not work on all platforms.
 	unsigned int line;     ///< line in file where symbol is defined, might not work on all platforms.
 	unsigned int offset;   ///< offset from start of function where call was made.
+	unsigned int inlined;  ///< 1 if this is a frame synthesized for a function inlined into the function of the next symbol, see callstack_symbols_inlined().
 } callstack_symbol_t;
 
+/**
+ * Backends used by callstack() to unwind the stack.
+ */
+enum callstack_unwinder
+{
+	CALLSTACK_UNWINDER_DEFAULT,       ///< platform default, backtrace() on unix and RtlCaptureStackBackTrace() on windows.
+	CALLSTACK_UNWINDER_FRAME_POINTER, ///< walk frame-pointers, only valid if all code on the stack is compiled with -fno-omit-frame-pointer.
+};
+
+/**
+ * Select the backend used by callstack() for all threads.
+ *
+ * The frame-pointer unwinder do not take any locks or allocate memory and is magnitudes faster
+ * than backtrace() but will stop at the first frame not having a frame-pointer. Frames are
+ * validated against the bounds of the current threads stack.
+ *
+ * Defining DBG_TOOLS_CALLSTACK_DEFAULT_FRAME_POINTER when compiling callstack.cpp will make
+ * CALLSTACK_UNWINDER_FRAME_POINTER the initial unwinder.
+ *
+ * @param unwinder backend to use.
+ * @return 0 on success, -1 if unwinder is not supported on the current platform.
+ */
+int callstack_set_unwinder( enum callstack_unwinder unwinder );
+
 /**
  * Generate a callstack from the current location in the code.
  * @param skip_frames number of frames to skip in output to addresses.
@@ -50,6 +75,23 @@ typedef struct
  */
 int callstack( int skip_frames, void** addresses, int num_addresses );
 
+/**
+ * Generate a callstack starting at the frame interrupted by a signal.
+ *
+ * This function is async-signal-safe and can be used from signal-handlers such as SIGSEGV or SIGPROF,
+ * it always walk frame-pointers and verifies that each stack-page is mapped before reading from it.
+ * The first address returned is the interrupted instruction itself, not a return-address.
+ *
+ * @note if the signal interrupted a function before it has set up its frame-pointer, i.e. in its prologue,
+ *       the caller of that function will be missing from the callstack.
+ *
+ * @param context pointer to the ucontext_t passed as the third argument to a SA_SIGINFO signal-handler.
+ * @param addresses is a pointer to a buffer where to store addresses in callstack.
+ * @param num_addresses size of addresses.
+ * @return number of addresses in callstack, 0 if not supported on the current platform.
+ */
+int callstack_from_context( void* context, void** addresses, int num_addresses );
+
 /**
  * Translate addresses from, for example, callstack to symbol-names.
  * @param addresses list of pointers to translate.
@@ -74,9 +116,390 @@ int callstack( int skip_frames, void** addresses, int num_addresses );
  *       4) The _NT_ALTERNATE_SYMBOL_PATH environment variable.
  *
  * @note On platforms that support it debug-output can be enabled by defining the environment variable DBGTOOLS_SYMBOL_DEBUG_OUTPUT.
+ *
+ * @note On linux resolved symbols are kept in a process-wide cache shared by all threads, see callstack_symbols_set_cache_size().
+ *       Strings in out_syms then point to memory owned by dbgtools that is valid for the lifetime of the process, or until
+ *       the shared library the address belongs to is unloaded, and memory is not used.
  */
 int callstack_symbols( void** addresses, callstack_symbol_t* out_syms, int num_addresses, char* memory, int mem_size );
 
+/**
+ * Translate addresses in the same way as callstack_symbols() but expand each address into the functions
+ * inlined at that address followed by the real function, i.e. one address might produce many symbols.
+ *
+ * Symbols for an address are ordered from the innermost inlined function to the real function, the same
+ * order as the frames of a callstack. Inlined functions have callstack_symbol_t::inlined set and an offset
+ * of 0, the file/line of each symbol after the first is the call-site in that function.
+ *
+ * @param addresses list of pointers to translate.
+ * @param out_syms list of callstack_symbol_t to fill with translated data.
+ * @param num_addresses number of addresses in addresses.
+ * @param max_syms number of symbols that fit in out_syms, symbols that do not fit are dropped.
+ * @param memory memory used to allocate strings stored in out_syms.
+ * @param mem_size size of memory.
+ * @return number of symbols written to out_syms.
+ *
+ * @note inlined functions are only expanded on linux, on other platforms there is one symbol per address.
+ * @note results are not stored in the cache used by callstack_symbols() and strings are always stored in memory.
+ */
+int callstack_symbols_inlined( void** addresses, callstack_symbol_t* out_syms, int num_addresses, int max_syms, char* memory, int mem_size );
+
+/**
+ * Flags controlling callstack_symbols_foreach() and friends.
+ */
+enum callstack_symbols_flags
+{
+	CALLSTACK_SYMBOLS_INLINED = 1 << 0, ///< expand inlined functions in the same way as callstack_symbols_inlined().
+};
+
+/**
+ * Callback receiving one resolved symbol at a time from callstack_symbols_foreach().
+ *
+ * @param sym resolved symbol, strings point to storage owned by dbgtools and are only guaranteed to be valid
+ *            during the call. On linux they stay valid in the same way as strings from callstack_symbols().
+ * @param index index in addresses of the address sym was resolved from, many symbols might share index if
+ *              inlined functions are expanded.
+ * @param userdata pointer passed to callstack_symbols_foreach().
+ * @return 0 to continue with the next symbol, anything else to stop.
+ */
+typedef int (*callstack_symbol_callback)( const callstack_symbol_t* sym, int index, void* userdata );
+
+/**
+ * Translate addresses in the same way as callstack_symbols() but pass each symbol to callback instead of
+ * copying strings to caller-provided memory, i.e. there is no buffer that can run out of space.
+ *
+ * @note callback is not allowed to call any of the callstack_symbols-functions.
+ *
+ * @param addresses list of pointers to translate.
+ * @param num_addresses number of addresses in addresses.
+ * @param flags bitwise or of callstack_symbols_flags.
+ * @param callback called once per symbol, in the same order as symbols are returned by callstack_symbols() and callstack_symbols_inlined().
+ * @param userdata passed to callback.
+ * @return number of symbols passed to callback.
+ */
+int callstack_symbols_foreach( void** addresses, int num_addresses, unsigned int flags, callstack_symbol_callback callback, void* userdata );
+
+/**
+ * Calculate the exact amount of memory callstack_symbols(), or callstack_symbols_inlined() if flags has
+ * CALLSTACK_SYMBOLS_INLINED set, needs to store all strings when translating addresses.
+ *
+ * @note on linux callstack_symbols() do not need any memory and 0 is returned when flags is 0.
+ *
+ * @param addresses list of pointers to translate.
+ * @param num_addresses number of addresses in addresses.
+ * @param flags bitwise or of callstack_symbols_flags.
+ * @param num_syms if not 0x0, set to the number of symbols the addresses translate to, i.e. the size needed for out_syms.
+ * @return size of memory needed in bytes.
+ */
+int callstack_symbols_mem_size( void** addresses, int num_addresses, unsigned int flags, int* num_syms );
+
+/**
+ * Set the memory budget of the process-wide cache of resolved addresses used by callstack_symbols(), when the
+ * cache is full the least recently used entries are evicted. 0 disables the cache. Defaults to 1MB.
+ *
+ * @note needs to be called before the first call to callstack_symbols().
+ *
+ * @param max_bytes memory budget in bytes.
+ * @return 0 on success, -1 if callstack_symbols() has already been called or the cache is not supported on the current platform.
+ */
+int callstack_symbols_set_cache_size( unsigned int max_bytes );
+
+/**
+ * How C++ names are demangled by the symbolize-functions.
+ */
+enum callstack_demangle
+{
+	CALLSTACK_DEMANGLE_FULL,  ///< complete names, "std::vector<int, std::allocator<int> >::push_back(int const&)".
+	CALLSTACK_DEMANGLE_SHORT, ///< template-arguments, and return-types of function-templates, dropped, "std::vector::push_back(int const&)".
+};
+
+/**
+ * Select how C++ names are demangled by callstack_symbols() and callstack_symbols_inlined(). Short names are
+ * cheaper to produce and keep output such as profiles small. Defaults to CALLSTACK_DEMANGLE_FULL.
+ *
+ * @note needs to be called before the first call to callstack_symbols() or callstack_symbols_inlined().
+ *
+ * @param mode to use.
+ * @return 0 on success, -1 if callstack_symbols() has already been called or mode is not supported on the current platform.
+ */
+int callstack_symbols_set_demangle( enum callstack_demangle mode );
+
+/**
+ * Opaque handle to a symbolizer, keeps loaded symbol-data, file-mappings and scratch-buffers
+ * alive between calls to callstack_symbolizer_symbolize().
+ *
+ * callstack_symbols() is implemented on top of a default symbolizer that is created on first
+ * use and lives for the duration of the process, use an explicit symbolizer if you need
+ * control over when symbol-data is loaded and released.
+ */
+typedef struct callstack_symbolizer callstack_symbolizer_t;
+
+/**
+ * Create a symbolizer for the current process.
+ * @return created symbolizer, or 0x0 on failure.
+ */
+callstack_symbolizer_t* callstack_symbolizer_create();
+
+/**
+ * Destroy a symbolizer created with callstack_symbolizer_create() and release all memory held by it.
+ * @param symbolizer to destroy.
+ */
+void callstack_symbolizer_destroy( callstack_symbolizer_t* symbolizer );
+
+/**
+ * Select how C++ names are demangled by symbolizer, see callstack_symbols_set_demangle().
+ *
+ * @note names are demangled once and kept with the symbolizer, names already demangled by an earlier call
+ *       are not changed so call this before symbolizing anything.
+ * @note CALLSTACK_DEMANGLE_SHORT is only supported on linux.
+ *
+ * @param symbolizer to change.
+ * @param mode to use.
+ * @return 0 on success, -1 if mode is not supported on the current platform.
+ */
+int callstack_symbolizer_set_demangle( callstack_symbolizer_t* symbolizer, enum callstack_demangle mode );
+
+/**
+ * Translate addresses to symbols in the same way as callstack_symbols() but reusing state
+ * held by symbolizer.
+ *
+ * @note a symbolizer may only be used from one thread at a time.
+ *
+ * @param symbolizer to use for the lookup.
+ * @see callstack_symbols() for the rest of the arguments.
+ * @return number of addresses translated.
+ */
+int callstack_symbolizer_symbolize( callstack_symbolizer_t* symbolizer, void** addresses, callstack_symbol_t* out_syms, int num_addresses, char* memory, int mem_size );
+
+/**
+ * Translate addresses to symbols in the same way as callstack_symbols_inlined() but reusing state
+ * held by symbolizer.
+ *
+ * @note a symbolizer may only be used from one thread at a time.
+ *
+ * @param symbolizer to use for the lookup.
+ * @see callstack_symbols_inlined() for the rest of the arguments.
+ * @return number of symbols written to out_syms.
+ */
+int callstack_symbolizer_symbolize_inlined( callstack_symbolizer_t* symbolizer, void** addresses, callstack_symbol_t* out_syms, int num_addresses, int max_syms, char* memory, int mem_size );
+
+/**
+ * Translate addresses in the same way as callstack_symbols_foreach() but reusing state held by symbolizer.
+ *
+ * @note a symbolizer may only be used from one thread at a time.
+ * @note on linux strings passed to callback stay valid until symbolizer is destroyed, or until the shared
+ *       library the address belongs to is unloaded.
+ *
+ * @param symbolizer to use for the lookup.
+ * @see callstack_symbols_foreach() for the rest of the arguments.
+ * @return number of symbols passed to callback.
+ */
+int callstack_symbolizer_symbolize_foreach( callstack_symbolizer_t* symbolizer, void** addresses, int num_addresses, unsigned int flags, callstack_symbol_callback callback, void* userdata );
+
+/**
+ * Calculate the exact amount of memory callstack_symbolizer_symbolize(), or callstack_symbolizer_symbolize_inlined()
+ * if flags has CALLSTACK_SYMBOLS_INLINED set, needs to store all strings when translating addresses.
+ *
+ * @param symbolizer to use for the lookup.
+ * @see callstack_symbols_mem_size() for the rest of the arguments.
+ * @return size of memory needed in bytes.
+ */
+int callstack_symbolizer_mem_size( callstack_symbolizer_t* symbolizer, void** addresses, int num_addresses, unsigned int flags, int* num_syms );
+
+/**
+ * Async-signal-safe version of callstack_symbolizer_symbolize().
+ *
+ * Only symbol-data already loaded by symbolizer is used, no memory is allocated, no locks are taken and
+ * strings are only written to memory. The symbolizer should be created before the signal-handler is
+ * installed and may not be used by any other thread while the handler is running.
+ *
+ * @note C++ names are demangled straight into memory, names using constructs the built-in demangler do not
+ *       handle, such as expressions in template-arguments, are returned mangled.
+ * @note debug-info is loaded per compilation unit, file and line is only found for addresses in units that
+ *       an earlier call to any of the other symbolize-functions has loaded.
+ * @note for modules without .symtab, function-names of non-exported functions are also taken from debug-info
+ *       and only found in units loaded by an earlier call.
+ * @note only supported on linux, returns 0 on other platforms.
+ *
+ * @see callstack_symbolizer_symbolize() for arguments.
+ * @return number of addresses translated.
+ */
+int callstack_symbolizer_symbolize_signal_safe( callstack_symbolizer_t* symbolizer, void** addresses, callstack_symbol_t* out_syms, int num_addresses, char* memory, int mem_size );
+
+/**
+ * Translate a large number of addresses, i.e. many callstacks concatenated into one array, in one go.
+ *
+ * Each unique address is only resolved once and addresses are resolved in module- and address-order
+ * so that symbol-data is read sequentially, this is a lot faster than calling callstack_symbolizer_symbolize()
+ * per stack when symbolizing big sets of stacks where the same frames show up over and over.
+ *
+ * Strings in out_syms point to memory owned by symbolizer that is valid until it is destroyed, or until the
+ * shared library the address belongs to is unloaded, so no memory is needed for the result.
+ *
+ * @note a symbolizer may only be used from one thread at a time.
+ * @note only supported on linux, returns 0 on other platforms.
+ *
+ * @param symbolizer to use for the lookup.
+ * @param addresses to translate.
+ * @param out_syms array to fill with symbols, needs to fit num_addresses symbols.
+ * @param num_addresses number of addresses in addresses.
+ * @return number of addresses translated.
+ */
+int callstack_symbolizer_symbolize_batch( callstack_symbolizer_t* symbolizer, void* const* addresses, callstack_symbol_t* out_syms, int num_addresses );
+
+/**
+ * Same as callstack_symbolizer_symbolize_batch() but the work is split over a number of worker-threads.
+ *
+ * Shared libraries that are not loaded by symbolizer yet are loaded in parallel and unique addresses
+ * are split in chunks, ordered by address, that the workers pick from until all are resolved. The
+ * calling thread is one of the workers.
+ *
+ * @note a symbolizer may only be used from one thread at a time, the workers are only running during the call.
+ * @note only supported on linux, returns 0 on other platforms.
+ *
+ * @param num_threads number of threads to use including the calling one, <= 0 to use one per online cpu.
+ * @see callstack_symbolizer_symbolize_batch() for the rest of the arguments.
+ * @return number of addresses translated.
+ */
+int callstack_symbolizer_symbolize_parallel( callstack_symbolizer_t* symbolizer, void* const* addresses, callstack_symbol_t* out_syms, int num_addresses, int num_threads );
+
+/**
+ * Store callstacks, together with the modules they point into, in a compact binary dump that can be
+ * symbolized later, in another process or on another machine, see callstack_symbolizer_create_from_dump().
+ * Nothing is symbolized and no files are read so this is cheap enough to do in the process being profiled.
+ *
+ * All integers in the format are unsigned LEB128 if nothing else is said:
+ *
+ *   "CSD" followed by the version-byte 1.
+ *   number of modules, followed by per module:
+ *     length of path, path (not 0-terminated), length of build-id, build-id,
+ *     load-bias, first and one past last address covered by the module relative to load-bias.
+ *   number of stacks, followed by per stack:
+ *     number of frames, followed by per frame:
+ *       1 + index of module or 0 if the address is not in any module.
+ *       for 0 the address, otherwise the address relative to load-bias stored as a signed LEB128 delta
+ *       from the previous address in the same module in the dump, 0 for the first.
+ *
+ * Only modules referenced by any frame are stored.
+ *
+ * @param addresses all callstacks to store concatenated, as returned by callstack().
+ * @param num_frames number of addresses in each callstack.
+ * @param num_stacks number of callstacks.
+ * @param out buffer to write the dump to, can be 0x0 to only query the size.
+ * @param out_size size of out.
+ * @return size of the dump in bytes, if larger than out_size the dump was not written in full.
+ *         0 on failure or if not supported on the current platform.
+ *
+ * @note only supported on linux.
+ */
+int callstack_dump_write( void* const* addresses, const int* num_frames, int num_stacks, void* out, int out_size );
+
+/**
+ * Callback receiving one callstack at a time from callstack_dump_read().
+ * @param addresses of the callstack, the runtime-addresses in the process that wrote the dump.
+ * @param num_addresses number of addresses.
+ * @param userdata pointer passed to callstack_dump_read().
+ * @return 0 to continue with the next callstack, anything else to stop.
+ */
+typedef int (*callstack_dump_callback)( void** addresses, int num_addresses, void* userdata );
+
+/**
+ * Read the callstacks stored in a dump written by callstack_dump_write().
+ *
+ * @param dump data of the dump.
+ * @param dump_size size of dump.
+ * @param callback called once per callstack in the order they were written.
+ * @param userdata passed to callback.
+ * @return number of callstacks passed to callback, -1 if dump is malformed or not supported on the current platform.
+ */
+int callstack_dump_read( const void* dump, int dump_size, callstack_dump_callback callback, void* userdata );
+
+/**
+ * Create a symbolizer for the modules stored in a dump, the addresses from callstack_dump_read() can then
+ * be translated with any of the symbolize-functions.
+ *
+ * Modules are loaded from the path recorded in the dump, prefixed with sysroot, if that file has the
+ * build-id recorded in the dump. Otherwise <debug-dir>/.build-id/xx/yyyyyyyy.debug is used, see the
+ * notes on separate debug-files in README.md.
+ *
+ * @param dump data of the dump, only needed during the call.
+ * @param dump_size size of dump.
+ * @param sysroot directory to look for modules in, 0x0 to use the recorded paths as is.
+ * @return created symbolizer, or 0x0 if dump is malformed or not supported on the current platform.
+ *
+ * @note only supported on linux.
+ */
+callstack_symbolizer_t* callstack_symbolizer_create_from_dump( const void* dump, int dump_size, const char* sysroot );
+
+/**
+ * Write a precomputed symbol-index for a module, i.e. an executable or shared library, to be placed next to
+ * it as <module>.csidx. When a module with an index is loaded by a symbolizer the index is mapped and used
+ * as is, no symbols or debug-info are parsed, and processes running the same module share its pages. The
+ * index holds function-ranges, file/line and names demangled in both modes, debug-info is still loaded if
+ * inlined frames are requested. Meant to be run as a build-step, see the callstack_index tool.
+ *
+ * The index is only used with the build it was written for, matched by build-id.
+ *
+ * @param module_path module to write index for, needs to have a build-id.
+ * @param index_path path to write index to, 0x0 to write it to <module_path>.csidx.
+ * @return 0 on success, -1 on failure or if not supported on the current platform.
+ *
+ * @note only supported on linux.
+ */
+int callstack_index_write( const char* module_path, const char* index_path );
+
+/**
+ * Symbol-server, symbolizes callstacks for other processes that connect to it over a unix-socket, see
+ * callstack_symbols_set_server(). All clients share the parsed debug-info of the modules they have in
+ * common, so the cost of loading dwarf is only paid once per machine and not once per process.
+ *
+ * Requests carry the callstacks as a dump, see callstack_dump_write(), modules are loaded through
+ * /proc/<client-pid>/root so that clients in other mount-namespaces, i.e. containers, are supported.
+ */
+typedef struct callstack_symbol_server callstack_symbol_server_t;
+
+/**
+ * Create a symbol-server listening on a unix-socket.
+ *
+ * @param socket_path path of the socket to create, an existing socket at the path is replaced.
+ * @return created server, or 0x0 on failure or if not supported on the current platform.
+ *
+ * @note only supported on linux.
+ */
+callstack_symbol_server_t* callstack_symbol_server_create( const char* socket_path );
+
+/**
+ * Accept new clients and serve pending requests, the server does nothing outside of this function.
+ *
+ * Clients are read from and written to without blocking, a client that stalls in the middle of a request
+ * or does not read its response is disconnected after a second without holding up the others.
+ *
+ * @param server to update.
+ * @param timeout_ms max time to wait for a request, 0 to only serve requests already pending, -1 to wait forever.
+ * @return number of requests served, -1 on error.
+ */
+int callstack_symbol_server_update( callstack_symbol_server_t* server, int timeout_ms );
+
+/**
+ * Close all connections, remove the socket and free all memory of the server.
+ */
+void callstack_symbol_server_destroy( callstack_symbol_server_t* server );
+
+/**
+ * Let callstack_symbols(), callstack_symbols_inlined() and callstack_symbols_foreach() send their addresses to a
+ * symbol-server instead of loading debug-info in the current process. If the server can not be reached, or fails
+ * to answer, symbolization falls back to the in-process symbolizer.
+ *
+ * @note as the strings received from the server are not owned by the process callstack_symbols() needs memory
+ *       for them when a server is set, see callstack_symbols_mem_size().
+ *
+ * @param socket_path path of the socket the server listens on, 0x0 to stop using a server.
+ * @return 0 on success, -1 if socket_path is too long or if not supported on the current platform.
+ *
+ * @note only supported on linux.
+ */
+int callstack_symbols_set_server( const char* socket_path );
+
 #ifdef __cplusplus
 }
 #endif  // __cplusplus
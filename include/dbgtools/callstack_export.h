@@ -0,0 +1,148 @@
+/*
+	dbgtools - platform independent wrapping of "nice to have" debug functions.
+
+	https://github.com/wc-duck/dbgtools
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+#ifndef DBGTOOLS_CALLSTACK_EXPORT_H_INCLUDED
+#define DBGTOOLS_CALLSTACK_EXPORT_H_INCLUDED
+
+#include <dbgtools/callstack.h>
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * Aggregation of weighted callstacks, e.g. samples from a profiler, into formats read by other tools:
+ *
+ *   folded stacks - the text-format used by flamegraph.pl, one line per unique callstack with the functions
+ *                   from the root to the leaf separated by ';' followed by a space and the weight.
+ *   pprof         - the protobuf-format read by pprof, not compressed.
+ *
+ * Callstacks are interned as they are added so memory grows with the number of unique callstacks and not
+ * with the number of samples, and the output is streamed through a callback in small blocks. Each unique
+ * address is only symbolized once, the first time the callstacks are written.
+ */
+typedef struct callstack_export callstack_export_t;
+
+/**
+ * Create an export.
+ * @param symbolizer used to symbolize addresses, 0x0 to symbolize in the current process as callstack_symbols().
+ *                   Must stay valid until the export is destroyed.
+ * @param max_stacks maximum number of unique callstacks that can be added.
+ * @param max_frames maximum number of addresses, summed over all unique callstacks, that can be added.
+ * @return created export or 0x0 on failure.
+ */
+callstack_export_t* callstack_export_create( callstack_symbolizer_t* symbolizer, unsigned int max_stacks, unsigned int max_frames );
+
+/**
+ * Destroy an export and all memory held by it.
+ * @param exp to destroy.
+ */
+void callstack_export_destroy( callstack_export_t* exp );
+
+/**
+ * Add weight to a callstack, may be called concurrently from any number of threads but not at the same time
+ * as any of the write-functions.
+ * @param exp export to add to.
+ * @param addresses addresses of the callstack as returned by callstack(), the leaf first.
+ * @param num_addresses number of addresses.
+ * @param weight to add to the callstack, for example number of samples.
+ * @return 0 on success, -1 if the callstack was new and max_stacks or max_frames was reached.
+ */
+int callstack_export_add( callstack_export_t* exp, void** addresses, int num_addresses, unsigned long long weight );
+
+/**
+ * Get the sum of all weights added.
+ * @param exp to query.
+ * @return total weight.
+ */
+unsigned long long callstack_export_total( callstack_export_t* exp );
+
+/**
+ * Callback receiving one folded callstack at a time from callstack_export_folded_foreach().
+ * @param stack the functions of the callstack from the root to the leaf separated by ';'.
+ * @param weight of the callstack.
+ * @param userdata pointer passed to callstack_export_folded_foreach().
+ * @return 0 to continue with the next callstack, anything else to stop.
+ */
+typedef int (*callstack_export_folded_callback)( const char* stack, unsigned long long weight, void* userdata );
+
+/**
+ * Call callback with each unique callstack folded into a string.
+ *
+ * Addresses that could not be symbolized are named by their address. ';' in function-names are replaced by
+ * ':' so that the name can not be mistaken for multiple functions. Different callstacks might fold into the
+ * same string, for example when addresses differ but are in the same functions, these are passed to callback
+ * one by one.
+ *
+ * @param exp export to fold.
+ * @param flags bitwise or of callstack_symbols_flags, CALLSTACK_SYMBOLS_INLINED to add inlined functions as frames.
+ * @param callback called once per callstack with a weight > 0.
+ * @param userdata passed to callback.
+ * @return number of callstacks passed to callback, -1 on failure.
+ */
+int callstack_export_folded_foreach( callstack_export_t* exp, unsigned int flags, callstack_export_folded_callback callback, void* userdata );
+
+/**
+ * Callback receiving the output of the write-functions.
+ * @param data to write.
+ * @param size of data in bytes.
+ * @param userdata pointer passed to the write-function.
+ * @return 0 on success, anything else aborts the write.
+ */
+typedef int (*callstack_export_write_callback)( const void* data, size_t size, void* userdata );
+
+/**
+ * Write all callstacks as folded stacks, see callstack_export_folded_foreach().
+ * @param exp export to write.
+ * @param flags bitwise or of callstack_symbols_flags.
+ * @param write called with the output in blocks.
+ * @param userdata passed to write.
+ * @return 0 on success, -1 on failure or if write failed.
+ */
+int callstack_export_write_folded( callstack_export_t* exp, unsigned int flags, callstack_export_write_callback write, void* userdata );
+
+/**
+ * Write all callstacks as a pprof-profile, each unique address is a location with one line per function
+ * if inlined functions are expanded.
+ * @param exp export to write.
+ * @param flags bitwise or of callstack_symbols_flags.
+ * @param sample_type name of the weight, for example "samples" or "cpu", 0x0 for "samples".
+ * @param sample_unit unit of the weight, for example "count" or "nanoseconds", 0x0 for "count".
+ * @param write called with the output in blocks.
+ * @param userdata passed to write.
+ * @return 0 on success, -1 on failure or if write failed.
+ */
+int callstack_export_write_pprof( callstack_export_t* exp, unsigned int flags, const char* sample_type, const char* sample_unit, callstack_export_write_callback write, void* userdata );
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+#endif // DBGTOOLS_CALLSTACK_EXPORT_H_INCLUDED
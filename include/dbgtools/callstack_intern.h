@@ -0,0 +1,115 @@
+/*
+	dbgtools - platform independent wrapping of "nice to have" debug functions.
+
+	https://github.com/wc-duck/dbgtools
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+#ifndef DBGTOOLS_CALLSTACK_INTERN_H_INCLUDED
+#define DBGTOOLS_CALLSTACK_INTERN_H_INCLUDED
+
+#include <dbgtools/callstack.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * Id returned by callstack_intern() when the table is full, no valid stack ever has this id.
+ */
+#define CALLSTACK_INTERN_INVALID_ID 0u
+
+/**
+ * Table mapping callstacks, i.e. arrays of addresses as returned by callstack(), to compact ids.
+ *
+ * The same callstack always map to the same id for the lifetime of the table and ids are
+ * allocated in increasing order starting at 1. All functions may be called concurrently from any
+ * number of threads and all except callstack_intern_symbols() are lock-free, it symbolizes through
+ * callstack_symbols() that takes the lock of the default symbolizer the first time an id is
+ * symbolized. All memory used for callstacks is allocated up front in callstack_intern_create().
+ */
+typedef struct callstack_intern callstack_intern_t;
+
+/**
+ * Create an intern-table.
+ * @param max_stacks maximum number of unique callstacks that can be stored in the table.
+ * @param max_frames maximum number of addresses, summed over all unique callstacks, that can be stored in the table.
+ * @return created table or 0x0 on failure.
+ */
+callstack_intern_t* callstack_intern_create( unsigned int max_stacks, unsigned int max_frames );
+
+/**
+ * Destroy an intern-table and all memory held by it, including symbols returned by callstack_intern_symbols().
+ * @param table to destroy.
+ */
+void callstack_intern_destroy( callstack_intern_t* table );
+
+/**
+ * Find or insert a callstack in table.
+ * @param table to intern callstack in.
+ * @param addresses addresses in callstack.
+ * @param num_addresses number of addresses in addresses.
+ * @return id of callstack or CALLSTACK_INTERN_INVALID_ID if the callstack did not exist and the table is full.
+ *
+ * @note if multiple threads race to insert the same new callstack all but one of them will waste
+ *       the id and space reserved for it, the returned id will still be the same for all of them.
+ */
+unsigned int callstack_intern( callstack_intern_t* table, void** addresses, int num_addresses );
+
+/**
+ * Get the addresses of an interned callstack.
+ * @param table to lookup callstack in.
+ * @param id returned by callstack_intern().
+ * @param addresses set to point to the addresses stored in the table, valid as long as the table.
+ * @return number of addresses, -1 if id is not a valid id or an id wasted by a race in callstack_intern().
+ */
+int callstack_intern_lookup( callstack_intern_t* table, unsigned int id, void* const** addresses );
+
+/**
+ * Get symbols of an interned callstack, the callstack is only symbolized the first time this is called
+ * for id and the result is kept until the table is destroyed.
+ *
+ * @note on linux the strings of the symbols are owned by the default symbolizer, as for callstack_symbols(),
+ *       and are released when the module they were found in is unloaded, i.e. by dlclose(). Symbols of a
+ *       callstack through a module that might be unloaded must be copied before that happens.
+ *
+ * @param table to lookup callstack in.
+ * @param id returned by callstack_intern().
+ * @param num_symbols set to the number of symbols returned.
+ * @return symbols of callstack or 0x0 if id is not a valid id or the symbolization failed.
+ */
+const callstack_symbol_t* callstack_intern_symbols( callstack_intern_t* table, unsigned int id, int* num_symbols );
+
+/**
+ * Get the number of ids allocated in table, valid ids are in [1, callstack_intern_count()].
+ * @param table to query.
+ * @return number of allocated ids.
+ */
+unsigned int callstack_intern_count( callstack_intern_t* table );
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+#endif // DBGTOOLS_CALLSTACK_INTERN_H_INCLUDED
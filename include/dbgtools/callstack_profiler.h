@@ -0,0 +1,231 @@
+/*
+	dbgtools - platform independent wrapping of "nice to have" debug functions.
+
+	https://github.com/wc-duck/dbgtools
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+#ifndef DBGTOOLS_CALLSTACK_PROFILER_H_INCLUDED
+#define DBGTOOLS_CALLSTACK_PROFILER_H_INCLUDED
+
+#include <dbgtools/callstack.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * Sampling cpu-profiler built on callstack_from_context().
+ *
+ * Each profiled thread gets a timer measuring the cpu-time of that thread, when it expires the thread is
+ * interrupted by SIGPROF and the interrupted callstack is written to a lock-free ring-buffer owned by the
+ * thread. A background thread drains all ring-buffers, interns the callstacks with callstack_intern() and
+ * counts samples per callstack. The aggregated profile is written with callstack_profiler_write() and
+ * optionally to a file at a regular interval.
+ *
+ * Samples are captured by walking frame-pointers so profiled code should be compiled with
+ * -fno-omit-frame-pointer, see callstack_from_context().
+ *
+ * The cpu-time of a thread is only accounted at each scheduler-tick so the highest usable frequency is
+ * the tick-rate of the kernel, usually 250 or 1000Hz.
+ *
+ * Instead of the timer the profiler can sample one of the software-events of perf_event_open(), see
+ * callstack_profiler_event. The kernel then captures the user-space callstack into a ring-buffer mapped by
+ * the profiler, so nothing at all runs in the profiled threads, and events that happens while the thread is
+ * not running, such as blocking in a context-switch, can be sampled. This requires that perf_event_open()
+ * is allowed by /proc/sys/kernel/perf_event_paranoid and that linux/perf_event.h was available at compile
+ * time.
+ *
+ * @note only supported on linux, on other platforms callstack_profiler_create() returns 0x0.
+ */
+typedef struct callstack_profiler callstack_profiler_t;
+
+/**
+ * Event that triggers a sample.
+ */
+enum callstack_profiler_event
+{
+	CALLSTACK_PROFILER_EVENT_TIMER,            ///< SIGPROF from a timer on the cpu-time of the thread, frequency is samples per second.
+	CALLSTACK_PROFILER_EVENT_CPU_CLOCK,        ///< perf cpu-clock, frequency is samples per second of cpu-time.
+	CALLSTACK_PROFILER_EVENT_TASK_CLOCK,       ///< perf task-clock, frequency is samples per second of cpu-time.
+	CALLSTACK_PROFILER_EVENT_PAGE_FAULTS,      ///< perf page-faults, frequency is page-faults per sample.
+	CALLSTACK_PROFILER_EVENT_CONTEXT_SWITCHES, ///< perf context-switches, frequency is context-switches per sample.
+};
+
+/**
+ * Configuration passed to callstack_profiler_create(), 0 in any field gives the default value.
+ */
+typedef struct
+{
+	enum callstack_profiler_event event; ///< event to sample in all threads, default CALLSTACK_PROFILER_EVENT_TIMER.
+	unsigned int frequency;         ///< frequency used by callstack_profiler_thread_start() if frequency is 0, see callstack_profiler_event, default 99 for clocks and 1 for other events.
+	unsigned int ring_size;         ///< size in bytes of the ring-buffer of each thread, rounded up to a power of 2 and at least a page for perf-events, default 64kb.
+	unsigned int max_threads;       ///< maximum number of threads profiled at the same time, default 256.
+	unsigned int max_stacks;        ///< maximum number of unique callstacks in the profile, default 65536.
+	unsigned int max_frames;        ///< maximum number of addresses summed over all unique callstacks, default 1048576.
+	unsigned int flush_interval_ms; ///< how often the background thread drains the ring-buffers, default 100.
+	unsigned int write_interval_ms; ///< how often the profile is written to output_path, default 10000.
+	const char*  output_path;       ///< file the profile is written to by the background thread, also written on destroy. 0x0 to disable.
+} callstack_profiler_config_t;
+
+/**
+ * Create a profiler and start its background thread, no thread is profiled until it calls
+ * callstack_profiler_thread_start().
+ * @param config configuration, 0x0 for all defaults.
+ * @return created profiler or 0x0 on failure or if not supported on the current platform.
+ *
+ * @note with CALLSTACK_PROFILER_EVENT_TIMER a handler for SIGPROF is installed, no other handler for SIGPROF can be
+ *       used while such a profiler exists.
+ */
+callstack_profiler_t* callstack_profiler_create( const callstack_profiler_config_t* config );
+
+/**
+ * Stop and destroy a profiler, writes the profile to output_path if set.
+ * @param profiler to destroy.
+ *
+ * @note all threads must have called callstack_profiler_thread_stop() before this is called. If a thread profiled
+ *       with CALLSTACK_PROFILER_EVENT_TIMER has not, a SIGPROF already queued for it might still be delivered after
+ *       this returns so the per-thread buffers and the SIGPROF-handler are then leaked instead of released.
+ */
+void callstack_profiler_destroy( callstack_profiler_t* profiler );
+
+/**
+ * Start profiling the calling thread.
+ * @param profiler to add samples to.
+ * @param frequency of samples as described by callstack_profiler_event, 0 to use the frequency of the profiler-config.
+ * @return 0 on success, -1 if the thread is already profiled, max_threads are already profiled or the timer or
+ *         perf-event could not be created.
+ */
+int callstack_profiler_thread_start( callstack_profiler_t* profiler, unsigned int frequency );
+
+/**
+ * Stop profiling the calling thread, samples not yet drained are kept until the next drain.
+ * Must be called before a profiled thread exits.
+ * @param profiler passed to callstack_profiler_thread_start().
+ * @return 0 on success, -1 if the thread is not profiled.
+ */
+int callstack_profiler_thread_stop( callstack_profiler_t* profiler );
+
+/**
+ * Drain the ring-buffers of all threads now instead of waiting for the background thread.
+ * @param profiler to drain.
+ * @return number of samples drained.
+ */
+int callstack_profiler_flush( callstack_profiler_t* profiler );
+
+/**
+ * Statistics of a profiler.
+ */
+typedef struct
+{
+	unsigned long long samples;         ///< samples drained and added to the profile.
+	unsigned long long dropped_samples; ///< samples lost since a ring-buffer was full, as reported by the kernel for perf-events, or the callstack-table was full.
+	unsigned int       num_stacks;      ///< unique callstacks in the profile.
+	unsigned int       num_threads;     ///< threads currently profiled.
+} callstack_profiler_stats_t;
+
+/**
+ * Get statistics of a profiler.
+ * @param profiler to query.
+ * @param stats filled with the current statistics.
+ */
+void callstack_profiler_stats( callstack_profiler_t* profiler, callstack_profiler_stats_t* stats );
+
+/**
+ * Write the aggregated profile, all samples drained so far.
+ *
+ * All integers in the format are unsigned LEB128:
+ *
+ *   "CSP" followed by the version-byte 2.
+ *   callstack_profiler_event sampled, default frequency, total number of samples, number of dropped samples.
+ *   number of callstacks, followed by the number of samples of each callstack.
+ *   size of dump, followed by the callstacks in a dump written by callstack_dump_write(), in the same order as the counts.
+ *
+ * @param profiler to write.
+ * @param out buffer to write the profile to, can be 0x0 to only query the size.
+ * @param out_size size of out.
+ * @return size of the profile in bytes, if larger than out_size the profile was not written in full.
+ *         0 on failure.
+ */
+int callstack_profiler_write( callstack_profiler_t* profiler, void* out, int out_size );
+
+/**
+ * Callback receiving one callstack at a time from callstack_profile_read().
+ * @param addresses of the callstack, the runtime-addresses in the profiled process.
+ * @param num_addresses number of addresses.
+ * @param count number of samples of the callstack.
+ * @param userdata pointer passed to callstack_profile_read().
+ * @return 0 to continue with the next callstack, anything else to stop.
+ */
+typedef int (*callstack_profile_callback)( void** addresses, int num_addresses, unsigned long long count, void* userdata );
+
+/**
+ * Read the callstacks and sample-counts of a profile written by callstack_profiler_write().
+ *
+ * The addresses can be symbolized offline with a symbolizer created by callstack_symbolizer_create_from_dump()
+ * from the dump returned by callstack_profile_dump().
+ *
+ * @param profile data of the profile.
+ * @param profile_size size of profile.
+ * @param callback called once per callstack.
+ * @param userdata passed to callback.
+ * @return number of callstacks passed to callback, -1 if profile is malformed or not supported on the current platform.
+ */
+int callstack_profile_read( const void* profile, int profile_size, callstack_profile_callback callback, void* userdata );
+
+/**
+ * Information stored in the header of a profile.
+ */
+typedef struct
+{
+	enum callstack_profiler_event event;
+	unsigned int                  frequency;       ///< default frequency of the profiler that wrote the profile.
+	unsigned long long            samples;
+	unsigned long long            dropped_samples;
+	unsigned int                  num_stacks;
+} callstack_profile_info_t;
+
+/**
+ * Get the information stored in the header of a profile written by callstack_profiler_write().
+ * @param profile data of the profile.
+ * @param profile_size size of profile.
+ * @param info filled with the information.
+ * @return 0 on success, -1 if profile is malformed or not supported on the current platform.
+ */
+int callstack_profile_info( const void* profile, int profile_size, callstack_profile_info_t* info );
+
+/**
+ * Get the callstack-dump stored in a profile written by callstack_profiler_write().
+ * @param profile data of the profile.
+ * @param profile_size size of profile.
+ * @param dump_size set to the size of the dump.
+ * @return dump stored in profile or 0x0 if profile is malformed.
+ */
+const void* callstack_profile_dump( const void* profile, int profile_size, int* dump_size );
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+#endif // DBGTOOLS_CALLSTACK_PROFILER_H_INCLUDED
@@ -54,6 +54,75 @@ static const char* alloc_string( callstack_string_buffer_t* buf, const char* str
 	res[str_len] = '\0';
 	return res;
 }
+
+typedef struct
+{
+	callstack_symbol_t*       out_syms;
+	int                       num_syms;
+	int                       max_syms;
+	callstack_string_buffer_t outbuf;
+} callstack_symbol_copy_t;
+
+// ... callstack_symbol_callback copying symbols to the out_syms/memory of the buffer-based functions ...
+static int symbol_copy_callback( const callstack_symbol_t* sym, int, void* userdata )
+{
+	callstack_symbol_copy_t* copy = (callstack_symbol_copy_t*)userdata;
+	if( copy->num_syms >= copy->max_syms )
+		return 1;
+
+	callstack_symbol_t* out = &copy->out_syms[copy->num_syms++];
+	*out = *sym;
+	out->function = alloc_string( &copy->outbuf, sym->function, strlen( sym->function ) );
+	out->file     = alloc_string( &copy->outbuf, sym->file, strlen( sym->file ) );
+	return copy->num_syms >= copy->max_syms;
+}
+
+typedef struct
+{
+	int num_syms;
+	int mem_size;
+} callstack_symbol_size_t;
+
+// ... callstack_symbol_callback summing up what symbol_copy_callback() would write ...
+static int symbol_size_callback( const callstack_symbol_t* sym, int, void* userdata )
+{
+	callstack_symbol_size_t* size = (callstack_symbol_size_t*)userdata;
+	size->num_syms += 1;
+	size->mem_size += (int)( strlen( sym->function ) + 1 + strlen( sym->file ) + 1 );
+	return 0;
+}
+
+int callstack_symbolizer_mem_size( callstack_symbolizer_t* symbolizer, void** addresses, int num_addresses, unsigned int flags, int* num_syms )
+{
+	callstack_symbol_size_t size = { 0, 0 };
+	callstack_symbolizer_symbolize_foreach( symbolizer, addresses, num_addresses, flags, symbol_size_callback, &size );
+	if( num_syms )
+		*num_syms = size.num_syms;
+	return size.mem_size;
+}
+
+#if defined(__linux)
+// ... set when a symbol-server is used by the default symbolizer, see callstack_symbols_set_server() ...
+static int g_symbol_server_enabled = 0;
+#endif
+
+int callstack_symbols_mem_size( void** addresses, int num_addresses, unsigned int flags, int* num_syms )
+{
+#if defined(__linux)
+	// ... all strings are owned by the default symbolizer so callstack_symbols() do not need any memory, unless they come from a symbol-server ...
+	if( ( flags & CALLSTACK_SYMBOLS_INLINED ) == 0 && !__atomic_load_n( &g_symbol_server_enabled, __ATOMIC_ACQUIRE ) )
+	{
+		if( num_syms )
+			*num_syms = num_addresses;
+		return 0;
+	}
+#endif
+	callstack_symbol_size_t size = { 0, 0 };
+	callstack_symbols_foreach( addresses, num_addresses, flags, symbol_size_callback, &size );
+	if( num_syms )
+		*num_syms = size.num_syms;
+	return size.mem_size;
+}
 #endif
 
 #if defined( DBG_TOOLS_CALLSTACK_UNIX )
@@ -62,174 +131,7547 @@ static const char* alloc_string( callstack_string_buffer_t* buf, const char* str
 	#include <stdlib.h>
 	#include <string.h>
 	#include <unistd.h>
+	#include <pthread.h>
+	#include <errno.h>
+	#include <ucontext.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
 	#include <cxxabi.h>
 
+	#include <stdint.h>
+
+	// ... g_unwinder is read by callstack() on any thread and in signal-handlers so it is only accessed atomically ...
+#if defined( DBG_TOOLS_CALLSTACK_DEFAULT_FRAME_POINTER )
+	static enum callstack_unwinder g_unwinder = CALLSTACK_UNWINDER_FRAME_POINTER;
+#else
+	static enum callstack_unwinder g_unwinder = CALLSTACK_UNWINDER_DEFAULT;
+#endif
+
+	int callstack_set_unwinder( enum callstack_unwinder unwinder )
+	{
+		switch( unwinder )
+		{
+			case CALLSTACK_UNWINDER_DEFAULT:
+			case CALLSTACK_UNWINDER_FRAME_POINTER:
+				__atomic_store_n( &g_unwinder, unwinder, __ATOMIC_RELAXED );
+				return 0;
+		}
+		return -1;
+	}
+
+	// ... bounds of the stack of the current thread, fetched once per thread ...
+	static __thread uintptr_t g_stack_lo = 0;
+	static __thread uintptr_t g_stack_hi = 0;
+
+	static void callstack_thread_stack_bounds( uintptr_t* lo, uintptr_t* hi )
+	{
+		if( g_stack_hi == 0 )
+		{
+			void*  addr = 0x0;
+			size_t size = 0;
+		#if defined(__APPLE__)
+			pthread_t self = pthread_self();
+			size = pthread_get_stacksize_np( self );
+			addr = (char*)pthread_get_stackaddr_np( self ) - size;
+		#else
+			pthread_attr_t attr;
+			if( pthread_getattr_np( pthread_self(), &attr ) == 0 )
+			{
+				pthread_attr_getstack( &attr, &addr, &size );
+				pthread_attr_destroy( &attr );
+			}
+		#endif
+			g_stack_lo = (uintptr_t)addr;
+			g_stack_hi = size > 0 ? (uintptr_t)addr + size : ~(uintptr_t)0;
+		}
+		*lo = g_stack_lo;
+		*hi = g_stack_hi;
+	}
+
+	// ... check if the page containing addr is mapped with a raw syscall, async-signal-safe and preserves errno ...
+	static int callstack_page_mapped( uintptr_t addr )
+	{
+		static const uintptr_t page_size = 4096; // ... smallest page-size on supported platforms, mincore() require alignment to it ...
+		int saved_errno = errno;
+		unsigned char vec[4];
+	#if defined(__linux)
+		int res = (int)syscall( SYS_mincore, (void*)( addr & ~( page_size - 1 ) ), (size_t)1, vec );
+	#else
+		int res = mincore( (void*)( addr & ~( page_size - 1 ) ), (size_t)1, (char*)vec );
+	#endif
+		errno = saved_errno;
+		return res == 0;
+	}
+
+	/**
+	 * Walk a chain of frame-records, i.e. { previous frame, return address }, starting at frame.
+	 * This is the layout used on x86, x86_64 and aarch64 when compiling with -fno-omit-frame-pointer.
+	 * Frames are validated to be aligned, inside [stack_lo, stack_hi) and moving towards the top of
+	 * the stack so that a corrupt or missing frame-pointer terminates the walk instead of crashing.
+	 *
+	 * If check_pages is set each new page touched by the walk is verified to be mapped before it is
+	 * read, used when the bounds of the stack is not known.
+	 */
+	static int callstack_walk_frames( void** frame, uintptr_t stack_lo, uintptr_t stack_hi, int check_pages, int skip_frames, void** addresses, int num_addresses )
+	{
+		int num_frames = 0;
+		uintptr_t checked_page = 0;
+		while( num_frames < num_addresses )
+		{
+			uintptr_t frame_addr = (uintptr_t)frame;
+			if( ( frame_addr & ( sizeof(void*) - 1 ) ) != 0 ||
+				frame_addr < stack_lo ||
+				frame_addr > stack_hi - 2 * sizeof(void*) )
+				break;
+
+			if( check_pages )
+			{
+				// ... a frame-record is 2 aligned pointers so it never straddle a page ...
+				uintptr_t page = frame_addr & ~(uintptr_t)4095;
+				if( page != checked_page )
+				{
+					if( !callstack_page_mapped( frame_addr ) )
+						break;
+					checked_page = page;
+				}
+			}
+
+			void*  ret  = frame[1];
+			void** next = (void**)frame[0];
+			if( ret == 0x0 )
+				break;
+
+			if( skip_frames > 0 )
+				--skip_frames;
+			else
+				addresses[num_frames++] = ret;
+
+			if( (uintptr_t)next <= frame_addr )
+				break;
+			frame = next;
+		}
+		return num_frames;
+	}
+
 	int callstack( int skip_frames, void** addresses, int num_addresses )
 	{
+		if( __atomic_load_n( &g_unwinder, __ATOMIC_RELAXED ) == CALLSTACK_UNWINDER_FRAME_POINTER )
+		{
+			uintptr_t stack_lo, stack_hi;
+			callstack_thread_stack_bounds( &stack_lo, &stack_hi );
+			// ... the first frame-record is the one of callstack() itself, i.e. its return-address is in our caller ...
+			return callstack_walk_frames( (void**)__builtin_frame_address( 0 ), stack_lo, stack_hi, 0, skip_frames, addresses, num_addresses );
+		}
+
 		++skip_frames;
 		void* trace[256];
-		int fetched = backtrace( trace, num_addresses + skip_frames ) - skip_frames;
+		int to_fetch = num_addresses + skip_frames;
+		if( to_fetch > (int)( sizeof(trace) / sizeof(trace[0]) ) )
+			to_fetch = (int)( sizeof(trace) / sizeof(trace[0]) );
+
+		int fetched = backtrace( trace, to_fetch ) - skip_frames;
+		if( fetched <= 0 )
+			return 0;
 		memcpy( addresses, trace + skip_frames, (size_t)fetched * sizeof(void*) );
 		return fetched;
 	}
 
+	int callstack_from_context( void* context, void** addresses, int num_addresses )
+	{
+		if( context == 0x0 || num_addresses <= 0 )
+			return 0;
+
+		ucontext_t* uc = (ucontext_t*)context;
+		uintptr_t pc, fp, sp;
+	#if defined(__linux) && defined(__x86_64__)
+		pc = (uintptr_t)uc->uc_mcontext.gregs[REG_RIP];
+		fp = (uintptr_t)uc->uc_mcontext.gregs[REG_RBP];
+		sp = (uintptr_t)uc->uc_mcontext.gregs[REG_RSP];
+	#elif defined(__linux) && defined(__i386__)
+		pc = (uintptr_t)uc->uc_mcontext.gregs[REG_EIP];
+		fp = (uintptr_t)uc->uc_mcontext.gregs[REG_EBP];
+		sp = (uintptr_t)uc->uc_mcontext.gregs[REG_ESP];
+	#elif defined(__linux) && defined(__aarch64__)
+		pc = (uintptr_t)uc->uc_mcontext.pc;
+		fp = (uintptr_t)uc->uc_mcontext.regs[29];
+		sp = (uintptr_t)uc->uc_mcontext.sp;
+	#elif defined(__APPLE__) && defined(__x86_64__)
+		pc = (uintptr_t)uc->uc_mcontext->__ss.__rip;
+		fp = (uintptr_t)uc->uc_mcontext->__ss.__rbp;
+		sp = (uintptr_t)uc->uc_mcontext->__ss.__rsp;
+	#elif defined(__APPLE__) && defined(__aarch64__)
+		pc = (uintptr_t)__darwin_arm_thread_state64_get_pc( uc->uc_mcontext->__ss );
+		fp = (uintptr_t)__darwin_arm_thread_state64_get_fp( uc->uc_mcontext->__ss );
+		sp = (uintptr_t)__darwin_arm_thread_state64_get_sp( uc->uc_mcontext->__ss );
+	#else
+		(void)uc;
+		return 0;
+	#endif
+
+		// ... the interrupted frame might not have a frame-record of its own yet so start with pc ...
+		addresses[0] = (void*)pc;
+
+		// ... stack-bounds might not be known for the interrupted thread and can't be fetched safely
+		//     here, instead only accept frames above sp and verify that each page is mapped ...
+		return 1 + callstack_walk_frames( (void**)fp, sp, ~(uintptr_t)0, 1, 0, addresses + 1, num_addresses - 1 );
+	}
+
 #if defined(__linux)
-	#include <stdint.h>
+	#include <elf.h>
+	#include <link.h>
+	#include <fcntl.h>
+	#include <limits.h>
+	#include <poll.h>
+	#include <signal.h>
+	#include <time.h>
+	#include <sys/stat.h>
+	#include <sys/socket.h>
+	#include <sys/un.h>
+	#if defined(__AVX2__)
+	#  include <immintrin.h>
+	#endif
+
+	// ... root of the separate debug-files, files are found in <dir>/.build-id/ or <dir>/<path of module> ...
+	#if !defined( DBG_TOOLS_CALLSTACK_DEBUG_FILE_DIR )
+	#  define DBG_TOOLS_CALLSTACK_DEBUG_FILE_DIR "/usr/lib/debug"
+	#endif
 
-	static uint16_t read_elf_type_from_self()
+	/**
+	 * In-process symbolizer for linux.
+	 *
+	 * Instead of spawning addr2line for each call to callstack_symbols() the executable, and each
+	 * shared library that frames are found in, is mapped into memory and .symtab (or .dynsym if
+	 * stripped) is used to find function names and .debug_line is decoded to find file/line. All
+	 * tables are built once per module on first use and kept sorted so that each address is just a
+	 * couple of binary searches.
+	 *
+	 * Line-tables are built per compilation unit, .debug_aranges is used to find the unit owning an
+	 * address and only the line-programs of units that are actually looked up are decoded.
+	 *
+	 * If the module is stripped, debug-info and .symtab are read from its separate debug-file instead,
+	 * found via the build-id note or .gnu_debuglink in the same way as gdb does.
+	 *
+	 * Nothing is read from the dynamic symbol-table unless .symtab is missing, so executables do not
+	 * need to be linked with -rdynamic. If .symtab is stripped but debug-info is kept the function
+	 * names are taken from DW_TAG_subprogram instead.
+	 *
+	 * Only little-endian targets are supported, i.e. the same byte-order as the process
+	 * doing the lookups, since we only ever symbolize ourself.
+	 */
+
+	// ... bounds-checked reader used for all parsing of DWARF data ...
+	typedef struct
+	{
+		const uint8_t* ptr;
+		const uint8_t* end;
+	} callstack_dwarf_cursor_t;
+
+	static void dwarf_cursor_init( callstack_dwarf_cursor_t* c, const void* data, size_t size )
+	{
+		c->ptr = (const uint8_t*)data;
+		c->end = c->ptr + size;
+	}
+
+	static size_t dwarf_left( const callstack_dwarf_cursor_t* c )
+	{
+		return (size_t)(c->end - c->ptr);
+	}
+
+	static void dwarf_skip( callstack_dwarf_cursor_t* c, uint64_t bytes )
+	{
+		c->ptr = bytes > dwarf_left( c ) ? c->end : c->ptr + bytes;
+	}
+
+	static uint64_t dwarf_read_uint( callstack_dwarf_cursor_t* c, size_t bytes )
 	{
-		uint16_t type = 0;
+		uint64_t res = 0;
+		if( dwarf_left( c ) < bytes )
+		{
+			c->ptr = c->end;
+			return 0;
+		}
+		for( size_t i = 0; i < bytes; ++i )
+			res |= (uint64_t)c->ptr[i] << ( i * 8 );
+		c->ptr += bytes;
+		return res;
+	}
+
+	static uint8_t  dwarf_read_u8 ( callstack_dwarf_cursor_t* c ) { return (uint8_t) dwarf_read_uint( c, 1 ); }
+	static uint16_t dwarf_read_u16( callstack_dwarf_cursor_t* c ) { return (uint16_t)dwarf_read_uint( c, 2 ); }
+	static uint32_t dwarf_read_u32( callstack_dwarf_cursor_t* c ) { return (uint32_t)dwarf_read_uint( c, 4 ); }
+	static uint64_t dwarf_read_u64( callstack_dwarf_cursor_t* c ) { return            dwarf_read_uint( c, 8 ); }
 
-		// lets check our own elf-type, first open our own exe!
-		FILE* f = fopen("/proc/self/exe", "r");
-		if(f)
+	static uint64_t dwarf_read_uleb( callstack_dwarf_cursor_t* c )
+	{
+		uint64_t res = 0;
+		unsigned int shift = 0;
+		while( c->ptr < c->end )
 		{
-			// we only need header-data at the start of the exe.
-			// more to the point, 2 bytes at offset 0x10 that is
-			// the elf-type.
-			// https://en.wikipedia.org/wiki/Executable_and_Linkable_Format#File_header
-			char elf_header[0x10 + 1] {0};
-			size_t read = fread(elf_header, sizeof(elf_header), 1, f);
-			fclose(f);
+			uint8_t b = *c->ptr++;
+			if( shift < 64 )
+				res |= (uint64_t)( b & 0x7f ) << shift;
+			shift += 7;
+			if( ( b & 0x80 ) == 0 )
+				break;
+		}
+		return res;
+	}
 
-			if(read == 1)
-				memcpy(&type, elf_header + 0x10, sizeof(type));
+	static int64_t dwarf_read_sleb( callstack_dwarf_cursor_t* c )
+	{
+		uint64_t res = 0;
+		unsigned int shift = 0;
+		uint8_t b = 0;
+		while( c->ptr < c->end )
+		{
+			b = *c->ptr++;
+			if( shift < 64 )
+				res |= (uint64_t)( b & 0x7f ) << shift;
+			shift += 7;
+			if( ( b & 0x80 ) == 0 )
+				break;
 		}
+		if( shift < 64 && ( b & 0x40 ) )
+			res |= ~(uint64_t)0 << shift;
+		return (int64_t)res;
+	}
 
-		return type;
+	static const char* dwarf_read_str( callstack_dwarf_cursor_t* c )
+	{
+		const char* str = (const char*)c->ptr;
+		const uint8_t* term = (const uint8_t*)memchr( c->ptr, '\0', dwarf_left( c ) );
+		if( term == 0x0 )
+		{
+			c->ptr = c->end;
+			return "";
+		}
+		c->ptr = term + 1;
+		return str;
 	}
 
-	// detect if the current running exe is compiled as PIE.
-	// https://en.wikipedia.org/wiki/Position-independent_code
-	// if it does we need to translate all addresses that we are going to
-	// lookup with the help of the address-maps in /proc/self/maps, if not
-	// we should not do that.
-	static int is_using_pie()
+	// ... reads an "initial length", returns the size of offsets in this unit, 4 or 8 ...
+	static size_t dwarf_read_unit_length( callstack_dwarf_cursor_t* c, uint64_t* length )
 	{
-		// elf-type for shared object/PIE-executable
-		const uint16_t ET_DYN = 0x03;
-		return read_elf_type_from_self() == ET_DYN;
+		*length = dwarf_read_u32( c );
+		if( *length != 0xffffffff )
+			return 4;
+		*length = dwarf_read_u64( c );
+		return 8;
 	}
 
-	typedef struct mmap_entry_t {
-		struct mmap_entry_t *next;
+	// ... simple append-only string storage, strings stay valid until the pool is freed ...
+	typedef struct callstack_string_chunk_t
+	{
+		struct callstack_string_chunk_t* next;
+		size_t used;
+		size_t size;
+		char   data[1];
+	} callstack_string_chunk_t;
+
+	// ... join path-parts with '/' into the pool, null or empty parts are skipped ...
+	static const char* string_pool_join( callstack_string_chunk_t** pool, const char** parts, int num_parts )
+	{
+		size_t need = 1;
+		for( int i = 0; i < num_parts; ++i )
+			need += parts[i] ? strlen( parts[i] ) + 1 : 0;
+
+		callstack_string_chunk_t* chunk = *pool;
+		if( chunk == 0x0 || chunk->size - chunk->used < need )
+		{
+			size_t size = need > 16 * 1024 ? need : 16 * 1024;
+			chunk = (callstack_string_chunk_t*)malloc( sizeof(callstack_string_chunk_t) + size );
+			if( chunk == 0x0 )
+				return parts[num_parts - 1];
+			chunk->next = *pool;
+			chunk->used = 0;
+			chunk->size = size;
+			*pool = chunk;
+		}
 
-		unsigned long range_start;
-		unsigned long range_end;
-		unsigned long file_offset;
-	} mmap_entry_t;
+		char* res = chunk->data + chunk->used;
+		char* out = res;
+		for( int i = 0; i < num_parts; ++i )
+		{
+			if( parts[i] == 0x0 || parts[i][0] == '\0' )
+				continue;
+			if( out != res && out[-1] != '/' )
+				*out++ = '/';
+			size_t len = strlen( parts[i] );
+			memcpy( out, parts[i], len );
+			out += len;
+		}
+		*out++ = '\0';
+		chunk->used += (size_t)( out - res );
+		return res;
+	}
 
-	static mmap_entry_t *parse_mmaps(const char *maps_file)
+	static void string_pool_free( callstack_string_chunk_t* pool )
 	{
-		FILE* maps = fopen(maps_file, "r");
-		if(!maps){
-			perror("fopen");
-			fprintf(stderr, "failed to open %s\n", maps_file);
-			return NULL;
+		while( pool )
+		{
+			callstack_string_chunk_t* next = pool->next;
+			free( pool );
+			pool = next;
 		}
+	}
 
-		mmap_entry_t *first = NULL;
-		mmap_entry_t *cur = NULL;
+	/**
+	 * Demangler for names following the Itanium C++ ABI, i.e. names from gcc and clang, that writes
+	 * straight into a caller-provided buffer and never allocates.
+	 *
+	 * No tree is built, substitutions and template-arguments are remembered as ranges of the mangled
+	 * name and are parsed again each time they are referenced so that all state fits on the stack.
+	 * Output is the same as from abi::__cxa_demangle() for all names handled, rarely seen constructs
+	 * such as expressions in template-arguments are reported as unsupported.
+	 *
+	 * With short_names all template-arguments are dropped together with the return-type of
+	 * function-templates, i.e. "std::vector<int, std::allocator<int> >::push_back(int const&)"
+	 * becomes "std::vector::push_back(int const&)".
+	 */
+	enum
+	{
+		CALLSTACK_DEMANGLE_MAX_SUBS  = 256,
+		CALLSTACK_DEMANGLE_MAX_ARGS  = 128,
+		CALLSTACK_DEMANGLE_MAX_MODS  = 16,
+		CALLSTACK_DEMANGLE_MAX_DIMS  = 8,
+		CALLSTACK_DEMANGLE_MAX_DEPTH = 64,
+		CALLSTACK_DEMANGLE_MAX_STEPS = 64 * 1024,
 
-		while(!feof(maps)){
-			char buf[4096];
-			char *ret = fgets(buf, 4096, maps);
-			if(!ret)
-				break;
+		CALLSTACK_DEMANGLE_OK          = 0,
+		CALLSTACK_DEMANGLE_UNSUPPORTED = 1, ///< malformed name or something not handled.
+		CALLSTACK_DEMANGLE_NO_SPACE    = 2, ///< output buffer is too small.
 
-			mmap_entry_t *next = (mmap_entry_t*) malloc(sizeof(mmap_entry_t));
-			next->next = NULL;
+		CALLSTACK_DEMANGLE_SUB_TYPE   = 0, ///< a <type>.
+		CALLSTACK_DEMANGLE_SUB_PREFIX = 1, ///< components of a <prefix> or an unscoped template-name.
+		CALLSTACK_DEMANGLE_SUB_ARG    = 2, ///< a <template-arg>.
+	};
 
-			// from man `proc`:
-			// address perms offset dev inode pathname
-			sscanf(buf, "%lx-%lx %*s %lx",
-				&next->range_start,
-				&next->range_end,
-				&next->file_offset
-			);
+	typedef struct
+	{
+		uint32_t begin; ///< offset in the mangled name.
+		uint32_t end;
+	} callstack_demangle_range_t;
 
-			if(!first){
-				first = next;
-				cur   = next;
-			} else {
-				cur->next = next;
-				cur       = next;
-			}
+	typedef struct
+	{
+		int  cv;          ///< qualifiers of a member-function, 1 = const, 2 = volatile, 4 = restrict.
+		char ref;         ///< 'R' or 'O' for a ref-qualified member-function, 0 otherwise.
+		int  is_template; ///< name ends with template-arguments.
+		int  no_return;   ///< constructor, destructor or conversion-operator, never has a return-type.
+	} callstack_demangle_name_t;
+
+	typedef struct
+	{
+		const char* name; ///< mangled name.
+		const char* p;    ///< read-position in name.
+
+		char*  out;
+		size_t len;
+		size_t cap;
+
+		int status;
+		int short_names;
+		int quiet;      ///< > 0 while parsing things that are not printed.
+		int no_subs;    ///< > 0 while re-parsing a substitution or template-argument, nothing new is recorded.
+		int in_lambda;  ///< > 0 while parsing the signature of a lambda, template-parameters there are auto-parameters.
+		int pack_index; ///< element of argument-packs printed by the current pack-expansion, -1 outside of expansions.
+		int pack_size;  ///< size of the first argument-pack referenced while probing a pack-expansion, -1 if none yet.
+		int depth;
+		int steps;
+
+		const char* last_name; ///< last source-name, the name of constructors and destructors.
+		size_t      last_name_len;
+		size_t      dropped_at; ///< length of the output right after an empty argument dropped its ", ".
+
+		callstack_demangle_range_t subs[CALLSTACK_DEMANGLE_MAX_SUBS];
+		uint8_t                    sub_kind[CALLSTACK_DEMANGLE_MAX_SUBS];
+		uint8_t                    sub_encoding[CALLSTACK_DEMANGLE_MAX_SUBS]; ///< encoding the substitution was recorded in.
+		int                        num_subs;
+		int                        foreign; ///< > 0 while re-parsing a substitution recorded in another encoding.
+
+		callstack_demangle_range_t args[CALLSTACK_DEMANGLE_MAX_ARGS]; ///< template-arguments T_ refers to, from args_base.
+		int                        num_args;
+		int                        args_base; ///< first argument of the innermost encoding, arguments of outer ones are below it.
+		int                        encoding;      ///< id of the innermost encoding, 0 for the name itself.
+		int                        num_encodings;
+	} callstack_demangle_t;
+
+	typedef struct
+	{
+		int args_base;
+		int num_args;
+		int encoding;
+	} callstack_demangle_scope_t;
+
+	typedef struct
+	{
+		char                       kind; ///< one of rVKPROM.
+		const char*                pos;
+		callstack_demangle_range_t cls;  ///< class of a pointer-to-member.
+	} callstack_demangle_mod_t;
+
+	typedef struct
+	{
+		char        code[3];
+		const char* name;
+	} callstack_demangle_operator_t;
+
+	static const callstack_demangle_operator_t CALLSTACK_DEMANGLE_OPERATORS[] =
+	{
+		{ "nw", "new" },   { "na", "new[]" }, { "dl", "delete" }, { "da", "delete[]" }, { "aw", "co_await" },
+		{ "ps", "+" },     { "ng", "-" },     { "ad", "&" },      { "de", "*" },        { "co", "~" },
+		{ "pl", "+" },     { "mi", "-" },     { "ml", "*" },      { "dv", "/" },        { "rm", "%" },
+		{ "an", "&" },     { "or", "|" },     { "eo", "^" },      { "aS", "=" },        { "pL", "+=" },
+		{ "mI", "-=" },    { "mL", "*=" },    { "dV", "/=" },     { "rM", "%=" },       { "aN", "&=" },
+		{ "oR", "|=" },    { "eO", "^=" },    { "ls", "<<" },     { "rs", ">>" },       { "lS", "<<=" },
+		{ "rS", ">>=" },   { "eq", "==" },    { "ne", "!=" },     { "lt", "<" },        { "gt", ">" },
+		{ "le", "<=" },    { "ge", ">=" },    { "ss", "<=>" },    { "nt", "!" },        { "aa", "&&" },
+		{ "oo", "||" },    { "pp", "++" },    { "mm", "--" },     { "cm", "," },        { "pm", "->*" },
+		{ "pt", "->" },    { "cl", "()" },    { "ix", "[]" },     { "qu", "?" },
+	};
+
+	// ... builtin types by mangled letter, 0x0 for letters that are not builtin types ...
+	static const char* const CALLSTACK_DEMANGLE_BUILTINS[26] =
+	{
+		"signed char", "bool", "char", "double", "long double", "float", "__float128", "unsigned char", "int", "unsigned int",
+		0x0, "long", "unsigned long", "__int128", "unsigned __int128", 0x0, 0x0, 0x0, "short", "unsigned short",
+		0x0, "void", "wchar_t", "long long", "unsigned long long", "...",
+	};
+
+	// ... builtin types starting with D by the second letter ...
+	static const char* const CALLSTACK_DEMANGLE_D_BUILTINS[26] =
+	{
+		"auto", 0x0, "decltype(auto)", "decimal64", "decimal128", "decimal32", 0x0, "half", "char32_t", 0x0,
+		0x0, 0x0, 0x0, "decltype(nullptr)", 0x0, 0x0, 0x0, 0x0, "char16_t", 0x0,
+		"char8_t", 0x0, 0x0, 0x0, 0x0, 0x0,
+	};
+
+	typedef struct
+	{
+		char        code;
+		const char* name;
+		const char* full;      ///< name used in front of a constructor or destructor.
+		const char* full_args; ///< template-arguments of full.
+		const char* ctor;      ///< name of constructors and destructors.
+	} callstack_demangle_std_sub_t;
+
+	static const callstack_demangle_std_sub_t CALLSTACK_DEMANGLE_STD_SUBS[] =
+	{
+		{ 'a', "std::allocator",    "std::allocator",     "",                                                   "allocator" },
+		{ 'b', "std::basic_string", "std::basic_string",  "",                                                   "basic_string" },
+		{ 's', "std::string",       "std::basic_string",  "<char, std::char_traits<char>, std::allocator<char> >", "basic_string" },
+		{ 'i', "std::istream",      "std::basic_istream", "<char, std::char_traits<char> >",                    "basic_istream" },
+		{ 'o', "std::ostream",      "std::basic_ostream", "<char, std::char_traits<char> >",                    "basic_ostream" },
+		{ 'd', "std::iostream",     "std::basic_iostream", "<char, std::char_traits<char> >",                   "basic_iostream" },
+	};
+
+	static void demangle_type( callstack_demangle_t* d );
+	static void demangle_name( callstack_demangle_t* d, callstack_demangle_name_t* info, int top );
+	static void demangle_encoding( callstack_demangle_t* d, int top, int with_return );
+	static void demangle_template_arg( callstack_demangle_t* d );
+	static void demangle_prefix( callstack_demangle_t* d, const char* stop, callstack_demangle_name_t* info, int top );
+
+	static void demangle_fail( callstack_demangle_t* d )
+	{
+		if( d->status == CALLSTACK_DEMANGLE_OK )
+			d->status = CALLSTACK_DEMANGLE_UNSUPPORTED;
+	}
+
+	static void demangle_append( callstack_demangle_t* d, const char* str, size_t len )
+	{
+		if( d->quiet > 0 || d->status != CALLSTACK_DEMANGLE_OK )
+			return;
+		if( d->len + len >= d->cap )
+		{
+			d->status = CALLSTACK_DEMANGLE_NO_SPACE;
+			return;
 		}
+		memcpy( d->out + d->len, str, len );
+		d->len += len;
+	}
 
-		fclose(maps);
+	static void demangle_puts( callstack_demangle_t* d, const char* str )
+	{
+		demangle_append( d, str, strlen( str ) );
+	}
 
-		return first;
+	static void demangle_put_number( callstack_demangle_t* d, size_t n )
+	{
+		char   buf[24];
+		size_t pos = sizeof(buf);
+		do
+		{
+			buf[--pos] = (char)( '0' + n % 10 );
+			n /= 10;
+		} while( n > 0 );
+		demangle_append( d, buf + pos, sizeof(buf) - pos );
 	}
 
-	static void mmap_free(mmap_entry_t *mmap)
+	// ... abi::__cxa_demangle() still sees the space of a dropped ", " as the last char, "A<B<int>>" if followed by an empty pack ...
+	static char demangle_last_char( callstack_demangle_t* d )
 	{
-		while(mmap){
-			mmap_entry_t *tmp = mmap->next;
-			free(mmap);
-			mmap = tmp;
+		if( d->quiet > 0 || d->len == 0 )
+			return '\0';
+		return d->len == d->dropped_at ? ' ' : d->out[d->len - 1];
+	}
+
+	/**
+	 * Drop the ", " written in front of empty pack-expansions at the end of a list, keep is where the last element that
+	 * wrote something ended. Like abi::__cxa_demangle() only trailing ones are dropped, "f<, int>(int, , int)".
+	 */
+	static void demangle_drop_separators( callstack_demangle_t* d, size_t keep )
+	{
+		if( d->len == keep )
+			return;
+		d->len        = keep;
+		d->dropped_at = keep;
+	}
+
+	// ... character after the current one, never reads past the end of the name ...
+	static char demangle_peek1( callstack_demangle_t* d )
+	{
+		return d->p[0] != '\0' ? d->p[1] : '\0';
+	}
+
+	static int demangle_consume( callstack_demangle_t* d, char c )
+	{
+		if( *d->p != c )
+		{
+			demangle_fail( d );
+			return 0;
 		}
+		++d->p;
+		return 1;
 	}
 
-	static void *mmap_translate(mmap_entry_t *mmap, void *addr)
+	static int demangle_enter( callstack_demangle_t* d )
 	{
-		for(; mmap != NULL; mmap = mmap->next){
-			unsigned long addr_i = (unsigned long)addr;
-			if(addr_i >= mmap->range_start && addr_i <= mmap->range_end)
-				return (void*) (addr_i - mmap->range_start + mmap->file_offset);
+		if( d->status != CALLSTACK_DEMANGLE_OK )
+			return 0;
+		if( ++d->steps > CALLSTACK_DEMANGLE_MAX_STEPS || d->depth == CALLSTACK_DEMANGLE_MAX_DEPTH )
+		{
+			demangle_fail( d );
+			return 0;
 		}
+		++d->depth;
+		return 1;
+	}
 
-		return addr;
+	static size_t demangle_number( callstack_demangle_t* d )
+	{
+		if( *d->p < '0' || *d->p > '9' )
+		{
+			demangle_fail( d );
+			return 0;
+		}
+		size_t n = 0;
+		while( *d->p >= '0' && *d->p <= '9' && n < 0x1000000 )
+			n = n * 10 + (size_t)( *d->p++ - '0' );
+		return n;
 	}
 
-	static FILE* run_addr2line( void** addresses, int num_addresses, char* tmp_buffer, size_t tmp_buf_len )
+	// ... [<number>] _ as used by discriminators and template-parameters, returns 0 for a lone _ and number + 1 otherwise ...
+	static size_t demangle_index( callstack_demangle_t* d )
 	{
-		mmap_entry_t* list = is_using_pie() 
-								? parse_mmaps("/proc/self/maps")
-								: 0x0;
+		size_t index = *d->p == '_' ? 0 : demangle_number( d ) + 1;
+		demangle_consume( d, '_' );
+		return index;
+	}
+
+	static void demangle_add_sub_range( callstack_demangle_t* d, const char* begin, const char* end, int kind )
+	{
+		if( d->no_subs > 0 || d->status != CALLSTACK_DEMANGLE_OK )
+			return;
+		if( d->num_subs == CALLSTACK_DEMANGLE_MAX_SUBS )
+		{
+			demangle_fail( d );
+			return;
+		}
+		d->subs[d->num_subs].begin = (uint32_t)( begin - d->name );
+		d->subs[d->num_subs].end   = (uint32_t)( end - d->name );
+		d->sub_kind[d->num_subs]   = (uint8_t)kind;
+		d->sub_encoding[d->num_subs] = (uint8_t)d->encoding;
+		++d->num_subs;
+	}
 
-		size_t start = (size_t)snprintf( tmp_buffer, tmp_buf_len, "addr2line -e /proc/%u/exe", getpid() );
-		for( int i = 0; i < num_addresses; ++i ){
-			// Translate addresses out of potentially ASLR'd VMA space
-			void *addr = mmap_translate(list, addresses[i]);
+	static void demangle_add_sub( callstack_demangle_t* d, const char* begin, int kind )
+	{
+		demangle_add_sub_range( d, begin, d->p, kind );
+	}
 
-			start += (size_t)snprintf( tmp_buffer + start, tmp_buf_len - start, " %p", addr );
+	// ... parse a range of the name again, at its original position, without recording anything ...
+	static void demangle_reparse( callstack_demangle_t* d, callstack_demangle_range_t range, int kind )
+	{
+		// ... like abi::__cxa_demangle() a constructor is named by the last name parsed in place, not by one repeated from a substitution ...
+		const char* p         = d->p;
+		const char* end       = d->name + range.end;
+		const char* last_name = d->last_name;
+		size_t      last_len  = d->last_name_len;
+		d->p = d->name + range.begin;
+		++d->no_subs;
+		switch( kind )
+		{
+			case CALLSTACK_DEMANGLE_SUB_TYPE:   demangle_type( d ); break;
+			case CALLSTACK_DEMANGLE_SUB_PREFIX: demangle_prefix( d, end, 0x0, 0 ); break;
+			default:                            demangle_template_arg( d ); break;
 		}
+		if( d->p != end )
+			demangle_fail( d );
+		--d->no_subs;
+		d->p             = p;
+		d->last_name     = last_name;
+		d->last_name_len = last_len;
+	}
 
-		mmap_free(list);
+	// ... enter an encoding nested in the name, its template-arguments are recorded after the ones of the encodings outside it ...
+	static callstack_demangle_scope_t demangle_push_encoding( callstack_demangle_t* d )
+	{
+		callstack_demangle_scope_t scope;
+		scope.args_base = d->args_base;
+		scope.num_args  = d->num_args;
+		scope.encoding  = d->encoding;
+		if( d->num_encodings == 255 )
+			demangle_fail( d );
+		d->args_base = d->num_args;
+		d->encoding  = ++d->num_encodings;
+		return scope;
+	}
 
-		return popen( tmp_buffer, "r" );
+	static void demangle_pop_encoding( callstack_demangle_t* d, callstack_demangle_scope_t scope )
+	{
+		d->args_base = scope.args_base;
+		d->num_args  = scope.num_args;
+		d->encoding  = scope.encoding;
 	}
-#elif defined(__APPLE__) && defined(__MACH__)
-	static FILE* run_addr2line( void** addresses, int num_addresses, char* tmp_buffer, size_t tmp_buf_len )
+
+	static void demangle_source_name( callstack_demangle_t* d )
 	{
-		size_t start = (size_t)snprintf( tmp_buffer, tmp_buf_len, "xcrun atos -p %u -l", getpid() );
-		for( int i = 0; i < num_addresses; ++i )
-			start += (size_t)snprintf( tmp_buffer + start, tmp_buf_len - start, " %p", addresses[i] );
+		size_t len = demangle_number( d );
+		if( d->status != CALLSTACK_DEMANGLE_OK )
+			return;
+		if( len == 0 || strnlen( d->p, len ) < len )
+		{
+			demangle_fail( d );
+			return;
+		}
 
-		return popen( tmp_buffer, "r" );
+		const char* name = d->p;
+		d->p += len;
+		if( len >= 10 && memcmp( name, "_GLOBAL_", 8 ) == 0 && ( name[8] == '.' || name[8] == '_' || name[8] == '$' ) && name[9] == 'N' )
+			demangle_puts( d, "(anonymous namespace)" );
+		else
+			demangle_append( d, name, len );
+		d->last_name     = name;
+		d->last_name_len = len;
 	}
-#else
-#   error "Unhandled platform"
-#endif
 
+	static void demangle_abi_tags( callstack_demangle_t* d )
+	{
+		while( *d->p == 'B' && d->status == CALLSTACK_DEMANGLE_OK )
+		{
+			++d->p;
+			size_t len = demangle_number( d );
+			if( d->status != CALLSTACK_DEMANGLE_OK || strnlen( d->p, len ) < len )
+			{
+				demangle_fail( d );
+				return;
+			}
+			demangle_puts( d, "[abi:" );
+			demangle_append( d, d->p, len );
+			demangle_puts( d, "]" );
+			d->p += len;
+		}
+	}
 
-	static char* demangle_symbol( char* symbol, char* buffer, size_t buffer_size )
+	// ... ( <type> | v ) up to the E ending a function-type or lambda or the end of an encoding, written as "(a, b)" ...
+	static void demangle_function_params( callstack_demangle_t* d )
 	{
-		int status;
-		char* demangled_symbol = abi::__cxa_demangle( symbol, buffer, &buffer_size, &status );
-		return status != 0 ? symbol : demangled_symbol;
+		demangle_puts( d, "(" );
+		if( *d->p == 'v' )
+			++d->p;
+		else
+		{
+			size_t keep  = d->len;
+			int    first = 1;
+			while( d->status == CALLSTACK_DEMANGLE_OK && *d->p != '\0' && *d->p != 'E' && *d->p != '.' )
+			{
+				if( ( *d->p == 'R' || *d->p == 'O' ) && demangle_peek1( d ) == 'E' )
+					break; // ... ref-qualifier of a function-type ...
+
+				if( !first )
+					demangle_puts( d, ", " );
+				size_t before = d->len;
+				demangle_type( d );
+				if( first || d->len != before )
+					keep = d->len;
+				first = 0;
+			}
+			demangle_drop_separators( d, keep );
+		}
+		demangle_puts( d, ")" );
 	}
 
-	int callstack_symbols( void** addresses, callstack_symbol_t* out_syms, int num_addresses, char* memory, int mem_size )
+	// ... I <template-arg>+ E, args are remembered for T_ if these are the arguments of the entity being demangled ...
+	static void demangle_template_args( callstack_demangle_t* d, int top )
+	{
+		if( !demangle_consume( d, 'I' ) )
+			return;
+
+		if( top )
+			d->num_args = d->args_base;
+
+		// ... names in the arguments must not become the name of a constructor following them ...
+		const char* last_name     = d->last_name;
+		size_t      last_name_len = d->last_name_len;
+
+		if( d->short_names )
+			++d->quiet;
+		if( demangle_last_char( d ) == '<' )
+			demangle_puts( d, " " );
+		demangle_puts( d, "<" );
+
+		size_t keep  = d->len;
+		int    first = 1;
+		while( d->status == CALLSTACK_DEMANGLE_OK && *d->p != 'E' )
+		{
+			if( !first )
+				demangle_puts( d, ", " );
+			size_t before = d->len;
+			const char* begin = d->p;
+			demangle_template_arg( d );
+			if( first || d->len != before )
+				keep = d->len;
+			first = 0;
+
+			if( top )
+			{
+				if( d->num_args == CALLSTACK_DEMANGLE_MAX_ARGS )
+				{
+					demangle_fail( d );
+					break;
+				}
+				d->args[d->num_args].begin = (uint32_t)( begin - d->name );
+				d->args[d->num_args].end   = (uint32_t)( d->p - d->name );
+				++d->num_args;
+			}
+		}
+		demangle_consume( d, 'E' );
+		demangle_drop_separators( d, keep );
+
+		if( demangle_last_char( d ) == '>' )
+			demangle_puts( d, " " );
+		demangle_puts( d, ">" );
+		if( d->short_names )
+			--d->quiet;
+		d->last_name     = last_name;
+		d->last_name_len = last_name_len;
+	}
+
+	// ... L <type> <value> E, L _Z <encoding> E ...
+	static void demangle_literal( callstack_demangle_t* d )
+	{
+		++d->p;
+		if( *d->p == 'Z' || ( *d->p == '_' && demangle_peek1( d ) == 'Z' ) )
+		{
+			d->p += *d->p == 'Z' ? 1 : 2;
+			callstack_demangle_scope_t scope = demangle_push_encoding( d );
+			demangle_encoding( d, 1, 1 );
+			demangle_pop_encoding( d, scope );
+			demangle_consume( d, 'E' );
+			return;
+		}
+
+		const char* suffix = 0x0;
+		switch( *d->p )
+		{
+			case 'i': suffix = "";    break;
+			case 'j': suffix = "u";   break;
+			case 'l': suffix = "l";   break;
+			case 'm': suffix = "ul";  break;
+			case 'x': suffix = "ll";  break;
+			case 'y': suffix = "ull"; break;
+			case 'b':
+				if( ( d->p[1] == '0' || d->p[1] == '1' ) && d->p[2] == 'E' )
+				{
+					demangle_puts( d, d->p[1] == '1' ? "true" : "false" );
+					d->p += 3;
+					return;
+				}
+				break;
+			// ... floating-point values are hex-encoded and nullptr has no value, leave those to abi::__cxa_demangle() ...
+			case 'f': case 'd': case 'e': case 'g': case 'D':
+				demangle_fail( d );
+				return;
+		}
+
+		if( suffix )
+			++d->p;
+		else
+		{
+			demangle_puts( d, "(" );
+			demangle_type( d );
+			demangle_puts( d, ")" );
+		}
+
+		if( *d->p == 'n' )
+		{
+			++d->p;
+			demangle_puts( d, "-" );
+		}
+		const char* value = d->p;
+		while( *d->p >= '0' && *d->p <= '9' )
+			++d->p;
+		if( d->p == value )
+		{
+			demangle_fail( d );
+			return;
+		}
+		demangle_append( d, value, (size_t)( d->p - value ) );
+		if( suffix )
+			demangle_puts( d, suffix );
+		demangle_consume( d, 'E' );
+	}
+
+	static void demangle_template_arg( callstack_demangle_t* d )
+	{
+		switch( *d->p )
+		{
+			case 'L':
+				demangle_literal( d );
+				break;
+			case 'J':
+			{
+				++d->p;
+				size_t keep  = d->len;
+				int    first = 1;
+				while( d->status == CALLSTACK_DEMANGLE_OK && *d->p != 'E' )
+				{
+					if( !first )
+						demangle_puts( d, ", " );
+					size_t before = d->len;
+					demangle_template_arg( d );
+					if( first || d->len != before )
+						keep = d->len;
+					first = 0;
+				}
+				demangle_consume( d, 'E' );
+				demangle_drop_separators( d, keep );
+				break;
+			}
+			case 'X':
+				demangle_fail( d ); // ... expressions ...
+				break;
+			default:
+				demangle_type( d );
+				break;
+		}
+	}
+
+	// ... print an argument-pack, only the element of the current pack-expansion if in one ...
+	static void demangle_pack( callstack_demangle_t* d, callstack_demangle_range_t pack )
+	{
+		const char* p = d->p;
+		d->p = d->name + pack.begin + 1;
+		++d->no_subs;
+
+		int num     = 0;
+		int printed = 0;
+		while( d->status == CALLSTACK_DEMANGLE_OK && *d->p != 'E' )
+		{
+			int show = d->pack_index < 0 || d->pack_index == num;
+			if( !show )
+				++d->quiet;
+			else if( printed )
+				demangle_puts( d, ", " );
+			demangle_template_arg( d );
+			if( !show )
+				--d->quiet;
+			printed |= show;
+			++num;
+		}
+
+		--d->no_subs;
+		d->p = p;
+		if( d->pack_size < 0 )
+			d->pack_size = num;
+	}
+
+	// ... T_ or T <number> _ ...
+	static void demangle_template_param( callstack_demangle_t* d )
+	{
+		++d->p;
+		size_t index = demangle_index( d );
+		if( d->status != CALLSTACK_DEMANGLE_OK )
+			return;
+
+		if( d->in_lambda > 0 )
+		{
+			demangle_puts( d, "auto:" );
+			demangle_put_number( d, index + 1 );
+			return;
+		}
+		index += (size_t)d->args_base;
+		if( index >= (size_t)d->num_args || d->foreign > 0 )
+		{
+			demangle_fail( d );
+			return;
+		}
+
+		callstack_demangle_range_t arg = d->args[index];
+		if( d->name[arg.begin] == 'J' )
+			demangle_pack( d, arg );
+		else
+			demangle_reparse( d, arg, CALLSTACK_DEMANGLE_SUB_ARG );
+	}
+
+	// ... S_, S <seq-id> _ or one of the std-abbreviations, a substitution in front of a constructor is written in full ...
+	static void demangle_substitution( callstack_demangle_t* d, int in_prefix )
+	{
+		++d->p;
+		for( size_t i = 0; i < sizeof(CALLSTACK_DEMANGLE_STD_SUBS) / sizeof(CALLSTACK_DEMANGLE_STD_SUBS[0]); ++i )
+		{
+			const callstack_demangle_std_sub_t* sub = &CALLSTACK_DEMANGLE_STD_SUBS[i];
+			if( *d->p != sub->code )
+				continue;
+
+			++d->p;
+			if( in_prefix && ( *d->p == 'C' || *d->p == 'D' ) )
+			{
+				demangle_puts( d, sub->full );
+				if( !d->short_names )
+					demangle_puts( d, sub->full_args );
+			}
+			else
+				demangle_puts( d, sub->name );
+			d->last_name     = sub->ctor;
+			d->last_name_len = strlen( sub->ctor );
+			return;
+		}
+
+		size_t index = 0;
+		if( *d->p != '_' )
+		{
+			for( ; ( *d->p >= '0' && *d->p <= '9' ) || ( *d->p >= 'A' && *d->p <= 'Z' ); ++d->p )
+				index = index * 36 + (size_t)( *d->p <= '9' ? *d->p - '0' : *d->p - 'A' + 10 );
+			++index;
+		}
+		if( !demangle_consume( d, '_' ) )
+			return;
+		if( index >= (size_t)d->num_subs )
+		{
+			demangle_fail( d );
+			return;
+		}
+		// ... T_ in a substitution from a nested encoding are written differently by abi::__cxa_demangle(), leave those to it ...
+		int foreign = d->sub_encoding[index] != d->encoding;
+		d->foreign += foreign;
+		demangle_reparse( d, d->subs[index], d->sub_kind[index] );
+		d->foreign -= foreign;
+	}
+
+	static void demangle_print_mod( callstack_demangle_t* d, const callstack_demangle_mod_t* mod )
+	{
+		switch( mod->kind )
+		{
+			case 'P': demangle_puts( d, "*" );         break;
+			case 'R': demangle_puts( d, "&" );         break;
+			case 'O': demangle_puts( d, "&&" );        break;
+			case 'K': demangle_puts( d, " const" );    break;
+			case 'V': demangle_puts( d, " volatile" ); break;
+			case 'r': demangle_puts( d, " restrict" ); break;
+			case 'M':
+				if( demangle_last_char( d ) != '(' )
+					demangle_puts( d, " " );
+				demangle_reparse( d, mod->cls, CALLSTACK_DEMANGLE_SUB_TYPE );
+				demangle_puts( d, "::*" );
+				break;
+		}
+	}
+
+	// ... a returned pointer to function or array wraps what it is returned from, "void (*f<int>())(int)", leave those to abi::__cxa_demangle() ...
+	static int demangle_returns_declarator( callstack_demangle_t* d )
+	{
+		const char* p = d->p;
+		while( *p != '\0' && strchr( "rVKPRO", *p ) )
+			++p;
+		return ( p != d->p && ( *p == 'F' || *p == 'A' ) ) || *p == 'M';
+	}
+
+	// ... F [Y] <return-type> <params> [<ref-qualifier>] E, declarators go between the return-type and params, "void (*)(int)" ...
+	static void demangle_function_type( callstack_demangle_t* d, const callstack_demangle_mod_t* mods, int num_decls, int num_mods )
+	{
+		const char* start = d->p;
+		++d->p;
+		if( *d->p == 'Y' )
+			++d->p;
+
+		if( demangle_returns_declarator( d ) )
+			demangle_fail( d );
+		demangle_type( d );
+		if( num_decls > 0 )
+		{
+			demangle_puts( d, " (" );
+			for( int i = num_decls - 1; i >= 0; --i )
+				demangle_print_mod( d, &mods[i] );
+			demangle_puts( d, ")" );
+		}
+		else
+			demangle_puts( d, " " );
+		demangle_function_params( d );
+
+		char ref = 0;
+		if( *d->p == 'R' || *d->p == 'O' )
+			ref = *d->p++;
+		demangle_consume( d, 'E' );
+
+		// ... cv-qualifiers directly in front of the function-type are the ones of the function ...
+		for( int i = num_mods - 1; i >= num_decls; --i )
+			demangle_print_mod( d, &mods[i] );
+		if( ref )
+			demangle_puts( d, ref == 'R' ? " &" : " &&" );
+
+		// ... a function-type with cv-qualifiers is only a substitution together with them ...
+		if( num_mods == num_decls )
+			demangle_add_sub( d, start, CALLSTACK_DEMANGLE_SUB_TYPE );
+	}
+
+	// ... A <dimension> _ <element-type>, all dimensions are written after the element-type, "int (*) [2][3]" ...
+	static void demangle_array_type( callstack_demangle_t* d, const callstack_demangle_mod_t* mods, int num_mods )
+	{
+		const char*                starts[CALLSTACK_DEMANGLE_MAX_DIMS];
+		callstack_demangle_range_t dims[CALLSTACK_DEMANGLE_MAX_DIMS];
+		int num_dims = 0;
+		while( *d->p == 'A' && d->status == CALLSTACK_DEMANGLE_OK )
+		{
+			if( num_dims == CALLSTACK_DEMANGLE_MAX_DIMS )
+			{
+				demangle_fail( d );
+				return;
+			}
+			starts[num_dims] = d->p++;
+			dims[num_dims].begin = (uint32_t)( d->p - d->name );
+			while( *d->p >= '0' && *d->p <= '9' )
+				++d->p;
+			dims[num_dims].end = (uint32_t)( d->p - d->name );
+			demangle_consume( d, '_' );
+			++num_dims;
+		}
+
+		// ... cv-qualifiers of an array are the ones of its elements, "char const (&) [3]" ...
+		int num_decls = num_mods;
+		while( num_decls > 0 && strchr( "rVK", mods[num_decls - 1].kind ) )
+			--num_decls;
+
+		demangle_type( d );
+		for( int i = num_mods - 1; i >= num_decls; --i )
+			demangle_print_mod( d, &mods[i] );
+		if( num_decls > 0 )
+		{
+			demangle_puts( d, " (" );
+			for( int i = num_decls - 1; i >= 0; --i )
+				demangle_print_mod( d, &mods[i] );
+			demangle_puts( d, ") " );
+		}
+		else
+			demangle_puts( d, " " );
+
+		for( int i = 0; i < num_dims; ++i )
+		{
+			demangle_puts( d, "[" );
+			demangle_append( d, d->name + dims[i].begin, dims[i].end - dims[i].begin );
+			demangle_puts( d, "]" );
+		}
+		for( int i = num_dims - 1; i >= 0; --i )
+			demangle_add_sub( d, starts[i], CALLSTACK_DEMANGLE_SUB_TYPE );
+	}
+
+	// ... skip the template-argument at p without writing or recording anything, returns where it ends ...
+	static const char* demangle_skip_arg( callstack_demangle_t* d, const char* p )
+	{
+		const char* pos       = d->p;
+		int         pack_size = d->pack_size;
+		d->p = p;
+		++d->quiet;
+		++d->no_subs;
+		demangle_template_arg( d );
+		--d->no_subs;
+		--d->quiet;
+		p = d->p;
+		d->p         = pos;
+		d->pack_size = pack_size;
+		return p;
+	}
+
+	/**
+	 * Type a T_ or S_ at p stands for, 0x0 if p is neither or it is followed by template-arguments. end is set to
+	 * where the T_ or S_ ends. A T_ referring to an argument-pack stands for the element of the current
+	 * pack-expansion, or the only element outside of one.
+	 */
+	static const char* demangle_resolve( callstack_demangle_t* d, const char* p, const char** end )
+	{
+		size_t index = 0;
+		if( p[0] == 'T' && ( p[1] == '_' || ( p[1] >= '0' && p[1] <= '9' ) ) )
+		{
+			for( ++p; *p >= '0' && *p <= '9'; ++p )
+				index = index * 10 + (size_t)( *p - '0' );
+			if( p[-1] != 'T' )
+				++index;
+			index += (size_t)d->args_base;
+			if( *p++ != '_' || *p == 'I' || d->in_lambda > 0 || index >= (size_t)d->num_args || d->foreign > 0 )
+				return 0x0;
+			*end = p;
+
+			const char* arg = d->name + d->args[index].begin;
+			if( *arg != 'J' )
+				return arg;
+
+			const char* elem = 0x0;
+			int num = 0;
+			for( ++arg; *arg != 'E' && d->status == CALLSTACK_DEMANGLE_OK; ++num )
+			{
+				if( num == ( d->pack_index < 0 ? 0 : d->pack_index ) )
+					elem = arg;
+				arg = demangle_skip_arg( d, arg );
+			}
+			if( d->pack_size < 0 )
+				d->pack_size = num;
+			return d->pack_index < 0 && num != 1 ? 0x0 : elem;
+		}
+
+		if( p[0] != 'S' || p[1] == 't' || ( p[1] >= 'a' && p[1] <= 'z' ) )
+			return 0x0;
+		if( *++p != '_' )
+		{
+			for( ; ( *p >= '0' && *p <= '9' ) || ( *p >= 'A' && *p <= 'Z' ); ++p )
+				index = index * 36 + (size_t)( *p <= '9' ? *p - '0' : *p - 'A' + 10 );
+			++index;
+		}
+		if( *p++ != '_' || *p == 'I' || index >= (size_t)d->num_subs || d->sub_kind[index] != CALLSTACK_DEMANGLE_SUB_TYPE )
+			return 0x0;
+		*end = p;
+		return d->name + d->subs[index].begin;
+	}
+
+	/**
+	 * Pointers, references, cv-qualifiers and pointers-to-members in front of a type, written after it in reverse.
+	 *
+	 * If the type is a T_ or S_ standing for a type that has a declarator itself parsing continues there, so that
+	 * "T*" with T = int() becomes "int (*)()" and references to references collapse, "T&&" with T = int& is int&.
+	 */
+	static void demangle_declarator_type( callstack_demangle_t* d )
+	{
+		callstack_demangle_mod_t mods[CALLSTACK_DEMANGLE_MAX_MODS];
+		int         num_mods  = 0;
+		int         num_outer = 0;   ///< mods in front of the T_ or S_ parsing continued from.
+		const char* token     = 0x0; ///< the T_ or S_ parsing continued from.
+		const char* resume    = 0x0; ///< end of token.
+		for( int hops = 0; d->status == CALLSTACK_DEMANGLE_OK; ++hops )
+		{
+			while( d->status == CALLSTACK_DEMANGLE_OK && *d->p != '\0' && strchr( "rVKPROM", *d->p ) )
+			{
+				char kind = *d->p;
+				if( ( kind == 'R' || kind == 'O' ) && num_mods > 0 && ( mods[num_mods - 1].kind == 'R' || mods[num_mods - 1].kind == 'O' ) )
+				{
+					if( kind == 'R' )
+						mods[num_mods - 1].kind = 'R';
+					++d->p;
+					continue;
+				}
+				// ... a qualifier the type already has is not repeated, "T const" with T = int const is int const ...
+				int dup = 0;
+				for( int i = num_mods - 1; i >= 0 && strchr( "rVK", mods[i].kind ) && !dup; --i )
+					dup = mods[i].kind == kind;
+				if( dup )
+				{
+					++d->p;
+					continue;
+				}
+				if( num_mods == CALLSTACK_DEMANGLE_MAX_MODS )
+				{
+					demangle_fail( d );
+					break;
+				}
+				callstack_demangle_mod_t* mod = &mods[num_mods++];
+				mod->kind = kind;
+				mod->pos  = d->p++;
+				if( mod->kind == 'M' )
+				{
+					mod->cls.begin = (uint32_t)( d->p - d->name );
+					++d->quiet;
+					demangle_type( d );
+					--d->quiet;
+					mod->cls.end = (uint32_t)( d->p - d->name );
+				}
+			}
+
+			const char* end    = 0x0;
+			const char* target = demangle_resolve( d, d->p, &end );
+			for( int i = 0; target != 0x0 && ( *target == 'T' || *target == 'S' ) && i < CALLSTACK_DEMANGLE_MAX_MODS; ++i )
+			{
+				const char* ignore;
+				const char* next = demangle_resolve( d, target, &ignore );
+				if( next == 0x0 )
+					break;
+				target = next;
+			}
+			if( target == 0x0 || strchr( "rVKPROMFA", *target ) == 0x0 || hops == CALLSTACK_DEMANGLE_MAX_MODS )
+				break;
+
+			if( resume == 0x0 )
+			{
+				token     = d->p;
+				resume    = end;
+				num_outer = num_mods;
+				++d->no_subs;
+			}
+			d->p = target;
+		}
+
+		if( d->status == CALLSTACK_DEMANGLE_OK )
+		{
+			if( *d->p == 'F' )
+			{
+				int num_decls = num_mods;
+				while( num_decls > 0 && strchr( "rVK", mods[num_decls - 1].kind ) )
+					--num_decls;
+				demangle_function_type( d, mods, num_decls, num_mods );
+			}
+			else if( *d->p == 'A' )
+				demangle_array_type( d, mods, num_mods );
+			else
+			{
+				demangle_type( d );
+				for( int i = num_mods - 1; i >= 0; --i )
+					demangle_print_mod( d, &mods[i] );
+			}
+		}
+
+		if( resume != 0x0 )
+		{
+			--d->no_subs;
+			d->p = resume;
+			if( *token == 'T' )
+				demangle_add_sub( d, token, CALLSTACK_DEMANGLE_SUB_TYPE );
+		}
+		else
+			num_outer = num_mods;
+		for( int i = num_outer - 1; i >= 0; --i )
+			demangle_add_sub( d, mods[i].pos, CALLSTACK_DEMANGLE_SUB_TYPE );
+	}
+
+	// ... Dp <type>, the pattern is written once per element of the argument-pack it refers to ...
+	static void demangle_pack_expansion( callstack_demangle_t* d )
+	{
+		const char* start = d->p;
+		d->p += 2;
+
+		if( d->pack_index >= 0 )
+		{
+			demangle_fail( d ); // ... nested expansions ...
+			return;
+		}
+
+		// ... parse once to record substitutions and find the size of the pack ...
+		callstack_demangle_range_t pattern;
+		pattern.begin = (uint32_t)( d->p - d->name );
+		int pack_size = d->pack_size;
+		d->pack_size = -1;
+		++d->quiet;
+		demangle_type( d );
+		--d->quiet;
+		pattern.end = (uint32_t)( d->p - d->name );
+
+		int num = d->pack_size < 0 ? 1 : d->pack_size;
+		int has_pack = d->pack_size >= 0;
+		for( int i = 0; i < num; ++i )
+		{
+			if( i > 0 )
+				demangle_puts( d, ", " );
+			d->pack_index = has_pack ? i : -1;
+			demangle_reparse( d, pattern, CALLSTACK_DEMANGLE_SUB_TYPE );
+		}
+		d->pack_index = -1;
+		d->pack_size  = pack_size;
+		demangle_add_sub( d, start, CALLSTACK_DEMANGLE_SUB_TYPE );
+	}
+
+	static void demangle_type( callstack_demangle_t* d )
+	{
+		if( !demangle_enter( d ) )
+			return;
+
+		const char* start = d->p;
+		char c  = *d->p;
+		char c1 = demangle_peek1( d );
+		callstack_demangle_name_t info;
+		memset( &info, 0x0, sizeof(info) );
+
+		if( c >= 'a' && c <= 'z' && CALLSTACK_DEMANGLE_BUILTINS[c - 'a'] )
+		{
+			demangle_puts( d, CALLSTACK_DEMANGLE_BUILTINS[c - 'a'] );
+			++d->p;
+		}
+		else if( c == 'u' )
+		{
+			++d->p;
+			demangle_source_name( d );
+			demangle_add_sub( d, start, CALLSTACK_DEMANGLE_SUB_TYPE );
+		}
+		else if( c == 'D' && c1 >= 'a' && c1 <= 'z' && CALLSTACK_DEMANGLE_D_BUILTINS[c1 - 'a'] )
+		{
+			demangle_puts( d, CALLSTACK_DEMANGLE_D_BUILTINS[c1 - 'a'] );
+			d->p += 2;
+		}
+		else if( c == 'D' && c1 == 'F' )
+		{
+			d->p += 2;
+			size_t bits = demangle_number( d );
+			if( demangle_consume( d, '_' ) )
+			{
+				demangle_puts( d, "_Float" );
+				demangle_put_number( d, bits );
+			}
+		}
+		else if( c == 'D' && c1 == 'p' )
+			demangle_pack_expansion( d );
+		else if( c != '\0' && strchr( "rVKPROMFA", c ) )
+			demangle_declarator_type( d );
+		else if( c == 'T' && ( c1 == 's' || c1 == 'u' || c1 == 'e' ) )
+		{
+			d->p += 2;
+			demangle_name( d, &info, 0 );
+			demangle_add_sub( d, start, CALLSTACK_DEMANGLE_SUB_TYPE );
+		}
+		else if( c == 'T' )
+		{
+			demangle_template_param( d );
+			demangle_add_sub( d, start, CALLSTACK_DEMANGLE_SUB_TYPE );
+			if( *d->p == 'I' )
+			{
+				demangle_template_args( d, 0 );
+				demangle_add_sub( d, start, CALLSTACK_DEMANGLE_SUB_TYPE );
+			}
+		}
+		else if( c == 'S' && c1 != 't' )
+		{
+			demangle_substitution( d, 0 );
+			if( *d->p == 'I' )
+			{
+				demangle_template_args( d, 0 );
+				demangle_add_sub( d, start, CALLSTACK_DEMANGLE_SUB_TYPE );
+			}
+		}
+		else if( c == 'N' || c == 'Z' || c == 'S' || ( c >= '0' && c <= '9' ) )
+		{
+			demangle_name( d, &info, 0 );
+			demangle_add_sub( d, start, CALLSTACK_DEMANGLE_SUB_TYPE );
+		}
+		else
+			demangle_fail( d );
+
+		--d->depth;
+	}
+
+	static void demangle_operator_name( callstack_demangle_t* d, callstack_demangle_name_t* info )
+	{
+		char c  = d->p[0];
+		char c1 = demangle_peek1( d );
+		if( c == 'c' && c1 == 'v' )
+		{
+			d->p += 2;
+			// ... the type of a templated conversion-operator may refer to arguments that follow it ...
+			if( *d->p == 'T' )
+			{
+				demangle_fail( d );
+				return;
+			}
+			demangle_puts( d, "operator " );
+			demangle_type( d );
+			info->no_return = 1;
+			return;
+		}
+		if( c == 'l' && c1 == 'i' )
+		{
+			d->p += 2;
+			demangle_puts( d, "operator\"\" " );
+			demangle_source_name( d );
+			return;
+		}
+		if( c == 'v' && c1 >= '0' && c1 <= '9' )
+		{
+			d->p += 2;
+			demangle_puts( d, "operator " );
+			demangle_source_name( d );
+			return;
+		}
+
+		for( size_t i = 0; i < sizeof(CALLSTACK_DEMANGLE_OPERATORS) / sizeof(CALLSTACK_DEMANGLE_OPERATORS[0]); ++i )
+		{
+			const callstack_demangle_operator_t* op = &CALLSTACK_DEMANGLE_OPERATORS[i];
+			if( op->code[0] != c || op->code[1] != c1 )
+				continue;
+			d->p += 2;
+			demangle_puts( d, "operator" );
+			if( op->name[0] >= 'a' && op->name[0] <= 'z' )
+				demangle_puts( d, " " );
+			demangle_puts( d, op->name );
+			return;
+		}
+		demangle_fail( d );
+	}
+
+	// ... one component of a name, returns 1 if the prefix ending with it is a substitution-candidate ...
+	static int demangle_unqualified_name( callstack_demangle_t* d, callstack_demangle_name_t* info, int in_prefix )
+	{
+		info->no_return = 0;
+		if( *d->p == 'L' )
+			++d->p; // ... internal linkage ...
+
+		char c  = d->p[0];
+		char c1 = demangle_peek1( d );
+		if( c >= '0' && c <= '9' )
+			demangle_source_name( d );
+		else if( c == 'S' && c1 == 't' && in_prefix )
+		{
+			d->p += 2;
+			demangle_puts( d, "std" );
+			return 0;
+		}
+		else if( c == 'S' && in_prefix )
+		{
+			demangle_substitution( d, 1 );
+			return 0;
+		}
+		else if( c == 'T' && in_prefix )
+			demangle_template_param( d );
+		else if( c == 'C' && c1 >= '1' && c1 <= '5' )
+		{
+			d->p += 2;
+			demangle_append( d, d->last_name, d->last_name_len );
+			info->no_return = 1;
+		}
+		else if( c == 'D' && ( c1 == '0' || c1 == '1' || c1 == '2' || c1 == '4' || c1 == '5' ) )
+		{
+			d->p += 2;
+			demangle_puts( d, "~" );
+			demangle_append( d, d->last_name, d->last_name_len );
+			info->no_return = 1;
+		}
+		else if( c == 'U' && c1 == 't' )
+		{
+			d->p += 2;
+			size_t index = demangle_index( d );
+			demangle_puts( d, "{unnamed type#" );
+			demangle_put_number( d, index + 1 );
+			demangle_puts( d, "}" );
+		}
+		else if( c == 'U' && c1 == 'l' )
+		{
+			d->p += 2;
+			if( *d->p == 'T' && strchr( "ynpt", demangle_peek1( d ) ) )
+			{
+				demangle_fail( d ); // ... explicit template-parameters of a lambda ...
+				return 0;
+			}
+			demangle_puts( d, "{lambda" );
+			++d->in_lambda;
+			demangle_function_params( d );
+			--d->in_lambda;
+			demangle_consume( d, 'E' );
+			size_t index = demangle_index( d );
+			demangle_puts( d, "#" );
+			demangle_put_number( d, index + 1 );
+			demangle_puts( d, "}" );
+		}
+		else if( c >= 'a' && c <= 'z' )
+			demangle_operator_name( d, info );
+		else
+		{
+			demangle_fail( d );
+			return 0;
+		}
+		demangle_abi_tags( d );
+		return 1;
+	}
+
+	/**
+	 * Components of a <prefix> up to stop, or up to the E ending a nested-name if stop is 0x0. If info is set
+	 * these are the components of a name and each prefix is recorded as a substitution, otherwise this is
+	 * re-parsing a substitution.
+	 */
+	static void demangle_prefix( callstack_demangle_t* d, const char* stop, callstack_demangle_name_t* info, int top )
+	{
+		callstack_demangle_name_t dummy;
+		memset( &dummy, 0x0, sizeof(dummy) );
+		if( info == 0x0 )
+			info = &dummy;
+
+		const char* start = d->p;
+		int first = 1;
+		while( d->status == CALLSTACK_DEMANGLE_OK && ( stop ? d->p < stop : *d->p != 'E' ) )
+		{
+			int record = 1;
+			if( *d->p == 'I' && !first )
+			{
+				demangle_template_args( d, top );
+				info->is_template = 1;
+			}
+			else if( *d->p == 'M' && !first )
+			{
+				++d->p; // ... closure in the initializer of a data-member, the member is already written ...
+				continue;
+			}
+			else
+			{
+				if( !first )
+					demangle_puts( d, "::" );
+				record = demangle_unqualified_name( d, info, 1 );
+				info->is_template = 0;
+			}
+			first = 0;
+			if( record && *d->p != 'E' )
+				demangle_add_sub( d, start, CALLSTACK_DEMANGLE_SUB_PREFIX );
+		}
+	}
+
+	// ... the <entity> [<discriminator>] of a local name, after the encoding it is in ...
+	static void demangle_local_entity( callstack_demangle_t* d, callstack_demangle_name_t* info, int top )
+	{
+		demangle_puts( d, "::" );
+		if( *d->p == 's' )
+		{
+			++d->p;
+			demangle_puts( d, "string literal" );
+		}
+		else if( *d->p == 'd' )
+		{
+			demangle_fail( d ); // ... default arguments ...
+			return;
+		}
+		else
+			demangle_name( d, info, top );
+
+		if( *d->p == '_' )
+		{
+			++d->p;
+			if( *d->p == '_' )
+			{
+				++d->p;
+				demangle_number( d );
+				demangle_consume( d, '_' );
+			}
+			else
+				demangle_number( d );
+		}
+	}
+
+	/**
+	 * Z <encoding> E <entity> [<discriminator>], T_ in the encoding refer to its own template-arguments. Those
+	 * stay visible after a local name that is the name being demangled, otherwise the ones outside are restored.
+	 */
+	static void demangle_local_name( callstack_demangle_t* d, callstack_demangle_name_t* info, int top )
+	{
+		callstack_demangle_scope_t scope;
+		if( !top )
+			scope = demangle_push_encoding( d );
+
+		++d->p;
+		demangle_encoding( d, 1, 0 );
+		if( demangle_consume( d, 'E' ) )
+			demangle_local_entity( d, info, top );
+
+		if( !top )
+			demangle_pop_encoding( d, scope );
+	}
+
+	static void demangle_name( callstack_demangle_t* d, callstack_demangle_name_t* info, int top )
+	{
+		if( !demangle_enter( d ) )
+			return;
+
+		const char* start = d->p;
+		if( *d->p == 'N' )
+		{
+			++d->p;
+			for( ;; ++d->p )
+			{
+				if( *d->p == 'r' )      info->cv |= 4;
+				else if( *d->p == 'V' ) info->cv |= 2;
+				else if( *d->p == 'K' ) info->cv |= 1;
+				else break;
+			}
+			if( *d->p == 'R' || *d->p == 'O' )
+				info->ref = *d->p++;
+			demangle_prefix( d, 0x0, info, top );
+			demangle_consume( d, 'E' );
+		}
+		else if( *d->p == 'Z' )
+			demangle_local_name( d, info, top );
+		else
+		{
+			if( *d->p == 'S' && demangle_peek1( d ) != 't' )
+			{
+				// ... a substituted template-name, must be followed by its arguments ...
+				demangle_substitution( d, 0 );
+				if( *d->p != 'I' )
+					demangle_fail( d );
+			}
+			else
+			{
+				if( *d->p == 'S' )
+				{
+					d->p += 2;
+					demangle_puts( d, "std::" );
+				}
+				demangle_unqualified_name( d, info, 0 );
+				if( *d->p == 'I' )
+					demangle_add_sub( d, start, CALLSTACK_DEMANGLE_SUB_PREFIX );
+			}
+
+			if( *d->p == 'I' )
+			{
+				demangle_template_args( d, top );
+				info->is_template = 1;
+			}
+		}
+
+		--d->depth;
+	}
+
+	// ... h <offset> _ or v <offset> _ <virtual offset> _ ...
+	static void demangle_call_offset( callstack_demangle_t* d )
+	{
+		char kind = *d->p++;
+		if( kind != 'h' && kind != 'v' )
+		{
+			demangle_fail( d );
+			return;
+		}
+		for( int i = 0; i < ( kind == 'h' ? 1 : 2 ); ++i )
+		{
+			if( *d->p == 'n' )
+				++d->p;
+			demangle_number( d );
+			demangle_consume( d, '_' );
+		}
+	}
+
+	static void demangle_special_name( callstack_demangle_t* d )
+	{
+		callstack_demangle_name_t info;
+		memset( &info, 0x0, sizeof(info) );
+
+		char c  = d->p[0];
+		char c1 = demangle_peek1( d );
+		d->p += 2;
+		if( c == 'G' && c1 == 'V' )
+		{
+			demangle_puts( d, "guard variable for " );
+			demangle_name( d, &info, 1 );
+			return;
+		}
+		if( c != 'T' )
+		{
+			demangle_fail( d );
+			return;
+		}
+
+		switch( c1 )
+		{
+			case 'V': demangle_puts( d, "vtable for " );        demangle_type( d ); break;
+			case 'T': demangle_puts( d, "VTT for " );           demangle_type( d ); break;
+			case 'I': demangle_puts( d, "typeinfo for " );      demangle_type( d ); break;
+			case 'S': demangle_puts( d, "typeinfo name for " ); demangle_type( d ); break;
+			case 'W': demangle_puts( d, "TLS wrapper function for " ); demangle_name( d, &info, 1 ); break;
+			case 'H': demangle_puts( d, "TLS init function for " );    demangle_name( d, &info, 1 ); break;
+			case 'h':
+			case 'v':
+				--d->p;
+				demangle_puts( d, c1 == 'h' ? "non-virtual thunk to " : "virtual thunk to " );
+				demangle_call_offset( d );
+				demangle_encoding( d, 1, 1 );
+				break;
+			case 'c':
+				demangle_puts( d, "covariant return thunk to " );
+				demangle_call_offset( d );
+				demangle_call_offset( d );
+				demangle_encoding( d, 1, 1 );
+				break;
+			case 'C':
+			{
+				// ... TC <derived type> <offset> _ <base type>, written as "base-in-derived" ...
+				callstack_demangle_range_t derived;
+				derived.begin = (uint32_t)( d->p - d->name );
+				++d->quiet;
+				demangle_type( d );
+				--d->quiet;
+				derived.end = (uint32_t)( d->p - d->name );
+				demangle_number( d );
+				demangle_consume( d, '_' );
+				demangle_puts( d, "construction vtable for " );
+				demangle_type( d );
+				demangle_puts( d, "-in-" );
+				demangle_reparse( d, derived, CALLSTACK_DEMANGLE_SUB_TYPE );
+				break;
+			}
+			default:
+				demangle_fail( d );
+				break;
+		}
+	}
+
+	static void demangle_reverse( char* str, size_t len )
+	{
+		for( size_t i = 0; i < len / 2; ++i )
+		{
+			char tmp = str[i];
+			str[i] = str[len - 1 - i];
+			str[len - 1 - i] = tmp;
+		}
+	}
+
+	/**
+	 * <name> [<bare-function-type>], function-templates have their return-type first in the parameters. The
+	 * return-type is not written for the function a local name is in, "f<int>()::x".
+	 */
+	static void demangle_encoding( callstack_demangle_t* d, int top, int with_return )
+	{
+		if( !demangle_enter( d ) )
+			return;
+
+		if( *d->p == 'T' || ( *d->p == 'G' && demangle_peek1( d ) == 'V' ) )
+		{
+			demangle_special_name( d );
+			--d->depth;
+			return;
+		}
+
+		callstack_demangle_name_t info;
+		memset( &info, 0x0, sizeof(info) );
+		size_t name_at = d->len;
+		demangle_name( d, &info, top );
+
+		char c = *d->p;
+		if( d->status == CALLSTACK_DEMANGLE_OK && c != '\0' && c != 'E' && c != '.' )
+		{
+			if( info.is_template && !info.no_return )
+			{
+				if( with_return && demangle_returns_declarator( d ) )
+					demangle_fail( d );
+
+				// ... the name is already written, write the return-type after it and rotate it into place ...
+				size_t ret_at = d->len;
+				int    hide   = d->short_names || !with_return;
+				if( hide )
+					++d->quiet;
+				demangle_type( d );
+				if( hide )
+					--d->quiet;
+				if( d->len != ret_at && d->status == CALLSTACK_DEMANGLE_OK )
+				{
+					demangle_puts( d, " " );
+					demangle_reverse( d->out + name_at, ret_at - name_at );
+					demangle_reverse( d->out + ret_at, d->len - ret_at );
+					demangle_reverse( d->out + name_at, d->len - name_at );
+				}
+			}
+
+			demangle_function_params( d );
+			if( info.cv & 1 ) demangle_puts( d, " const" );
+			if( info.cv & 2 ) demangle_puts( d, " volatile" );
+			if( info.cv & 4 ) demangle_puts( d, " restrict" );
+			if( info.ref )
+				demangle_puts( d, info.ref == 'R' ? " &" : " &&" );
+		}
+
+		--d->depth;
+	}
+
+	/**
+	 * Demangle name into out, returns the length of the demangled name, -1 if name is not a mangled name or
+	 * uses something that is not supported and -2 if out is too small.
+	 *
+	 * This never allocates or takes locks and is safe to call from a signal-handler.
+	 */
+	static int demangle_name_into( const char* name, char* out, size_t out_size, int short_names )
+	{
+		if( name[0] != '_' || name[1] != 'Z' )
+			return -1;
+
+		callstack_demangle_t d;
+		d.name          = name;
+		d.p             = name + 2;
+		d.out           = out;
+		d.len           = 0;
+		d.cap           = out_size;
+		d.status        = CALLSTACK_DEMANGLE_OK;
+		d.short_names   = short_names;
+		d.quiet         = 0;
+		d.no_subs       = 0;
+		d.in_lambda     = 0;
+		d.pack_index    = -1;
+		d.pack_size     = 0;
+		d.depth         = 0;
+		d.steps         = 0;
+		d.last_name     = "";
+		d.last_name_len = 0;
+		d.dropped_at    = (size_t)-1;
+		d.num_subs      = 0;
+		d.foreign       = 0;
+		d.num_args      = 0;
+		d.args_base     = 0;
+		d.encoding      = 0;
+		d.num_encodings = 0;
+
+		demangle_encoding( &d, 1, 1 );
+
+		// ... suffixes added by the compiler to clones of a function, "f() [clone .constprop.0]" ...
+		while( d.status == CALLSTACK_DEMANGLE_OK && *d.p == '.' )
+		{
+			const char* suffix = d.p++;
+			while( ( *d.p >= 'a' && *d.p <= 'z' ) || ( *d.p >= '0' && *d.p <= '9' ) || *d.p == '_' )
+				++d.p;
+			while( d.p[0] == '.' && d.p[1] >= '0' && d.p[1] <= '9' )
+				for( ++d.p; *d.p >= '0' && *d.p <= '9'; ++d.p ) {}
+			if( d.p == suffix + 1 )
+				demangle_fail( &d );
+			demangle_puts( &d, " [clone " );
+			demangle_append( &d, suffix, (size_t)( d.p - suffix ) );
+			demangle_puts( &d, "]" );
+		}
+
+		if( *d.p != '\0' )
+			demangle_fail( &d );
+		if( d.status != CALLSTACK_DEMANGLE_OK )
+			return d.status == CALLSTACK_DEMANGLE_NO_SPACE ? -2 : -1;
+		out[d.len] = '\0';
+		return (int)d.len;
+	}
+
+	// ... remove template-arguments from a name demangled by abi::__cxa_demangle(), leaving operator-names alone ...
+	static void demangle_strip_template_args( char* name )
+	{
+		char* out   = name;
+		int   depth = 0;
+		for( const char* in = name; *in != '\0'; )
+		{
+			if( depth == 0 && strncmp( in, "operator", 8 ) == 0 )
+			{
+				for( int i = 0; i < 8; ++i )
+					*out++ = *in++;
+				while( *in == '<' || *in == '>' || *in == '=' || *in == '-' )
+					*out++ = *in++;
+				continue;
+			}
+			if( *in == '<' )
+			{
+				if( depth++ == 0 && out > name && out[-1] == ' ' )
+					--out;
+			}
+			else if( *in == '>' && depth > 0 )
+				--depth;
+			else if( depth == 0 )
+				*out++ = *in;
+			++in;
+		}
+		*out = '\0';
+	}
+
+	/**
+	 * Demangle name straight into the pool, returns name itself if it is not a mangled C++ name.
+	 *
+	 * Names are demangled into the space left in the current chunk of the pool, or a new chunk if that is
+	 * not enough, so nothing is copied. Names the demangler above do not handle are passed to
+	 * abi::__cxa_demangle().
+	 */
+	static const char* demangle_into_pool( callstack_string_chunk_t** pool, const char* name, int short_names )
+	{
+		if( name[0] != '_' || name[1] != 'Z' )
+			return name;
+
+		for( int attempt = 0; attempt < 2; ++attempt )
+		{
+			callstack_string_chunk_t* chunk = *pool;
+			if( attempt > 0 || chunk == 0x0 || chunk->size - chunk->used < 256 )
+			{
+				size_t size = attempt == 0 ? 16 * 1024 : 256 * 1024;
+				chunk = (callstack_string_chunk_t*)malloc( sizeof(callstack_string_chunk_t) + size );
+				if( chunk == 0x0 )
+					return name;
+				chunk->next = *pool;
+				chunk->used = 0;
+				chunk->size = size;
+				*pool = chunk;
+			}
+
+			int len = demangle_name_into( name, chunk->data + chunk->used, chunk->size - chunk->used, short_names );
+			if( len >= 0 )
+			{
+				const char* res = chunk->data + chunk->used;
+				chunk->used += (size_t)len + 1;
+				return res;
+			}
+			if( len == -1 )
+				break;
+		}
+
+		int   status;
+		char* demangled = abi::__cxa_demangle( name, 0x0, 0x0, &status );
+		if( demangled == 0x0 )
+			return name;
+		if( short_names )
+			demangle_strip_template_args( demangled );
+		const char* res = string_pool_join( pool, (const char**)&demangled, 1 );
+		free( demangled );
+		return res;
+	}
+
+	/**
+	 * Static search-tree over a sorted array of addresses, used instead of binary search in the tables that can
+	 * have millions of entries. Binary search touches a new cache-line at almost each of its log2(n) steps, here
+	 * each node is one cache-line of CALLSTACK_ADDR_TREE_KEYS addresses so a lookup touches one node per level,
+	 * log8(n) of them, and all addresses of a node are compared at once.
+	 *
+	 * The last level holds all addresses, padded with ~0 to a whole node, and each level above holds the first
+	 * address of each node in the level below it. Levels are stored root first and all start on a node.
+	 */
+	enum
+	{
+		CALLSTACK_ADDR_TREE_KEYS       = 8,  ///< addresses per node, one cache-line.
+		CALLSTACK_ADDR_TREE_MAX_LEVELS = 22, ///< enough for 2^64 addresses.
+	};
+
+	typedef struct
+	{
+		const uint64_t* keys;   ///< all levels, 0x0 if the tree could not be built, base is then binary searched.
+		uint64_t*       owned;  ///< keys if allocated by addr_tree_build().
+		const uint8_t*  base;   ///< sorted array the tree is built over, the address is the first uint64_t of each element.
+		size_t          stride;
+		size_t          num;
+		size_t          num_keys; ///< keys in all levels.
+		int             num_levels;
+		size_t          offsets[CALLSTACK_ADDR_TREE_MAX_LEVELS]; ///< offset of each level in keys, in keys.
+	} callstack_addr_tree_t;
+
+	static uint64_t addr_tree_base_addr( const callstack_addr_tree_t* tree, size_t i )
+	{
+		return *(const uint64_t*)( tree->base + i * tree->stride );
+	}
+
+	// ... setup levels for num addresses, returns the number of keys in all levels ...
+	static size_t addr_tree_layout( callstack_addr_tree_t* tree, const void* base, size_t stride, size_t num )
+	{
+		memset( tree, 0x0, sizeof(callstack_addr_tree_t) );
+		tree->base   = (const uint8_t*)base;
+		tree->stride = stride;
+		tree->num    = num;
+
+		size_t sizes[CALLSTACK_ADDR_TREE_MAX_LEVELS];
+		size_t n = num;
+		do
+		{
+			n = ( n + CALLSTACK_ADDR_TREE_KEYS - 1 ) / CALLSTACK_ADDR_TREE_KEYS;
+			sizes[tree->num_levels++] = n * CALLSTACK_ADDR_TREE_KEYS;
+		} while( n > 1 );
+
+		size_t total = 0;
+		for( int i = 0; i < tree->num_levels; ++i )
+		{
+			tree->offsets[i] = total;
+			total += sizes[tree->num_levels - 1 - i];
+		}
+		tree->num_keys = total;
+		return total;
+	}
+
+	static void addr_tree_fill( const callstack_addr_tree_t* tree, uint64_t* keys, size_t total )
+	{
+		int       last  = tree->num_levels - 1;
+		uint64_t* level = keys + tree->offsets[last];
+		size_t    size  = total - tree->offsets[last];
+		for( size_t i = 0; i < size; ++i )
+			level[i] = i < tree->num ? addr_tree_base_addr( tree, i ) : ~(uint64_t)0;
+
+		for( int l = last - 1; l >= 0; --l )
+		{
+			const uint64_t* below     = keys + tree->offsets[l + 1];
+			size_t          num_below = ( size + CALLSTACK_ADDR_TREE_KEYS - 1 ) / CALLSTACK_ADDR_TREE_KEYS;
+			level = keys + tree->offsets[l];
+			size  = tree->offsets[l + 1] - tree->offsets[l];
+			for( size_t i = 0; i < size; ++i )
+				level[i] = i < num_below ? below[i * CALLSTACK_ADDR_TREE_KEYS] : ~(uint64_t)0;
+		}
+	}
+
+	static void addr_tree_build( callstack_addr_tree_t* tree, const void* base, size_t stride, size_t num )
+	{
+		size_t total = addr_tree_layout( tree, base, stride, num );
+		void*  keys  = 0x0;
+		if( num == 0 || posix_memalign( &keys, CALLSTACK_ADDR_TREE_KEYS * sizeof(uint64_t), total * sizeof(uint64_t) ) != 0 )
+			return;
+		addr_tree_fill( tree, (uint64_t*)keys, total );
+		tree->owned = (uint64_t*)keys;
+		tree->keys  = tree->owned;
+	}
+
+	static void addr_tree_free( callstack_addr_tree_t* tree )
+	{
+		free( tree->owned );
+		memset( tree, 0x0, sizeof(callstack_addr_tree_t) );
+	}
+
+	// ... number of keys in node <= addr, branch-free so that all keys are compared at once ...
+	static size_t addr_tree_node_count( const uint64_t* node, uint64_t addr )
+	{
+	#if defined(__AVX2__)
+		// ... avx2 only has signed 64-bit compares, flipping the sign-bit of both sides gives the unsigned order ...
+		const __m256i sign = _mm256_set1_epi64x( (long long)0x8000000000000000ull );
+		const __m256i a    = _mm256_xor_si256( _mm256_set1_epi64x( (long long)addr ), sign );
+		__m256i k0 = _mm256_xor_si256( _mm256_load_si256( (const __m256i*)node ), sign );
+		__m256i k1 = _mm256_xor_si256( _mm256_load_si256( (const __m256i*)( node + 4 ) ), sign );
+		int gt = _mm256_movemask_pd( _mm256_castsi256_pd( _mm256_cmpgt_epi64( k0, a ) ) ) |
+				 _mm256_movemask_pd( _mm256_castsi256_pd( _mm256_cmpgt_epi64( k1, a ) ) ) << 4;
+		return (size_t)( CALLSTACK_ADDR_TREE_KEYS - __builtin_popcount( (unsigned int)gt ) );
+	#else
+		size_t count = 0;
+		for( int i = 0; i < CALLSTACK_ADDR_TREE_KEYS; ++i )
+			count += node[i] <= addr;
+		return count;
+	#endif
+	}
+
+	// ... number of addresses <= addr, i.e. the index after the last element at or before addr ...
+	static size_t addr_tree_upper_bound( const callstack_addr_tree_t* tree, uint64_t addr )
+	{
+		if( tree->keys == 0x0 )
+		{
+			size_t lo = 0, hi = tree->num;
+			while( lo < hi )
+			{
+				size_t mid = lo + ( hi - lo ) / 2;
+				if( addr_tree_base_addr( tree, mid ) <= addr )
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			return lo;
+		}
+
+		// ... the padding is ~0 and should never be counted ...
+		if( addr == ~(uint64_t)0 )
+			--addr;
+
+		size_t node = 0;
+		for( int l = 0; l < tree->num_levels; ++l )
+		{
+			size_t count = addr_tree_node_count( tree->keys + tree->offsets[l] + node * CALLSTACK_ADDR_TREE_KEYS, addr );
+			if( count == 0 )
+				return 0; // ... only possible in the root, below it the first key of a node is always <= addr ...
+			node = node * CALLSTACK_ADDR_TREE_KEYS + count - 1;
+		}
+		return node + 1;
+	}
+
+	typedef struct
+	{
+		uint64_t    addr;
+		uint64_t    size;
+		const char* name;
+		const char* demangled; ///< demangled name, set on first lookup of the symbol.
+	} callstack_elf_sym_t;
+
+	// ... file index marking the end of a sequence in the line-table ...
+	static const uint32_t CALLSTACK_LINE_END_SEQUENCE = 0xffffffff;
+
+	typedef struct
+	{
+		uint64_t addr;
+		uint32_t file; ///< index into callstack_module_t::files or CALLSTACK_LINE_END_SEQUENCE
+		uint32_t line;
+	} callstack_line_row_t;
+
+	// ... rows and files decoded from the line-program of one compilation unit ...
+	typedef struct
+	{
+		callstack_line_row_t* rows;
+		size_t                num_rows;
+		size_t                cap_rows;
+
+		const char** files;
+		size_t       num_files;
+		size_t       cap_files;
+		uint32_t     file_number_base; ///< file-number of files[0] in the line-program and in DW_AT_call_file, 0 in v5 and 1 before that.
+	} callstack_line_table_t;
+
+	// ... one mapped ELF-file, a module, its separate debug-file or a split-dwarf file ...
+	typedef struct
+	{
+		void*  map;
+		size_t map_size;
+
+		const ElfW(Ehdr)* ehdr;
+		const ElfW(Shdr)* shdrs; ///< 0x0 if the file is not a valid ELF-file.
+		const char*       shstrtab;
+	} callstack_elf_file_t;
+
+	enum
+	{
+		CALLSTACK_MAX_BUILD_ID = 64, ///< longest build-id handled, gnu ld writes 20 bytes by default.
+	};
+
+	enum
+	{
+		CALLSTACK_DWO_INFO,
+		CALLSTACK_DWO_ABBREV,
+		CALLSTACK_DWO_STR,
+		CALLSTACK_DWO_STR_OFFSETS,
+		CALLSTACK_DWO_RNGLISTS,
+		CALLSTACK_DWO_CU_INDEX, ///< only in .dwp-files.
+		CALLSTACK_DWO_NUM_SECTIONS
+	};
+
+	/**
+	 * A .dwo-file with the DIEs of one split unit or a .dwp-file with the DIEs of many, the line-programs
+	 * and addresses of split units are still in the module itself.
+	 */
+	typedef struct
+	{
+		callstack_elf_file_t elf;
+		void*                arena; ///< decompressed sections if any was compressed.
+		size_t               arena_size;
+
+		const uint8_t* sections[CALLSTACK_DWO_NUM_SECTIONS];
+		size_t         sizes[CALLSTACK_DWO_NUM_SECTIONS];
+	} callstack_dwo_file_t;
+
+	/**
+	 * Address-range of a DW_TAG_inlined_subroutine or DW_TAG_subprogram, a function with more than one
+	 * range has one entry per range.
+	 */
+	typedef struct
+	{
+		uint64_t    addr_begin;
+		uint64_t    addr_end;
+		uint64_t    max_end;   ///< max addr_end of this and all entries before it, bounds the search for entries covering an address.
+		const char* name;      ///< linkage-name if available, otherwise plain name.
+		const char* demangled; ///< demangled name, set on first lookup of the entry.
+		uint32_t    call_file; ///< file-number of call-site as it is in the line-program.
+		uint32_t    call_line;
+		uint32_t    depth;     ///< number of inlined functions this one is inlined into, 0 if inlined directly into a real function.
+	} callstack_dwarf_inline_t;
+
+	typedef struct
+	{
+		callstack_dwarf_inline_t* entries; ///< sorted by addr_begin.
+		size_t                    num;
+		size_t                    cap;
+	} callstack_dwarf_inline_list_t;
+
+	/**
+	 * One compilation unit, its unit-DIE and line-program is decoded the first time an address
+	 * in the unit is looked up.
+	 */
+	typedef struct
+	{
+		uint64_t info_offset; ///< offset of unit in .debug_info, ~0 if the module has no .debug_info.
+		uint64_t line_offset; ///< offset of line-program in .debug_line, ~0 until read from the unit-DIE.
+		int      indexed;     ///< set when the address-ranges of the unit are in callstack_module_t::cu_ranges.
+		int      queued;      ///< set while the unit is waiting to be loaded by a batch.
+		int      loaded;
+		int      inlines_loaded;
+
+		callstack_line_table_t lines;
+
+		callstack_dwarf_inline_list_t inlines; ///< only loaded when inlined frames are requested or funcs are needed.
+		callstack_dwarf_inline_list_t funcs;   ///< real functions, only loaded for modules without .symtab.
+
+		callstack_dwo_file_t* dwo; ///< .dwo-file of a split unit, opened the first time the DIEs of the unit are walked.
+	} callstack_dwarf_cu_t;
+
+	typedef struct
+	{
+		uint64_t addr_begin;
+		uint64_t addr_end;
+		size_t   cu; ///< index into callstack_module_t::cus
+	} callstack_dwarf_range_t;
+
+	typedef struct
+	{
+		const char*    debug_str;
+		size_t         debug_str_size;
+		const char*    debug_line_str;
+		size_t         debug_line_str_size;
+		const uint8_t* debug_str_offsets;
+		size_t         debug_str_offsets_size;
+	} callstack_dwarf_strings_t;
+
+	typedef struct
+	{
+		const uint8_t* debug_info;
+		size_t         debug_info_size;
+		const uint8_t* debug_abbrev;
+		size_t         debug_abbrev_size;
+		const uint8_t* debug_line;
+		size_t         debug_line_size;
+		const uint8_t* debug_addr;
+		size_t         debug_addr_size;
+		const uint8_t* debug_ranges;
+		size_t         debug_ranges_size;
+		const uint8_t* debug_rnglists;
+		size_t         debug_rnglists_size;
+
+		callstack_dwarf_strings_t strs;
+	} callstack_dwarf_sections_t;
+
+	/**
+	 * Precomputed symbol-index of a module, written by callstack_index_write() to <module>.csidx and mapped
+	 * as is when the module is loaded so that no debug-info needs to be parsed to resolve an address. All
+	 * offsets are from the start of the file and all arrays are sorted by address.
+	 *
+	 * Line-rows are stored in blocks of CALLSTACK_INDEX_LINE_BLOCK rows, each row as uleb address-delta from
+	 * the row before it in the block, uleb index into files + 1, 0 for a gap between sequences, and uleb line.
+	 *
+	 * Functions and line-blocks are searched with a callstack_addr_tree_t, the keys of the trees are stored in
+	 * the index as well so that nothing needs to be built when it is mapped.
+	 */
+	static const uint8_t CALLSTACK_INDEX_MAGIC[4] = { 'C', 'S', 'I', 2 };
+
+	enum
+	{
+		CALLSTACK_INDEX_LINE_BLOCK       = 32,
+		CALLSTACK_INDEX_FUNCS_FROM_DWARF = 1 << 0, ///< functions are DW_TAG_subprogram:s, looked up by the call-instruction instead of the return-address.
+	};
+
+	typedef struct
+	{
+		uint8_t  magic[4];
+		uint32_t flags;
+		uint32_t build_id_size;
+		uint32_t reserved;
+		uint8_t  build_id[CALLSTACK_MAX_BUILD_ID]; ///< build-id of the module the index was written for.
+		uint64_t funcs;           ///< offset of callstack_index_func_t[num_funcs].
+		uint64_t num_funcs;
+		uint64_t funcs_tree;      ///< offset of the keys of the callstack_addr_tree_t over funcs.
+		uint64_t files;           ///< offset of uint32_t[num_files], string-offsets of file-names.
+		uint64_t num_files;
+		uint64_t line_blocks;     ///< offset of callstack_index_line_block_t[num_line_blocks].
+		uint64_t num_line_blocks;
+		uint64_t line_blocks_tree;
+		uint64_t line_data;
+		uint64_t line_data_size;
+		uint64_t strings;         ///< 0-terminated strings, all string-offsets are relative to this.
+		uint64_t strings_size;
+	} callstack_index_header_t;
+
+	typedef struct
+	{
+		uint64_t addr_begin;
+		uint64_t addr_end;
+		uint64_t max_end;    ///< max addr_end of this and all functions before it, same as callstack_dwarf_inline_t::max_end.
+		uint32_t name;       ///< demangled name.
+		uint32_t short_name; ///< name demangled with CALLSTACK_DEMANGLE_SHORT.
+	} callstack_index_func_t;
+
+	typedef struct
+	{
+		uint64_t addr;     ///< address of the first row in the block.
+		uint32_t data;     ///< offset of the first row in line_data.
+		uint32_t num_rows;
+	} callstack_index_line_block_t;
+
+	typedef struct
+	{
+		int load_ok;
+
+		callstack_elf_file_t elf;
+		callstack_elf_file_t debug; ///< separate debug-file, only mapped if elf is stripped.
+
+		void*  zdebug;      ///< arena holding all decompressed debug-sections, 0x0 if none is compressed.
+		size_t zdebug_size;
+
+		callstack_dwo_file_t dwp; ///< <module>.dwp holding the DIEs of split units, all sections 0x0 if there is none.
+
+		callstack_elf_sym_t*  syms;
+		size_t                num_syms;
+		callstack_addr_tree_t syms_tree;
+		int                  has_symtab; ///< 0 if syms is from .dynsym, function names are then taken from DW_TAG_subprogram when available.
+
+		callstack_dwarf_sections_t dwarf;
+
+		callstack_dwarf_cu_t* cus; ///< sorted by info_offset.
+		size_t                num_cus;
+		size_t                num_unindexed; ///< units without .debug_aranges, all loaded on the first address not found in cu_ranges.
+
+		callstack_dwarf_range_t* cu_ranges; ///< sorted by addr_begin.
+		size_t                   num_cu_ranges;
+		size_t                   cap_cu_ranges;
+		callstack_addr_tree_t    cu_ranges_tree;
+
+		callstack_string_chunk_t* strings;
+
+		// ... mapped <module>.csidx, when there is one all addresses are resolved with it and the fields above are only loaded for inlined frames ...
+		const callstack_index_header_t* index;
+		size_t                          index_size;
+		callstack_addr_tree_t           index_funcs_tree;
+		callstack_addr_tree_t           index_line_blocks_tree;
+		const char*                     path;         ///< path the module was loaded from, set if debug-info is loaded on demand.
+		int                             debug_loaded; ///< symbols and debug-info are loaded, always set if there is no index.
+	} callstack_module_t;
+
+	static int elf_file_open( callstack_elf_file_t* elf, const char* path )
+	{
+		memset( elf, 0x0, sizeof(callstack_elf_file_t) );
+
+		int fd = open( path, O_RDONLY | O_CLOEXEC );
+		if( fd < 0 )
+			return 0;
+
+		struct stat st;
+		if( fstat( fd, &st ) != 0 || (size_t)st.st_size < sizeof(ElfW(Ehdr)) )
+		{
+			close( fd );
+			return 0;
+		}
+
+		elf->map_size = (size_t)st.st_size;
+		elf->map      = mmap( 0x0, elf->map_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		close( fd );
+		if( elf->map == MAP_FAILED )
+		{
+			elf->map = 0x0;
+			return 0;
+		}
+
+		const ElfW(Ehdr)* ehdr = (const ElfW(Ehdr)*)elf->map;
+		if( memcmp( ehdr->e_ident, ELFMAG, SELFMAG ) != 0 ||
+			ehdr->e_shoff == 0 ||
+			ehdr->e_shstrndx >= ehdr->e_shnum ||
+			ehdr->e_shoff + (size_t)ehdr->e_shnum * sizeof(ElfW(Shdr)) > elf->map_size )
+			return 0;
+
+		const ElfW(Shdr)* shdrs = (const ElfW(Shdr)*)( (const uint8_t*)elf->map + ehdr->e_shoff );
+		if( shdrs[ehdr->e_shstrndx].sh_offset >= elf->map_size )
+			return 0;
+
+		elf->ehdr     = ehdr;
+		elf->shdrs    = shdrs;
+		elf->shstrtab = (const char*)elf->map + shdrs[ehdr->e_shstrndx].sh_offset;
+		return 1;
+	}
+
+	static void elf_file_close( callstack_elf_file_t* elf )
+	{
+		if( elf->map )
+			munmap( elf->map, elf->map_size );
+		memset( elf, 0x0, sizeof(callstack_elf_file_t) );
+	}
+
+	static const ElfW(Shdr)* elf_find_shdr( const callstack_elf_file_t* elf, const char* name )
+	{
+		if( elf->shdrs == 0x0 )
+			return 0x0;
+		for( unsigned int i = 0; i < elf->ehdr->e_shnum; ++i )
+		{
+			const ElfW(Shdr)* shdr = &elf->shdrs[i];
+			if( shdr->sh_type == SHT_NOBITS || shdr->sh_name == 0 )
+				continue;
+			if( strcmp( elf->shstrtab + shdr->sh_name, name ) != 0 )
+				continue;
+			if( shdr->sh_offset + shdr->sh_size > elf->map_size )
+				return 0x0;
+			return shdr;
+		}
+		return 0x0;
+	}
+
+	static const void* elf_find_section( const callstack_elf_file_t* elf, const char* name, size_t* size )
+	{
+		const ElfW(Shdr)* shdr = elf_find_shdr( elf, name );
+		if( shdr == 0x0 )
+			return 0x0;
+		*size = shdr->sh_size;
+		return (const uint8_t*)elf->map + shdr->sh_offset;
+	}
+
+	// ... find the NT_GNU_BUILD_ID note among the notes in [note, end), returns the id and stores its length in size ...
+	static const uint8_t* elf_note_build_id( const uint8_t* note, const uint8_t* end, size_t* size )
+	{
+		while( (size_t)( end - note ) >= sizeof(ElfW(Nhdr)) )
+		{
+			const ElfW(Nhdr)* nhdr = (const ElfW(Nhdr)*)note;
+			size_t name_size = ( (size_t)nhdr->n_namesz + 3 ) & ~(size_t)3;
+			size_t desc_size = ( (size_t)nhdr->n_descsz + 3 ) & ~(size_t)3;
+			const uint8_t* name = note + sizeof(ElfW(Nhdr));
+			if( name_size + desc_size > (size_t)( end - name ) )
+				break;
+			if( nhdr->n_type == NT_GNU_BUILD_ID && nhdr->n_namesz == 4 && memcmp( name, "GNU", 4 ) == 0 && nhdr->n_descsz > 0 )
+			{
+				*size = nhdr->n_descsz;
+				return name + name_size;
+			}
+			note = name + name_size + desc_size;
+		}
+		return 0x0;
+	}
+
+	// ... find the NT_GNU_BUILD_ID note, returns the id and stores its length in size ...
+	static const uint8_t* elf_find_build_id( const callstack_elf_file_t* elf, size_t* size )
+	{
+		if( elf->shdrs == 0x0 )
+			return 0x0;
+		for( unsigned int i = 0; i < elf->ehdr->e_shnum; ++i )
+		{
+			const ElfW(Shdr)* shdr = &elf->shdrs[i];
+			if( shdr->sh_type != SHT_NOTE || shdr->sh_offset + shdr->sh_size > elf->map_size )
+				continue;
+
+			const uint8_t* note = (const uint8_t*)elf->map + shdr->sh_offset;
+			const uint8_t* id   = elf_note_build_id( note, note + shdr->sh_size, size );
+			if( id )
+				return id;
+		}
+		return 0x0;
+	}
+
+	// ... write id as a 0-terminated hex-string to out, that needs to fit id_size * 2 + 1 chars ...
+	static void elf_build_id_hex( const uint8_t* id, size_t id_size, char* out )
+	{
+		static const char hex[] = "0123456789abcdef";
+		for( size_t i = 0; i < id_size; ++i )
+		{
+			*out++ = hex[id[i] >> 4];
+			*out++ = hex[id[i] & 0xf];
+		}
+		*out = '\0';
+	}
+
+	// ... crc32 as used by .gnu_debuglink, same polynomial as zlib ...
+	static uint32_t elf_crc32( const uint8_t* data, size_t size )
+	{
+		uint32_t table[256];
+		for( uint32_t i = 0; i < 256; ++i )
+		{
+			uint32_t c = i;
+			for( int k = 0; k < 8; ++k )
+				c = c & 1 ? 0xedb88320u ^ ( c >> 1 ) : c >> 1;
+			table[i] = c;
+		}
+
+		uint32_t crc = 0xffffffffu;
+		for( size_t i = 0; i < size; ++i )
+			crc = table[( crc ^ data[i] ) & 0xff] ^ ( crc >> 8 );
+		return crc ^ 0xffffffffu;
+	}
+
+	// ... write <debug-dir>/.build-id/xx/yyyyyyyy.debug where xxyyyyyyyy is id_hex to path, returns 0 if it do not fit ...
+	static int elf_build_id_path( const char* id_hex, char* path, size_t size )
+	{
+		if( strlen( id_hex ) <= 2 )
+			return 0;
+		int len = snprintf( path, size, "%s/.build-id/%.2s/%s.debug", DBG_TOOLS_CALLSTACK_DEBUG_FILE_DIR, id_hex, id_hex + 2 );
+		return len > 0 && (size_t)len < size;
+	}
+
+	/**
+	 * Map <debug-dir>/.build-id/xx/yyyyyyyy.debug where xxyyyyyyyy is id_hex, returns 0 if it do not exist or
+	 * has another build-id.
+	 */
+	static int elf_open_build_id_file( const char* id_hex, callstack_elf_file_t* file )
+	{
+		char path[PATH_MAX];
+		if( !elf_build_id_path( id_hex, path, sizeof(path) ) || !elf_file_open( file, path ) )
+		{
+			elf_file_close( file );
+			return 0;
+		}
+
+		size_t         file_id_size;
+		const uint8_t* file_id = elf_find_build_id( file, &file_id_size );
+		char           file_id_hex[CALLSTACK_MAX_BUILD_ID * 2 + 1];
+		if( file_id && file_id_size <= CALLSTACK_MAX_BUILD_ID )
+		{
+			elf_build_id_hex( file_id, file_id_size, file_id_hex );
+			if( strcmp( file_id_hex, id_hex ) == 0 )
+				return 1;
+		}
+		elf_file_close( file );
+		return 0;
+	}
+
+	/**
+	 * Find and map the separate debug-file of the module at path, the same locations as gdb are searched:
+	 *
+	 * <debug-dir>/.build-id/xx/yyyyyyyy.debug where xxyyyyyyyy is the build-id, the build-id is checked.
+	 * <dir of module>/<debuglink>, <dir of module>/.debug/<debuglink> and <debug-dir>/<dir of module>/<debuglink>,
+	 * where the crc32 of the file is checked against the one stored in .gnu_debuglink.
+	 */
+	static int elf_open_debug_file( const callstack_elf_file_t* elf, const char* path, callstack_elf_file_t* debug )
+	{
+		char debug_path[PATH_MAX];
+
+		size_t         id_size;
+		const uint8_t* id = elf_find_build_id( elf, &id_size );
+		char           id_hex[CALLSTACK_MAX_BUILD_ID * 2 + 1];
+		if( id && id_size <= CALLSTACK_MAX_BUILD_ID )
+		{
+			elf_build_id_hex( id, id_size, id_hex );
+			if( elf_open_build_id_file( id_hex, debug ) )
+				return 1;
+		}
+
+		size_t      link_size;
+		const char* link = (const char*)elf_find_section( elf, ".gnu_debuglink", &link_size );
+		size_t      link_len = link ? strnlen( link, link_size ) : link_size;
+		size_t      crc_offset = ( link_len + 4 ) & ~(size_t)3;
+		if( link == 0x0 || link_len == 0 || crc_offset + 4 > link_size )
+			return 0;
+
+		uint32_t crc;
+		memcpy( &crc, link + crc_offset, sizeof(crc) );
+
+		// ... /proc/self/exe is a link to the executable, the debug-file is found relative to the real file ...
+		char real_path[PATH_MAX];
+		if( realpath( path, real_path ) == 0x0 )
+			return 0;
+		char* last_slash = strrchr( real_path, '/' );
+		if( last_slash == 0x0 )
+			return 0;
+		last_slash[1] = '\0';
+
+		const char* formats[] = { "%s%.*s", "%s.debug/%.*s", DBG_TOOLS_CALLSTACK_DEBUG_FILE_DIR "%s%.*s" };
+		for( size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i )
+		{
+			int len = snprintf( debug_path, sizeof(debug_path), formats[i], real_path, (int)link_len, link );
+			if( len <= 0 || (size_t)len >= sizeof(debug_path) || strcmp( debug_path, real_path ) == 0 )
+				continue;
+			if( !elf_file_open( debug, debug_path ) )
+			{
+				elf_file_close( debug );
+				continue;
+			}
+			if( elf_crc32( (const uint8_t*)debug->map, debug->map_size ) == crc )
+				return 1;
+			elf_file_close( debug );
+		}
+		return 0;
+	}
+
+	enum
+	{
+		CALLSTACK_INFLATE_FAST_BITS = 10, ///< codes up to this length are decoded with a single table-lookup.
+		CALLSTACK_INFLATE_MAX_BITS  = 15,
+	};
+
+	// ... canonical huffman-code as used by deflate ...
+	typedef struct
+	{
+		uint16_t fast[1 << CALLSTACK_INFLATE_FAST_BITS]; ///< symbol | code-length << 9 indexed by the next bits, 0 if the code is longer.
+		uint16_t count[CALLSTACK_INFLATE_MAX_BITS + 1];  ///< number of codes of each length.
+		uint16_t symbol[288];                            ///< symbols ordered by code.
+	} callstack_huffman_t;
+
+	typedef struct
+	{
+		const uint8_t* in;
+		const uint8_t* in_end;
+		uint64_t       bits;
+		unsigned int   num_bits;
+		int            overrun; ///< set if more bits than available was read, the stream is broken.
+
+		uint8_t* out_begin;
+		uint8_t* out;
+		uint8_t* out_end;
+	} callstack_inflate_t;
+
+	static void inflate_refill( callstack_inflate_t* s )
+	{
+		while( s->num_bits <= 56 && s->in < s->in_end )
+		{
+			s->bits |= (uint64_t)*s->in++ << s->num_bits;
+			s->num_bits += 8;
+		}
+	}
+
+	static uint32_t inflate_bits( callstack_inflate_t* s, unsigned int n )
+	{
+		if( s->num_bits < n )
+		{
+			inflate_refill( s );
+			if( s->num_bits < n )
+			{
+				s->overrun = 1;
+				return 0;
+			}
+		}
+		uint32_t val = (uint32_t)( s->bits & ( ( (uint64_t)1 << n ) - 1 ) );
+		s->bits     >>= n;
+		s->num_bits -= n;
+		return val;
+	}
+
+	static int huffman_build( callstack_huffman_t* h, const uint8_t* lengths, int num_symbols )
+	{
+		memset( h, 0x0, sizeof(callstack_huffman_t) );
+		for( int i = 0; i < num_symbols; ++i )
+			++h->count[lengths[i]];
+		h->count[0] = 0;
+
+		// ... over-subscribed sets of lengths are invalid, incomplete ones are allowed ...
+		int left = 1;
+		for( int len = 1; len <= CALLSTACK_INFLATE_MAX_BITS; ++len )
+		{
+			left = ( left << 1 ) - h->count[len];
+			if( left < 0 )
+				return 0;
+		}
+
+		uint16_t offsets[CALLSTACK_INFLATE_MAX_BITS + 1];
+		offsets[1] = 0;
+		for( int len = 1; len < CALLSTACK_INFLATE_MAX_BITS; ++len )
+			offsets[len + 1] = (uint16_t)( offsets[len] + h->count[len] );
+		for( int i = 0; i < num_symbols; ++i )
+			if( lengths[i] != 0 )
+				h->symbol[offsets[lengths[i]]++] = (uint16_t)i;
+
+		// ... codes are stored msb first in the lsb first bit-stream, so the table is indexed by reversed codes ...
+		uint32_t code  = 0;
+		int      index = 0;
+		for( int len = 1; len <= CALLSTACK_INFLATE_FAST_BITS; ++len, code <<= 1 )
+			for( int i = 0; i < h->count[len]; ++i, ++code, ++index )
+			{
+				uint32_t reversed = 0;
+				for( int b = 0; b < len; ++b )
+					reversed |= ( ( code >> b ) & 1 ) << ( len - 1 - b );
+				for( uint32_t j = reversed; j < ( 1u << CALLSTACK_INFLATE_FAST_BITS ); j += 1u << len )
+					h->fast[j] = (uint16_t)( h->symbol[index] | len << 9 );
+			}
+		return 1;
+	}
+
+	static int inflate_decode( callstack_inflate_t* s, const callstack_huffman_t* h )
+	{
+		if( s->num_bits < CALLSTACK_INFLATE_MAX_BITS )
+			inflate_refill( s );
+
+		uint16_t entry = h->fast[s->bits & ( ( 1u << CALLSTACK_INFLATE_FAST_BITS ) - 1 )];
+		if( entry != 0 )
+		{
+			unsigned int len = (unsigned int)entry >> 9;
+			if( len > s->num_bits )
+				return -1;
+			s->bits     >>= len;
+			s->num_bits -= len;
+			return entry & 0x1ff;
+		}
+
+		// ... long code, walk the code-lengths one bit at a time ...
+		int code = 0, first = 0, index = 0;
+		for( int len = 1; len <= CALLSTACK_INFLATE_MAX_BITS; ++len )
+		{
+			code |= (int)inflate_bits( s, 1 );
+			int count = h->count[len];
+			if( code - count < first )
+				return s->overrun ? -1 : h->symbol[index + ( code - first )];
+			index += count;
+			first  = ( first + count ) << 1;
+			code <<= 1;
+		}
+		return -1;
+	}
+
+	static int inflate_codes( callstack_inflate_t* s, const callstack_huffman_t* lencode, const callstack_huffman_t* distcode )
+	{
+		static const uint16_t LEN_BASE[29]   = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+		static const uint8_t  LEN_EXTRA[29]  = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+		static const uint16_t DIST_BASE[30]  = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+		static const uint8_t  DIST_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+		for( ;; )
+		{
+			int sym = inflate_decode( s, lencode );
+			if( sym < 0 )
+				return 0;
+			if( sym < 256 )
+			{
+				if( s->out == s->out_end )
+					return 0;
+				*s->out++ = (uint8_t)sym;
+				continue;
+			}
+			if( sym == 256 )
+				return 1;
+
+			sym -= 257;
+			if( sym >= 29 )
+				return 0;
+			size_t len = LEN_BASE[sym] + inflate_bits( s, LEN_EXTRA[sym] );
+
+			int dist_sym = inflate_decode( s, distcode );
+			if( dist_sym < 0 || dist_sym >= 30 )
+				return 0;
+			size_t dist = DIST_BASE[dist_sym] + inflate_bits( s, DIST_EXTRA[dist_sym] );
+			if( s->overrun || dist > (size_t)( s->out - s->out_begin ) || len > (size_t)( s->out_end - s->out ) )
+				return 0;
+
+			const uint8_t* from = s->out - dist;
+			if( dist >= len )
+				memcpy( s->out, from, len );
+			else
+				for( size_t i = 0; i < len; ++i ) // ... overlapping copy repeats the last dist bytes ...
+					s->out[i] = from[i];
+			s->out += len;
+		}
+	}
+
+	static int inflate_stored( callstack_inflate_t* s )
+	{
+		inflate_bits( s, s->num_bits & 7 );
+		uint32_t len  = inflate_bits( s, 16 );
+		uint32_t nlen = inflate_bits( s, 16 );
+		if( s->overrun || len != ( ~nlen & 0xffff ) || len > (size_t)( s->out_end - s->out ) )
+			return 0;
+
+		// ... bytes might already be in the bit-buffer ...
+		for( ; len > 0 && s->num_bits > 0; --len )
+			*s->out++ = (uint8_t)inflate_bits( s, 8 );
+		if( len > (size_t)( s->in_end - s->in ) )
+			return 0;
+		memcpy( s->out, s->in, len );
+		s->out += len;
+		s->in  += len;
+		return 1;
+	}
+
+	static int inflate_fixed( callstack_inflate_t* s )
+	{
+		uint8_t lengths[288 + 30];
+		memset( lengths,       8, 144 );
+		memset( lengths + 144, 9, 112 );
+		memset( lengths + 256, 7, 24 );
+		memset( lengths + 280, 8, 8 );
+		memset( lengths + 288, 5, 30 );
+
+		callstack_huffman_t lencode, distcode;
+		huffman_build( &lencode, lengths, 288 );
+		huffman_build( &distcode, lengths + 288, 30 );
+		return inflate_codes( s, &lencode, &distcode );
+	}
+
+	static int inflate_dynamic( callstack_inflate_t* s )
+	{
+		static const uint8_t ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+		int num_len  = (int)inflate_bits( s, 5 ) + 257;
+		int num_dist = (int)inflate_bits( s, 5 ) + 1;
+		int num_code = (int)inflate_bits( s, 4 ) + 4;
+		if( s->overrun || num_len > 286 || num_dist > 30 )
+			return 0;
+
+		uint8_t lengths[286 + 30];
+		memset( lengths, 0x0, sizeof(lengths) );
+		for( int i = 0; i < num_code; ++i )
+			lengths[ORDER[i]] = (uint8_t)inflate_bits( s, 3 );
+
+		callstack_huffman_t lencode, distcode;
+		if( !huffman_build( &lencode, lengths, 19 ) )
+			return 0;
+
+		int index = 0;
+		memset( lengths, 0x0, sizeof(lengths) );
+		while( index < num_len + num_dist )
+		{
+			int sym = inflate_decode( s, &lencode );
+			if( sym < 0 )
+				return 0;
+			if( sym < 16 )
+			{
+				lengths[index++] = (uint8_t)sym;
+				continue;
+			}
+
+			uint8_t  len    = 0;
+			uint32_t repeat;
+			if( sym == 16 )
+			{
+				if( index == 0 )
+					return 0;
+				len    = lengths[index - 1];
+				repeat = 3 + inflate_bits( s, 2 );
+			}
+			else if( sym == 17 )
+				repeat = 3 + inflate_bits( s, 3 );
+			else
+				repeat = 11 + inflate_bits( s, 7 );
+			if( s->overrun || index + (int)repeat > num_len + num_dist )
+				return 0;
+			while( repeat-- > 0 )
+				lengths[index++] = len;
+		}
+
+		if( lengths[256] == 0 ||
+			!huffman_build( &lencode, lengths, num_len ) ||
+			!huffman_build( &distcode, lengths + num_len, num_dist ) )
+			return 0;
+		return inflate_codes( s, &lencode, &distcode );
+	}
+
+	// ... decompress a zlib-stream that should decompress to exactly out_size bytes ...
+	static int inflate_zlib( const uint8_t* in, size_t in_size, uint8_t* out, size_t out_size )
+	{
+		if( in_size < 2 || ( in[0] & 0x0f ) != 8 || ( in[0] * 256 + in[1] ) % 31 != 0 || ( in[1] & 0x20 ) != 0 )
+			return 0;
+
+		callstack_inflate_t s;
+		memset( &s, 0x0, sizeof(s) );
+		s.in        = in + 2;
+		s.in_end    = in + in_size;
+		s.out_begin = out;
+		s.out       = out;
+		s.out_end   = out + out_size;
+
+		int last;
+		do
+		{
+			last = (int)inflate_bits( &s, 1 );
+			int ok;
+			switch( inflate_bits( &s, 2 ) )
+			{
+				case 0:  ok = inflate_stored( &s );  break;
+				case 1:  ok = inflate_fixed( &s );   break;
+				case 2:  ok = inflate_dynamic( &s ); break;
+				default: ok = 0; break;
+			}
+			if( !ok || s.overrun )
+				return 0;
+		} while( !last );
+		return s.out == s.out_end;
+	}
+
+	/**
+	 * Find a debug-section that might be compressed, either flagged with SHF_COMPRESSED or stored as
+	 * .zdebug_* by older toolchains. Compressed data is returned as is with uncompressed_size set to
+	 * the size of the decompressed section, for uncompressed sections uncompressed_size is 0.
+	 *
+	 * Only zlib is supported, sections compressed with anything else are treated as missing.
+	 */
+	static const uint8_t* elf_find_debug_section( const callstack_elf_file_t* elf, const char* name, size_t* size, size_t* uncompressed_size )
+	{
+		*uncompressed_size = 0;
+
+		const ElfW(Shdr)* shdr = elf_find_shdr( elf, name );
+		if( shdr )
+		{
+			const uint8_t* data = (const uint8_t*)elf->map + shdr->sh_offset;
+			*size = shdr->sh_size;
+			if( ( shdr->sh_flags & SHF_COMPRESSED ) == 0 )
+				return data;
+
+			ElfW(Chdr) chdr;
+			if( *size < sizeof(chdr) )
+				return 0x0;
+			memcpy( &chdr, data, sizeof(chdr) );
+			if( chdr.ch_type != ELFCOMPRESS_ZLIB || chdr.ch_size == 0 )
+				return 0x0;
+			*size -= sizeof(chdr);
+			*uncompressed_size = chdr.ch_size;
+			return data + sizeof(chdr);
+		}
+
+		// ... .zdebug_* has a "ZLIB" header followed by the big-endian uncompressed size ...
+		char zname[64];
+		if( strncmp( name, ".debug_", 7 ) != 0 || snprintf( zname, sizeof(zname), ".zdebug_%s", name + 7 ) >= (int)sizeof(zname) )
+			return 0x0;
+		const uint8_t* data = (const uint8_t*)elf_find_section( elf, zname, size );
+		if( data == 0x0 || *size < 12 || memcmp( data, "ZLIB", 4 ) != 0 )
+			return 0x0;
+		for( int i = 0; i < 8; ++i )
+			*uncompressed_size = *uncompressed_size << 8 | data[4 + i];
+		*size -= 12;
+		return *uncompressed_size > 0 ? data + 12 : 0x0;
+	}
+
+	static int elf_sym_cmp( const void* a, const void* b )
+	{
+		const callstack_elf_sym_t* sa = (const callstack_elf_sym_t*)a;
+		const callstack_elf_sym_t* sb = (const callstack_elf_sym_t*)b;
+		if( sa->addr != sb->addr )
+			return sa->addr < sb->addr ? -1 : 1;
+		// ... prefer sized symbols over zero-sized aliases at the same address ...
+		return sa->size > sb->size ? -1 : ( sa->size < sb->size ? 1 : 0 );
+	}
+
+	static int elf_load_symbols( callstack_module_t* mod, const callstack_elf_file_t* elf, const char* symtab_name, const char* strtab_name )
+	{
+		size_t symtab_size, strtab_size;
+		const ElfW(Sym)* symtab = (const ElfW(Sym)*)elf_find_section( elf, symtab_name, &symtab_size );
+		const char*      strtab = (const char*)     elf_find_section( elf, strtab_name, &strtab_size );
+		if( symtab == 0x0 || strtab == 0x0 )
+			return 0;
+
+		size_t num_syms = symtab_size / sizeof(ElfW(Sym));
+		mod->syms = (callstack_elf_sym_t*)malloc( num_syms * sizeof(callstack_elf_sym_t) );
+		if( mod->syms == 0x0 )
+			return 0;
+
+		for( size_t i = 0; i < num_syms; ++i )
+		{
+			const ElfW(Sym)* sym = &symtab[i];
+			int type = ELF64_ST_TYPE( sym->st_info );
+			if( type != STT_FUNC && type != STT_GNU_IFUNC )
+				continue;
+			if( sym->st_shndx == SHN_UNDEF || sym->st_value == 0 || sym->st_name >= strtab_size )
+				continue;
+
+			callstack_elf_sym_t* out = &mod->syms[mod->num_syms++];
+			out->addr = sym->st_value;
+			out->size = sym->st_size;
+			out->name = strtab + sym->st_name;
+			out->demangled = 0x0;
+		}
+
+		if( mod->num_syms == 0 )
+		{
+			free( mod->syms );
+			mod->syms = 0x0;
+			return 0;
+		}
+		qsort( mod->syms, mod->num_syms, sizeof(callstack_elf_sym_t), elf_sym_cmp );
+		addr_tree_build( &mod->syms_tree, mod->syms, sizeof(callstack_elf_sym_t), mod->num_syms );
+		return 1;
+	}
+
+	static callstack_elf_sym_t* elf_find_symbol( const callstack_module_t* mod, uint64_t addr )
+	{
+		// ... find last symbol starting at or before addr ...
+		size_t lo = addr_tree_upper_bound( &mod->syms_tree, addr );
+		if( lo == 0 )
+			return 0x0;
+
+		// ... step back over zero-sized aliases to the "real" symbol ...
+		size_t i = lo - 1;
+		while( i > 0 && mod->syms[i - 1].addr == mod->syms[i].addr )
+			--i;
+
+		callstack_elf_sym_t* sym = &mod->syms[i];
+		if( sym->size != 0 && addr >= sym->addr + sym->size )
+			return 0x0;
+		return sym;
+	}
+
+	// ... register a file from a line-table header, relative paths are resolved against dir and the dir against comp_dir ...
+	static uint32_t line_add_file( callstack_line_table_t* lt, callstack_string_chunk_t** strings, const char* comp_dir, const char* dir, const char* file )
+	{
+		if( lt->num_files == lt->cap_files )
+		{
+			size_t new_cap = lt->cap_files ? lt->cap_files * 2 : 32;
+			const char** new_files = (const char**)realloc( lt->files, new_cap * sizeof(const char*) );
+			if( new_files == 0x0 )
+				return CALLSTACK_LINE_END_SEQUENCE;
+			lt->files     = new_files;
+			lt->cap_files = new_cap;
+		}
+		const char* parts[3] = { comp_dir, dir, file };
+		if( file[0] == '/' )
+			lt->files[lt->num_files] = file;
+		else if( dir && dir[0] == '/' )
+			lt->files[lt->num_files] = string_pool_join( strings, parts + 1, 2 );
+		else
+			lt->files[lt->num_files] = string_pool_join( strings, parts, 3 );
+		return (uint32_t)lt->num_files++;
+	}
+
+	static void line_add_row( callstack_line_table_t* lt, uint64_t addr, uint32_t file, uint32_t line )
+	{
+		if( lt->num_rows == lt->cap_rows )
+		{
+			size_t new_cap = lt->cap_rows ? lt->cap_rows * 2 : 256;
+			callstack_line_row_t* new_rows = (callstack_line_row_t*)realloc( lt->rows, new_cap * sizeof(callstack_line_row_t) );
+			if( new_rows == 0x0 )
+				return;
+			lt->rows     = new_rows;
+			lt->cap_rows = new_cap;
+		}
+		callstack_line_row_t* row = &lt->rows[lt->num_rows++];
+		row->addr = addr;
+		row->file = file;
+		row->line = line;
+	}
+
+	// DWARF constants used by the line-program and unit-DIE decoders.
+	enum
+	{
+		DW_FORM_addr           = 0x01,
+		DW_FORM_block2         = 0x03,
+		DW_FORM_block4         = 0x04,
+		DW_FORM_data2          = 0x05,
+		DW_FORM_data4          = 0x06,
+		DW_FORM_data8          = 0x07,
+		DW_FORM_string         = 0x08,
+		DW_FORM_block          = 0x09,
+		DW_FORM_block1         = 0x0a,
+		DW_FORM_data1          = 0x0b,
+		DW_FORM_flag           = 0x0c,
+		DW_FORM_sdata          = 0x0d,
+		DW_FORM_strp           = 0x0e,
+		DW_FORM_udata          = 0x0f,
+		DW_FORM_ref_addr       = 0x10,
+		DW_FORM_ref1           = 0x11,
+		DW_FORM_ref2           = 0x12,
+		DW_FORM_ref4           = 0x13,
+		DW_FORM_ref8           = 0x14,
+		DW_FORM_ref_udata      = 0x15,
+		DW_FORM_indirect       = 0x16,
+		DW_FORM_sec_offset     = 0x17,
+		DW_FORM_exprloc        = 0x18,
+		DW_FORM_flag_present   = 0x19,
+		DW_FORM_strx           = 0x1a,
+		DW_FORM_addrx          = 0x1b,
+		DW_FORM_ref_sup4       = 0x1c,
+		DW_FORM_strp_sup       = 0x1d,
+		DW_FORM_data16         = 0x1e,
+		DW_FORM_line_strp      = 0x1f,
+		DW_FORM_ref_sig8       = 0x20,
+		DW_FORM_implicit_const = 0x21,
+		DW_FORM_loclistx       = 0x22,
+		DW_FORM_rnglistx       = 0x23,
+		DW_FORM_ref_sup8       = 0x24,
+		DW_FORM_strx1          = 0x25,
+		DW_FORM_strx2          = 0x26,
+		DW_FORM_strx3          = 0x27,
+		DW_FORM_strx4          = 0x28,
+		DW_FORM_addrx1         = 0x29,
+		DW_FORM_addrx2         = 0x2a,
+		DW_FORM_addrx3         = 0x2b,
+		DW_FORM_addrx4         = 0x2c,
+		DW_FORM_GNU_addr_index = 0x1f01,
+		DW_FORM_GNU_str_index  = 0x1f02,
+		DW_FORM_GNU_ref_alt    = 0x1f20,
+		DW_FORM_GNU_strp_alt   = 0x1f21,
+
+		DW_TAG_inlined_subroutine = 0x1d,
+		DW_TAG_subprogram         = 0x2e,
+		DW_TAG_skeleton_unit      = 0x4a,
+
+		DW_AT_name              = 0x03,
+		DW_AT_stmt_list         = 0x10,
+		DW_AT_low_pc            = 0x11,
+		DW_AT_high_pc           = 0x12,
+		DW_AT_comp_dir          = 0x1b,
+		DW_AT_abstract_origin   = 0x31,
+		DW_AT_specification     = 0x47,
+		DW_AT_ranges            = 0x55,
+		DW_AT_call_file         = 0x58,
+		DW_AT_call_line         = 0x59,
+		DW_AT_linkage_name      = 0x6e,
+		DW_AT_str_offsets_base  = 0x72,
+		DW_AT_addr_base         = 0x73,
+		DW_AT_rnglists_base     = 0x74,
+		DW_AT_dwo_name          = 0x76,
+		DW_AT_MIPS_linkage_name = 0x2007,
+		DW_AT_GNU_dwo_name      = 0x2130,
+		DW_AT_GNU_dwo_id        = 0x2131,
+		DW_AT_GNU_ranges_base   = 0x2132,
+		DW_AT_GNU_addr_base     = 0x2133,
+
+		DW_RLE_end_of_list   = 0x00,
+		DW_RLE_base_addressx = 0x01,
+		DW_RLE_startx_endx   = 0x02,
+		DW_RLE_startx_length = 0x03,
+		DW_RLE_offset_pair   = 0x04,
+		DW_RLE_base_address  = 0x05,
+		DW_RLE_start_end     = 0x06,
+		DW_RLE_start_length  = 0x07,
+
+		DW_UT_compile       = 0x01,
+		DW_UT_type          = 0x02,
+		DW_UT_partial       = 0x03,
+		DW_UT_skeleton      = 0x04,
+		DW_UT_split_compile = 0x05,
+		DW_UT_split_type    = 0x06,
+
+		DW_LNCT_path            = 0x1,
+		DW_LNCT_directory_index = 0x2,
+
+		DW_LNS_copy               = 0x01,
+		DW_LNS_advance_pc         = 0x02,
+		DW_LNS_advance_line       = 0x03,
+		DW_LNS_set_file           = 0x04,
+		DW_LNS_const_add_pc       = 0x08,
+		DW_LNS_fixed_advance_pc   = 0x09,
+
+		DW_LNE_end_sequence = 0x01,
+		DW_LNE_set_address  = 0x02,
+		DW_LNE_define_file  = 0x03,
+	};
+
+	static const char* dwarf_str_at( const char* section, size_t section_size, uint64_t offset )
+	{
+		if( section == 0x0 || offset >= section_size )
+			return "";
+		return section + offset;
+	}
+
+	// ... read a value from a line-table entry-format, strings are returned via str, numbers via val ...
+	static void dwarf_read_lnct_form( callstack_dwarf_cursor_t* c, uint64_t form, size_t offset_size, const callstack_dwarf_strings_t* strs, const char** str, uint64_t* val )
+	{
+		switch( form )
+		{
+			case DW_FORM_string:    *str = dwarf_read_str( c ); break;
+			case DW_FORM_line_strp: *str = dwarf_str_at( strs->debug_line_str, strs->debug_line_str_size, dwarf_read_uint( c, offset_size ) ); break;
+			case DW_FORM_strp:      *str = dwarf_str_at( strs->debug_str,      strs->debug_str_size,      dwarf_read_uint( c, offset_size ) ); break;
+			case DW_FORM_data1:     *val = dwarf_read_u8( c );  break;
+			case DW_FORM_data2:     *val = dwarf_read_u16( c ); break;
+			case DW_FORM_data4:     *val = dwarf_read_u32( c ); break;
+			case DW_FORM_data8:     *val = dwarf_read_u64( c ); break;
+			case DW_FORM_udata:     *val = dwarf_read_uleb( c ); break;
+			case DW_FORM_sdata:     *val = (uint64_t)dwarf_read_sleb( c ); break;
+			case DW_FORM_data16:    dwarf_skip( c, 16 ); break;
+			case DW_FORM_block1:    dwarf_skip( c, dwarf_read_u8( c ) ); break;
+			case DW_FORM_block2:    dwarf_skip( c, dwarf_read_u16( c ) ); break;
+			case DW_FORM_block4:    dwarf_skip( c, dwarf_read_u32( c ) ); break;
+			case DW_FORM_block:     dwarf_skip( c, dwarf_read_uleb( c ) ); break;
+			default:
+				// ... unknown form, we can't continue parsing this header ...
+				c->ptr = c->end;
+				break;
+		}
+	}
+
+	// ... parse one of the v5 entry-format tables, dirs is filled if it is the directory-table otherwise files are registered in lt ...
+	static int dwarf_parse_v5_entries( callstack_dwarf_cursor_t* c, size_t offset_size, const callstack_dwarf_strings_t* strs,
+									   const char** dirs, size_t max_dirs, size_t* num_dirs,
+									   callstack_line_table_t* lt, callstack_string_chunk_t** strings, size_t* num_files )
+	{
+		uint64_t formats[16];
+		uint8_t format_count = dwarf_read_u8( c );
+		if( format_count > sizeof(formats) / sizeof(formats[0]) / 2 )
+			return 0;
+		for( uint8_t i = 0; i < format_count; ++i )
+		{
+			formats[i * 2 + 0] = dwarf_read_uleb( c );
+			formats[i * 2 + 1] = dwarf_read_uleb( c );
+		}
+
+		uint64_t count = dwarf_read_uleb( c );
+		for( uint64_t e = 0; e < count && c->ptr < c->end; ++e )
+		{
+			const char* path = "";
+			uint64_t    dir  = 0;
+			for( uint8_t i = 0; i < format_count; ++i )
+			{
+				const char* str = 0x0;
+				uint64_t    val = 0;
+				dwarf_read_lnct_form( c, formats[i * 2 + 1], offset_size, strs, &str, &val );
+				if( formats[i * 2] == DW_LNCT_path && str )
+					path = str;
+				else if( formats[i * 2] == DW_LNCT_directory_index )
+					dir = val;
+			}
+
+			if( num_files == 0x0 )
+			{
+				if( *num_dirs < max_dirs )
+					dirs[(*num_dirs)++] = path;
+			}
+			else
+			{
+				// ... directory 0 is the compilation directory in v5 ...
+				if( dir == 0 )
+					line_add_file( lt, strings, 0x0, *num_dirs > 0 ? dirs[0] : 0x0, path );
+				else
+					line_add_file( lt, strings, dirs[0], dir < *num_dirs ? dirs[dir] : 0x0, path );
+				++*num_files;
+			}
+		}
+		return c->ptr < c->end;
+	}
+
+	/**
+	 * Decode one line-program (one compilation unit) and append its rows to lt->rows. comp_dir is the
+	 * compilation directory from the unit-DIE, only used before v5 where it is not part of the header.
+	 */
+	static void dwarf_decode_line_program( callstack_line_table_t* lt, callstack_string_chunk_t** strings, callstack_dwarf_cursor_t* unit, size_t offset_size, uint16_t version, const callstack_dwarf_strings_t* strs, const char* comp_dir )
+	{
+		uint8_t address_size = sizeof(void*);
+		if( version >= 5 )
+		{
+			address_size = dwarf_read_u8( unit );
+			dwarf_read_u8( unit ); // segment_selector_size
+		}
+
+		uint64_t header_length = dwarf_read_uint( unit, offset_size );
+		if( header_length > dwarf_left( unit ) )
+			return;
+		callstack_dwarf_cursor_t program = { unit->ptr + header_length, unit->end };
+
+		uint8_t min_inst_length = dwarf_read_u8( unit );
+		if( version >= 4 )
+			dwarf_read_u8( unit ); // maximum_operations_per_instruction, VLIW is not supported.
+		dwarf_read_u8( unit ); // default_is_stmt
+		int8_t  line_base   = (int8_t)dwarf_read_u8( unit );
+		uint8_t line_range  = dwarf_read_u8( unit );
+		uint8_t opcode_base = dwarf_read_u8( unit );
+		if( line_range == 0 || opcode_base == 0 )
+			return;
+
+		const uint8_t* std_opcode_lengths = unit->ptr;
+		dwarf_skip( unit, (uint64_t)opcode_base - 1 );
+
+		const char* dirs[512];
+		size_t   num_dirs = 0;
+		uint32_t first_file; // module file-index of file 0 in v5 and file 1 in v2-4.
+		size_t   num_files = 0;
+
+		first_file = (uint32_t)lt->num_files;
+		if( version >= 5 )
+		{
+			if( !dwarf_parse_v5_entries( unit, offset_size, strs, dirs, sizeof(dirs) / sizeof(dirs[0]), &num_dirs, lt, strings, 0x0 ) ||
+				!dwarf_parse_v5_entries( unit, offset_size, strs, dirs, sizeof(dirs) / sizeof(dirs[0]), &num_dirs, lt, strings, &num_files ) )
+				return;
+		}
+		else
+		{
+			// ... include_directories, directory 0 is the compilation directory that is only known from .debug_info ...
+			dirs[num_dirs++] = comp_dir;
+			for( ;; )
+			{
+				const char* dir = dwarf_read_str( unit );
+				if( dir[0] == '\0' )
+					break;
+				if( num_dirs < sizeof(dirs) / sizeof(dirs[0]) )
+					dirs[num_dirs++] = dir;
+			}
+
+			for( ;; )
+			{
+				const char* file = dwarf_read_str( unit );
+				if( file[0] == '\0' )
+					break;
+				uint64_t dir = dwarf_read_uleb( unit );
+				dwarf_read_uleb( unit ); // mtime
+				dwarf_read_uleb( unit ); // length
+				line_add_file( lt, strings, dir > 0 ? comp_dir : 0x0, dir < num_dirs ? dirs[dir] : 0x0, file );
+				++num_files;
+			}
+		}
+
+		// ... file-numbers are 0-based in v5 and 1-based before that ...
+		uint64_t file_number_base = version >= 5 ? 0 : 1;
+		lt->file_number_base = (uint32_t)file_number_base;
+
+		// ... run the line-number state machine ...
+		uint64_t address = 0;
+		uint64_t file    = 1;
+		int64_t  line    = 1;
+
+		#define CALLSTACK_LINE_EMIT() \
+			do { \
+				uint64_t file_index = file - file_number_base; \
+				line_add_row( lt, address, file_index < num_files ? first_file + (uint32_t)file_index : CALLSTACK_LINE_END_SEQUENCE - 1, (uint32_t)line ); \
+			} while( 0 )
+
+		while( program.ptr < program.end )
+		{
+			uint8_t opcode = dwarf_read_u8( &program );
+			if( opcode >= opcode_base )
+			{
+				uint8_t adjusted = (uint8_t)( opcode - opcode_base );
+				address += (uint64_t)( adjusted / line_range ) * min_inst_length;
+				line    += line_base + adjusted % line_range;
+				CALLSTACK_LINE_EMIT();
+				continue;
+			}
+
+			switch( opcode )
+			{
+				case 0:
+				{
+					uint64_t len = dwarf_read_uleb( &program );
+					if( len == 0 || len > dwarf_left( &program ) )
+						return;
+					callstack_dwarf_cursor_t ext = { program.ptr, program.ptr + len };
+					program.ptr += len;
+
+					switch( dwarf_read_u8( &ext ) )
+					{
+						case DW_LNE_end_sequence:
+							line_add_row( lt, address, CALLSTACK_LINE_END_SEQUENCE, 0 );
+							address = 0;
+							file    = 1;
+							line    = 1;
+							break;
+						case DW_LNE_set_address:
+							address = dwarf_read_uint( &ext, address_size );
+							break;
+						case DW_LNE_define_file:
+						{
+							const char* name = dwarf_read_str( &ext );
+							uint64_t    dir  = dwarf_read_uleb( &ext );
+							if( first_file + num_files == lt->num_files )
+							{
+								line_add_file( lt, strings, dir > 0 ? dirs[0] : 0x0, dir < num_dirs ? dirs[dir] : 0x0, name );
+								++num_files;
+							}
+							break;
+						}
+						default:
+							break; // ... DW_LNE_set_discriminator and vendor extensions ...
+					}
+					break;
+				}
+				case DW_LNS_copy:             CALLSTACK_LINE_EMIT(); break;
+				case DW_LNS_advance_pc:       address += dwarf_read_uleb( &program ) * min_inst_length; break;
+				case DW_LNS_advance_line:     line += dwarf_read_sleb( &program ); break;
+				case DW_LNS_set_file:         file = dwarf_read_uleb( &program ); break;
+				case DW_LNS_const_add_pc:     address += (uint64_t)( ( 255 - opcode_base ) / line_range ) * min_inst_length; break;
+				case DW_LNS_fixed_advance_pc: address += dwarf_read_u16( &program ); break;
+				default:
+					// ... opcodes with operands we do not care about, i.e. set_column, set_isa etc ...
+					for( uint8_t i = 0; i < std_opcode_lengths[opcode - 1]; ++i )
+						dwarf_read_uleb( &program );
+					break;
+			}
+		}
+
+		#undef CALLSTACK_LINE_EMIT
+	}
+
+	typedef struct
+	{
+		uint64_t addr;
+		size_t   first_row;
+		size_t   num_rows;
+	} callstack_line_sequence_t;
+
+	static int line_sequence_cmp( const void* a, const void* b )
+	{
+		const callstack_line_sequence_t* sa = (const callstack_line_sequence_t*)a;
+		const callstack_line_sequence_t* sb = (const callstack_line_sequence_t*)b;
+		if( sa->addr != sb->addr )
+			return sa->addr < sb->addr ? -1 : 1;
+		return sa->first_row < sb->first_row ? -1 : ( sa->first_row > sb->first_row ? 1 : 0 );
+	}
+
+	/**
+	 * Rows within a sequence are always sorted by address so instead of sorting all rows we
+	 * sort the sequences and lay them out after each other. Each sequence is terminated by an
+	 * end-row so the last row <= an address is always the one covering that address.
+	 */
+	static void line_sort_sequences( callstack_line_table_t* lt )
+	{
+		size_t num_seqs = 0;
+		for( size_t i = 0; i < lt->num_rows; ++i )
+			num_seqs += lt->rows[i].file == CALLSTACK_LINE_END_SEQUENCE;
+
+		callstack_line_sequence_t* seqs = (callstack_line_sequence_t*)malloc( num_seqs * sizeof(callstack_line_sequence_t) + 1 );
+		callstack_line_row_t*      rows = (callstack_line_row_t*)malloc( lt->num_rows * sizeof(callstack_line_row_t) + 1 );
+		if( seqs == 0x0 || rows == 0x0 )
+		{
+			free( seqs );
+			free( rows );
+			lt->num_rows = 0;
+			return;
+		}
+
+		num_seqs = 0;
+		size_t start = 0;
+		for( size_t i = 0; i < lt->num_rows; ++i )
+		{
+			if( lt->rows[i].file != CALLSTACK_LINE_END_SEQUENCE )
+				continue;
+
+			// ... sequences at address 0 are functions removed by the linker, i.e. --gc-sections ...
+			if( lt->rows[start].addr != 0 )
+			{
+				seqs[num_seqs].addr      = lt->rows[start].addr;
+				seqs[num_seqs].first_row = start;
+				seqs[num_seqs].num_rows  = i - start + 1;
+				++num_seqs;
+			}
+			start = i + 1;
+		}
+
+		qsort( seqs, num_seqs, sizeof(callstack_line_sequence_t), line_sequence_cmp );
+
+		size_t num_rows = 0;
+		for( size_t i = 0; i < num_seqs; ++i )
+		{
+			memcpy( rows + num_rows, lt->rows + seqs[i].first_row, seqs[i].num_rows * sizeof(callstack_line_row_t) );
+			num_rows += seqs[i].num_rows;
+		}
+
+		free( seqs );
+		free( lt->rows );
+		lt->rows     = rows;
+		lt->num_rows = num_rows;
+		lt->cap_rows = num_rows;
+	}
+
+	static const callstack_line_row_t* dwarf_find_line( const callstack_line_table_t* lt, uint64_t addr )
+	{
+		size_t lo = 0, hi = lt->num_rows;
+		while( lo < hi )
+		{
+			size_t mid = lo + ( hi - lo ) / 2;
+			if( lt->rows[mid].addr <= addr )
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if( lo == 0 )
+			return 0x0;
+
+		const callstack_line_row_t* row = &lt->rows[lo - 1];
+		if( row->file >= lt->num_files )
+			return 0x0; // ... addr is in a gap between sequences ...
+		return row;
+	}
+
+	// ... read an attribute-value of a DIE, strings are returned via str, numbers and string-indices (DW_FORM_strx*) via val ...
+	static void dwarf_read_attr_form( callstack_dwarf_cursor_t* c, uint64_t form, size_t offset_size, uint8_t address_size, const callstack_dwarf_strings_t* strs, const char** str, uint64_t* val, int* is_strx )
+	{
+		switch( form )
+		{
+			case DW_FORM_addr:           *val = dwarf_read_uint( c, address_size ); break;
+			case DW_FORM_flag:
+			case DW_FORM_ref1:
+			case DW_FORM_addrx1:         *val = dwarf_read_u8( c ); break;
+			case DW_FORM_ref2:
+			case DW_FORM_addrx2:         *val = dwarf_read_u16( c ); break;
+			case DW_FORM_addrx3:         *val = dwarf_read_uint( c, 3 ); break;
+			case DW_FORM_ref4:
+			case DW_FORM_ref_sup4:
+			case DW_FORM_addrx4:         *val = dwarf_read_u32( c ); break;
+			case DW_FORM_ref8:
+			case DW_FORM_ref_sig8:
+			case DW_FORM_ref_sup8:       *val = dwarf_read_u64( c ); break;
+			case DW_FORM_ref_udata:
+			case DW_FORM_addrx:
+			case DW_FORM_loclistx:
+			case DW_FORM_rnglistx:
+			case DW_FORM_GNU_addr_index: *val = dwarf_read_uleb( c ); break;
+			case DW_FORM_ref_addr:
+			case DW_FORM_sec_offset:
+			case DW_FORM_strp_sup:
+			case DW_FORM_GNU_ref_alt:
+			case DW_FORM_GNU_strp_alt:   *val = dwarf_read_uint( c, offset_size ); break;
+			case DW_FORM_exprloc:        dwarf_skip( c, dwarf_read_uleb( c ) ); break;
+			case DW_FORM_flag_present:
+			case DW_FORM_implicit_const: break;
+			case DW_FORM_strx:
+			case DW_FORM_GNU_str_index:  *val = dwarf_read_uleb( c );      *is_strx = 1; break;
+			case DW_FORM_strx1:          *val = dwarf_read_u8( c );        *is_strx = 1; break;
+			case DW_FORM_strx2:          *val = dwarf_read_u16( c );       *is_strx = 1; break;
+			case DW_FORM_strx3:          *val = dwarf_read_uint( c, 3 );   *is_strx = 1; break;
+			case DW_FORM_strx4:          *val = dwarf_read_u32( c );       *is_strx = 1; break;
+			case DW_FORM_indirect:       dwarf_read_attr_form( c, dwarf_read_uleb( c ), offset_size, address_size, strs, str, val, is_strx ); break;
+			default:                     dwarf_read_lnct_form( c, form, offset_size, strs, str, val ); break;
+		}
+	}
+
+	typedef struct
+	{
+		uint64_t at;
+		uint64_t form;
+		int64_t  implicit_const;
+	} callstack_dwarf_attr_spec_t;
+
+	typedef struct
+	{
+		uint64_t code;
+		uint64_t tag;
+		int      has_children;
+		size_t   first_spec; ///< index into callstack_dwarf_unit_t::specs
+		size_t   num_specs;
+	} callstack_dwarf_abbrev_t;
+
+	/**
+	 * Header of one unit in .debug_info and what is needed to decode the DIEs in it.
+	 */
+	typedef struct
+	{
+		const callstack_dwarf_sections_t* dw;
+
+		uint64_t                 info_offset;
+		callstack_dwarf_cursor_t dies; ///< DIEs of the unit, starting at the unit-DIE.
+		size_t                   offset_size;
+		uint8_t                  address_size;
+		uint16_t                 version;
+		uint8_t                  unit_type;
+		uint64_t                 abbrev_offset;
+
+		uint64_t base_address; ///< DW_AT_low_pc of the unit-DIE, base of range-lists.
+		uint64_t str_offsets_base;
+		uint64_t addr_base;
+		uint64_t rnglists_base;
+		uint64_t ranges_base; ///< DW_AT_GNU_ranges_base of pre v5 split units, added to offsets in .debug_ranges.
+
+		uint64_t    dwo_id;   ///< id of split unit, 0 if not split.
+		const char* dwo_name; ///< set if this is the skeleton of a split unit.
+		const char* comp_dir;
+
+		callstack_dwarf_abbrev_t*    abbrevs; ///< only loaded by dwarf_unit_load().
+		size_t                       num_abbrevs;
+		callstack_dwarf_attr_spec_t* specs;
+		size_t                       num_specs;
+	} callstack_dwarf_unit_t;
+
+	// ... parse the unit-header at info_offset, unit->dies is left at the unit-DIE ...
+	static int dwarf_unit_open( const callstack_dwarf_sections_t* dw, uint64_t info_offset, callstack_dwarf_unit_t* unit )
+	{
+		memset( unit, 0x0, sizeof(callstack_dwarf_unit_t) );
+		if( dw->debug_info == 0x0 || info_offset >= dw->debug_info_size )
+			return 0;
+
+		callstack_dwarf_cursor_t section;
+		dwarf_cursor_init( &section, dw->debug_info + info_offset, dw->debug_info_size - (size_t)info_offset );
+		uint64_t unit_length;
+		unit->offset_size = dwarf_read_unit_length( &section, &unit_length );
+		if( unit_length > dwarf_left( &section ) )
+			return 0;
+
+		unit->dw          = dw;
+		unit->info_offset = info_offset;
+		unit->dies.ptr    = section.ptr;
+		unit->dies.end    = section.ptr + unit_length;
+
+		unit->version = dwarf_read_u16( &unit->dies );
+		if( unit->version < 2 || unit->version > 5 )
+			return 0;
+		if( unit->version >= 5 )
+		{
+			unit->unit_type     = dwarf_read_u8( &unit->dies );
+			unit->address_size  = dwarf_read_u8( &unit->dies );
+			unit->abbrev_offset = dwarf_read_uint( &unit->dies, unit->offset_size );
+			if( unit->unit_type == DW_UT_skeleton || unit->unit_type == DW_UT_split_compile )
+				unit->dwo_id = dwarf_read_u64( &unit->dies );
+		}
+		else
+		{
+			unit->abbrev_offset = dwarf_read_uint( &unit->dies, unit->offset_size );
+			unit->address_size  = dwarf_read_u8( &unit->dies );
+		}
+
+		// ... defaults if the unit-DIE has no bases, the bases point past the header of each section, pre v5 split units has no header in .debug_str_offsets.dwo ...
+		unit->str_offsets_base = unit->version >= 5 ? unit->offset_size * 2 : 0;
+		unit->addr_base        = unit->offset_size * 2;
+		unit->rnglists_base    = unit->offset_size * 2 + 4;
+		return unit->abbrev_offset < dw->debug_abbrev_size;
+	}
+
+	static const char* dwarf_unit_str( const callstack_dwarf_unit_t* unit, uint64_t index )
+	{
+		const callstack_dwarf_strings_t* strs = &unit->dw->strs;
+		uint64_t entry = unit->str_offsets_base + index * unit->offset_size;
+		if( strs->debug_str_offsets == 0x0 || entry + unit->offset_size > strs->debug_str_offsets_size )
+			return "";
+		callstack_dwarf_cursor_t c;
+		dwarf_cursor_init( &c, strs->debug_str_offsets + entry, unit->offset_size );
+		return dwarf_str_at( strs->debug_str, strs->debug_str_size, dwarf_read_uint( &c, unit->offset_size ) );
+	}
+
+	static uint64_t dwarf_unit_addr( const callstack_dwarf_unit_t* unit, uint64_t index )
+	{
+		uint64_t entry = unit->addr_base + index * unit->address_size;
+		if( unit->dw->debug_addr == 0x0 || entry + unit->address_size > unit->dw->debug_addr_size )
+			return 0;
+		callstack_dwarf_cursor_t c;
+		dwarf_cursor_init( &c, unit->dw->debug_addr + entry, unit->address_size );
+		return dwarf_read_uint( &c, unit->address_size );
+	}
+
+	/**
+	 * Read DW_AT_stmt_list and DW_AT_comp_dir from the unit-DIE of cu, i.e. the first DIE in the unit,
+	 * the rest of the DIEs in the unit are never touched.
+	 */
+	static void dwarf_read_unit_die( const callstack_module_t* mod, callstack_dwarf_cu_t* cu, const char** comp_dir )
+	{
+		const callstack_dwarf_sections_t* dw = &mod->dwarf;
+		callstack_dwarf_unit_t unit;
+		if( !dwarf_unit_open( dw, cu->info_offset, &unit ) )
+			return;
+
+		// ... find the abbreviation of the unit-DIE, it is usually the first one ...
+		uint64_t code = dwarf_read_uleb( &unit.dies );
+		callstack_dwarf_cursor_t abbrev;
+		dwarf_cursor_init( &abbrev, dw->debug_abbrev + unit.abbrev_offset, dw->debug_abbrev_size - (size_t)unit.abbrev_offset );
+		for( ;; )
+		{
+			uint64_t abbrev_code = dwarf_read_uleb( &abbrev );
+			if( abbrev_code == 0 || dwarf_left( &abbrev ) == 0 )
+				return;
+			dwarf_read_uleb( &abbrev ); // tag
+			dwarf_read_u8( &abbrev );   // has_children
+			if( abbrev_code == code )
+				break;
+
+			for( ;; )
+			{
+				uint64_t at   = dwarf_read_uleb( &abbrev );
+				uint64_t form = dwarf_read_uleb( &abbrev );
+				if( form == DW_FORM_implicit_const )
+					dwarf_read_sleb( &abbrev );
+				if( ( at == 0 && form == 0 ) || dwarf_left( &abbrev ) == 0 )
+					break;
+			}
+		}
+
+		uint64_t comp_dir_strx = ~(uint64_t)0;
+		while( dwarf_left( &abbrev ) > 0 )
+		{
+			uint64_t at   = dwarf_read_uleb( &abbrev );
+			uint64_t form = dwarf_read_uleb( &abbrev );
+			if( form == DW_FORM_implicit_const )
+				dwarf_read_sleb( &abbrev );
+			if( at == 0 && form == 0 )
+				break;
+
+			const char* str    = 0x0;
+			uint64_t    val    = 0;
+			int         is_strx = 0;
+			dwarf_read_attr_form( &unit.dies, form, unit.offset_size, unit.address_size, &dw->strs, &str, &val, &is_strx );
+			switch( at )
+			{
+				case DW_AT_stmt_list:        cu->line_offset = val; break;
+				case DW_AT_str_offsets_base: unit.str_offsets_base = val; break;
+				case DW_AT_comp_dir:
+					if( is_strx )
+						comp_dir_strx = val;
+					else if( str )
+						*comp_dir = str;
+					break;
+				default:
+					break;
+			}
+		}
+
+		// ... DW_AT_str_offsets_base might come after DW_AT_comp_dir ...
+		if( comp_dir_strx != ~(uint64_t)0 )
+			*comp_dir = dwarf_unit_str( &unit, comp_dir_strx );
+	}
+
+	/**
+	 * Decode the line-program of cu, file-paths are stored in strings.
+	 *
+	 * Units share no state while loading so different units of the same module can be loaded from
+	 * different threads as long as they use separate string-pools.
+	 */
+	static void dwarf_load_cu( const callstack_module_t* mod, callstack_dwarf_cu_t* cu, callstack_string_chunk_t** strings )
+	{
+		const callstack_dwarf_sections_t* dw = &mod->dwarf;
+
+		const char* comp_dir = 0x0;
+		if( cu->info_offset != ~(uint64_t)0 )
+			dwarf_read_unit_die( mod, cu, &comp_dir );
+
+		if( cu->line_offset < dw->debug_line_size )
+		{
+			callstack_dwarf_cursor_t section;
+			dwarf_cursor_init( &section, dw->debug_line + cu->line_offset, dw->debug_line_size - (size_t)cu->line_offset );
+			uint64_t unit_length;
+			size_t offset_size = dwarf_read_unit_length( &section, &unit_length );
+			if( unit_length > 0 && unit_length <= dwarf_left( &section ) )
+			{
+				callstack_dwarf_cursor_t unit = { section.ptr, section.ptr + unit_length };
+				uint16_t version = dwarf_read_u16( &unit );
+				if( version >= 2 && version <= 5 )
+					dwarf_decode_line_program( &cu->lines, strings, &unit, offset_size, version, &dw->strs, comp_dir );
+			}
+		}
+
+		line_sort_sequences( &cu->lines );
+		cu->loaded = 1;
+	}
+
+	static void dwarf_add_cu_range( callstack_module_t* mod, uint64_t addr_begin, uint64_t addr_end, size_t cu )
+	{
+		if( mod->num_cu_ranges == mod->cap_cu_ranges )
+		{
+			size_t new_cap = mod->cap_cu_ranges ? mod->cap_cu_ranges * 2 : 256;
+			callstack_dwarf_range_t* new_ranges = (callstack_dwarf_range_t*)realloc( mod->cu_ranges, new_cap * sizeof(callstack_dwarf_range_t) );
+			if( new_ranges == 0x0 )
+				return;
+			mod->cu_ranges     = new_ranges;
+			mod->cap_cu_ranges = new_cap;
+		}
+		callstack_dwarf_range_t* range = &mod->cu_ranges[mod->num_cu_ranges++];
+		range->addr_begin = addr_begin;
+		range->addr_end   = addr_end;
+		range->cu         = cu;
+	}
+
+	static int dwarf_range_cmp( const void* a, const void* b )
+	{
+		const callstack_dwarf_range_t* ra = (const callstack_dwarf_range_t*)a;
+		const callstack_dwarf_range_t* rb = (const callstack_dwarf_range_t*)b;
+		return ra->addr_begin < rb->addr_begin ? -1 : ( ra->addr_begin > rb->addr_begin ? 1 : 0 );
+	}
+
+	// ... sort the unit-ranges and rebuild their search-tree after ranges were added, cu_ranges is 0x0 until the first range ...
+	static void dwarf_sort_cu_ranges( callstack_module_t* mod )
+	{
+		if( mod->num_cu_ranges == 0 )
+			return;
+		qsort( mod->cu_ranges, mod->num_cu_ranges, sizeof(callstack_dwarf_range_t), dwarf_range_cmp );
+		addr_tree_free( &mod->cu_ranges_tree );
+		addr_tree_build( &mod->cu_ranges_tree, mod->cu_ranges, sizeof(callstack_dwarf_range_t), mod->num_cu_ranges );
+	}
+
+	// ... count the units in a .debug_info or .debug_line section, offsets is filled with the offset of each unit if set ...
+	static size_t dwarf_find_units( const uint8_t* data, size_t size, int is_info, uint64_t* offsets )
+	{
+		size_t num_units = 0;
+		callstack_dwarf_cursor_t section;
+		dwarf_cursor_init( &section, data, size );
+		while( dwarf_left( &section ) > 0 )
+		{
+			uint64_t offset = (uint64_t)( section.ptr - data );
+			uint64_t unit_length;
+			dwarf_read_unit_length( &section, &unit_length );
+			if( unit_length == 0 || unit_length > dwarf_left( &section ) )
+				break;
+
+			callstack_dwarf_cursor_t unit = { section.ptr, section.ptr + unit_length };
+			section.ptr += unit_length;
+
+			// ... type-units have no code and are never looked up ...
+			uint16_t version = dwarf_read_u16( &unit );
+			if( is_info && version >= 5 )
+			{
+				uint8_t unit_type = dwarf_read_u8( &unit );
+				if( unit_type == DW_UT_type || unit_type == DW_UT_split_type )
+					continue;
+			}
+
+			if( offsets )
+				offsets[num_units] = offset;
+			++num_units;
+		}
+		return num_units;
+	}
+
+	enum
+	{
+		CALLSTACK_MAX_DEBUG_SECTIONS = 16,
+	};
+
+	/**
+	 * Find the debug-sections in names, sections that are compressed are decompressed into one arena
+	 * that is returned in arena/arena_size and has to be unmapped by the caller. Missing sections, and
+	 * sections that fail to decompress, are returned as 0x0.
+	 */
+	static void elf_load_debug_sections( const callstack_elf_file_t* elf, const char* const* names, size_t num, const uint8_t** data, size_t* size, void** arena, size_t* arena_size )
+	{
+		size_t uncompressed_size[CALLSTACK_MAX_DEBUG_SECTIONS];
+		size_t total = 0;
+		for( size_t i = 0; i < num; ++i )
+		{
+			data[i] = elf_find_debug_section( elf, names[i], &size[i], &uncompressed_size[i] );
+			if( data[i] == 0x0 )
+				size[i] = uncompressed_size[i] = 0;
+			total += ( uncompressed_size[i] + 7 ) & ~(size_t)7;
+		}
+
+		*arena      = 0x0;
+		*arena_size = 0;
+		if( total == 0 )
+			return;
+
+		*arena = mmap( 0x0, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+		if( *arena == MAP_FAILED )
+			*arena = 0x0;
+		else
+			*arena_size = total;
+
+		uint8_t* out = (uint8_t*)*arena;
+		for( size_t i = 0; i < num; ++i )
+		{
+			if( uncompressed_size[i] == 0 )
+				continue;
+			if( out == 0x0 || !inflate_zlib( data[i], size[i], out, uncompressed_size[i] ) )
+			{
+				data[i] = 0x0;
+				size[i] = 0;
+				continue;
+			}
+			data[i] = out;
+			size[i] = uncompressed_size[i];
+			out += ( uncompressed_size[i] + 7 ) & ~(size_t)7;
+		}
+		if( *arena )
+			mprotect( *arena, *arena_size, PROT_READ );
+	}
+
+	/**
+	 * Find the debug-sections used by the symbolizer, sections that are compressed are decompressed into
+	 * one arena owned by the module. Sections not read by the symbolizer, i.e. .debug_loc and .debug_frame,
+	 * are never touched. Returns .debug_aranges that is only needed while indexing.
+	 */
+	static const uint8_t* dwarf_find_sections( callstack_module_t* mod, size_t* aranges_size )
+	{
+		static const char* const NAMES[] = { ".debug_info", ".debug_abbrev", ".debug_line", ".debug_addr", ".debug_ranges", ".debug_rnglists",
+											 ".debug_str", ".debug_line_str", ".debug_str_offsets", ".debug_aranges" };
+		enum { NUM_SECTIONS = sizeof(NAMES) / sizeof(NAMES[0]) };
+
+		const uint8_t* data[NUM_SECTIONS];
+		size_t         size[NUM_SECTIONS];
+		elf_load_debug_sections( mod->debug.map ? &mod->debug : &mod->elf, NAMES, NUM_SECTIONS, data, size, &mod->zdebug, &mod->zdebug_size );
+
+		callstack_dwarf_sections_t* dw = &mod->dwarf;
+		dw->debug_info             = data[0];               dw->debug_info_size             = size[0];
+		dw->debug_abbrev           = data[1];               dw->debug_abbrev_size           = size[1];
+		dw->debug_line             = data[2];               dw->debug_line_size             = size[2];
+		dw->debug_addr             = data[3];               dw->debug_addr_size             = size[3];
+		dw->debug_ranges           = data[4];               dw->debug_ranges_size           = size[4];
+		dw->debug_rnglists         = data[5];               dw->debug_rnglists_size         = size[5];
+		dw->strs.debug_str         = (const char*)data[6];  dw->strs.debug_str_size         = size[6];
+		dw->strs.debug_line_str    = (const char*)data[7];  dw->strs.debug_line_str_size    = size[7];
+		dw->strs.debug_str_offsets = data[8];               dw->strs.debug_str_offsets_size = size[8];
+		*aranges_size = size[9];
+		return data[9];
+	}
+
+	/**
+	 * Build the list of units in the module and the address-ranges of the units from .debug_aranges.
+	 *
+	 * Only the unit-headers are read here, units not covered by .debug_aranges (clang does not emit it
+	 * by default) are indexed by dwarf_index_remaining() by decoding their line-programs the first
+	 * time it is needed.
+	 */
+	static void dwarf_index_units( callstack_module_t* mod )
+	{
+		callstack_dwarf_sections_t* dw = &mod->dwarf;
+		size_t         aranges_size;
+		const uint8_t* aranges = dwarf_find_sections( mod, &aranges_size );
+		if( dw->debug_line == 0x0 )
+			return;
+
+		// ... without .debug_info each line-program is treated as its own unit ...
+		int is_info = dw->debug_info != 0x0 && dw->debug_abbrev != 0x0;
+		const uint8_t* units      = is_info ? dw->debug_info      : dw->debug_line;
+		size_t         units_size = is_info ? dw->debug_info_size : dw->debug_line_size;
+
+		size_t num_units = dwarf_find_units( units, units_size, is_info, 0x0 );
+		uint64_t* offsets = (uint64_t*)malloc( num_units * sizeof(uint64_t) + 1 );
+		mod->cus = (callstack_dwarf_cu_t*)calloc( num_units + 1, sizeof(callstack_dwarf_cu_t) );
+		if( offsets == 0x0 || mod->cus == 0x0 )
+		{
+			free( offsets );
+			return;
+		}
+		dwarf_find_units( units, units_size, is_info, offsets );
+
+		for( size_t i = 0; i < num_units; ++i )
+		{
+			mod->cus[i].info_offset = is_info ? offsets[i] : ~(uint64_t)0;
+			mod->cus[i].line_offset = is_info ? ~(uint64_t)0 : offsets[i];
+		}
+		mod->num_cus       = num_units;
+		mod->num_unindexed = num_units;
+		free( offsets );
+
+		if( aranges == 0x0 || !is_info )
+			return;
+
+		callstack_dwarf_cursor_t section;
+		dwarf_cursor_init( &section, aranges, aranges_size );
+		while( dwarf_left( &section ) > 0 )
+		{
+			const uint8_t* set_start = section.ptr;
+			uint64_t set_length;
+			size_t offset_size = dwarf_read_unit_length( &section, &set_length );
+			if( set_length == 0 || set_length > dwarf_left( &section ) )
+				break;
+
+			callstack_dwarf_cursor_t set = { section.ptr, section.ptr + set_length };
+			section.ptr += set_length;
+
+			uint16_t version      = dwarf_read_u16( &set );
+			uint64_t info_offset  = dwarf_read_uint( &set, offset_size );
+			uint8_t  address_size = dwarf_read_u8( &set );
+			uint8_t  segment_size = dwarf_read_u8( &set );
+			if( version != 2 || segment_size != 0 || ( address_size != 4 && address_size != 8 ) )
+				continue;
+
+			// ... tuples are aligned to twice the address-size from the start of the set ...
+			size_t header_size = (size_t)( set.ptr - set_start );
+			dwarf_skip( &set, ( 2 * address_size - header_size % ( 2 * address_size ) ) % ( 2 * address_size ) );
+
+			size_t lo = 0, hi = mod->num_cus;
+			while( lo < hi )
+			{
+				size_t mid = lo + ( hi - lo ) / 2;
+				if( mod->cus[mid].info_offset < info_offset )
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			if( lo == mod->num_cus || mod->cus[lo].info_offset != info_offset || mod->cus[lo].indexed )
+				continue;
+
+			while( dwarf_left( &set ) >= 2 * (size_t)address_size )
+			{
+				uint64_t addr = dwarf_read_uint( &set, address_size );
+				uint64_t len  = dwarf_read_uint( &set, address_size );
+				if( addr == 0 && len == 0 )
+					break;
+				// ... ranges at address 0 are functions removed by the linker, i.e. --gc-sections ...
+				if( addr != 0 && len != 0 )
+					dwarf_add_cu_range( mod, addr, addr + len, lo );
+			}
+			mod->cus[lo].indexed = 1;
+			--mod->num_unindexed;
+		}
+
+		dwarf_sort_cu_ranges( mod );
+	}
+
+	/**
+	 * Load all units not covered by .debug_aranges and add the range of each of their line-sequences to
+	 * the index, this is as expensive as decoding all of .debug_line but only done once per module and
+	 * only if the module is missing .debug_aranges for some units.
+	 */
+	static void dwarf_index_remaining( callstack_module_t* mod )
+	{
+		for( size_t i = 0; i < mod->num_cus; ++i )
+		{
+			callstack_dwarf_cu_t* cu = &mod->cus[i];
+			if( cu->indexed )
+				continue;
+			if( !cu->loaded )
+				dwarf_load_cu( mod, cu, &mod->strings );
+
+			// ... rows are sorted by sequence and each sequence ends with an end-row ...
+			size_t start = 0;
+			for( size_t r = 0; r < cu->lines.num_rows; ++r )
+			{
+				if( cu->lines.rows[r].file != CALLSTACK_LINE_END_SEQUENCE )
+					continue;
+				if( cu->lines.rows[r].addr > cu->lines.rows[start].addr )
+					dwarf_add_cu_range( mod, cu->lines.rows[start].addr, cu->lines.rows[r].addr, i );
+				start = r + 1;
+			}
+			cu->indexed = 1;
+		}
+		mod->num_unindexed = 0;
+		dwarf_sort_cu_ranges( mod );
+	}
+
+	/**
+	 * Find the unit covering addr. If addr is not in the index and build_index is set all units not in
+	 * the index yet are indexed before giving up.
+	 */
+	static callstack_dwarf_cu_t* dwarf_find_cu( callstack_module_t* mod, uint64_t addr, int build_index )
+	{
+		size_t lo = addr_tree_upper_bound( &mod->cu_ranges_tree, addr );
+		if( lo > 0 && addr < mod->cu_ranges[lo - 1].addr_end )
+			return &mod->cus[mod->cu_ranges[lo - 1].cu];
+
+		if( build_index && mod->num_unindexed > 0 )
+		{
+			dwarf_index_remaining( mod );
+			return dwarf_find_cu( mod, addr, 0 );
+		}
+		return 0x0;
+	}
+
+	static int dwarf_form_is_addrx( uint64_t form )
+	{
+		return form == DW_FORM_addrx || form == DW_FORM_GNU_addr_index || ( form >= DW_FORM_addrx1 && form <= DW_FORM_addrx4 );
+	}
+
+	// ... read the value of one attribute of a DIE, indexed strings and addresses are resolved through the unit ...
+	static void dwarf_unit_read_attr( const callstack_dwarf_unit_t* unit, callstack_dwarf_cursor_t* c, const callstack_dwarf_attr_spec_t* spec, const char** str, uint64_t* val )
+	{
+		*str = 0x0;
+		*val = 0;
+		if( spec->form == DW_FORM_implicit_const )
+		{
+			*val = (uint64_t)spec->implicit_const;
+			return;
+		}
+
+		int is_strx = 0;
+		dwarf_read_attr_form( c, spec->form, unit->offset_size, unit->address_size, &unit->dw->strs, str, val, &is_strx );
+		if( is_strx )
+			*str = dwarf_unit_str( unit, *val );
+		else if( dwarf_form_is_addrx( spec->form ) )
+			*val = dwarf_unit_addr( unit, *val );
+	}
+
+	static void dwarf_unit_free( callstack_dwarf_unit_t* unit )
+	{
+		free( unit->abbrevs );
+		free( unit->specs );
+		unit->abbrevs = 0x0;
+		unit->specs   = 0x0;
+	}
+
+	static const callstack_dwarf_abbrev_t* dwarf_unit_find_abbrev( const callstack_dwarf_unit_t* unit, uint64_t code )
+	{
+		// ... codes are usually assigned in order starting at 1 ...
+		if( code - 1 < unit->num_abbrevs && unit->abbrevs[code - 1].code == code )
+			return &unit->abbrevs[code - 1];
+		for( size_t i = 0; i < unit->num_abbrevs; ++i )
+			if( unit->abbrevs[i].code == code )
+				return &unit->abbrevs[i];
+		return 0x0;
+	}
+
+	/**
+	 * Open the unit at info_offset, load its abbreviation-table and read the bases from the unit-DIE
+	 * so that all DIEs in the unit can be decoded. The unit is freed with dwarf_unit_free().
+	 *
+	 * When loading a split unit skeleton should be its skeleton-unit, the split unit-DIE has no bases
+	 * for addresses or ranges since those are in the module and not in the .dwo/.dwp-file.
+	 */
+	static int dwarf_unit_load( const callstack_dwarf_sections_t* dw, uint64_t info_offset, callstack_dwarf_unit_t* unit, const callstack_dwarf_unit_t* skeleton )
+	{
+		if( !dwarf_unit_open( dw, info_offset, unit ) )
+			return 0;
+		if( skeleton )
+		{
+			unit->base_address = skeleton->base_address;
+			unit->addr_base    = skeleton->addr_base;
+			unit->ranges_base  = skeleton->ranges_base;
+		}
+
+		size_t cap_abbrevs = 0, cap_specs = 0;
+		callstack_dwarf_cursor_t c;
+		dwarf_cursor_init( &c, dw->debug_abbrev + unit->abbrev_offset, dw->debug_abbrev_size - (size_t)unit->abbrev_offset );
+		while( dwarf_left( &c ) > 0 )
+		{
+			uint64_t code = dwarf_read_uleb( &c );
+			if( code == 0 )
+				break;
+
+			if( unit->num_abbrevs == cap_abbrevs )
+			{
+				cap_abbrevs = cap_abbrevs ? cap_abbrevs * 2 : 64;
+				callstack_dwarf_abbrev_t* new_abbrevs = (callstack_dwarf_abbrev_t*)realloc( unit->abbrevs, cap_abbrevs * sizeof(callstack_dwarf_abbrev_t) );
+				if( new_abbrevs == 0x0 )
+					return 0;
+				unit->abbrevs = new_abbrevs;
+			}
+
+			callstack_dwarf_abbrev_t* abbrev = &unit->abbrevs[unit->num_abbrevs++];
+			abbrev->code         = code;
+			abbrev->tag          = dwarf_read_uleb( &c );
+			abbrev->has_children = dwarf_read_u8( &c ) != 0;
+			abbrev->first_spec   = unit->num_specs;
+			abbrev->num_specs    = 0;
+			while( dwarf_left( &c ) > 0 )
+			{
+				callstack_dwarf_attr_spec_t spec;
+				spec.at             = dwarf_read_uleb( &c );
+				spec.form           = dwarf_read_uleb( &c );
+				spec.implicit_const = spec.form == DW_FORM_implicit_const ? dwarf_read_sleb( &c ) : 0;
+				if( spec.at == 0 && spec.form == 0 )
+					break;
+
+				if( unit->num_specs == cap_specs )
+				{
+					cap_specs = cap_specs ? cap_specs * 2 : 256;
+					callstack_dwarf_attr_spec_t* new_specs = (callstack_dwarf_attr_spec_t*)realloc( unit->specs, cap_specs * sizeof(callstack_dwarf_attr_spec_t) );
+					if( new_specs == 0x0 )
+						return 0;
+					unit->specs = new_specs;
+				}
+				unit->specs[unit->num_specs++] = spec;
+				++abbrev->num_specs;
+			}
+		}
+
+		// ... read the bases from the unit-DIE, they are needed to resolve other attributes of the unit-DIE so read it twice ...
+		callstack_dwarf_cursor_t die = unit->dies;
+		const callstack_dwarf_abbrev_t* abbrev = dwarf_unit_find_abbrev( unit, dwarf_read_uleb( &die ) );
+		if( abbrev == 0x0 )
+			return 0;
+		callstack_dwarf_cursor_t attrs = die;
+		for( size_t i = 0; i < abbrev->num_specs; ++i )
+		{
+			const callstack_dwarf_attr_spec_t* spec = &unit->specs[abbrev->first_spec + i];
+			const char* str;
+			uint64_t    val;
+			dwarf_unit_read_attr( unit, &attrs, spec, &str, &val );
+			switch( spec->at )
+			{
+				case DW_AT_str_offsets_base: unit->str_offsets_base = val; break;
+				case DW_AT_addr_base:
+				case DW_AT_GNU_addr_base:    unit->addr_base        = val; break;
+				case DW_AT_rnglists_base:    unit->rnglists_base    = val; break;
+				case DW_AT_GNU_ranges_base:  unit->ranges_base      = val; break;
+				case DW_AT_GNU_dwo_id:       unit->dwo_id           = val; break;
+				default: break;
+			}
+		}
+		attrs = die;
+		for( size_t i = 0; i < abbrev->num_specs; ++i )
+		{
+			const callstack_dwarf_attr_spec_t* spec = &unit->specs[abbrev->first_spec + i];
+			const char* str;
+			uint64_t    val;
+			dwarf_unit_read_attr( unit, &attrs, spec, &str, &val );
+			switch( spec->at )
+			{
+				case DW_AT_low_pc:       unit->base_address = val; break;
+				case DW_AT_comp_dir:     unit->comp_dir     = str; break;
+				case DW_AT_dwo_name:
+				case DW_AT_GNU_dwo_name: unit->dwo_name     = str; break;
+				default: break;
+			}
+		}
+		return 1;
+	}
+
+	static void dwo_file_close( callstack_dwo_file_t* file )
+	{
+		elf_file_close( &file->elf );
+		if( file->arena )
+			munmap( file->arena, file->arena_size );
+		memset( file, 0x0, sizeof(callstack_dwo_file_t) );
+	}
+
+	static void dwo_file_free( callstack_dwo_file_t* file )
+	{
+		if( file == 0x0 )
+			return;
+		dwo_file_close( file );
+		free( file );
+	}
+
+	static int dwo_file_open( callstack_dwo_file_t* file, const char* path )
+	{
+		static const char* const NAMES[CALLSTACK_DWO_NUM_SECTIONS] = { ".debug_info.dwo", ".debug_abbrev.dwo", ".debug_str.dwo", ".debug_str_offsets.dwo", ".debug_rnglists.dwo", ".debug_cu_index" };
+
+		memset( file, 0x0, sizeof(callstack_dwo_file_t) );
+		if( elf_file_open( &file->elf, path ) )
+			elf_load_debug_sections( &file->elf, NAMES, CALLSTACK_DWO_NUM_SECTIONS, file->sections, file->sizes, &file->arena, &file->arena_size );
+		if( file->sections[CALLSTACK_DWO_INFO] == 0x0 || file->sections[CALLSTACK_DWO_ABBREV] == 0x0 )
+		{
+			dwo_file_close( file );
+			return 0;
+		}
+		return 1;
+	}
+
+	// ... open the .dwo-file named by the skeleton-unit, a relative name is relative to the compilation-directory ...
+	static callstack_dwo_file_t* dwo_file_load( const callstack_dwarf_unit_t* skeleton )
+	{
+		char path[PATH_MAX];
+		int  len;
+		if( skeleton->dwo_name[0] != '/' && skeleton->comp_dir )
+			len = snprintf( path, sizeof(path), "%s/%s", skeleton->comp_dir, skeleton->dwo_name );
+		else
+			len = snprintf( path, sizeof(path), "%s", skeleton->dwo_name );
+		if( len <= 0 || (size_t)len >= sizeof(path) )
+			return 0x0;
+
+		callstack_dwo_file_t* file = (callstack_dwo_file_t*)malloc( sizeof(callstack_dwo_file_t) );
+		if( file && !dwo_file_open( file, path ) )
+		{
+			free( file );
+			return 0x0;
+		}
+		return file;
+	}
+
+	/**
+	 * Find the contributions of the split unit with id dwo_id in .debug_cu_index of a .dwp-file, offsets
+	 * and sizes are indexed by CALLSTACK_DWO_* and are 0 for sections the unit has no contribution to.
+	 * Both version 2 (the GNU-extension) and 5 of the index are supported.
+	 */
+	static int dwp_find_unit( const callstack_dwo_file_t* dwp, uint64_t dwo_id, uint64_t* offsets, uint64_t* sizes )
+	{
+		// ... section-ids that are the same in version 2 and 5, only 5 has a column for .debug_rnglists.dwo ...
+		enum
+		{
+			DW_SECT_INFO        = 1,
+			DW_SECT_ABBREV      = 3,
+			DW_SECT_STR_OFFSETS = 6,
+			DW_SECT_RNGLISTS    = 8,
+		};
+
+		callstack_dwarf_cursor_t c;
+		dwarf_cursor_init( &c, dwp->sections[CALLSTACK_DWO_CU_INDEX], dwp->sizes[CALLSTACK_DWO_CU_INDEX] );
+		uint32_t version     = dwarf_read_u32( &c ) & 0xffff; // ... v5 has a 2 byte version and 2 bytes padding ...
+		uint64_t num_columns = dwarf_read_u32( &c );
+		uint64_t num_units   = dwarf_read_u32( &c );
+		uint64_t num_slots   = dwarf_read_u32( &c );
+		if( ( version != 2 && version != 5 ) || num_slots == 0 || ( num_slots & ( num_slots - 1 ) ) != 0 )
+			return 0;
+		if( num_slots * 12 + num_columns * 4 + num_units * num_columns * 8 > dwarf_left( &c ) )
+			return 0;
+
+		const uint8_t* hashes  = c.ptr;
+		const uint8_t* rows    = hashes + num_slots * 8;
+		const uint8_t* columns = rows + num_slots * 4;
+		const uint8_t* table   = columns + num_columns * 4;
+
+		uint64_t mask = num_slots - 1;
+		uint64_t slot = dwo_id & mask;
+		uint64_t step = ( ( dwo_id >> 32 ) & mask ) | 1;
+		uint32_t row  = 0;
+		for( uint64_t i = 0; i < num_slots && row == 0; ++i, slot = ( slot + step ) & mask )
+		{
+			dwarf_cursor_init( &c, rows + slot * 4, 4 );
+			uint32_t slot_row = dwarf_read_u32( &c );
+			if( slot_row == 0 )
+				return 0; // ... empty slot, dwo_id is not in the index ...
+			dwarf_cursor_init( &c, hashes + slot * 8, 8 );
+			if( dwarf_read_u64( &c ) == dwo_id )
+				row = slot_row;
+		}
+		if( row == 0 || row > num_units )
+			return 0;
+
+		memset( offsets, 0x0, CALLSTACK_DWO_NUM_SECTIONS * sizeof(uint64_t) );
+		memset( sizes,   0x0, CALLSTACK_DWO_NUM_SECTIONS * sizeof(uint64_t) );
+		for( uint64_t col = 0; col < num_columns; ++col )
+		{
+			dwarf_cursor_init( &c, columns + col * 4, 4 );
+			int section;
+			switch( dwarf_read_u32( &c ) )
+			{
+				case DW_SECT_INFO:        section = CALLSTACK_DWO_INFO; break;
+				case DW_SECT_ABBREV:      section = CALLSTACK_DWO_ABBREV; break;
+				case DW_SECT_STR_OFFSETS: section = CALLSTACK_DWO_STR_OFFSETS; break;
+				case DW_SECT_RNGLISTS:    section = version == 5 ? CALLSTACK_DWO_RNGLISTS : -1; break;
+				default:                  section = -1; break;
+			}
+			if( section < 0 )
+				continue;
+
+			uint64_t cell = ( row - 1 ) * num_columns + col;
+			dwarf_cursor_init( &c, table + cell * 4, 4 );
+			offsets[section] = dwarf_read_u32( &c );
+			dwarf_cursor_init( &c, table + ( num_units * num_columns + cell ) * 4, 4 );
+			sizes[section] = dwarf_read_u32( &c );
+		}
+		return 1;
+	}
+
+	/**
+	 * Setup the sections of the split unit that skeleton is the skeleton-unit of. DIEs, abbreviations and
+	 * strings are read from the .dwp-file of the module or from the .dwo-file of the unit, opened here on
+	 * first use, while addresses and pre v5 range-lists are still read from the module.
+	 */
+	static int dwarf_split_sections( const callstack_module_t* mod, callstack_dwarf_cu_t* cu, const callstack_dwarf_unit_t* skeleton, callstack_dwarf_sections_t* split )
+	{
+		uint64_t offsets[CALLSTACK_DWO_NUM_SECTIONS];
+		uint64_t sizes[CALLSTACK_DWO_NUM_SECTIONS];
+		const callstack_dwo_file_t* file = 0x0;
+		if( mod->dwp.sections[CALLSTACK_DWO_CU_INDEX] && skeleton->dwo_id != 0 && dwp_find_unit( &mod->dwp, skeleton->dwo_id, offsets, sizes ) )
+			file = &mod->dwp;
+		else
+		{
+			if( cu->dwo == 0x0 && skeleton->dwo_name )
+				cu->dwo = dwo_file_load( skeleton );
+			if( cu->dwo == 0x0 )
+				return 0;
+			file = cu->dwo;
+			for( int i = 0; i < CALLSTACK_DWO_NUM_SECTIONS; ++i )
+			{
+				offsets[i] = 0;
+				sizes[i]   = file->sizes[i];
+			}
+		}
+
+		// ... strings are shared by all units in a .dwp-file ...
+		offsets[CALLSTACK_DWO_STR] = 0;
+		sizes[CALLSTACK_DWO_STR]   = file->sizes[CALLSTACK_DWO_STR];
+
+		const uint8_t* data[CALLSTACK_DWO_NUM_SECTIONS];
+		size_t         size[CALLSTACK_DWO_NUM_SECTIONS];
+		for( int i = 0; i < CALLSTACK_DWO_NUM_SECTIONS; ++i )
+		{
+			int valid = file->sections[i] && sizes[i] > 0 && offsets[i] <= file->sizes[i] && sizes[i] <= file->sizes[i] - offsets[i];
+			data[i] = valid ? file->sections[i] + offsets[i] : 0x0;
+			size[i] = valid ? (size_t)sizes[i] : 0;
+		}
+
+		memset( split, 0x0, sizeof(callstack_dwarf_sections_t) );
+		split->debug_info             = data[CALLSTACK_DWO_INFO];
+		split->debug_info_size        = size[CALLSTACK_DWO_INFO];
+		split->debug_abbrev           = data[CALLSTACK_DWO_ABBREV];
+		split->debug_abbrev_size      = size[CALLSTACK_DWO_ABBREV];
+		split->debug_rnglists         = data[CALLSTACK_DWO_RNGLISTS];
+		split->debug_rnglists_size    = size[CALLSTACK_DWO_RNGLISTS];
+		split->debug_addr             = mod->dwarf.debug_addr;
+		split->debug_addr_size        = mod->dwarf.debug_addr_size;
+		split->debug_ranges           = mod->dwarf.debug_ranges;
+		split->debug_ranges_size      = mod->dwarf.debug_ranges_size;
+		split->strs.debug_str         = (const char*)data[CALLSTACK_DWO_STR];
+		split->strs.debug_str_size    = size[CALLSTACK_DWO_STR];
+		split->strs.debug_str_offsets      = data[CALLSTACK_DWO_STR_OFFSETS];
+		split->strs.debug_str_offsets_size = size[CALLSTACK_DWO_STR_OFFSETS];
+		return split->debug_info != 0x0 && split->debug_abbrev != 0x0;
+	}
+
+	// ... convert the value of a reference-attribute to an offset in .debug_info, ~0 if form is not a supported reference ...
+	static uint64_t dwarf_unit_ref( const callstack_dwarf_unit_t* unit, uint64_t form, uint64_t val )
+	{
+		switch( form )
+		{
+			case DW_FORM_ref1:
+			case DW_FORM_ref2:
+			case DW_FORM_ref4:
+			case DW_FORM_ref8:
+			case DW_FORM_ref_udata: return unit->info_offset + val;
+			case DW_FORM_ref_addr:  return val;
+			default:                return ~(uint64_t)0;
+		}
+	}
+
+	/**
+	 * Find the name of the function described by the DIE at die_offset, the linkage-name is preferred
+	 * since it will be demangled to the same name as the symbol of a real function. References via
+	 * DW_AT_abstract_origin and DW_AT_specification are followed until a name is found.
+	 */
+	static const char* dwarf_die_name( const callstack_module_t* mod, const callstack_dwarf_unit_t* unit, uint64_t die_offset, int max_refs )
+	{
+		const callstack_dwarf_sections_t* dw = unit->dw;
+		uint64_t unit_end = (uint64_t)( unit->dies.end - dw->debug_info );
+
+		// ... the reference might be to another unit, i.e. with LTO, units are only looked up in the module itself and not in .dwo-files ...
+		callstack_dwarf_unit_t other;
+		memset( &other, 0x0, sizeof(other) );
+		if( die_offset < unit->info_offset || die_offset >= unit_end )
+		{
+			if( dw != &mod->dwarf )
+				return 0x0;
+			size_t lo = 0, hi = mod->num_cus;
+			while( lo < hi )
+			{
+				size_t mid = lo + ( hi - lo ) / 2;
+				if( mod->cus[mid].info_offset <= die_offset )
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			if( lo == 0 || !dwarf_unit_load( dw, mod->cus[lo - 1].info_offset, &other, 0x0 ) )
+			{
+				dwarf_unit_free( &other );
+				return 0x0;
+			}
+			unit     = &other;
+			unit_end = (uint64_t)( other.dies.end - dw->debug_info );
+		}
+
+		const char* name    = 0x0;
+		const char* linkage = 0x0;
+		uint64_t    ref     = ~(uint64_t)0;
+		if( die_offset < unit_end )
+		{
+			callstack_dwarf_cursor_t c = { dw->debug_info + die_offset, unit->dies.end };
+			const callstack_dwarf_abbrev_t* abbrev = dwarf_unit_find_abbrev( unit, dwarf_read_uleb( &c ) );
+			for( size_t i = 0; abbrev && i < abbrev->num_specs; ++i )
+			{
+				const callstack_dwarf_attr_spec_t* spec = &unit->specs[abbrev->first_spec + i];
+				const char* str;
+				uint64_t    val;
+				dwarf_unit_read_attr( unit, &c, spec, &str, &val );
+				switch( spec->at )
+				{
+					case DW_AT_name:              name = str; break;
+					case DW_AT_linkage_name:
+					case DW_AT_MIPS_linkage_name: linkage = str; break;
+					case DW_AT_abstract_origin:
+					case DW_AT_specification:     ref = dwarf_unit_ref( unit, spec->form, val ); break;
+					default: break;
+				}
+			}
+		}
+
+		const char* res = linkage ? linkage : name;
+		if( res == 0x0 && ref != ~(uint64_t)0 && max_refs > 0 )
+			res = dwarf_die_name( mod, unit, ref, max_refs - 1 );
+		dwarf_unit_free( &other );
+		return res;
+	}
+
+	static void dwarf_add_inline( callstack_dwarf_inline_list_t* list, const callstack_dwarf_inline_t* in, uint64_t addr_begin, uint64_t addr_end )
+	{
+		// ... ranges at address 0 are functions removed by the linker, i.e. --gc-sections ...
+		if( addr_begin == 0 || addr_begin >= addr_end )
+			return;
+
+		if( list->num == list->cap )
+		{
+			size_t new_cap = list->cap ? list->cap * 2 : 64;
+			callstack_dwarf_inline_t* new_entries = (callstack_dwarf_inline_t*)realloc( list->entries, new_cap * sizeof(callstack_dwarf_inline_t) );
+			if( new_entries == 0x0 )
+				return;
+			list->entries = new_entries;
+			list->cap     = new_cap;
+		}
+		callstack_dwarf_inline_t* out = &list->entries[list->num++];
+		*out = *in;
+		out->addr_begin = addr_begin;
+		out->addr_end   = addr_end;
+	}
+
+	// ... add one entry per range in the range-list referenced by a DW_AT_ranges, .debug_ranges before v5 and .debug_rnglists from v5 ...
+	static void dwarf_add_inline_ranges( const callstack_dwarf_unit_t* unit, callstack_dwarf_inline_list_t* list, const callstack_dwarf_inline_t* in, uint64_t form, uint64_t val )
+	{
+		const callstack_dwarf_sections_t* dw = unit->dw;
+		uint64_t base = unit->base_address;
+		uint8_t  as   = unit->address_size;
+		callstack_dwarf_cursor_t c;
+
+		if( unit->version < 5 )
+		{
+			val += unit->ranges_base;
+			if( dw->debug_ranges == 0x0 || val >= dw->debug_ranges_size )
+				return;
+			uint64_t max_addr = as == 8 ? ~(uint64_t)0 : 0xffffffff;
+			dwarf_cursor_init( &c, dw->debug_ranges + val, dw->debug_ranges_size - (size_t)val );
+			while( dwarf_left( &c ) >= 2 * (size_t)as )
+			{
+				uint64_t begin = dwarf_read_uint( &c, as );
+				uint64_t end   = dwarf_read_uint( &c, as );
+				if( begin == 0 && end == 0 )
+					break;
+				if( begin == max_addr )
+					base = end;
+				else
+					dwarf_add_inline( list, in, base + begin, base + end );
+			}
+			return;
+		}
+
+		if( dw->debug_rnglists == 0x0 )
+			return;
+		if( form == DW_FORM_rnglistx )
+		{
+			// ... offsets in the offset-table are relative to the table itself ...
+			uint64_t entry = unit->rnglists_base + val * unit->offset_size;
+			if( entry + unit->offset_size > dw->debug_rnglists_size )
+				return;
+			dwarf_cursor_init( &c, dw->debug_rnglists + entry, unit->offset_size );
+			val = unit->rnglists_base + dwarf_read_uint( &c, unit->offset_size );
+		}
+		if( val >= dw->debug_rnglists_size )
+			return;
+
+		dwarf_cursor_init( &c, dw->debug_rnglists + val, dw->debug_rnglists_size - (size_t)val );
+		while( dwarf_left( &c ) > 0 )
+		{
+			uint64_t begin, end;
+			switch( dwarf_read_u8( &c ) )
+			{
+				case DW_RLE_base_addressx: base = dwarf_unit_addr( unit, dwarf_read_uleb( &c ) ); continue;
+				case DW_RLE_base_address:  base = dwarf_read_uint( &c, as ); continue;
+				case DW_RLE_startx_endx:
+					begin = dwarf_unit_addr( unit, dwarf_read_uleb( &c ) );
+					end   = dwarf_unit_addr( unit, dwarf_read_uleb( &c ) );
+					break;
+				case DW_RLE_startx_length:
+					begin = dwarf_unit_addr( unit, dwarf_read_uleb( &c ) );
+					end   = begin + dwarf_read_uleb( &c );
+					break;
+				case DW_RLE_offset_pair:
+					begin = base + dwarf_read_uleb( &c );
+					end   = base + dwarf_read_uleb( &c );
+					break;
+				case DW_RLE_start_end:
+					begin = dwarf_read_uint( &c, as );
+					end   = dwarf_read_uint( &c, as );
+					break;
+				case DW_RLE_start_length:
+					begin = dwarf_read_uint( &c, as );
+					end   = begin + dwarf_read_uleb( &c );
+					break;
+				default:
+					return; // ... DW_RLE_end_of_list or unknown entry ...
+			}
+			dwarf_add_inline( list, in, begin, end );
+		}
+	}
+
+	static int dwarf_inline_cmp( const void* a, const void* b )
+	{
+		const callstack_dwarf_inline_t* ia = (const callstack_dwarf_inline_t*)a;
+		const callstack_dwarf_inline_t* ib = (const callstack_dwarf_inline_t*)b;
+		if( ia->addr_begin != ib->addr_begin )
+			return ia->addr_begin < ib->addr_begin ? -1 : 1;
+		return ia->depth < ib->depth ? -1 : ( ia->depth > ib->depth ? 1 : 0 );
+	}
+
+	enum
+	{
+		CALLSTACK_DWARF_MAX_DIE_DEPTH = 256, ///< deepest DIE-tree walked when looking for inlined functions.
+		CALLSTACK_MAX_INLINE_DEPTH    = 64,  ///< max number of inlined frames reported for one address.
+	};
+
+	static void dwarf_sort_inlines( callstack_dwarf_inline_list_t* list )
+	{
+		if( list->num > 1 )
+			qsort( list->entries, list->num, sizeof(callstack_dwarf_inline_t), dwarf_inline_cmp );
+		uint64_t max_end = 0;
+		for( size_t i = 0; i < list->num; ++i )
+		{
+			if( list->entries[i].addr_end > max_end )
+				max_end = list->entries[i].addr_end;
+			list->entries[i].max_end = max_end;
+		}
+	}
+
+	/**
+	 * Walk all DIEs of cu and collect the ranges of all DW_TAG_inlined_subroutine:s, this is only done
+	 * for units that inlined frames are requested from.
+	 *
+	 * For modules without .symtab the ranges of all DW_TAG_subprogram:s are collected as well since
+	 * .dynsym only has the exported functions. Their names are demangled up front into strings so that
+	 * nothing in the unit is modified when it is later used to resolve addresses.
+	 */
+	static void dwarf_load_inlines( const callstack_module_t* mod, callstack_dwarf_cu_t* cu, callstack_string_chunk_t** strings, int short_names )
+	{
+		cu->inlines_loaded = 1;
+
+		callstack_dwarf_unit_t unit;
+		if( cu->info_offset == ~(uint64_t)0 || !dwarf_unit_load( &mod->dwarf, cu->info_offset, &unit, 0x0 ) )
+		{
+			dwarf_unit_free( &unit );
+			return;
+		}
+
+		// ... the DIEs of a split unit are in a .dwo/.dwp-file, the skeleton-unit in the module only has the bases ...
+		callstack_dwarf_sections_t split;
+		if( unit.dwo_name || unit.unit_type == DW_UT_skeleton )
+		{
+			callstack_dwarf_unit_t skeleton = unit;
+			memset( &unit, 0x0, sizeof(unit) );
+			int ok = dwarf_split_sections( mod, cu, &skeleton, &split ) &&
+					 dwarf_unit_load( &split, 0, &unit, &skeleton ) &&
+					 ( unit.dwo_id == 0 || skeleton.dwo_id == 0 || unit.dwo_id == skeleton.dwo_id );
+			dwarf_unit_free( &skeleton );
+			if( !ok )
+			{
+				dwarf_unit_free( &unit );
+				return;
+			}
+		}
+
+		// ... number of inlined functions enclosing the children of each DIE on the path to the current one ...
+		uint32_t depths[CALLSTACK_DWARF_MAX_DIE_DEPTH];
+		int      level = 0;
+
+		callstack_dwarf_cursor_t c = unit.dies;
+		while( dwarf_left( &c ) > 0 )
+		{
+			uint64_t die_offset = (uint64_t)( c.ptr - unit.dw->debug_info );
+			uint64_t code = dwarf_read_uleb( &c );
+			if( code == 0 )
+			{
+				if( --level <= 0 )
+					break;
+				continue;
+			}
+
+			const callstack_dwarf_abbrev_t* abbrev = dwarf_unit_find_abbrev( &unit, code );
+			if( abbrev == 0x0 )
+				break;
+
+			uint32_t depth   = level > 0 ? depths[level - 1] : 0;
+			int      inlined = abbrev->tag == DW_TAG_inlined_subroutine;
+			int      func    = abbrev->tag == DW_TAG_subprogram && !mod->has_symtab;
+
+			callstack_dwarf_inline_t in;
+			memset( &in, 0x0, sizeof(in) );
+			in.depth = depth;
+			uint64_t low_pc = 0, high_pc = 0, origin = ~(uint64_t)0;
+			uint64_t ranges = 0, ranges_form = 0;
+			int      high_pc_is_offset = 0;
+			for( size_t i = 0; i < abbrev->num_specs; ++i )
+			{
+				const callstack_dwarf_attr_spec_t* spec = &unit.specs[abbrev->first_spec + i];
+				if( !inlined && !func )
+				{
+					// ... just skip the value, no need to resolve anything ...
+					const char* str = 0x0;
+					uint64_t    val = 0;
+					int         is_strx = 0;
+					if( spec->form != DW_FORM_implicit_const )
+						dwarf_read_attr_form( &c, spec->form, unit.offset_size, unit.address_size, &unit.dw->strs, &str, &val, &is_strx );
+					continue;
+				}
+
+				const char* str;
+				uint64_t    val;
+				dwarf_unit_read_attr( &unit, &c, spec, &str, &val );
+				switch( spec->at )
+				{
+					case DW_AT_low_pc:          low_pc = val; break;
+					case DW_AT_high_pc:         high_pc = val; high_pc_is_offset = spec->form != DW_FORM_addr && !dwarf_form_is_addrx( spec->form ); break;
+					case DW_AT_ranges:          ranges = val; ranges_form = spec->form; break;
+					case DW_AT_abstract_origin: origin = dwarf_unit_ref( &unit, spec->form, val ); break;
+					case DW_AT_call_file:       in.call_file = (uint32_t)val; break;
+					case DW_AT_call_line:       in.call_line = (uint32_t)val; break;
+					default: break;
+				}
+			}
+
+			callstack_dwarf_inline_list_t* list = inlined ? &cu->inlines : &cu->funcs;
+			if( inlined )
+				in.name = origin != ~(uint64_t)0 ? dwarf_die_name( mod, &unit, origin, 8 ) : 0x0;
+			else if( func && ( low_pc != 0 || ranges_form != 0 ) )
+				in.name = dwarf_die_name( mod, &unit, die_offset, 8 ); // ... declarations have no address and are skipped ...
+
+			if( inlined || func )
+			{
+				if( ranges_form != 0 )
+					dwarf_add_inline_ranges( &unit, list, &in, ranges_form, ranges );
+				else if( low_pc != 0 )
+					dwarf_add_inline( list, &in, low_pc, high_pc_is_offset ? low_pc + high_pc : high_pc );
+			}
+
+			if( abbrev->has_children )
+			{
+				if( level == CALLSTACK_DWARF_MAX_DIE_DEPTH )
+					break;
+				depths[level++] = depth + (uint32_t)inlined;
+			}
+			else if( level == 0 )
+				break; // ... unit-DIE without children ...
+		}
+		dwarf_unit_free( &unit );
+
+		dwarf_sort_inlines( &cu->inlines );
+		dwarf_sort_inlines( &cu->funcs );
+
+		for( size_t i = 0; i < cu->funcs.num; ++i )
+		{
+			callstack_dwarf_inline_t* fn = &cu->funcs.entries[i];
+			if( fn->name )
+				fn->demangled = demangle_into_pool( strings, fn->name, short_names );
+		}
+	}
+
+	// ... find the entries of list covering addr, the last one starting first, returns number found ...
+	static int dwarf_find_inline_entries( callstack_dwarf_inline_list_t* list, uint64_t addr, callstack_dwarf_inline_t** out, int max_out )
+	{
+		size_t lo = 0, hi = list->num;
+		while( lo < hi )
+		{
+			size_t mid = lo + ( hi - lo ) / 2;
+			if( list->entries[mid].addr_begin <= addr )
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+
+		int num = 0;
+		for( size_t i = lo; i > 0 && list->entries[i - 1].max_end > addr && num < max_out; --i )
+			if( addr < list->entries[i - 1].addr_end )
+				out[num++] = &list->entries[i - 1];
+		return num;
+	}
+
+	// ... find the inlined functions covering addr ordered from the innermost to the outermost, returns number found ...
+	static int dwarf_find_inlines( callstack_dwarf_cu_t* cu, uint64_t addr, callstack_dwarf_inline_t** out, int max_out )
+	{
+		int num = dwarf_find_inline_entries( &cu->inlines, addr, out, max_out );
+		for( int i = 1; i < num; ++i )
+			for( int j = i; j > 0 && out[j - 1]->depth < out[j]->depth; --j )
+			{
+				callstack_dwarf_inline_t* tmp = out[j];
+				out[j]     = out[j - 1];
+				out[j - 1] = tmp;
+			}
+		return num;
+	}
+
+	// ... find the DW_TAG_subprogram covering addr, the innermost if nested, 0x0 if none ...
+	static const callstack_dwarf_inline_t* dwarf_find_function( callstack_dwarf_cu_t* cu, uint64_t addr )
+	{
+		callstack_dwarf_inline_t* fn;
+		return dwarf_find_inline_entries( &cu->funcs, addr, &fn, 1 ) ? fn : 0x0;
+	}
+
+	static int index_array_ok( size_t size, uint64_t offset, uint64_t num, size_t elem_size )
+	{
+		return offset % 8 == 0 && offset <= size && num <= ( size - offset ) / elem_size;
+	}
+
+	// ... map <path>.csidx if it exists and was written for the same build as elf, returns 0x0 otherwise ...
+	// ... setup tree over the num elements at offset in index, the keys were written by callstack_index_write() at tree_offset ...
+	static int index_tree_open( const callstack_index_header_t* idx, size_t size, callstack_addr_tree_t* tree, uint64_t offset, uint64_t num, size_t stride, uint64_t tree_offset )
+	{
+		size_t total = addr_tree_layout( tree, (const uint8_t*)idx + offset, stride, (size_t)num );
+		if( tree_offset % ( CALLSTACK_ADDR_TREE_KEYS * sizeof(uint64_t) ) != 0 || !index_array_ok( size, tree_offset, total, sizeof(uint64_t) ) )
+			return 0;
+		tree->keys = num > 0 ? (const uint64_t*)( (const uint8_t*)idx + tree_offset ) : 0x0;
+		return 1;
+	}
+
+	static const callstack_index_header_t* index_open( const callstack_elf_file_t* elf, const char* path, size_t* index_size, callstack_addr_tree_t* funcs_tree, callstack_addr_tree_t* line_blocks_tree )
+	{
+		size_t         id_size;
+		const uint8_t* id = elf_find_build_id( elf, &id_size );
+		char           index_path[PATH_MAX];
+		if( id == 0x0 || id_size > CALLSTACK_MAX_BUILD_ID || !realpath( path, index_path ) || strlen( index_path ) + sizeof(".csidx") > sizeof(index_path) )
+			return 0x0;
+		strcat( index_path, ".csidx" );
+
+		int fd = open( index_path, O_RDONLY | O_CLOEXEC );
+		if( fd < 0 )
+			return 0x0;
+
+		struct stat st;
+		void* map = MAP_FAILED;
+		if( fstat( fd, &st ) == 0 && (size_t)st.st_size >= sizeof(callstack_index_header_t) )
+			map = mmap( 0x0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		close( fd );
+		if( map == MAP_FAILED )
+			return 0x0;
+
+		size_t size = (size_t)st.st_size;
+		const callstack_index_header_t* idx = (const callstack_index_header_t*)map;
+		if( memcmp( idx->magic, CALLSTACK_INDEX_MAGIC, sizeof(CALLSTACK_INDEX_MAGIC) ) != 0 ||
+			( idx->flags & ~(uint32_t)CALLSTACK_INDEX_FUNCS_FROM_DWARF ) != 0 ||
+			idx->build_id_size != id_size ||
+			memcmp( idx->build_id, id, id_size ) != 0 ||
+			!index_array_ok( size, idx->funcs, idx->num_funcs, sizeof(callstack_index_func_t) ) ||
+			!index_array_ok( size, idx->files, idx->num_files, sizeof(uint32_t) ) ||
+			!index_array_ok( size, idx->line_blocks, idx->num_line_blocks, sizeof(callstack_index_line_block_t) ) ||
+			!index_tree_open( idx, size, funcs_tree, idx->funcs, idx->num_funcs, sizeof(callstack_index_func_t), idx->funcs_tree ) ||
+			!index_tree_open( idx, size, line_blocks_tree, idx->line_blocks, idx->num_line_blocks, sizeof(callstack_index_line_block_t), idx->line_blocks_tree ) ||
+			!index_array_ok( size, idx->line_data, idx->line_data_size, 1 ) ||
+			!index_array_ok( size, idx->strings, idx->strings_size, 1 ) ||
+			idx->strings_size == 0 || idx->strings_size > 0xffffffff ||
+			( (const char*)map )[idx->strings + idx->strings_size - 1] != '\0' )
+		{
+			munmap( map, size );
+			return 0x0;
+		}
+		*index_size = size;
+		return idx;
+	}
+
+	static const char* index_string( const callstack_index_header_t* idx, uint32_t offset )
+	{
+		// ... the last string is 0-terminated, checked in index_open(), so any offset in range gives a valid string ...
+		return offset < idx->strings_size ? (const char*)idx + idx->strings + offset : "failed to lookup symbol";
+	}
+
+	static const callstack_index_func_t* index_find_func( const callstack_module_t* mod, uint64_t addr )
+	{
+		const callstack_index_func_t* funcs = (const callstack_index_func_t*)( (const uint8_t*)mod->index + mod->index->funcs );
+		size_t lo = addr_tree_upper_bound( &mod->index_funcs_tree, addr );
+		for( size_t i = lo; i > 0 && funcs[i - 1].max_end > addr; --i )
+			if( addr < funcs[i - 1].addr_end )
+				return &funcs[i - 1];
+		return 0x0;
+	}
+
+	static int index_find_line( const callstack_module_t* mod, uint64_t addr, const char** file, unsigned int* line )
+	{
+		const callstack_index_header_t*     idx    = mod->index;
+		const callstack_index_line_block_t* blocks = (const callstack_index_line_block_t*)( (const uint8_t*)idx + idx->line_blocks );
+		size_t lo = addr_tree_upper_bound( &mod->index_line_blocks_tree, addr );
+		if( lo == 0 )
+			return 0;
+
+		// ... only the rows of one block are decoded, the first row is always at the address of the block ...
+		const callstack_index_line_block_t* block = &blocks[lo - 1];
+		callstack_dwarf_cursor_t c;
+		dwarf_cursor_init( &c, (const uint8_t*)idx + idx->line_data, idx->line_data_size );
+		dwarf_skip( &c, block->data );
+
+		uint64_t row_addr = block->addr;
+		uint64_t row_file = 0;
+		uint64_t row_line = 0;
+		for( uint32_t i = 0; i < block->num_rows && dwarf_left( &c ) > 0; ++i )
+		{
+			uint64_t next_addr = row_addr + dwarf_read_uleb( &c );
+			if( next_addr > addr )
+				break;
+			row_addr = next_addr;
+			row_file = dwarf_read_uleb( &c );
+			row_line = dwarf_read_uleb( &c );
+		}
+		if( row_file == 0 || row_file > idx->num_files )
+			return 0;
+
+		const uint32_t* files = (const uint32_t*)( (const uint8_t*)idx + idx->files );
+		*file = index_string( idx, files[row_file - 1] );
+		*line = (unsigned int)row_line;
+		return 1;
+	}
+
+	// ... load symbols and index the debug-info of a module that has elf opened ...
+	static void module_load_debug_info( callstack_module_t* mod, const char* path )
+	{
+		// ... the debug-file is only looked for when the module is stripped, and as the module itself only mapped on first lookup in the module ...
+		size_t size;
+		size_t zsize;
+		if( elf_find_debug_section( &mod->elf, ".debug_line", &size, &zsize ) == 0x0 || elf_find_section( &mod->elf, ".symtab", &size ) == 0x0 )
+			if( !elf_open_debug_file( &mod->elf, path, &mod->debug ) )
+				elf_file_close( &mod->debug );
+
+		mod->has_symtab = elf_load_symbols( mod, &mod->elf, ".symtab", ".strtab" ) ||
+						  elf_load_symbols( mod, &mod->debug, ".symtab", ".strtab" );
+		if( !mod->has_symtab )
+			elf_load_symbols( mod, &mod->elf, ".dynsym", ".dynstr" );
+		dwarf_index_units( mod );
+
+		// ... split units are looked up in <module>.dwp first, only the index is read here, DIEs are read per unit when needed ...
+		char dwp_path[PATH_MAX];
+		if( mod->dwarf.debug_addr && realpath( path, dwp_path ) && strlen( dwp_path ) + sizeof(".dwp") <= sizeof(dwp_path) )
+		{
+			strcat( dwp_path, ".dwp" );
+			if( !dwo_file_open( &mod->dwp, dwp_path ) || mod->dwp.sections[CALLSTACK_DWO_CU_INDEX] == 0x0 )
+				dwo_file_close( &mod->dwp );
+		}
+		mod->debug_loaded = 1;
+	}
+
+	static void module_load( callstack_module_t* mod, const char* path )
+	{
+		memset( mod, 0x0, sizeof(callstack_module_t) );
+		if( !elf_file_open( &mod->elf, path ) )
+			return;
+
+		// ... with a precomputed index nothing is parsed here, debug-info is only loaded if inlined frames are requested ...
+		mod->index = index_open( &mod->elf, path, &mod->index_size, &mod->index_funcs_tree, &mod->index_line_blocks_tree );
+		if( mod->index )
+			mod->path = string_pool_join( &mod->strings, &path, 1 );
+		if( mod->index && mod->path == path )
+		{
+			munmap( (void*)mod->index, mod->index_size );
+			mod->index = 0x0;
+		}
+		if( mod->index == 0x0 )
+			module_load_debug_info( mod, path );
+		mod->load_ok = 1;
+	}
+
+	static void module_require_debug_info( callstack_module_t* mod )
+	{
+		if( mod->load_ok && !mod->debug_loaded )
+			module_load_debug_info( mod, mod->path );
+	}
+
+	static int module_has_build_id( const callstack_module_t* mod, const char* id_hex )
+	{
+		size_t         id_size;
+		const uint8_t* id = elf_find_build_id( &mod->elf, &id_size );
+		char           hex[CALLSTACK_MAX_BUILD_ID * 2 + 1];
+		if( id == 0x0 || id_size > CALLSTACK_MAX_BUILD_ID )
+			return id_hex[0] == '\0';
+		elf_build_id_hex( id, id_size, hex );
+		return strcmp( hex, id_hex ) == 0;
+	}
+
+	static void module_free( callstack_module_t* mod )
+	{
+		elf_file_close( &mod->elf );
+		elf_file_close( &mod->debug );
+		if( mod->zdebug )
+			munmap( mod->zdebug, mod->zdebug_size );
+		dwo_file_close( &mod->dwp );
+		free( mod->syms );
+		addr_tree_free( &mod->syms_tree );
+		addr_tree_free( &mod->cu_ranges_tree );
+		for( size_t i = 0; i < mod->num_cus; ++i )
+		{
+			free( mod->cus[i].lines.rows );
+			free( mod->cus[i].lines.files );
+			free( mod->cus[i].inlines.entries );
+			free( mod->cus[i].funcs.entries );
+			dwo_file_free( mod->cus[i].dwo );
+		}
+		free( mod->cus );
+		free( mod->cu_ranges );
+		string_pool_free( mod->strings );
+		if( mod->index )
+			munmap( (void*)mod->index, mod->index_size );
+		memset( mod, 0x0, sizeof(callstack_module_t) );
+	}
+
+	/**
+	 * One object loaded in the process, i.e. the executable or a shared library, as reported by
+	 * dl_iterate_phdr().
+	 */
+	typedef struct
+	{
+		uintptr_t   addr_begin; ///< first runtime-address covered by the module.
+		uintptr_t   addr_end;   ///< one past the last runtime-address covered by the module.
+		uintptr_t   load_bias;  ///< difference between runtime-address and address in elf-file.
+		const char* path;
+		const char* build_id;   ///< hex-string of the build the file at path needs to be, only set for modules read from a dump.
+		int         is_main;    ///< module is the main executable.
+
+		callstack_module_t* data; ///< symbol-data, 0x0 until loaded.
+	} callstack_module_entry_t;
+
+	typedef struct
+	{
+		// ... pool to store demangled names in, 0x0 to store them with the module the symbol belongs to ...
+		callstack_string_chunk_t** strings;
+
+		int short_names; ///< drop template-arguments, see CALLSTACK_DEMANGLE_SHORT.
+	} callstack_demangler_t;
+
+	struct callstack_symbolizer
+	{
+		// ... sorted by addr_begin ...
+		callstack_module_entry_t* modules;
+		size_t                    num_modules;
+
+		// ... dlpi_adds/dlpi_subs when modules was built, used to detect dlopen()/dlclose() ...
+		unsigned long long adds;
+		unsigned long long subs;
+
+		callstack_string_chunk_t* strings;
+
+		callstack_demangler_t demangler;
+
+		int offline; ///< modules are read from a dump, see callstack_symbolizer_create_from_dump(), and the table is never refreshed.
+	};
+
+	typedef struct
+	{
+		callstack_symbolizer_t*   symbolizer;
+		callstack_module_entry_t* modules;
+		size_t                    num_modules;
+		size_t                    cap_modules;
+	} callstack_module_table_builder_t;
+
+	// ... runtime-addresses covered by the PT_LOAD segments of a module reported by dl_iterate_phdr(), returns 0 if there are none ...
+	static int module_phdr_range( struct dl_phdr_info* info, uintptr_t* addr_begin, uintptr_t* addr_end )
+	{
+		*addr_begin = ~(uintptr_t)0;
+		*addr_end   = 0;
+		for( ElfW(Half) i = 0; i < info->dlpi_phnum; ++i )
+		{
+			const ElfW(Phdr)* phdr = &info->dlpi_phdr[i];
+			if( phdr->p_type != PT_LOAD )
+				continue;
+			uintptr_t begin = (uintptr_t)info->dlpi_addr + phdr->p_vaddr;
+			uintptr_t end   = begin + phdr->p_memsz;
+			if( begin < *addr_begin ) *addr_begin = begin;
+			if( end   > *addr_end )   *addr_end   = end;
+		}
+		return *addr_begin < *addr_end;
+	}
+
+	static int module_table_add( struct dl_phdr_info* info, size_t, void* data )
+	{
+		callstack_module_table_builder_t* builder = (callstack_module_table_builder_t*)data;
+
+		if( builder->num_modules == builder->cap_modules )
+		{
+			size_t new_cap = builder->cap_modules ? builder->cap_modules * 2 : 64;
+			callstack_module_entry_t* new_modules = (callstack_module_entry_t*)realloc( builder->modules, new_cap * sizeof(callstack_module_entry_t) );
+			if( new_modules == 0x0 )
+				return 1;
+			builder->modules     = new_modules;
+			builder->cap_modules = new_cap;
+		}
+
+		callstack_module_entry_t* mod = &builder->modules[builder->num_modules];
+		mod->load_bias = (uintptr_t)info->dlpi_addr;
+		if( !module_phdr_range( info, &mod->addr_begin, &mod->addr_end ) )
+			return 0;
+
+		// ... first entry reported by dl_iterate_phdr() is always the main executable and it has no name ...
+		mod->is_main = builder->num_modules == 0;
+		const char* path = mod->is_main || info->dlpi_name == 0x0 || info->dlpi_name[0] == '\0' ? "/proc/self/exe" : info->dlpi_name;
+		mod->path     = string_pool_join( &builder->symbolizer->strings, &path, 1 );
+		mod->build_id = 0x0;
+		mod->data     = 0x0;
+
+		++builder->num_modules;
+		return 0;
+	}
+
+	static int module_table_read_counters( struct dl_phdr_info* info, size_t size, void* data )
+	{
+		unsigned long long* counters = (unsigned long long*)data;
+		if( size >= offsetof( struct dl_phdr_info, dlpi_subs ) + sizeof( info->dlpi_subs ) )
+		{
+			counters[0] = info->dlpi_adds;
+			counters[1] = info->dlpi_subs;
+		}
+		return 1; // ... counters are the same for all entries so stop after the first one ...
+	}
+
+	static int module_entry_cmp( const void* a, const void* b )
+	{
+		const callstack_module_entry_t* ma = (const callstack_module_entry_t*)a;
+		const callstack_module_entry_t* mb = (const callstack_module_entry_t*)b;
+		return ma->addr_begin < mb->addr_begin ? -1 : ( ma->addr_begin > mb->addr_begin ? 1 : 0 );
+	}
+
+	static void module_entry_free( callstack_module_entry_t* mod )
+	{
+		if( mod->data )
+		{
+			module_free( mod->data );
+			free( mod->data );
+			mod->data = 0x0;
+		}
+	}
+
+	/**
+	 * Rebuild the module table if something was loaded or unloaded since it was last built. Symbol-data
+	 * of modules that are still loaded at the same address is kept.
+	 * @return 1 if any module was unloaded, i.e. addresses resolved before might now be invalid.
+	 */
+	static int symbolizer_refresh_modules( callstack_symbolizer_t* symbolizer )
+	{
+		if( symbolizer->offline )
+			return 0;
+
+		unsigned long long counters[2] = { 0, 0 };
+		dl_iterate_phdr( module_table_read_counters, counters );
+		if( symbolizer->modules != 0x0 && counters[0] == symbolizer->adds && counters[1] == symbolizer->subs )
+			return 0;
+
+		callstack_module_table_builder_t builder = { symbolizer, 0x0, 0, 0 };
+		dl_iterate_phdr( module_table_add, &builder );
+		qsort( builder.modules, builder.num_modules, sizeof(callstack_module_entry_t), module_entry_cmp );
+
+		for( size_t i = 0; i < symbolizer->num_modules; ++i )
+		{
+			callstack_module_entry_t* old_mod = &symbolizer->modules[i];
+			for( size_t j = 0; j < builder.num_modules && old_mod->data; ++j )
+			{
+				callstack_module_entry_t* new_mod = &builder.modules[j];
+				if( new_mod->data == 0x0 && new_mod->load_bias == old_mod->load_bias && strcmp( new_mod->path, old_mod->path ) == 0 )
+				{
+					new_mod->data = old_mod->data;
+					old_mod->data = 0x0;
+				}
+			}
+			module_entry_free( old_mod );
+		}
+
+		int unloaded = counters[1] != symbolizer->subs;
+		free( symbolizer->modules );
+		symbolizer->modules     = builder.modules;
+		symbolizer->num_modules = builder.num_modules;
+		symbolizer->adds        = counters[0];
+		symbolizer->subs        = counters[1];
+		return unloaded;
+	}
+
+	static callstack_module_entry_t* symbolizer_find_module( callstack_symbolizer_t* symbolizer, uintptr_t addr )
+	{
+		size_t lo = 0, hi = symbolizer->num_modules;
+		while( lo < hi )
+		{
+			size_t mid = lo + ( hi - lo ) / 2;
+			if( symbolizer->modules[mid].addr_begin <= addr )
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if( lo == 0 || addr >= symbolizer->modules[lo - 1].addr_end )
+			return 0x0;
+		return &symbolizer->modules[lo - 1];
+	}
+
+	static callstack_module_t* module_entry_data( callstack_module_entry_t* mod, int signal_safe )
+	{
+		if( mod->data == 0x0 && !signal_safe )
+		{
+			mod->data = (callstack_module_t*)malloc( sizeof(callstack_module_t) );
+			if( mod->data )
+				module_load( mod->data, mod->path );
+
+			// ... a module from a dump might have been rebuilt since, the debug-file of the recorded build is used instead if it exists ...
+			if( mod->data && mod->build_id && !module_has_build_id( mod->data, mod->build_id ) )
+			{
+				char path[PATH_MAX];
+				module_free( mod->data );
+				if( elf_build_id_path( mod->build_id, path, sizeof(path) ) )
+					module_load( mod->data, path );
+				if( !module_has_build_id( mod->data, mod->build_id ) )
+					mod->data->load_ok = 0;
+			}
+		}
+		return mod->data;
+	}
+
+	callstack_symbolizer_t* callstack_symbolizer_create()
+	{
+		callstack_symbolizer_t* symbolizer = (callstack_symbolizer_t*)malloc( sizeof(callstack_symbolizer_t) );
+		if( symbolizer == 0x0 )
+			return 0x0;
+
+		memset( symbolizer, 0x0, sizeof(callstack_symbolizer_t) );
+
+		// ... load the executable up front so that it can be used from signal-handlers ...
+		symbolizer_refresh_modules( symbolizer );
+		for( size_t i = 0; i < symbolizer->num_modules; ++i )
+			if( symbolizer->modules[i].is_main )
+				module_entry_data( &symbolizer->modules[i], 0 );
+		return symbolizer;
+	}
+
+	void callstack_symbolizer_destroy( callstack_symbolizer_t* symbolizer )
+	{
+		if( symbolizer == 0x0 )
+			return;
+		for( size_t i = 0; i < symbolizer->num_modules; ++i )
+			module_entry_free( &symbolizer->modules[i] );
+		free( symbolizer->modules );
+		string_pool_free( symbolizer->strings );
+		free( symbolizer );
+	}
+
+	int callstack_symbolizer_set_demangle( callstack_symbolizer_t* symbolizer, enum callstack_demangle mode )
+	{
+		if( symbolizer == 0x0 )
+			return -1;
+		switch( mode )
+		{
+			case CALLSTACK_DEMANGLE_FULL:
+			case CALLSTACK_DEMANGLE_SHORT:
+				symbolizer->demangler.short_names = mode == CALLSTACK_DEMANGLE_SHORT;
+				return 0;
+		}
+		return -1;
+	}
+
+	/**
+	 * Resolve one address in mod, all strings in out point to storage owned by the symbolizer and
+	 * stay valid until it is destroyed. Demangled names are only generated once per symbol.
+	 *
+	 * If signal_safe is set only data that is already loaded is used and nothing is allocated, i.e.
+	 * names not demangled by an earlier lookup are returned mangled.
+	 */
+	static void symbolizer_resolve( callstack_demangler_t* demangler, callstack_module_entry_t* entry, callstack_module_t* mod, void* address, callstack_symbol_t* out, int signal_safe )
+	{
+		out->function = "failed to lookup symbol";
+		out->offset   = 0;
+		out->file     = "failed to lookup file";
+		out->line     = 0;
+		out->inlined  = 0;
+
+		if( mod == 0x0 || !mod->load_ok )
+			return;
+
+		uint64_t addr = (uint64_t)( (uintptr_t)address - entry->load_bias );
+		if( mod->index )
+		{
+			// ... all strings are in the mapped index, nothing to demangle or allocate ...
+			const callstack_index_func_t* fn = index_find_func( mod, ( mod->index->flags & CALLSTACK_INDEX_FUNCS_FROM_DWARF ) ? addr - 1 : addr );
+			if( fn )
+			{
+				out->function = index_string( mod->index, demangler->short_names ? fn->short_name : fn->name );
+				out->offset   = (unsigned int)( addr - fn->addr_begin );
+			}
+			index_find_line( mod, addr - 1, &out->file, &out->line );
+			return;
+		}
+
+		callstack_string_chunk_t** strings = demangler->strings ? demangler->strings : &mod->strings;
+
+		// ... addresses from callstack() are return-addresses, look up the call instruction instead ...
+		callstack_dwarf_cu_t* cu = dwarf_find_cu( mod, addr - 1, !signal_safe );
+		if( cu && !cu->loaded && !signal_safe )
+			dwarf_load_cu( mod, cu, strings );
+		if( cu && cu->loaded && !cu->inlines_loaded && !mod->has_symtab && !signal_safe )
+			dwarf_load_inlines( mod, cu, strings, demangler->short_names );
+
+		const callstack_dwarf_inline_t* fn  = cu && cu->inlines_loaded ? dwarf_find_function( cu, addr - 1 ) : 0x0;
+		callstack_elf_sym_t*            sym = fn ? 0x0 : elf_find_symbol( mod, addr );
+		if( fn )
+		{
+			out->function = fn->demangled ? fn->demangled : "failed to lookup symbol";
+			out->offset   = (unsigned int)( addr - fn->addr_begin );
+		}
+		else if( sym )
+		{
+			if( sym->demangled == 0x0 && !signal_safe )
+				sym->demangled = demangle_into_pool( strings, sym->name, demangler->short_names );
+			out->function = sym->demangled ? sym->demangled : sym->name;
+			out->offset   = (unsigned int)( addr - sym->addr );
+		}
+
+		const callstack_line_row_t* row = cu && cu->loaded ? dwarf_find_line( &cu->lines, addr - 1 ) : 0x0;
+		if( row )
+		{
+			out->file = cu->lines.files[row->file];
+			out->line = row->line;
+		}
+	}
+
+	/**
+	 * Resolve all addresses where out_syms[i].function is 0x0, the rest are left as is.
+	 *
+	 * Addresses are resolved grouped by the module they belong to so that each module is loaded, and
+	 * its tables touched, once per batch even if frames from different modules are interleaved in the
+	 * stack.
+	 */
+	static void symbolizer_resolve_batch( callstack_symbolizer_t* symbolizer, void** addresses, callstack_symbol_t* out_syms, int num_addresses, int signal_safe )
+	{
+		for( int i = 0; i < num_addresses; ++i )
+		{
+			if( out_syms[i].function != 0x0 )
+				continue;
+
+			callstack_module_entry_t* entry = symbolizer_find_module( symbolizer, (uintptr_t)addresses[i] );
+			callstack_module_t*       mod   = entry ? module_entry_data( entry, signal_safe ) : 0x0;
+			symbolizer_resolve( &symbolizer->demangler, entry, mod, addresses[i], &out_syms[i], signal_safe );
+
+			if( entry == 0x0 )
+				continue;
+
+			// ... resolve the rest of the addresses in the same module while its data is hot ...
+			for( int j = i + 1; j < num_addresses; ++j )
+			{
+				uintptr_t addr = (uintptr_t)addresses[j];
+				if( out_syms[j].function == 0x0 && addr >= entry->addr_begin && addr < entry->addr_end )
+					symbolizer_resolve( &symbolizer->demangler, entry, mod, addresses[j], &out_syms[j], signal_safe );
+			}
+		}
+	}
+
+	static int symbolizer_symbolize( callstack_symbolizer_t* symbolizer, void** addresses, callstack_symbol_t* out_syms, int num_addresses, char* memory, int mem_size, int signal_safe )
+	{
+		callstack_string_buffer_t outbuf = { memory, memory + mem_size };
+
+		// ... dl_iterate_phdr() takes the loader-lock so the module table can not be refreshed from a signal-handler ...
+		if( !signal_safe )
+			symbolizer_refresh_modules( symbolizer );
+
+		for( int i = 0; i < num_addresses; ++i )
+			out_syms[i].function = 0x0;
+		symbolizer_resolve_batch( symbolizer, addresses, out_syms, num_addresses, signal_safe );
+
+		for( int i = 0; i < num_addresses; ++i )
+		{
+			// ... names that has not been demangled by an earlier call are demangled straight into memory, nothing is allocated by that ...
+			int len = -1;
+			if( signal_safe )
+				len = demangle_name_into( out_syms[i].function, outbuf.out_ptr, (size_t)( outbuf.end_ptr - outbuf.out_ptr ), symbolizer->demangler.short_names );
+			if( len >= 0 )
+			{
+				out_syms[i].function = outbuf.out_ptr;
+				outbuf.out_ptr += len + 1;
+			}
+			else
+				out_syms[i].function = alloc_string( &outbuf, out_syms[i].function, strlen( out_syms[i].function ) );
+			out_syms[i].file     = alloc_string( &outbuf, out_syms[i].file, strlen( out_syms[i].file ) );
+		}
+		return num_addresses;
+	}
+
+	/**
+	 * Resolve address to the chain of functions inlined at it followed by the real function, returns
+	 * the number of symbols written to out.
+	 *
+	 * The innermost inlined function gets the file/line of the address itself and each function after
+	 * that gets the file/line of the call-site of the function before it.
+	 */
+	static int symbolizer_resolve_inlined( callstack_symbolizer_t* symbolizer, void* address, callstack_symbol_t* out, int max_out )
+	{
+		callstack_module_entry_t* entry = symbolizer_find_module( symbolizer, (uintptr_t)address );
+		callstack_module_t*       mod   = entry ? module_entry_data( entry, 0 ) : 0x0;
+
+		callstack_symbol_t real;
+		symbolizer_resolve( &symbolizer->demangler, entry, mod, address, &real, 0 );
+
+		callstack_dwarf_inline_t* chain[CALLSTACK_MAX_INLINE_DEPTH];
+		int num_inlined = 0;
+		callstack_dwarf_cu_t* cu = 0x0;
+		if( mod && mod->load_ok )
+		{
+			module_require_debug_info( mod );
+
+			// ... addresses from callstack() are return-addresses, look up the call instruction instead ...
+			uint64_t addr = (uint64_t)( (uintptr_t)address - entry->load_bias ) - 1;
+			cu = dwarf_find_cu( mod, addr, 1 );
+			if( cu && cu->loaded )
+			{
+				if( !cu->inlines_loaded )
+					dwarf_load_inlines( mod, cu, &mod->strings, symbolizer->demangler.short_names );
+				num_inlined = dwarf_find_inlines( cu, addr, chain, CALLSTACK_MAX_INLINE_DEPTH );
+			}
+		}
+
+		const char*  file = real.file;
+		unsigned int line = real.line;
+		int num_out = 0;
+		for( int i = 0; i < num_inlined && num_out < max_out; ++i )
+		{
+			callstack_dwarf_inline_t* in = chain[i];
+			if( in->demangled == 0x0 && in->name )
+				in->demangled = demangle_into_pool( &mod->strings, in->name, symbolizer->demangler.short_names );
+
+			out[num_out].function = in->demangled ? in->demangled : "failed to lookup symbol";
+			out[num_out].file     = file;
+			out[num_out].line     = line;
+			out[num_out].offset   = 0;
+			out[num_out].inlined  = 1;
+			++num_out;
+
+			// ... the function this one was inlined into is at the call-site ...
+			uint32_t file_index = in->call_file - cu->lines.file_number_base;
+			file = file_index < cu->lines.num_files ? cu->lines.files[file_index] : "failed to lookup file";
+			line = in->call_line;
+		}
+
+		if( num_out < max_out )
+		{
+			out[num_out] = real;
+			out[num_out].file = file;
+			out[num_out].line = line;
+			++num_out;
+		}
+		return num_out;
+	}
+
+	int callstack_symbolizer_symbolize_inlined( callstack_symbolizer_t* symbolizer, void** addresses, callstack_symbol_t* out_syms, int num_addresses, int max_syms, char* memory, int mem_size )
+	{
+		callstack_symbol_copy_t copy = { out_syms, 0, max_syms, { memory, memory + mem_size } };
+		callstack_symbolizer_symbolize_foreach( symbolizer, addresses, num_addresses, CALLSTACK_SYMBOLS_INLINED, symbol_copy_callback, &copy );
+		return copy.num_syms;
+	}
+
+	/**
+	 * Process-wide cache of resolved addresses used by callstack_symbols().
+	 *
+	 * The cache is a set-associative table where each entry is protected by a sequence-lock, readers
+	 * never write to shared memory except for the lru-tick of the entry they hit so lookups scale with
+	 * the number of threads. Writers are already serialized by the lock around the default symbolizer.
+	 *
+	 * The sequence-lock is built from acquire/release accesses only, no standalone fences, so that it
+	 * can be checked by tools such as thread-sanitizer. The writer makes seq odd and then stores each
+	 * field with release, so a reader that observes any new field also observes the odd seq. The reader
+	 * loads each field with acquire, so its second load of seq can not be done before the fields are
+	 * read, and a torn read always shows up as a changed seq.
+	 * Cached strings point into the default symbolizer that is never destroyed so hits do not need to
+	 * copy anything.
+	 */
+	enum
+	{
+		CALLSTACK_SYMBOL_CACHE_WAYS         = 4,
+		CALLSTACK_SYMBOL_CACHE_DEFAULT_SIZE = 1024 * 1024,
+	};
+
+	typedef struct
+	{
+		uint32_t    seq;  ///< odd while entry is being written.
+		uint32_t    tick; ///< g_symbol_cache.tick when entry was last used.
+		uintptr_t   addr;
+		const char* function;
+		const char* file;
+		uint32_t    line;
+		uint32_t    offset;
+	} callstack_symbol_cache_entry_t;
+
+	static struct
+	{
+		size_t                          max_bytes;
+		callstack_symbol_cache_entry_t* entries;
+		size_t                          set_mask;
+		uint32_t                        tick;
+	} g_symbol_cache = { CALLSTACK_SYMBOL_CACHE_DEFAULT_SIZE, 0x0, 0, 0 };
+
+	static void symbol_cache_create()
+	{
+		size_t max_entries = g_symbol_cache.max_bytes / sizeof(callstack_symbol_cache_entry_t);
+		if( max_entries < CALLSTACK_SYMBOL_CACHE_WAYS )
+			return;
+
+		size_t num_sets = 1;
+		while( num_sets * 2 * CALLSTACK_SYMBOL_CACHE_WAYS <= max_entries )
+			num_sets *= 2;
+
+		g_symbol_cache.entries  = (callstack_symbol_cache_entry_t*)calloc( num_sets * CALLSTACK_SYMBOL_CACHE_WAYS, sizeof(callstack_symbol_cache_entry_t) );
+		g_symbol_cache.set_mask = num_sets - 1;
+	}
+
+	static callstack_symbol_cache_entry_t* symbol_cache_set( uintptr_t addr )
+	{
+		uint64_t h = (uint64_t)addr * 0x9e3779b97f4a7c15ull;
+		return g_symbol_cache.entries + ( ( h >> 32 ) & g_symbol_cache.set_mask ) * CALLSTACK_SYMBOL_CACHE_WAYS;
+	}
+
+	static int symbol_cache_lookup( uintptr_t addr, callstack_symbol_t* out )
+	{
+		// ... addr 0 marks an empty entry so it is never cached ...
+		if( addr == 0 )
+			return 0;
+
+		callstack_symbol_cache_entry_t* set = symbol_cache_set( addr );
+		for( int way = 0; way < CALLSTACK_SYMBOL_CACHE_WAYS; ++way )
+		{
+			callstack_symbol_cache_entry_t* e = &set[way];
+			uint32_t seq = __atomic_load_n( &e->seq, __ATOMIC_ACQUIRE );
+			if( ( seq & 1 ) != 0 || __atomic_load_n( &e->addr, __ATOMIC_ACQUIRE ) != addr )
+				continue;
+
+			out->function = __atomic_load_n( &e->function, __ATOMIC_ACQUIRE );
+			out->file     = __atomic_load_n( &e->file,     __ATOMIC_ACQUIRE );
+			out->line     = __atomic_load_n( &e->line,     __ATOMIC_ACQUIRE );
+			out->offset   = __atomic_load_n( &e->offset,   __ATOMIC_ACQUIRE );
+			out->inlined  = 0;
+
+			if( __atomic_load_n( &e->seq, __ATOMIC_RELAXED ) != seq )
+				continue; // ... entry was replaced while we read it, treat as a miss ...
+
+			uint32_t tick = __atomic_load_n( &g_symbol_cache.tick, __ATOMIC_RELAXED );
+			if( __atomic_load_n( &e->tick, __ATOMIC_RELAXED ) != tick )
+				__atomic_store_n( &e->tick, tick, __ATOMIC_RELAXED );
+			return 1;
+		}
+		return 0;
+	}
+
+	// ... must be called with g_default_symbolizer_lock held ...
+	static void symbol_cache_insert( uintptr_t addr, const callstack_symbol_t* sym )
+	{
+		if( addr == 0 )
+			return;
+
+		callstack_symbol_cache_entry_t* set = symbol_cache_set( addr );
+
+		// ... replace the least recently used way in the set ...
+		uint32_t now    = __atomic_add_fetch( &g_symbol_cache.tick, 1, __ATOMIC_RELAXED );
+		callstack_symbol_cache_entry_t* victim = &set[0];
+		for( int way = 0; way < CALLSTACK_SYMBOL_CACHE_WAYS; ++way )
+		{
+			callstack_symbol_cache_entry_t* e = &set[way];
+			if( e->addr == addr || e->addr == 0 )
+			{
+				victim = e;
+				break;
+			}
+			// ... tick is written by readers on hit ...
+			if( now - __atomic_load_n( &e->tick, __ATOMIC_RELAXED ) > now - __atomic_load_n( &victim->tick, __ATOMIC_RELAXED ) )
+				victim = e;
+		}
+
+		uint32_t seq = victim->seq;
+		__atomic_store_n( &victim->seq,      seq + 1,       __ATOMIC_RELAXED );
+		__atomic_store_n( &victim->addr,     addr,          __ATOMIC_RELEASE );
+		__atomic_store_n( &victim->function, sym->function, __ATOMIC_RELEASE );
+		__atomic_store_n( &victim->file,     sym->file,     __ATOMIC_RELEASE );
+		__atomic_store_n( &victim->line,     sym->line,     __ATOMIC_RELEASE );
+		__atomic_store_n( &victim->offset,   sym->offset,   __ATOMIC_RELEASE );
+		__atomic_store_n( &victim->tick,     now,           __ATOMIC_RELAXED );
+		__atomic_store_n( &victim->seq,      seq + 2,       __ATOMIC_RELEASE );
+	}
+
+	// ... must be called with g_default_symbolizer_lock held ...
+	static void symbol_cache_clear()
+	{
+		size_t num_entries = ( g_symbol_cache.set_mask + 1 ) * CALLSTACK_SYMBOL_CACHE_WAYS;
+		for( size_t i = 0; i < num_entries; ++i )
+		{
+			callstack_symbol_cache_entry_t* e = &g_symbol_cache.entries[i];
+			if( e->addr == 0 )
+				continue;
+			uint32_t seq = e->seq;
+			__atomic_store_n( &e->seq,  seq + 1,      __ATOMIC_RELAXED );
+			__atomic_store_n( &e->addr, (uintptr_t)0, __ATOMIC_RELEASE );
+			__atomic_store_n( &e->seq,  seq + 2,      __ATOMIC_RELEASE );
+		}
+	}
+
+	static int symbol_cache_symbolize( callstack_symbolizer_t* symbolizer, pthread_mutex_t* lock, void** addresses, callstack_symbol_t* out_syms, int num_addresses )
+	{
+		int num_misses = 0;
+		for( int i = 0; i < num_addresses; ++i )
+		{
+			if( g_symbol_cache.entries && symbol_cache_lookup( (uintptr_t)addresses[i], &out_syms[i] ) )
+				continue;
+			out_syms[i].function = 0x0;
+			++num_misses;
+		}
+
+		if( num_misses == 0 )
+			return num_addresses;
+
+		pthread_mutex_lock( lock );
+
+		// ... addresses cached for a module that has been unloaded might now belong to some other module ...
+		if( symbolizer_refresh_modules( symbolizer ) && g_symbol_cache.entries )
+			symbol_cache_clear();
+
+		// ... remember what was missing, out_syms[i].function is set by resolve ...
+		void*  misses_buffer[256];
+		void** misses = num_addresses <= 256 ? misses_buffer : (void**)malloc( (size_t)num_addresses * sizeof(void*) );
+		if( misses )
+			for( int i = 0; i < num_addresses; ++i )
+				misses[i] = out_syms[i].function == 0x0 ? addresses[i] : 0x0;
+
+		symbolizer_resolve_batch( symbolizer, addresses, out_syms, num_addresses, 0 );
+
+		if( misses && g_symbol_cache.entries )
+			for( int i = 0; i < num_addresses; ++i )
+				if( misses[i] )
+					symbol_cache_insert( (uintptr_t)misses[i], &out_syms[i] );
+
+		pthread_mutex_unlock( lock );
+
+		if( misses != misses_buffer )
+			free( misses );
+		return num_addresses;
+	}
+
+	int callstack_symbolizer_symbolize( callstack_symbolizer_t* symbolizer, void** addresses, callstack_symbol_t* out_syms, int num_addresses, char* memory, int mem_size )
+	{
+		return symbolizer_symbolize( symbolizer, addresses, out_syms, num_addresses, memory, mem_size, 0 );
+	}
+
+	int callstack_symbolizer_symbolize_signal_safe( callstack_symbolizer_t* symbolizer, void** addresses, callstack_symbol_t* out_syms, int num_addresses, char* memory, int mem_size )
+	{
+		if( symbolizer == 0x0 )
+			return 0;
+		return symbolizer_symbolize( symbolizer, addresses, out_syms, num_addresses, memory, mem_size, 1 );
+	}
+
+	enum
+	{
+		CALLSTACK_FOREACH_BLOCK_SIZE = CALLSTACK_MAX_INLINE_DEPTH + 1, ///< symbols resolved per round by symbolizer_foreach(), fits one address with all inlined functions.
+	};
+
+	/**
+	 * Resolve addresses a block at a time to the stack and pass them on to callback. If lock is set symbolizer is
+	 * the default symbolizer, it is only held while resolving and not while calling callback, and the cache is used.
+	 */
+	static int symbolizer_foreach( callstack_symbolizer_t* symbolizer, pthread_mutex_t* lock, void** addresses, int num_addresses, unsigned int flags, callstack_symbol_callback callback, void* userdata )
+	{
+		if( symbolizer == 0x0 || callback == 0x0 )
+			return 0;
+
+		if( lock == 0x0 )
+			symbolizer_refresh_modules( symbolizer );
+
+		callstack_symbol_t syms[CALLSTACK_FOREACH_BLOCK_SIZE];
+		int num_reported = 0;
+		for( int first = 0; first < num_addresses; )
+		{
+			int num_syms  = 0;
+			int num_block = 1;
+			if( flags & CALLSTACK_SYMBOLS_INLINED )
+			{
+				// ... inlined frames are not cached, the cache only holds one symbol per address ...
+				if( lock )
+				{
+					pthread_mutex_lock( lock );
+					if( first == 0 )
+						symbolizer_refresh_modules( symbolizer );
+				}
+				num_syms = symbolizer_resolve_inlined( symbolizer, addresses[first], syms, CALLSTACK_FOREACH_BLOCK_SIZE );
+				if( lock )
+					pthread_mutex_unlock( lock );
+			}
+			else
+			{
+				num_block = num_addresses - first < CALLSTACK_FOREACH_BLOCK_SIZE ? num_addresses - first : CALLSTACK_FOREACH_BLOCK_SIZE;
+				if( lock )
+					num_syms = symbol_cache_symbolize( symbolizer, lock, addresses + first, syms, num_block );
+				else
+				{
+					for( int i = 0; i < num_block; ++i )
+						syms[i].function = 0x0;
+					symbolizer_resolve_batch( symbolizer, addresses + first, syms, num_block, 0 );
+					num_syms = num_block;
+				}
+			}
+
+			for( int i = 0; i < num_syms; ++i )
+			{
+				++num_reported;
+				if( callback( &syms[i], num_block == 1 ? first : first + i, userdata ) != 0 )
+					return num_reported;
+			}
+			first += num_block;
+		}
+		return num_reported;
+	}
+
+	int callstack_symbolizer_symbolize_foreach( callstack_symbolizer_t* symbolizer, void** addresses, int num_addresses, unsigned int flags, callstack_symbol_callback callback, void* userdata )
+	{
+		return symbolizer_foreach( symbolizer, 0x0, addresses, num_addresses, flags, callback, userdata );
+	}
+
+	enum
+	{
+		CALLSTACK_BATCH_MAX_THREADS = 256,
+	};
+
+	typedef struct
+	{
+		uintptr_t                 addr;
+		int                       id;     ///< index of address in unique addresses.
+		callstack_module_entry_t* module; ///< module that addr belongs to, 0x0 if none.
+	} callstack_batch_addr_t;
+
+	static int batch_addr_cmp( const void* a, const void* b )
+	{
+		const callstack_batch_addr_t* ba = (const callstack_batch_addr_t*)a;
+		const callstack_batch_addr_t* bb = (const callstack_batch_addr_t*)b;
+		return ba->addr < bb->addr ? -1 : ( ba->addr > bb->addr ? 1 : 0 );
+	}
+
+	typedef struct
+	{
+		const callstack_module_t* mod;
+		callstack_dwarf_cu_t*     cu;
+	} callstack_batch_cu_t;
+
+	/**
+	 * Work shared by all threads symbolizing a batch, threads grab modules to load, then units to load
+	 * and then chunks of addresses to resolve by bumping next until everything is taken.
+	 */
+	typedef struct
+	{
+		const callstack_batch_addr_t* uniques;
+		callstack_symbol_t*           unique_syms;
+
+		callstack_module_entry_t**    load; ///< modules that are needed by the batch but not loaded yet.
+		int                           num_load;
+
+		callstack_batch_cu_t*         load_cus; ///< compilation units that are needed by the batch but not loaded yet.
+		int                           num_load_cus;
+
+		const int*                    chunks; ///< chunk i is uniques[chunks[i]] to uniques[chunks[i + 1]].
+		int                           num_chunks;
+
+		int                           next;
+	} callstack_batch_job_t;
+
+	typedef struct
+	{
+		callstack_batch_job_t*    job;
+		callstack_demangler_t     demangler;
+		callstack_string_chunk_t* strings; ///< demangled names and file-paths loaded by this worker.
+	} callstack_batch_worker_t;
+
+	static void* batch_load_worker( void* arg )
+	{
+		callstack_batch_job_t* job = ( (callstack_batch_worker_t*)arg )->job;
+		for( int i = __atomic_fetch_add( &job->next, 1, __ATOMIC_RELAXED ); i < job->num_load; i = __atomic_fetch_add( &job->next, 1, __ATOMIC_RELAXED ) )
+			module_entry_data( job->load[i], 0 );
+		return 0x0;
+	}
+
+	static void* batch_load_cu_worker( void* arg )
+	{
+		callstack_batch_worker_t* worker = (callstack_batch_worker_t*)arg;
+		callstack_batch_job_t*    job    = worker->job;
+		for( int i = __atomic_fetch_add( &job->next, 1, __ATOMIC_RELAXED ); i < job->num_load_cus; i = __atomic_fetch_add( &job->next, 1, __ATOMIC_RELAXED ) )
+		{
+			const callstack_module_t* mod = job->load_cus[i].mod;
+			callstack_dwarf_cu_t*     cu  = job->load_cus[i].cu;
+			if( !cu->loaded )
+				dwarf_load_cu( mod, cu, &worker->strings );
+			if( !mod->has_symtab && !cu->inlines_loaded )
+				dwarf_load_inlines( mod, cu, &worker->strings, worker->demangler.short_names );
+			cu->queued = 0;
+		}
+		return 0x0;
+	}
+
+	static void* batch_resolve_worker( void* arg )
+	{
+		callstack_batch_worker_t* worker = (callstack_batch_worker_t*)arg;
+		callstack_batch_job_t*    job    = worker->job;
+		for( int c = __atomic_fetch_add( &job->next, 1, __ATOMIC_RELAXED ); c < job->num_chunks; c = __atomic_fetch_add( &job->next, 1, __ATOMIC_RELAXED ) )
+		{
+			callstack_module_entry_t* entry = 0x0;
+			for( int i = job->chunks[c]; i < job->chunks[c + 1]; ++i )
+			{
+				uintptr_t addr = job->uniques[i].addr;
+				if( entry == 0x0 || addr < entry->addr_begin || addr >= entry->addr_end )
+					entry = job->uniques[i].module;
+				symbolizer_resolve( &worker->demangler, entry, entry ? entry->data : 0x0, (void*)addr, &job->unique_syms[job->uniques[i].id], 0 );
+			}
+		}
+		return 0x0;
+	}
+
+	static callstack_elf_sym_t* batch_addr_symbol( const callstack_batch_addr_t* ba )
+	{
+		callstack_module_entry_t* entry = ba->module;
+		if( entry == 0x0 || entry->data == 0x0 || !entry->data->load_ok )
+			return 0x0;
+		return elf_find_symbol( entry->data, ba->addr - entry->load_bias );
+	}
+
+	// ... run func on num_threads threads, including the calling one, and wait for all of them ...
+	static void batch_run( void* (*func)( void* ), callstack_batch_job_t* job, callstack_batch_worker_t* workers, int num_threads )
+	{
+		pthread_t threads[CALLSTACK_BATCH_MAX_THREADS];
+		int       started[CALLSTACK_BATCH_MAX_THREADS];
+
+		job->next = 0;
+		for( int t = 1; t < num_threads; ++t )
+			started[t] = pthread_create( &threads[t], 0x0, func, &workers[t] ) == 0; // ... on failure the others just do more work ...
+		func( &workers[0] );
+		for( int t = 1; t < num_threads; ++t )
+			if( started[t] )
+				pthread_join( threads[t], 0x0 );
+	}
+
+	static int symbolizer_symbolize_batch( callstack_symbolizer_t* symbolizer, void* const* addresses, callstack_symbol_t* out_syms, int num_addresses, int num_threads )
+	{
+		if( symbolizer == 0x0 || num_addresses <= 0 )
+			return 0;
+
+		if( num_threads <= 0 )
+			num_threads = (int)sysconf( _SC_NPROCESSORS_ONLN );
+		if( num_threads < 1 )
+			num_threads = 1;
+		if( num_threads > CALLSTACK_BATCH_MAX_THREADS )
+			num_threads = CALLSTACK_BATCH_MAX_THREADS;
+
+		symbolizer_refresh_modules( symbolizer );
+
+		size_t hash_size = 16;
+		while( hash_size < (size_t)num_addresses * 2 )
+			hash_size *= 2;
+
+		// ... one allocation for all scratch-memory, sized for the worst case of no duplicates ...
+		size_t num = (size_t)num_addresses;
+		char* scratch = (char*)malloc( num * ( sizeof(callstack_batch_addr_t) + sizeof(callstack_symbol_t) + sizeof(callstack_module_entry_t*) + sizeof(callstack_batch_cu_t) + 2 * sizeof(int) ) + ( hash_size + 1 ) * sizeof(int) );
+		if( scratch == 0x0 )
+			return 0;
+		callstack_symbol_t*        unique_syms = (callstack_symbol_t*)scratch;
+		callstack_batch_addr_t*    uniques     = (callstack_batch_addr_t*)( unique_syms + num );
+		callstack_module_entry_t** load        = (callstack_module_entry_t**)( uniques + num );
+		callstack_batch_cu_t*      load_cus    = (callstack_batch_cu_t*)( load + num );
+		int*                       unique_of   = (int*)( load_cus + num );
+		int*                       chunks      = unique_of + num;
+		int*                       hash        = chunks + num + 1;
+		memset( hash, 0xFF, hash_size * sizeof(int) );
+
+		// ... dedupe with an open-addressing hash, stacks in a batch usually share most of their frames ...
+		int num_uniques = 0;
+		for( int i = 0; i < num_addresses; ++i )
+		{
+			uintptr_t addr = (uintptr_t)addresses[i];
+			size_t    slot = (size_t)( ( (uint64_t)addr * 0x9e3779b97f4a7c15ull ) >> 32 ) & ( hash_size - 1 );
+			while( hash[slot] >= 0 && uniques[hash[slot]].addr != addr )
+				slot = ( slot + 1 ) & ( hash_size - 1 );
+
+			if( hash[slot] < 0 )
+			{
+				uniques[num_uniques].addr = addr;
+				uniques[num_uniques].id   = num_uniques;
+				hash[slot] = num_uniques++;
+			}
+			unique_of[i] = hash[slot];
+		}
+
+		// ... modules are sorted by address so sorting on address also groups by module and symbol-data is read in order ...
+		qsort( uniques, (size_t)num_uniques, sizeof(callstack_batch_addr_t), batch_addr_cmp );
+
+		// ... find the module of each address and all modules that need to be loaded ...
+		callstack_batch_job_t job;
+		memset( &job, 0x0, sizeof(job) );
+		job.uniques     = uniques;
+		job.unique_syms = unique_syms;
+		job.load        = load;
+		job.load_cus    = load_cus;
+		job.chunks      = chunks;
+
+		callstack_module_entry_t* entry = 0x0;
+		for( int i = 0; i < num_uniques; ++i )
+		{
+			uintptr_t addr = uniques[i].addr;
+			if( entry == 0x0 || addr < entry->addr_begin || addr >= entry->addr_end )
+			{
+				callstack_module_entry_t* prev = entry;
+				entry = symbolizer_find_module( symbolizer, addr );
+				if( entry && entry != prev && entry->data == 0x0 )
+					load[job.num_load++] = entry;
+			}
+			uniques[i].module = entry;
+		}
+
+		// ... split work in chunks, a chunk never ends in the middle of a symbol so that each symbol is demangled by one thread only ...
+		int chunk_size = num_uniques / ( num_threads * 8 );
+		if( chunk_size < 64 )
+			chunk_size = 64;
+
+		callstack_batch_worker_t workers[CALLSTACK_BATCH_MAX_THREADS];
+		memset( workers, 0x0, sizeof(workers) );
+		for( int t = 0; t < num_threads; ++t )
+		{
+			workers[t].job = &job;
+			workers[t].demangler.strings     = &workers[t].strings;
+			workers[t].demangler.short_names = symbolizer->demangler.short_names;
+		}
+
+		// ... the calling thread is the only one that stores demangled names with the modules, the others use their own pools ...
+		workers[0].demangler = symbolizer->demangler;
+
+		int load_threads = job.num_load < num_threads ? job.num_load : num_threads;
+		if( load_threads > 0 )
+			batch_run( batch_load_worker, &job, workers, load_threads );
+
+		// ... find all units that need to be loaded, units are only ever indexed here so that the resolve-workers never modify a module ...
+		for( int i = 0; i < num_uniques; ++i )
+		{
+			callstack_module_entry_t* mod_entry = uniques[i].module;
+			if( mod_entry == 0x0 || mod_entry->data == 0x0 || !mod_entry->data->load_ok )
+				continue;
+			callstack_dwarf_cu_t* cu = dwarf_find_cu( mod_entry->data, (uint64_t)( uniques[i].addr - mod_entry->load_bias ) - 1, 1 );
+			if( cu == 0x0 || cu->queued || ( cu->loaded && ( mod_entry->data->has_symtab || cu->inlines_loaded ) ) )
+				continue;
+			cu->queued = 1;
+			load_cus[job.num_load_cus].mod = mod_entry->data;
+			load_cus[job.num_load_cus].cu  = cu;
+			++job.num_load_cus;
+		}
+
+		int load_cu_threads = job.num_load_cus < num_threads ? job.num_load_cus : num_threads;
+		if( load_cu_threads > 0 )
+			batch_run( batch_load_cu_worker, &job, workers, load_cu_threads );
+
+		chunks[job.num_chunks++] = 0;
+		for( int begin = 0; begin < num_uniques; )
+		{
+			int end = begin + chunk_size < num_uniques ? begin + chunk_size : num_uniques;
+			while( end < num_uniques && uniques[end].module == uniques[end - 1].module && batch_addr_symbol( &uniques[end] ) != 0x0 && batch_addr_symbol( &uniques[end] ) == batch_addr_symbol( &uniques[end - 1] ) )
+				++end;
+			chunks[job.num_chunks++] = end;
+			begin = end;
+		}
+		--job.num_chunks;
+
+		int resolve_threads = job.num_chunks < num_threads ? job.num_chunks : num_threads;
+		if( resolve_threads > 0 )
+			batch_run( batch_resolve_worker, &job, workers, resolve_threads );
+
+		// ... strings created by the workers are kept with the symbolizer ...
+		for( int t = 0; t < num_threads; ++t )
+		{
+			callstack_string_chunk_t* last = workers[t].strings;
+			if( last == 0x0 )
+				continue;
+			while( last->next )
+				last = last->next;
+			last->next = symbolizer->strings;
+			symbolizer->strings = workers[t].strings;
+		}
+
+		for( int i = 0; i < num_addresses; ++i )
+			out_syms[i] = unique_syms[unique_of[i]];
+
+		free( scratch );
+		return num_addresses;
+	}
+
+	int callstack_symbolizer_symbolize_batch( callstack_symbolizer_t* symbolizer, void* const* addresses, callstack_symbol_t* out_syms, int num_addresses )
+	{
+		return symbolizer_symbolize_batch( symbolizer, addresses, out_syms, num_addresses, 1 );
+	}
+
+	int callstack_symbolizer_symbolize_parallel( callstack_symbolizer_t* symbolizer, void* const* addresses, callstack_symbol_t* out_syms, int num_addresses, int num_threads )
+	{
+		return symbolizer_symbolize_batch( symbolizer, addresses, out_syms, num_addresses, num_threads );
+	}
+
+
+	/**
+	 * Binary dumps of callstacks, see callstack_dump_write() for the format. Dumps are read with the same
+	 * bounds-checked cursor as DWARF.
+	 */
+	static const uint8_t CALLSTACK_DUMP_MAGIC[4] = { 'C', 'S', 'D', 1 };
+
+	typedef struct
+	{
+		uintptr_t      addr_begin;
+		uintptr_t      addr_end;
+		uintptr_t      load_bias;
+		const char*    path;
+		const uint8_t* build_id;
+		size_t         build_id_size;
+		uint64_t       last_addr; ///< last module-relative address written, frames are stored as a delta from it.
+		size_t         index;     ///< 1 + index of module in the dump, 0 if no frame is in the module.
+	} callstack_dump_module_t;
+
+	typedef struct
+	{
+		callstack_dump_module_t* modules;
+		size_t                   num_modules;
+		size_t                   cap_modules;
+		const char*              exe_path;
+	} callstack_dump_module_list_t;
+
+	static int dump_module_add( struct dl_phdr_info* info, size_t, void* data )
+	{
+		callstack_dump_module_list_t* list = (callstack_dump_module_list_t*)data;
+
+		if( list->num_modules == list->cap_modules )
+		{
+			size_t new_cap = list->cap_modules ? list->cap_modules * 2 : 64;
+			callstack_dump_module_t* new_modules = (callstack_dump_module_t*)realloc( list->modules, new_cap * sizeof(callstack_dump_module_t) );
+			if( new_modules == 0x0 )
+				return 1;
+			list->modules     = new_modules;
+			list->cap_modules = new_cap;
+		}
+
+		callstack_dump_module_t* mod = &list->modules[list->num_modules];
+		memset( mod, 0x0, sizeof(callstack_dump_module_t) );
+		mod->load_bias = (uintptr_t)info->dlpi_addr;
+		if( !module_phdr_range( info, &mod->addr_begin, &mod->addr_end ) )
+			return 0;
+
+		// ... the build-id is read from the mapped notes, the file itself is never touched ...
+		for( ElfW(Half) i = 0; i < info->dlpi_phnum && mod->build_id == 0x0; ++i )
+		{
+			const ElfW(Phdr)* phdr = &info->dlpi_phdr[i];
+			if( phdr->p_type != PT_NOTE )
+				continue;
+			const uint8_t* note = (const uint8_t*)( mod->load_bias + phdr->p_vaddr );
+			mod->build_id = elf_note_build_id( note, note + phdr->p_memsz, &mod->build_id_size );
+		}
+
+		mod->path = list->num_modules == 0 || info->dlpi_name == 0x0 || info->dlpi_name[0] == '\0' ? list->exe_path : info->dlpi_name;
+		++list->num_modules;
+		return 0;
+	}
+
+	static int dump_module_cmp( const void* a, const void* b )
+	{
+		const callstack_dump_module_t* ma = (const callstack_dump_module_t*)a;
+		const callstack_dump_module_t* mb = (const callstack_dump_module_t*)b;
+		return ma->addr_begin < mb->addr_begin ? -1 : ( ma->addr_begin > mb->addr_begin ? 1 : 0 );
+	}
+
+	static callstack_dump_module_t* dump_find_module( callstack_dump_module_list_t* list, uintptr_t addr )
+	{
+		size_t lo = 0, hi = list->num_modules;
+		while( lo < hi )
+		{
+			size_t mid = lo + ( hi - lo ) / 2;
+			if( list->modules[mid].addr_begin <= addr )
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if( lo == 0 || addr >= list->modules[lo - 1].addr_end )
+			return 0x0;
+		return &list->modules[lo - 1];
+	}
+
+	// ... output of a dump, only counts the bytes needed once out is full unless it can grow ...
+	typedef struct
+	{
+		uint8_t* out;
+		size_t   size;
+		size_t   pos;
+		int      grow; ///< out is malloc:ed and is realloc:ed when full.
+	} callstack_dump_writer_t;
+
+	static void dump_write( callstack_dump_writer_t* w, const void* data, size_t size )
+	{
+		if( w->pos + size > w->size && w->grow )
+		{
+			size_t   new_size = w->size * 2 > w->pos + size ? w->size * 2 : w->pos + size + 4096;
+			uint8_t* new_out  = (uint8_t*)realloc( w->out, new_size );
+			if( new_out )
+			{
+				w->out  = new_out;
+				w->size = new_size;
+			}
+		}
+		if( size > 0 && w->pos + size <= w->size ) // ... data is 0x0 for empty build-ids ...
+			memcpy( w->out + w->pos, data, size );
+		w->pos += size;
+	}
+
+	static void dump_write_uleb( callstack_dump_writer_t* w, uint64_t val )
+	{
+		uint8_t buf[10];
+		size_t  len = 0;
+		do
+		{
+			uint8_t b = (uint8_t)( val & 0x7f );
+			val >>= 7;
+			buf[len++] = val ? (uint8_t)( b | 0x80 ) : b;
+		} while( val );
+		dump_write( w, buf, len );
+	}
+
+	static void dump_write_sleb( callstack_dump_writer_t* w, int64_t val )
+	{
+		uint8_t buf[10];
+		size_t  len = 0;
+		for( ;; )
+		{
+			uint8_t b = (uint8_t)( val & 0x7f );
+			val >>= 7; // ... arithmetic shift, keeps the sign ...
+			if( ( val == 0 && ( b & 0x40 ) == 0 ) || ( val == -1 && ( b & 0x40 ) != 0 ) )
+			{
+				buf[len++] = b;
+				break;
+			}
+			buf[len++] = (uint8_t)( b | 0x80 );
+		}
+		dump_write( w, buf, len );
+	}
+
+	int callstack_dump_write( void* const* addresses, const int* num_frames, int num_stacks, void* out, int out_size )
+	{
+		if( num_stacks < 0 || ( num_stacks > 0 && ( addresses == 0x0 || num_frames == 0x0 ) ) )
+			return 0;
+
+		char   exe_path[PATH_MAX];
+		ssize_t exe_len = readlink( "/proc/self/exe", exe_path, sizeof(exe_path) - 1 );
+		exe_path[exe_len < 0 ? 0 : exe_len] = '\0';
+
+		callstack_dump_module_list_t list = { 0x0, 0, 0, exe_path };
+		dl_iterate_phdr( dump_module_add, &list );
+		qsort( list.modules, list.num_modules, sizeof(callstack_dump_module_t), dump_module_cmp );
+
+		// ... only modules that frames point into are stored, in address-order ...
+		size_t num_addresses = 0;
+		for( int i = 0; i < num_stacks; ++i )
+		{
+			if( num_frames[i] < 0 )
+			{
+				free( list.modules );
+				return 0;
+			}
+			num_addresses += (size_t)num_frames[i];
+		}
+		for( size_t i = 0; i < num_addresses; ++i )
+		{
+			callstack_dump_module_t* mod = dump_find_module( &list, (uintptr_t)addresses[i] );
+			if( mod )
+				mod->index = 1;
+		}
+		size_t num_used = 0;
+		for( size_t i = 0; i < list.num_modules; ++i )
+			if( list.modules[i].index )
+				list.modules[i].index = ++num_used;
+
+		callstack_dump_writer_t w = { (uint8_t*)out, out ? (size_t)( out_size < 0 ? 0 : out_size ) : 0, 0, 0 };
+		dump_write( &w, CALLSTACK_DUMP_MAGIC, sizeof(CALLSTACK_DUMP_MAGIC) );
+		dump_write_uleb( &w, num_used );
+		for( size_t i = 0; i < list.num_modules; ++i )
+		{
+			const callstack_dump_module_t* mod = &list.modules[i];
+			if( mod->index == 0 )
+				continue;
+			size_t path_len = strlen( mod->path );
+			dump_write_uleb( &w, path_len );
+			dump_write( &w, mod->path, path_len );
+			dump_write_uleb( &w, mod->build_id_size );
+			dump_write( &w, mod->build_id, mod->build_id_size );
+			dump_write_uleb( &w, mod->load_bias );
+			dump_write_uleb( &w, mod->addr_begin - mod->load_bias );
+			dump_write_uleb( &w, mod->addr_end - mod->load_bias );
+		}
+
+		dump_write_uleb( &w, (uint64_t)num_stacks );
+		void* const* frame = addresses;
+		for( int i = 0; i < num_stacks; ++i )
+		{
+			dump_write_uleb( &w, (uint64_t)num_frames[i] );
+			for( int j = 0; j < num_frames[i]; ++j, ++frame )
+			{
+				callstack_dump_module_t* mod = dump_find_module( &list, (uintptr_t)*frame );
+				if( mod == 0x0 )
+				{
+					dump_write_uleb( &w, 0 );
+					dump_write_uleb( &w, (uintptr_t)*frame );
+					continue;
+				}
+				uint64_t addr = (uint64_t)( (uintptr_t)*frame - mod->load_bias );
+				dump_write_uleb( &w, mod->index );
+				dump_write_sleb( &w, (int64_t)( addr - mod->last_addr ) );
+				mod->last_addr = addr;
+			}
+		}
+
+		free( list.modules );
+		return w.pos > 0x7fffffff ? 0 : (int)w.pos;
+	}
+
+	// ... uleb from a dump, sets *error if the dump ends before it does ...
+	static uint64_t dump_read_uleb( callstack_dwarf_cursor_t* c, int* error )
+	{
+		if( dwarf_left( c ) == 0 )
+		{
+			*error = 1;
+			return 0;
+		}
+		uint64_t val = dwarf_read_uleb( c );
+		if( c->ptr[-1] & 0x80 )
+			*error = 1;
+		return val;
+	}
+
+	static int64_t dump_read_sleb( callstack_dwarf_cursor_t* c, int* error )
+	{
+		if( dwarf_left( c ) == 0 )
+		{
+			*error = 1;
+			return 0;
+		}
+		int64_t val = dwarf_read_sleb( c );
+		if( c->ptr[-1] & 0x80 )
+			*error = 1;
+		return val;
+	}
+
+	typedef struct
+	{
+		const char*    path; ///< not 0-terminated.
+		size_t         path_len;
+		const uint8_t* build_id;
+		size_t         build_id_size;
+		uint64_t       load_bias;
+		uint64_t       addr_begin; ///< relative to load_bias.
+		uint64_t       addr_end;   ///< relative to load_bias.
+	} callstack_dump_module_info_t;
+
+	// ... read the header of a dump, returns the number of modules or -1 if data is not a dump ...
+	static int64_t dump_read_header( callstack_dwarf_cursor_t* c, const void* dump, int dump_size )
+	{
+		if( dump == 0x0 || dump_size < (int)sizeof(CALLSTACK_DUMP_MAGIC) || memcmp( dump, CALLSTACK_DUMP_MAGIC, sizeof(CALLSTACK_DUMP_MAGIC) ) != 0 )
+			return -1;
+		dwarf_cursor_init( c, dump, (size_t)dump_size );
+		dwarf_skip( c, sizeof(CALLSTACK_DUMP_MAGIC) );
+
+		int error = 0;
+		uint64_t num_modules = dump_read_uleb( c, &error );
+		return error || num_modules > dwarf_left( c ) ? -1 : (int64_t)num_modules;
+	}
+
+	static int dump_read_module( callstack_dwarf_cursor_t* c, callstack_dump_module_info_t* mod )
+	{
+		int error = 0;
+		mod->path_len = (size_t)dump_read_uleb( c, &error );
+		mod->path     = (const char*)c->ptr;
+		if( error || mod->path_len > dwarf_left( c ) )
+			return 0;
+		dwarf_skip( c, mod->path_len );
+
+		mod->build_id_size = (size_t)dump_read_uleb( c, &error );
+		mod->build_id      = c->ptr;
+		if( error || mod->build_id_size > dwarf_left( c ) )
+			return 0;
+		dwarf_skip( c, mod->build_id_size );
+
+		mod->load_bias  = dump_read_uleb( c, &error );
+		mod->addr_begin = dump_read_uleb( c, &error );
+		mod->addr_end   = dump_read_uleb( c, &error );
+		return !error && mod->addr_begin < mod->addr_end;
+	}
+
+	/**
+	 * Decode the stacks of a dump, c positioned after the modules. Frames in module i are module_bias[i] plus
+	 * the module-relative address, frames outside all modules are passed as is if keep_unknown is set and as 0x0
+	 * otherwise. Returns the number of stacks passed to callback or -1 if the dump is malformed.
+	 */
+	static int dump_read_stacks( callstack_dwarf_cursor_t* c, const uint64_t* module_bias, uint64_t num_modules, int keep_unknown, callstack_dump_callback callback, void* userdata )
+	{
+		uint64_t* last_addr = (uint64_t*)calloc( (size_t)num_modules + 1, sizeof(uint64_t) );
+		if( last_addr == 0x0 )
+			return -1;
+
+		int error = 0;
+		uint64_t num_stacks = dump_read_uleb( c, &error );
+		void**   frames     = 0x0;
+		uint64_t cap_frames = 0;
+		int      num_read   = 0;
+		for( uint64_t i = 0; i < num_stacks && !error; ++i )
+		{
+			// ... each frame takes at least 2 bytes, so a broken count is caught before allocating ...
+			uint64_t num_frames = dump_read_uleb( c, &error );
+			if( error || num_frames > dwarf_left( c ) / 2 || num_frames > 0x7fffffff )
+			{
+				error = 1;
+				break;
+			}
+			if( num_frames > cap_frames )
+			{
+				void** new_frames = (void**)realloc( frames, (size_t)num_frames * sizeof(void*) );
+				if( new_frames == 0x0 )
+				{
+					error = 1;
+					break;
+				}
+				frames     = new_frames;
+				cap_frames = num_frames;
+			}
+
+			for( uint64_t j = 0; j < num_frames && !error; ++j )
+			{
+				uint64_t index = dump_read_uleb( c, &error );
+				if( index == 0 )
+				{
+					uint64_t addr = dump_read_uleb( c, &error );
+					frames[j] = keep_unknown ? (void*)(uintptr_t)addr : 0x0;
+					continue;
+				}
+				if( index > num_modules )
+				{
+					error = 1;
+					break;
+				}
+				last_addr[index - 1] += (uint64_t)dump_read_sleb( c, &error );
+				frames[j] = (void*)(uintptr_t)( module_bias[index - 1] + last_addr[index - 1] );
+			}
+			if( error )
+				break;
+
+			++num_read;
+			if( callback && callback( frames, (int)num_frames, userdata ) != 0 )
+				break;
+		}
+
+		free( frames );
+		free( last_addr );
+		return error ? -1 : num_read;
+	}
+
+	int callstack_dump_read( const void* dump, int dump_size, callstack_dump_callback callback, void* userdata )
+	{
+		callstack_dwarf_cursor_t c;
+		int64_t num_modules = dump_read_header( &c, dump, dump_size );
+		if( num_modules < 0 )
+			return -1;
+
+		uint64_t* module_bias = (uint64_t*)malloc( ( (size_t)num_modules + 1 ) * sizeof(uint64_t) );
+		if( module_bias == 0x0 )
+			return -1;
+		for( int64_t i = 0; i < num_modules; ++i )
+		{
+			callstack_dump_module_info_t mod;
+			if( !dump_read_module( &c, &mod ) )
+			{
+				free( module_bias );
+				return -1;
+			}
+			module_bias[i] = mod.load_bias;
+		}
+
+		int res = dump_read_stacks( &c, module_bias, (uint64_t)num_modules, 1, callback, userdata );
+		free( module_bias );
+		return res;
+	}
+
+	callstack_symbolizer_t* callstack_symbolizer_create_from_dump( const void* dump, int dump_size, const char* sysroot )
+	{
+		callstack_dwarf_cursor_t c;
+		int64_t num_modules = dump_read_header( &c, dump, dump_size );
+		if( num_modules < 0 )
+			return 0x0;
+
+		callstack_symbolizer_t* symbolizer = (callstack_symbolizer_t*)malloc( sizeof(callstack_symbolizer_t) );
+		if( symbolizer == 0x0 )
+			return 0x0;
+		memset( symbolizer, 0x0, sizeof(callstack_symbolizer_t) );
+		symbolizer->offline = 1;
+		symbolizer->modules = (callstack_module_entry_t*)calloc( (size_t)num_modules + 1, sizeof(callstack_module_entry_t) );
+		if( symbolizer->modules == 0x0 )
+		{
+			free( symbolizer );
+			return 0x0;
+		}
+
+		for( int64_t i = 0; i < num_modules; ++i )
+		{
+			callstack_dump_module_info_t info;
+			char path[PATH_MAX];
+			char id_hex[CALLSTACK_MAX_BUILD_ID * 2 + 1];
+			if( !dump_read_module( &c, &info ) || info.path_len >= sizeof(path) || info.build_id_size > CALLSTACK_MAX_BUILD_ID )
+			{
+				callstack_symbolizer_destroy( symbolizer );
+				return 0x0;
+			}
+			memcpy( path, info.path, info.path_len );
+			path[info.path_len] = '\0';
+			elf_build_id_hex( info.build_id, info.build_id_size, id_hex );
+
+			const char* parts[] = { sysroot, path };
+			const char* id      = id_hex;
+			callstack_module_entry_t* mod = &symbolizer->modules[symbolizer->num_modules++];
+			mod->addr_begin = (uintptr_t)( info.load_bias + info.addr_begin );
+			mod->addr_end   = (uintptr_t)( info.load_bias + info.addr_end );
+			mod->load_bias  = (uintptr_t)info.load_bias;
+			mod->path       = string_pool_join( &symbolizer->strings, parts, 2 );
+			mod->build_id   = info.build_id_size ? string_pool_join( &symbolizer->strings, &id, 1 ) : 0x0;
+			if( mod->path == path || mod->build_id == id )
+			{
+				callstack_symbolizer_destroy( symbolizer ); // ... out of memory, the strings were not copied ...
+				return 0x0;
+			}
+		}
+		qsort( symbolizer->modules, symbolizer->num_modules, sizeof(callstack_module_entry_t), module_entry_cmp );
+		return symbolizer;
+	}
+
+	/**
+	 * Writer of the precomputed symbol-index read by index_open(), see callstack_index_header_t for the format.
+	 * All strings are interned so that names and files used from many places are only stored once.
+	 */
+	typedef struct
+	{
+		callstack_dump_writer_t data;
+		uint32_t*               hash;      ///< offset + 1 of a string in data per slot, 0 if unused.
+		size_t                  hash_size;
+		size_t                  num;
+		int                     error;
+	} callstack_index_strings_t;
+
+	typedef struct
+	{
+		callstack_line_row_t* rows; ///< file is an index into files + 1, 0 for a gap between sequences.
+		size_t                num_rows;
+		size_t                cap_rows;
+		uint32_t*             files;
+		size_t                num_files;
+		size_t                cap_files;
+		int                   error;
+	} callstack_index_lines_t;
+
+	static size_t index_string_hash( const char* str )
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for( ; *str; ++str )
+			hash = ( hash ^ (uint8_t)*str ) * 0x100000001b3ull;
+		return (size_t)hash;
+	}
+
+	static uint32_t index_intern( callstack_index_strings_t* s, const char* str )
+	{
+		if( ( s->num + 1 ) * 2 > s->hash_size )
+		{
+			size_t    new_size = s->hash_size ? s->hash_size * 2 : 4096;
+			uint32_t* new_hash = (uint32_t*)calloc( new_size, sizeof(uint32_t) );
+			if( new_hash == 0x0 )
+			{
+				s->error = 1;
+				return 0;
+			}
+			for( size_t i = 0; i < s->hash_size; ++i )
+			{
+				if( s->hash[i] == 0 )
+					continue;
+				size_t slot = index_string_hash( (const char*)s->data.out + s->hash[i] - 1 ) & ( new_size - 1 );
+				while( new_hash[slot] != 0 )
+					slot = ( slot + 1 ) & ( new_size - 1 );
+				new_hash[slot] = s->hash[i];
+			}
+			free( s->hash );
+			s->hash      = new_hash;
+			s->hash_size = new_size;
+		}
+
+		size_t slot = index_string_hash( str ) & ( s->hash_size - 1 );
+		for( ; s->hash[slot] != 0; slot = ( slot + 1 ) & ( s->hash_size - 1 ) )
+			if( strcmp( (const char*)s->data.out + s->hash[slot] - 1, str ) == 0 )
+				return s->hash[slot] - 1;
+
+		size_t offset = s->data.pos;
+		dump_write( &s->data, str, strlen( str ) + 1 );
+		if( s->data.pos > s->data.size || s->data.pos > 0xffffffff )
+		{
+			s->error = 1;
+			return 0;
+		}
+		s->hash[slot] = (uint32_t)offset + 1;
+		++s->num;
+		return (uint32_t)offset;
+	}
+
+	static void index_add_file( callstack_index_lines_t* lines, uint32_t name )
+	{
+		if( lines->num_files == lines->cap_files )
+		{
+			size_t    new_cap   = lines->cap_files ? lines->cap_files * 2 : 256;
+			uint32_t* new_files = (uint32_t*)realloc( lines->files, new_cap * sizeof(uint32_t) );
+			if( new_files == 0x0 )
+			{
+				lines->error = 1;
+				return;
+			}
+			lines->files     = new_files;
+			lines->cap_files = new_cap;
+		}
+		lines->files[lines->num_files++] = name;
+	}
+
+	static void index_add_row( callstack_index_lines_t* lines, uint64_t addr, uint32_t file, uint32_t line )
+	{
+		// ... a row at the same address replaces the one before it and rows that does not change file/line are not needed ...
+		callstack_line_row_t* last = lines->num_rows > 0 ? &lines->rows[lines->num_rows - 1] : 0x0;
+		if( last && last->addr > addr )
+			return;
+		if( last && last->addr == addr )
+		{
+			--lines->num_rows;
+			last = lines->num_rows > 0 ? last - 1 : 0x0;
+		}
+		if( last ? last->file == file && last->line == line : file == 0 )
+			return;
+
+		if( lines->num_rows == lines->cap_rows )
+		{
+			size_t                new_cap  = lines->cap_rows ? lines->cap_rows * 2 : 4096;
+			callstack_line_row_t* new_rows = (callstack_line_row_t*)realloc( lines->rows, new_cap * sizeof(callstack_line_row_t) );
+			if( new_rows == 0x0 )
+			{
+				lines->error = 1;
+				return;
+			}
+			lines->rows     = new_rows;
+			lines->cap_rows = new_cap;
+		}
+		callstack_line_row_t* row = &lines->rows[lines->num_rows++];
+		row->addr = addr;
+		row->file = file;
+		row->line = line;
+	}
+
+	static void index_func_names( callstack_index_func_t* fn, callstack_module_t* mod, callstack_index_strings_t* strings, const char* name )
+	{
+		fn->name       = index_intern( strings, name ? demangle_into_pool( &mod->strings, name, 0 ) : "failed to lookup symbol" );
+		fn->short_name = index_intern( strings, name ? demangle_into_pool( &mod->strings, name, 1 ) : "failed to lookup symbol" );
+	}
+
+	static int index_func_cmp( const void* a, const void* b )
+	{
+		const callstack_index_func_t* fa = (const callstack_index_func_t*)a;
+		const callstack_index_func_t* fb = (const callstack_index_func_t*)b;
+		if( fa->addr_begin != fb->addr_begin )
+			return fa->addr_begin < fb->addr_begin ? -1 : 1;
+		// ... outer functions first so that the innermost is found first when searching backwards ...
+		return fa->addr_end > fb->addr_end ? -1 : ( fa->addr_end < fb->addr_end ? 1 : 0 );
+	}
+
+	// ... functions as they are resolved by symbolizer_resolve(), from .symtab if there is one, otherwise from DW_TAG_subprogram ...
+	static callstack_index_func_t* index_collect_funcs( callstack_module_t* mod, callstack_index_strings_t* strings, size_t* num_funcs )
+	{
+		callstack_index_func_t* funcs = 0x0;
+		*num_funcs = 0;
+		if( mod->has_symtab )
+		{
+			funcs = (callstack_index_func_t*)malloc( mod->num_syms * sizeof(callstack_index_func_t) + 1 );
+			for( size_t i = 0; funcs && i < mod->num_syms; ++i )
+			{
+				// ... only the first symbol at each address is used and zero-sized ones cover everything up to the next symbol, see elf_find_symbol() ...
+				const callstack_elf_sym_t* sym = &mod->syms[i];
+				if( i > 0 && sym->addr == mod->syms[i - 1].addr )
+					continue;
+				size_t next = i + 1;
+				while( next < mod->num_syms && mod->syms[next].addr == sym->addr )
+					++next;
+
+				callstack_index_func_t* fn = &funcs[(*num_funcs)++];
+				fn->addr_begin = sym->addr;
+				fn->addr_end   = sym->size ? sym->addr + sym->size : ( next < mod->num_syms ? mod->syms[next].addr : ~(uint64_t)0 );
+				index_func_names( fn, mod, strings, sym->name );
+			}
+		}
+		else
+		{
+			size_t max_funcs = 0;
+			for( size_t i = 0; i < mod->num_cus; ++i )
+			{
+				callstack_dwarf_cu_t* cu = &mod->cus[i];
+				if( !cu->loaded )
+					dwarf_load_cu( mod, cu, &mod->strings );
+				if( !cu->inlines_loaded )
+					dwarf_load_inlines( mod, cu, &mod->strings, 0 );
+				max_funcs += cu->funcs.num;
+			}
+
+			funcs = (callstack_index_func_t*)malloc( max_funcs * sizeof(callstack_index_func_t) + 1 );
+			for( size_t i = 0; funcs && i < mod->num_cus; ++i )
+			{
+				for( size_t j = 0; j < mod->cus[i].funcs.num; ++j )
+				{
+					const callstack_dwarf_inline_t* in = &mod->cus[i].funcs.entries[j];
+					callstack_index_func_t*         fn = &funcs[(*num_funcs)++];
+					fn->addr_begin = in->addr_begin;
+					fn->addr_end   = in->addr_end;
+					index_func_names( fn, mod, strings, in->name );
+				}
+			}
+			if( funcs )
+				qsort( funcs, *num_funcs, sizeof(callstack_index_func_t), index_func_cmp );
+		}
+
+		uint64_t max_end = 0;
+		for( size_t i = 0; funcs && i < *num_funcs; ++i )
+		{
+			max_end = funcs[i].addr_end > max_end ? funcs[i].addr_end : max_end;
+			funcs[i].max_end = max_end;
+		}
+		return funcs;
+	}
+
+	// ... line-rows of all units as they are resolved by symbolizer_resolve(), dwarf_find_cu() picks the last range starting at or before an address so each range is cut where the next one starts ...
+	static void index_collect_lines( callstack_module_t* mod, callstack_index_strings_t* strings, callstack_index_lines_t* lines )
+	{
+		uint32_t* cu_files = (uint32_t*)calloc( mod->num_cus + 1, sizeof(uint32_t) ); ///< index in lines->files of the first file of each unit + 1, 0 if not added yet.
+		if( cu_files == 0x0 )
+		{
+			lines->error = 1;
+			return;
+		}
+
+		for( size_t r = 0; r < mod->num_cu_ranges; ++r )
+		{
+			const callstack_dwarf_range_t* range = &mod->cu_ranges[r];
+			uint64_t end = r + 1 < mod->num_cu_ranges && mod->cu_ranges[r + 1].addr_begin < range->addr_end ? mod->cu_ranges[r + 1].addr_begin : range->addr_end;
+			if( end <= range->addr_begin )
+				continue;
+
+			callstack_dwarf_cu_t* cu = &mod->cus[range->cu];
+			if( !cu->loaded )
+				dwarf_load_cu( mod, cu, &mod->strings );
+			if( cu_files[range->cu] == 0 )
+			{
+				cu_files[range->cu] = (uint32_t)lines->num_files + 1;
+				for( size_t f = 0; f < cu->lines.num_files; ++f )
+					index_add_file( lines, index_intern( strings, cu->lines.files[f] ) );
+			}
+
+			const callstack_line_row_t* row = dwarf_find_line( &cu->lines, range->addr_begin );
+			index_add_row( lines, range->addr_begin, row ? cu_files[range->cu] + row->file : 0, row ? row->line : 0 );
+
+			size_t lo = 0, hi = cu->lines.num_rows;
+			while( lo < hi )
+			{
+				size_t mid = lo + ( hi - lo ) / 2;
+				if( cu->lines.rows[mid].addr <= range->addr_begin )
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			for( size_t i = lo; i < cu->lines.num_rows && cu->lines.rows[i].addr < end; ++i )
+			{
+				row = &cu->lines.rows[i];
+				int gap = row->file >= cu->lines.num_files;
+				index_add_row( lines, row->addr, gap ? 0 : cu_files[range->cu] + row->file, gap ? 0 : row->line );
+			}
+			index_add_row( lines, end, 0, 0 );
+		}
+		free( cu_files );
+	}
+
+	static uint64_t index_write_section( callstack_dump_writer_t* w, const void* data, size_t size, size_t align )
+	{
+		static const uint8_t padding[64] = { 0 };
+		dump_write( w, padding, ( align - w->pos % align ) % align );
+		uint64_t offset = w->pos;
+		if( size > 0 )
+			dump_write( w, data, size );
+		return offset;
+	}
+
+	static int index_write_file( const char* path, const uint8_t* data, size_t size )
+	{
+		// ... written to a temporary file that is renamed into place so that a process never maps a half-written index ...
+		char tmp_path[PATH_MAX];
+		if( snprintf( tmp_path, sizeof(tmp_path), "%s.%d.tmp", path, (int)getpid() ) >= (int)sizeof(tmp_path) )
+			return 0;
+
+		int fd = open( tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+		if( fd < 0 )
+			return 0;
+		while( size > 0 )
+		{
+			ssize_t res = write( fd, data, size );
+			if( res < 0 && errno == EINTR )
+				continue;
+			if( res <= 0 )
+				break;
+			data += res;
+			size -= (size_t)res;
+		}
+		if( close( fd ) != 0 || size > 0 || rename( tmp_path, path ) != 0 )
+		{
+			unlink( tmp_path );
+			return 0;
+		}
+		return 1;
+	}
+
+	int callstack_index_write( const char* module_path, const char* index_path )
+	{
+		callstack_module_t mod;
+		memset( &mod, 0x0, sizeof(mod) );
+
+		size_t         id_size = 0;
+		const uint8_t* id      = module_path && elf_file_open( &mod.elf, module_path ) ? elf_find_build_id( &mod.elf, &id_size ) : 0x0;
+		char           default_path[PATH_MAX];
+		if( id && id_size <= CALLSTACK_MAX_BUILD_ID && index_path == 0x0 && realpath( module_path, default_path ) && strlen( default_path ) + sizeof(".csidx") <= sizeof(default_path) )
+			index_path = strcat( default_path, ".csidx" );
+		if( id == 0x0 || id_size > CALLSTACK_MAX_BUILD_ID || index_path == 0x0 )
+		{
+			module_free( &mod );
+			return -1;
+		}
+
+		module_load_debug_info( &mod, module_path );
+		dwarf_index_remaining( &mod );
+
+		callstack_index_strings_t strings;
+		callstack_index_lines_t   lines;
+		memset( &strings, 0x0, sizeof(strings) );
+		memset( &lines,   0x0, sizeof(lines) );
+		strings.data.grow = 1;
+		index_intern( &strings, "" ); // ... there is always at least one string ...
+
+		size_t                  num_funcs = 0;
+		callstack_index_func_t* funcs     = index_collect_funcs( &mod, &strings, &num_funcs );
+		index_collect_lines( &mod, &strings, &lines );
+
+		size_t                        num_blocks = 0;
+		callstack_index_line_block_t* blocks     = (callstack_index_line_block_t*)malloc( ( lines.num_rows / CALLSTACK_INDEX_LINE_BLOCK + 1 ) * sizeof(callstack_index_line_block_t) );
+		callstack_dump_writer_t       line_data  = { 0x0, 0, 0, 1 };
+		for( size_t i = 0; blocks && i < lines.num_rows; ++i )
+		{
+			const callstack_line_row_t* row = &lines.rows[i];
+			if( i % CALLSTACK_INDEX_LINE_BLOCK == 0 )
+			{
+				size_t left = lines.num_rows - i;
+				blocks[num_blocks].addr     = row->addr;
+				blocks[num_blocks].data     = (uint32_t)line_data.pos;
+				blocks[num_blocks].num_rows = (uint32_t)( left < CALLSTACK_INDEX_LINE_BLOCK ? left : (size_t)CALLSTACK_INDEX_LINE_BLOCK );
+				++num_blocks;
+			}
+			dump_write_uleb( &line_data, i % CALLSTACK_INDEX_LINE_BLOCK == 0 ? 0 : row->addr - lines.rows[i - 1].addr );
+			dump_write_uleb( &line_data, row->file );
+			dump_write_uleb( &line_data, row->line );
+		}
+
+		callstack_index_header_t hdr;
+		memset( &hdr, 0x0, sizeof(hdr) );
+		memcpy( hdr.magic, CALLSTACK_INDEX_MAGIC, sizeof(CALLSTACK_INDEX_MAGIC) );
+		hdr.flags         = mod.has_symtab ? 0 : CALLSTACK_INDEX_FUNCS_FROM_DWARF;
+		hdr.build_id_size = (uint32_t)id_size;
+		memcpy( hdr.build_id, id, id_size );
+
+		callstack_dump_writer_t out = { 0x0, 0, 0, 1 };
+		dump_write( &out, &hdr, sizeof(hdr) );
+		callstack_addr_tree_t funcs_tree;
+		callstack_addr_tree_t blocks_tree;
+		addr_tree_build( &funcs_tree, funcs, sizeof(callstack_index_func_t), funcs ? num_funcs : 0 );
+		addr_tree_build( &blocks_tree, blocks, sizeof(callstack_index_line_block_t), blocks ? num_blocks : 0 );
+
+		const size_t tree_align = CALLSTACK_ADDR_TREE_KEYS * sizeof(uint64_t);
+		hdr.funcs            = index_write_section( &out, funcs, num_funcs * sizeof(callstack_index_func_t), 8 );
+		hdr.num_funcs        = num_funcs;
+		hdr.funcs_tree       = index_write_section( &out, funcs_tree.owned, funcs_tree.owned ? funcs_tree.num_keys * sizeof(uint64_t) : 0, tree_align );
+		hdr.files            = index_write_section( &out, lines.files, lines.num_files * sizeof(uint32_t), 8 );
+		hdr.num_files        = lines.num_files;
+		hdr.line_blocks      = index_write_section( &out, blocks, num_blocks * sizeof(callstack_index_line_block_t), 8 );
+		hdr.num_line_blocks  = num_blocks;
+		hdr.line_blocks_tree = index_write_section( &out, blocks_tree.owned, blocks_tree.owned ? blocks_tree.num_keys * sizeof(uint64_t) : 0, tree_align );
+		hdr.line_data        = index_write_section( &out, line_data.out, line_data.pos, 8 );
+		hdr.line_data_size   = line_data.pos;
+		hdr.strings          = index_write_section( &out, strings.data.out, strings.data.pos, 8 );
+		hdr.strings_size     = strings.data.pos;
+
+		int ok = funcs && blocks && ( num_funcs == 0 || funcs_tree.owned ) && ( num_blocks == 0 || blocks_tree.owned ) && !strings.error && !lines.error && line_data.pos <= line_data.size && line_data.pos <= 0xffffffff && out.pos <= out.size;
+		if( ok )
+		{
+			memcpy( out.out, &hdr, sizeof(hdr) );
+			ok = index_write_file( index_path, out.out, out.pos );
+		}
+
+		free( out.out );
+		free( line_data.out );
+		addr_tree_free( &blocks_tree );
+		addr_tree_free( &funcs_tree );
+		free( blocks );
+		free( funcs );
+		free( lines.rows );
+		free( lines.files );
+		free( strings.hash );
+		free( strings.data.out );
+		module_free( &mod );
+		return ok ? 0 : -1;
+	}
+
+	/**
+	 * Symbol-server, a process answering symbolization-requests from other processes over a unix-socket.
+	 *
+	 * A request is a header followed by a dump as written by callstack_dump_write(), the response is a
+	 * 32-bit size followed by the symbols, each as:
+	 *   function and file as 0-terminated strings followed by index of address in request, line, offset and
+	 *   inlined as uleb.
+	 *
+	 * All modules of all clients are kept in one offline symbolizer, per demangle-mode, where each module gets
+	 * an address-range of its own. Modules with a build-id are shared between all clients using the same build
+	 * so debug-info is only loaded once per machine, modules without are per process and their range is reused
+	 * once the process has exited.
+	 *
+	 * Sockets of clients are non-blocking and requests are read and answered as data arrives in
+	 * callstack_symbol_server_update(), so a slow client never stalls the others.
+	 */
+	enum
+	{
+		CALLSTACK_SYMBOL_SERVER_MAGIC       = 0x51525343,        ///< "CSRQ", first word of each request.
+		CALLSTACK_SYMBOL_SERVER_SHORT_NAMES = 1 << 16,           ///< request-flag, demangle with CALLSTACK_DEMANGLE_SHORT.
+		CALLSTACK_SYMBOL_SERVER_MAX_REQUEST = 64 * 1024 * 1024,  ///< larger requests are dropped.
+		CALLSTACK_SYMBOL_SERVER_MAX_CLIENTS = 256,
+		CALLSTACK_SYMBOL_SERVER_TIMEOUT_MS  = 1000,              ///< reads and writes on the socket fail after this long, clients that make no progress on a request are dropped.
+		CALLSTACK_SYMBOL_SERVER_MAX_MODULES = 4096,              ///< per table, modules of exited processes are evicted to make room.
+	};
+
+	// ... address-range reserved per module in the offline symbolizer of the server ...
+	static const uint64_t CALLSTACK_SYMBOL_SERVER_MODULE_SPAN = (uint64_t)1 << 36;
+
+	typedef struct
+	{
+		uint32_t magic;
+		uint32_t flags; ///< callstack_symbols_flags and CALLSTACK_SYMBOL_SERVER_SHORT_NAMES.
+		uint32_t size;  ///< size of dump following the header.
+	} callstack_symbol_server_request_t;
+
+	typedef struct
+	{
+		const char* path;     ///< as recorded in the dump.
+		const char* build_id; ///< hex-string, 0x0 if there was none, such modules are not shared between processes.
+		int         pid;      ///< process that added the module if it has no build-id.
+	} callstack_symbol_server_module_t;
+
+	typedef struct
+	{
+		callstack_symbolizer_t*           symbolizer;
+		callstack_symbol_server_module_t* modules; ///< same order as symbolizer->modules, path is 0x0 for evicted modules.
+		size_t                            cap_modules;
+	} callstack_symbol_server_table_t;
+
+	typedef struct
+	{
+		int      fd;
+		int      pid;      ///< peer of the connection.
+		uint64_t deadline; ///< CLOCK_MONOTONIC ms the current request or response has to progress before, 0 when idle.
+
+		callstack_symbol_server_request_t req;
+		size_t   received; ///< bytes of req and dump read so far.
+		uint8_t* dump;     ///< grown as the request arrives, not allocated to req.size up front.
+		size_t   cap_dump;
+
+		uint8_t* pending;  ///< part of the response the socket did not take, sent when writable.
+		size_t   pending_size;
+		size_t   sent;
+	} callstack_symbol_server_client_t;
+
+	struct callstack_symbol_server
+	{
+		int  listen_fd;
+		char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+
+		callstack_symbol_server_client_t clients[CALLSTACK_SYMBOL_SERVER_MAX_CLIENTS];
+		int num_clients;
+
+		callstack_symbol_server_table_t tables[2]; ///< full and short names, created on first use.
+		callstack_string_chunk_t*       strings;
+
+		void** addresses; ///< addresses of current request.
+		size_t num_addresses;
+		size_t cap_addresses;
+
+		callstack_dump_writer_t response;
+	};
+
+	static int socket_read_all( int fd, void* data, size_t size )
+	{
+		uint8_t* ptr = (uint8_t*)data;
+		while( size > 0 )
+		{
+			ssize_t res = recv( fd, ptr, size, 0 );
+			if( res < 0 && errno == EINTR )
+				continue;
+			if( res <= 0 )
+				return 0;
+			ptr  += res;
+			size -= (size_t)res;
+		}
+		return 1;
+	}
+
+	// ... MSG_NOSIGNAL, a peer that went away should not kill the process with SIGPIPE ...
+	static int socket_write_all( int fd, const void* data, size_t size )
+	{
+		const uint8_t* ptr = (const uint8_t*)data;
+		while( size > 0 )
+		{
+			ssize_t res = send( fd, ptr, size, MSG_NOSIGNAL );
+			if( res < 0 && errno == EINTR )
+				continue;
+			if( res <= 0 )
+				return 0;
+			ptr  += res;
+			size -= (size_t)res;
+		}
+		return 1;
+	}
+
+	static void socket_set_timeout( int fd, int timeout_ms )
+	{
+		struct timeval tv;
+		tv.tv_sec  = timeout_ms / 1000;
+		tv.tv_usec = ( timeout_ms % 1000 ) * 1000;
+		setsockopt( fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv) );
+		setsockopt( fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv) );
+	}
+
+	// ... drop modules without build-id of processes that have exited, returns first slot freed or num_modules if none was ...
+	static size_t symbol_server_evict_exited( callstack_symbol_server_table_t* table )
+	{
+		callstack_symbolizer_t* symbolizer = table->symbolizer;
+		size_t first = symbolizer->num_modules;
+		for( size_t i = 0; i < symbolizer->num_modules; ++i )
+		{
+			callstack_symbol_server_module_t* mod = &table->modules[i];
+			if( mod->path == 0x0 || mod->build_id || mod->pid <= 0 || kill( mod->pid, 0 ) == 0 || errno != ESRCH )
+				continue;
+
+			// ... the range stays reserved, but empty, so that modules stay sorted on addr_begin ...
+			callstack_module_entry_t* entry = &symbolizer->modules[i];
+			module_entry_free( entry );
+			entry->addr_end = entry->addr_begin;
+			mod->path = 0x0;
+			if( first == symbolizer->num_modules )
+				first = i;
+		}
+		return first;
+	}
+
+	/**
+	 * Find or add the module described by info to table, returns the load-bias it got in the symbolizer or 0 if
+	 * it could not be added. Files are opened via /proc/<pid>/root so that clients in other mount-namespaces,
+	 * i.e. containers, get their own files.
+	 */
+	static uint64_t symbol_server_module_bias( callstack_symbol_server_t* server, callstack_symbol_server_table_t* table, const callstack_dump_module_info_t* info, int pid )
+	{
+		char path[PATH_MAX];
+		char id_hex[CALLSTACK_MAX_BUILD_ID * 2 + 1];
+		if( info->path_len >= sizeof(path) || info->build_id_size > CALLSTACK_MAX_BUILD_ID || info->addr_end > CALLSTACK_SYMBOL_SERVER_MODULE_SPAN )
+			return 0;
+		memcpy( path, info->path, info->path_len );
+		path[info->path_len] = '\0';
+		elf_build_id_hex( info->build_id, info->build_id_size, id_hex );
+
+		callstack_symbolizer_t* symbolizer = table->symbolizer;
+		size_t slot = symbolizer->num_modules;
+		for( size_t i = 0; i < symbolizer->num_modules; ++i )
+		{
+			const callstack_symbol_server_module_t* mod = &table->modules[i];
+			if( mod->path == 0x0 )
+			{
+				if( slot == symbolizer->num_modules )
+					slot = i;
+				continue;
+			}
+			if( strcmp( mod->path, path ) != 0 )
+				continue;
+			if( info->build_id_size ? mod->build_id && strcmp( mod->build_id, id_hex ) == 0 : mod->build_id == 0x0 && mod->pid == pid )
+				return (uint64_t)( i + 1 ) * CALLSTACK_SYMBOL_SERVER_MODULE_SPAN;
+		}
+
+		// ... evict before growing, so the table only grows with the modules of processes that are still alive ...
+		if( slot == symbolizer->num_modules && symbolizer->num_modules == table->cap_modules )
+			slot = symbol_server_evict_exited( table );
+
+		if( slot == symbolizer->num_modules && symbolizer->num_modules == table->cap_modules )
+		{
+			if( table->cap_modules == CALLSTACK_SYMBOL_SERVER_MAX_MODULES )
+				return 0;
+			size_t new_cap = table->cap_modules ? table->cap_modules * 2 : 64;
+			if( new_cap > CALLSTACK_SYMBOL_SERVER_MAX_MODULES )
+				new_cap = CALLSTACK_SYMBOL_SERVER_MAX_MODULES;
+			callstack_module_entry_t*         new_entries = (callstack_module_entry_t*)realloc( symbolizer->modules, new_cap * sizeof(callstack_module_entry_t) );
+			if( new_entries )
+				symbolizer->modules = new_entries;
+			callstack_symbol_server_module_t* new_modules = (callstack_symbol_server_module_t*)realloc( table->modules, new_cap * sizeof(callstack_symbol_server_module_t) );
+			if( new_modules )
+				table->modules = new_modules;
+			if( new_entries == 0x0 || new_modules == 0x0 )
+				return 0;
+			table->cap_modules = new_cap;
+		}
+
+		char proc_root[64];
+		snprintf( proc_root, sizeof(proc_root), "/proc/%d/root", pid );
+		const char* file_parts[] = { pid > 0 ? proc_root : 0x0, path };
+		const char* key_path     = path;
+		const char* key_id       = id_hex;
+
+		const char* entry_path = string_pool_join( &symbolizer->strings, file_parts, 2 );
+		const char* entry_id   = info->build_id_size ? string_pool_join( &symbolizer->strings, &key_id, 1 ) : 0x0;
+		const char* mod_path   = string_pool_join( &server->strings, &key_path, 1 );
+		if( entry_path == path || mod_path == path || entry_id == id_hex )
+			return 0; // ... out of memory ...
+
+		uint64_t bias = (uint64_t)( slot + 1 ) * CALLSTACK_SYMBOL_SERVER_MODULE_SPAN;
+		callstack_module_entry_t* entry = &symbolizer->modules[slot];
+		memset( entry, 0x0, sizeof(callstack_module_entry_t) );
+		entry->addr_begin = (uintptr_t)( bias + info->addr_begin );
+		entry->addr_end   = (uintptr_t)( bias + info->addr_end );
+		entry->load_bias  = (uintptr_t)bias;
+		entry->path       = entry_path;
+		entry->build_id   = entry_id;
+
+		callstack_symbol_server_module_t* mod = &table->modules[slot];
+		mod->path     = mod_path;
+		mod->build_id = entry->build_id;
+		mod->pid      = pid;
+
+		if( slot == symbolizer->num_modules )
+			++symbolizer->num_modules;
+		return bias;
+	}
+
+	static int symbol_server_add_stack( void** addresses, int num_addresses, void* userdata )
+	{
+		callstack_symbol_server_t* server = (callstack_symbol_server_t*)userdata;
+		if( server->num_addresses + (size_t)num_addresses > server->cap_addresses )
+		{
+			size_t new_cap = server->cap_addresses * 2 > server->num_addresses + (size_t)num_addresses ? server->cap_addresses * 2 : server->num_addresses + (size_t)num_addresses + 256;
+			void** new_addresses = (void**)realloc( server->addresses, new_cap * sizeof(void*) );
+			if( new_addresses == 0x0 )
+				return 1;
+			server->addresses     = new_addresses;
+			server->cap_addresses = new_cap;
+		}
+		memcpy( server->addresses + server->num_addresses, addresses, (size_t)num_addresses * sizeof(void*) );
+		server->num_addresses += (size_t)num_addresses;
+		return 0;
+	}
+
+	static int symbol_server_write_symbol( const callstack_symbol_t* sym, int index, void* userdata )
+	{
+		callstack_dump_writer_t* w = (callstack_dump_writer_t*)userdata;
+		dump_write( w, sym->function, strlen( sym->function ) + 1 );
+		dump_write( w, sym->file, strlen( sym->file ) + 1 );
+		dump_write_uleb( w, (uint64_t)index );
+		dump_write_uleb( w, sym->line );
+		dump_write_uleb( w, sym->offset );
+		dump_write_uleb( w, sym->inlined );
+		return 0;
+	}
+
+	static uint64_t symbol_server_now_ms()
+	{
+		struct timespec ts;
+		clock_gettime( CLOCK_MONOTONIC, &ts );
+		return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+	}
+
+	// ... read what is available of the current request of client, returns 1 when complete, 0 if more is needed and -1 if the connection should be closed ...
+	static int symbol_server_client_read( callstack_symbol_server_client_t* client )
+	{
+		for( ;; )
+		{
+			uint8_t* dst;
+			size_t   left;
+			if( client->received < sizeof(client->req) )
+			{
+				dst  = (uint8_t*)&client->req + client->received;
+				left = sizeof(client->req) - client->received;
+			}
+			else
+			{
+				size_t have = client->received - sizeof(client->req);
+				if( have == client->req.size )
+					return 1;
+				if( have == client->cap_dump )
+				{
+					// ... grow with what is actually sent, a header announcing a huge request does not get it allocated ...
+					size_t   new_cap  = client->cap_dump ? client->cap_dump * 2 : 64 * 1024;
+					if( new_cap > client->req.size )
+						new_cap = client->req.size;
+					uint8_t* new_dump = (uint8_t*)realloc( client->dump, new_cap );
+					if( new_dump == 0x0 )
+						return -1;
+					client->dump     = new_dump;
+					client->cap_dump = new_cap;
+				}
+				dst  = client->dump + have;
+				left = client->cap_dump - have;
+			}
+
+			ssize_t res = recv( client->fd, dst, left, 0 );
+			if( res < 0 && errno == EINTR )
+				continue;
+			if( res < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) )
+				return 0;
+			if( res <= 0 )
+				return -1;
+			client->received += (size_t)res;
+			if( client->received == sizeof(client->req) && ( client->req.magic != CALLSTACK_SYMBOL_SERVER_MAGIC || client->req.size > CALLSTACK_SYMBOL_SERVER_MAX_REQUEST ) )
+				return -1;
+		}
+	}
+
+	// ... send as much of data as the socket takes without blocking, returns bytes sent or -1 if the connection should be closed ...
+	static ssize_t symbol_server_client_send( callstack_symbol_server_client_t* client, const uint8_t* data, size_t size )
+	{
+		size_t sent = 0;
+		while( sent < size )
+		{
+			ssize_t res = send( client->fd, data + sent, size - sent, MSG_NOSIGNAL );
+			if( res < 0 && errno == EINTR )
+				continue;
+			if( res < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) )
+				break;
+			if( res <= 0 )
+				return -1;
+			sent += (size_t)res;
+		}
+		return (ssize_t)sent;
+	}
+
+	// ... answer the request read by client, returns 0 if the connection should be closed ...
+	static int symbol_server_handle_request( callstack_symbol_server_t* server, callstack_symbol_server_client_t* client )
+	{
+		const callstack_symbol_server_request_t* req = &client->req;
+		callstack_symbol_server_table_t* table = &server->tables[( req->flags & CALLSTACK_SYMBOL_SERVER_SHORT_NAMES ) ? 1 : 0];
+		if( table->symbolizer == 0x0 )
+		{
+			table->symbolizer = (callstack_symbolizer_t*)calloc( 1, sizeof(callstack_symbolizer_t) );
+			if( table->symbolizer )
+			{
+				table->symbolizer->offline = 1;
+				callstack_symbolizer_set_demangle( table->symbolizer, table == &server->tables[1] ? CALLSTACK_DEMANGLE_SHORT : CALLSTACK_DEMANGLE_FULL );
+			}
+		}
+
+		// ... map the modules of the client to where they live in the symbolizer, frames in modules that could not be added become 0x0 ...
+		callstack_dwarf_cursor_t c;
+		int64_t   num_modules = table->symbolizer && client->dump ? dump_read_header( &c, client->dump, (int)req->size ) : -1;
+		uint64_t* module_bias = num_modules >= 0 ? (uint64_t*)malloc( ( (size_t)num_modules + 1 ) * sizeof(uint64_t) ) : 0x0;
+		int       ok          = module_bias != 0x0;
+		for( int64_t i = 0; ok && i < num_modules; ++i )
+		{
+			callstack_dump_module_info_t info;
+			ok = dump_read_module( &c, &info );
+			if( ok )
+				module_bias[i] = symbol_server_module_bias( server, table, &info, client->pid );
+			if( ok && module_bias[i] == 0 )
+				module_bias[i] = (uint64_t)-1 - info.addr_end; // ... nothing lives up there ...
+		}
+
+		server->num_addresses = 0;
+		ok = ok && dump_read_stacks( &c, module_bias, (uint64_t)num_modules, 0, symbol_server_add_stack, server ) >= 0;
+		free( module_bias );
+		if( !ok )
+			return 0;
+
+		server->response.pos = 0;
+		uint32_t size = 0;
+		dump_write( &server->response, &size, sizeof(size) );
+		callstack_symbolizer_symbolize_foreach( table->symbolizer, server->addresses, (int)server->num_addresses, req->flags & CALLSTACK_SYMBOLS_INLINED, symbol_server_write_symbol, &server->response );
+		if( server->response.pos > server->response.size )
+			return 0;
+
+		size = (uint32_t)( server->response.pos - sizeof(size) );
+		memcpy( server->response.out, &size, sizeof(size) );
+
+		// ... the rest is kept with the client and sent as the socket gets writable ...
+		ssize_t sent = symbol_server_client_send( client, server->response.out, server->response.pos );
+		if( sent < 0 )
+			return 0;
+		if( (size_t)sent < server->response.pos )
+		{
+			client->pending_size = server->response.pos - (size_t)sent;
+			client->pending      = (uint8_t*)malloc( client->pending_size );
+			if( client->pending == 0x0 )
+				return 0;
+			memcpy( client->pending, server->response.out + sent, client->pending_size );
+			client->sent = 0;
+		}
+		return 1;
+	}
+
+	// ... back to waiting for the next request, buffers are only kept while a request is in flight ...
+	static void symbol_server_client_reset( callstack_symbol_server_client_t* client )
+	{
+		free( client->dump );
+		free( client->pending );
+		client->dump         = 0x0;
+		client->cap_dump     = 0;
+		client->received     = 0;
+		client->pending      = 0x0;
+		client->pending_size = 0;
+		client->sent         = 0;
+	}
+
+	// ... progress on the socket of client, returns 1 if a request was answered, 0 if not and -1 if the connection should be closed ...
+	static int symbol_server_client_update( callstack_symbol_server_t* server, callstack_symbol_server_client_t* client, short revents )
+	{
+		if( revents & ( POLLERR | POLLNVAL ) )
+			return -1;
+
+		if( client->pending )
+		{
+			if( ( revents & ( POLLOUT | POLLHUP ) ) == 0 )
+				return 0;
+			ssize_t sent = symbol_server_client_send( client, client->pending + client->sent, client->pending_size - client->sent );
+			if( sent < 0 )
+				return -1;
+			client->sent += (size_t)sent;
+			if( client->sent == client->pending_size )
+				symbol_server_client_reset( client );
+			return 0;
+		}
+
+		if( ( revents & ( POLLIN | POLLHUP ) ) == 0 )
+			return 0;
+		int res = symbol_server_client_read( client );
+		if( res <= 0 )
+			return res;
+		if( !symbol_server_handle_request( server, client ) )
+			return -1;
+
+		// ... keep the response if it is still being sent ...
+		free( client->dump );
+		client->dump     = 0x0;
+		client->cap_dump = 0;
+		client->received = 0;
+		if( client->pending == 0x0 )
+			symbol_server_client_reset( client );
+		return 1;
+	}
+
+	callstack_symbol_server_t* callstack_symbol_server_create( const char* socket_path )
+	{
+		struct sockaddr_un addr;
+		memset( &addr, 0x0, sizeof(addr) );
+		addr.sun_family = AF_UNIX;
+		if( socket_path == 0x0 || strlen( socket_path ) >= sizeof(addr.sun_path) || sizeof(uintptr_t) < 8 )
+			return 0x0;
+		strcpy( addr.sun_path, socket_path );
+
+		int fd = socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+		if( fd < 0 )
+			return 0x0;
+
+		// ... a socket-file left by a server that was killed would make bind() fail ...
+		unlink( socket_path );
+		callstack_symbol_server_t* server = 0x0;
+		if( bind( fd, (struct sockaddr*)&addr, sizeof(addr) ) != 0 || listen( fd, 64 ) != 0 || ( server = (callstack_symbol_server_t*)calloc( 1, sizeof(callstack_symbol_server_t) ) ) == 0x0 )
+		{
+			close( fd );
+			return 0x0;
+		}
+		server->listen_fd = fd;
+		strcpy( server->path, socket_path );
+		server->response.grow = 1;
+		return server;
+	}
+
+	void callstack_symbol_server_destroy( callstack_symbol_server_t* server )
+	{
+		if( server == 0x0 )
+			return;
+		for( int i = 0; i < server->num_clients; ++i )
+		{
+			close( server->clients[i].fd );
+			symbol_server_client_reset( &server->clients[i] );
+		}
+		close( server->listen_fd );
+		unlink( server->path );
+		for( int i = 0; i < 2; ++i )
+		{
+			callstack_symbolizer_destroy( server->tables[i].symbolizer );
+			free( server->tables[i].modules );
+		}
+		string_pool_free( server->strings );
+		free( server->addresses );
+		free( server->response.out );
+		free( server );
+	}
+
+	int callstack_symbol_server_update( callstack_symbol_server_t* server, int timeout_ms )
+	{
+		if( server == 0x0 )
+			return -1;
+
+		// ... wake up in time to drop clients that have stalled ...
+		uint64_t now = symbol_server_now_ms();
+		struct pollfd fds[1 + CALLSTACK_SYMBOL_SERVER_MAX_CLIENTS];
+		fds[0].fd     = server->listen_fd;
+		fds[0].events = POLLIN;
+		for( int i = 0; i < server->num_clients; ++i )
+		{
+			const callstack_symbol_server_client_t* client = &server->clients[i];
+			fds[i + 1].fd     = client->fd;
+			fds[i + 1].events = client->pending ? POLLOUT : POLLIN;
+			if( client->deadline != 0 )
+			{
+				int left = client->deadline > now ? (int)( client->deadline - now ) : 0;
+				if( timeout_ms < 0 || left < timeout_ms )
+					timeout_ms = left;
+			}
+		}
+
+		int res = poll( fds, (nfds_t)( 1 + server->num_clients ), timeout_ms );
+		if( res < 0 )
+			return errno == EINTR ? 0 : -1;
+
+		// ... backwards as clients are removed by moving the last one into their slot ...
+		int handled = 0;
+		now = symbol_server_now_ms();
+		for( int i = server->num_clients - 1; i >= 0; --i )
+		{
+			callstack_symbol_server_client_t* client = &server->clients[i];
+			size_t progress = client->received + client->sent;
+
+			int client_res = fds[i + 1].revents ? symbol_server_client_update( server, client, fds[i + 1].revents ) : 0;
+			if( client_res > 0 )
+				++handled;
+
+			// ... a client that stops half-way through a request or does not read its response only gets to hold its slot for a while ...
+			int busy = client->received > 0 || client->pending != 0x0;
+			if( client_res >= 0 && !busy )
+				client->deadline = 0;
+			else if( client_res >= 0 && ( client->deadline == 0 || client_res > 0 || client->received + client->sent != progress ) )
+				client->deadline = now + CALLSTACK_SYMBOL_SERVER_TIMEOUT_MS;
+			if( client_res >= 0 && ( client->deadline == 0 || now < client->deadline ) )
+				continue;
+
+			close( client->fd );
+			symbol_server_client_reset( client );
+			*client = server->clients[--server->num_clients];
+		}
+
+		if( fds[0].revents & POLLIN )
+		{
+			int fd = accept4( server->listen_fd, 0x0, 0x0, SOCK_CLOEXEC | SOCK_NONBLOCK );
+			if( fd >= 0 && server->num_clients == CALLSTACK_SYMBOL_SERVER_MAX_CLIENTS )
+				close( fd );
+			else if( fd >= 0 )
+			{
+				struct ucred cred;
+				socklen_t    cred_len = sizeof(cred);
+				callstack_symbol_server_client_t* client = &server->clients[server->num_clients++];
+				memset( client, 0x0, sizeof(callstack_symbol_server_client_t) );
+				client->fd  = fd;
+				client->pid = getsockopt( fd, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len ) == 0 ? (int)cred.pid : 0;
+			}
+		}
+		return handled;
+	}
+
+	// ... connection to the server set with callstack_symbols_set_server(), all guarded by g_symbol_server_lock ...
+	static int             g_symbol_server_fd      = -1;
+	static char            g_symbol_server_path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+	static pthread_mutex_t g_symbol_server_lock    = PTHREAD_MUTEX_INITIALIZER;
+
+	static int symbol_server_connect()
+	{
+		struct sockaddr_un addr;
+		memset( &addr, 0x0, sizeof(addr) );
+		addr.sun_family = AF_UNIX;
+		memcpy( addr.sun_path, g_symbol_server_path, sizeof(addr.sun_path) );
+
+		int fd = socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+		if( fd < 0 )
+			return -1;
+		socket_set_timeout( fd, CALLSTACK_SYMBOL_SERVER_TIMEOUT_MS );
+		if( connect( fd, (struct sockaddr*)&addr, sizeof(addr) ) != 0 )
+		{
+			close( fd );
+			return -1;
+		}
+		return fd;
+	}
+
+	// ... send request to the server and read the response into a malloc:ed buffer, 0x0 on failure ...
+	static uint8_t* symbol_server_call( const uint8_t* request, size_t request_size, uint32_t* response_size )
+	{
+		uint8_t* response = 0x0;
+		pthread_mutex_lock( &g_symbol_server_lock );
+
+		// ... a kept connection might have been closed by the server since the last call, reconnect once ...
+		for( int attempt = 0; attempt < 2 && response == 0x0; ++attempt )
+		{
+			int reused = g_symbol_server_fd >= 0;
+			if( !reused )
+				g_symbol_server_fd = symbol_server_connect();
+			if( g_symbol_server_fd < 0 )
+				break;
+
+			if( socket_write_all( g_symbol_server_fd, request, request_size ) &&
+				socket_read_all( g_symbol_server_fd, response_size, sizeof(uint32_t) ) &&
+				*response_size <= CALLSTACK_SYMBOL_SERVER_MAX_REQUEST )
+			{
+				response = (uint8_t*)malloc( *response_size + 1 );
+				if( response && !socket_read_all( g_symbol_server_fd, response, *response_size ) )
+				{
+					free( response );
+					response = 0x0;
+				}
+			}
+
+			if( response == 0x0 )
+			{
+				close( g_symbol_server_fd );
+				g_symbol_server_fd = -1;
+				if( !reused )
+					break;
+			}
+		}
+
+		pthread_mutex_unlock( &g_symbol_server_lock );
+		return response;
+	}
+
+	/**
+	 * Symbolize addresses with the server set with callstack_symbols_set_server(), returns the number of symbols
+	 * passed to callback or -1 if there is no server or it could not be reached, the caller should then fall
+	 * back to symbolizing in process.
+	 */
+	static int symbol_server_foreach( void** addresses, int num_addresses, unsigned int flags, int short_names, callstack_symbol_callback callback, void* userdata )
+	{
+		if( !__atomic_load_n( &g_symbol_server_enabled, __ATOMIC_ACQUIRE ) )
+			return -1;
+		if( num_addresses <= 0 )
+			return 0;
+
+		int dump_size = callstack_dump_write( addresses, &num_addresses, 1, 0x0, 0 );
+		uint8_t* request = dump_size > 0 ? (uint8_t*)malloc( sizeof(callstack_symbol_server_request_t) + (size_t)dump_size ) : 0x0;
+		if( request == 0x0 )
+			return -1;
+
+		callstack_symbol_server_request_t req;
+		req.magic = CALLSTACK_SYMBOL_SERVER_MAGIC;
+		req.flags = ( flags & CALLSTACK_SYMBOLS_INLINED ) | ( short_names ? CALLSTACK_SYMBOL_SERVER_SHORT_NAMES : 0 );
+		req.size  = (uint32_t)dump_size;
+		memcpy( request, &req, sizeof(req) );
+		callstack_dump_write( addresses, &num_addresses, 1, request + sizeof(req), dump_size );
+
+		uint32_t response_size = 0;
+		uint8_t* response = symbol_server_call( request, sizeof(req) + (size_t)dump_size, &response_size );
+		free( request );
+		if( response == 0x0 )
+			return -1;
+
+		// ... strings are sent 0-terminated so symbols can point straight into the response ...
+		callstack_dwarf_cursor_t c;
+		dwarf_cursor_init( &c, response, response_size );
+		int num_reported = 0;
+		while( dwarf_left( &c ) > 0 )
+		{
+			callstack_symbol_t sym;
+			sym.function = (const char*)c.ptr;
+			const uint8_t* function_end = (const uint8_t*)memchr( c.ptr, '\0', dwarf_left( &c ) );
+			if( function_end == 0x0 )
+				break;
+			dwarf_skip( &c, (uint64_t)( function_end - c.ptr ) + 1 );
+			sym.file = (const char*)c.ptr;
+			const uint8_t* file_end = (const uint8_t*)memchr( c.ptr, '\0', dwarf_left( &c ) );
+			if( file_end == 0x0 )
+				break;
+			dwarf_skip( &c, (uint64_t)( file_end - c.ptr ) + 1 );
+
+			int error = 0;
+			int index   = (int)dump_read_uleb( &c, &error );
+			sym.line    = (unsigned int)dump_read_uleb( &c, &error );
+			sym.offset  = (unsigned int)dump_read_uleb( &c, &error );
+			sym.inlined = (unsigned int)dump_read_uleb( &c, &error );
+			if( error )
+				break;
+
+			++num_reported;
+			if( callback( &sym, index, userdata ) != 0 )
+				break;
+		}
+		free( response );
+		return num_reported;
+	}
+
+	int callstack_symbols_set_server( const char* socket_path )
+	{
+		if( socket_path && strlen( socket_path ) >= sizeof(g_symbol_server_path) )
+			return -1;
+
+		pthread_mutex_lock( &g_symbol_server_lock );
+		if( g_symbol_server_fd >= 0 )
+			close( g_symbol_server_fd );
+		g_symbol_server_fd = -1;
+		memset( g_symbol_server_path, 0x0, sizeof(g_symbol_server_path) );
+		if( socket_path )
+			strcpy( g_symbol_server_path, socket_path );
+		__atomic_store_n( &g_symbol_server_enabled, socket_path != 0x0, __ATOMIC_RELEASE );
+		pthread_mutex_unlock( &g_symbol_server_lock );
+		return 0;
+	}
+#elif defined(__APPLE__) && defined(__MACH__)
+	// ... buffer must be malloc:ed as __cxa_demangle() might realloc() it, buffer and buffer_size is updated if it does ...
+	static char* demangle_symbol( char* symbol, char** buffer, size_t* buffer_size )
+	{
+		int status;
+		char* demangled_symbol = abi::__cxa_demangle( symbol, *buffer, buffer_size, &status );
+		if( status != 0 )
+			return symbol;
+		*buffer = demangled_symbol;
+		return demangled_symbol;
+	}
+
+	static FILE* run_addr2line( void** addresses, int num_addresses, char* tmp_buffer, size_t tmp_buf_len )
+	{
+		size_t start = (size_t)snprintf( tmp_buffer, tmp_buf_len, "xcrun atos -p %u -l", getpid() );
+		for( int i = 0; i < num_addresses; ++i )
+			start += (size_t)snprintf( tmp_buffer + start, tmp_buf_len - start, " %p", addresses[i] );
+
+		return popen( tmp_buffer, "r" );
+	}
+
+	struct callstack_symbolizer
+	{
+		char*  tmp_buffer;
+		size_t tmp_buf_len;
+		char*  demangle_buffer; ///< kept apart from tmp_buffer as names need to stay alive while the output of atos is read.
+		size_t demangle_buf_len;
+	};
+
+	callstack_symbolizer_t* callstack_symbolizer_create()
+	{
+		callstack_symbolizer_t* symbolizer = (callstack_symbolizer_t*)malloc( sizeof(callstack_symbolizer_t) );
+		if( symbolizer == 0x0 )
+			return 0x0;
+		symbolizer->tmp_buf_len      = 1024 * 32;
+		symbolizer->tmp_buffer       = (char*)malloc( symbolizer->tmp_buf_len );
+		symbolizer->demangle_buf_len = 1024;
+		symbolizer->demangle_buffer  = (char*)malloc( symbolizer->demangle_buf_len );
+		return symbolizer;
+	}
+
+	void callstack_symbolizer_destroy( callstack_symbolizer_t* symbolizer )
+	{
+		if( symbolizer == 0x0 )
+			return;
+		free( symbolizer->tmp_buffer );
+		free( symbolizer->demangle_buffer );
+		free( symbolizer );
+	}
+
+	// ... names are demangled by atos ...
+	int callstack_symbolizer_set_demangle( callstack_symbolizer_t*, enum callstack_demangle mode )
+	{
+		return mode == CALLSTACK_DEMANGLE_FULL ? 0 : -1;
+	}
+
+	// ... atos does not report inlined functions, one symbol per address ...
+	int callstack_symbolizer_symbolize_foreach( callstack_symbolizer_t* symbolizer, void** addresses, int num_addresses, unsigned int, callstack_symbol_callback callback, void* userdata )
 	{
-		int num_translated = 0;
-		callstack_string_buffer_t outbuf = { memory, memory + mem_size };
-		memset( out_syms, 0x0, (size_t)num_addresses * sizeof(callstack_symbol_t) );
+		if( symbolizer == 0x0 || callback == 0x0 )
+			return 0;
 
+		int num_translated = 0;
 		char** syms = backtrace_symbols( addresses, num_addresses );
-		size_t tmp_buf_len = 1024 * 32;
-		char*  tmp_buffer  = (char*)malloc( tmp_buf_len );
+		size_t& tmp_buf_len = symbolizer->tmp_buf_len;
+		char*&  tmp_buffer  = symbolizer->tmp_buffer;
 
 		FILE* addr2line = run_addr2line( addresses, num_addresses, tmp_buffer, tmp_buf_len );
 
@@ -239,17 +7681,6 @@ static const char* alloc_string( callstack_string_buffer_t* buf, const char* str
 			unsigned int offset = 0;
 
 			// find function name and offset
-		#if defined(__linux)
-			char* name_start   = strchr( symbol, '(' );
-			char* offset_start = name_start ? strchr( name_start, '+' ) : 0x0;
-
-			if( name_start && offset_start )
-			{
-				// zero terminate all strings
-				++name_start;
-				*offset_start = '\0'; ++offset_start;
-			}
-		#elif defined(__APPLE__) && defined(__MACH__)
 			char* name_start   = 0x0;
 			char* offset_start = strrchr( symbol, '+' );
 			if( offset_start )
@@ -259,33 +7690,24 @@ static const char* alloc_string( callstack_string_buffer_t* buf, const char* str
 				if( name_start )
 					++name_start;
 			}
-		#else
-		#  error "Unhandled platform"
-		#endif
 
 			if( name_start && offset_start )
 			{
 				offset = (unsigned int)strtoll( offset_start, 0x0, 16 );
-				symbol = demangle_symbol( name_start, tmp_buffer, tmp_buf_len );
+				symbol = demangle_symbol( name_start, &symbolizer->demangle_buffer, &symbolizer->demangle_buf_len );
 			}
 
-			out_syms[i].function = alloc_string( &outbuf, symbol, strlen( symbol ) );
-			out_syms[i].offset   = offset;
-			out_syms[i].file = "failed to lookup file";
-			out_syms[i].line = 0;
+			callstack_symbol_t sym;
+			sym.function = symbol;
+			sym.offset   = offset;
+			sym.file     = "failed to lookup file";
+			sym.line     = 0;
+			sym.inlined  = 0;
 
 			if( addr2line != 0x0 )
 			{
 				if( fgets( tmp_buffer, (int)tmp_buf_len, addr2line ) != 0x0 )
 				{
-				#if defined(__linux)
-					char* line_start = strchr( tmp_buffer, ':' );
-					*line_start = '\0';
-
-					if( tmp_buffer[0] != '?' && tmp_buffer[1] != '?' )
-						out_syms[i].file = alloc_string( &outbuf, tmp_buffer, strlen( tmp_buffer ) );
-					out_syms[i].line = (unsigned int)strtoll( line_start + 1, 0x0, 10 );
-				#elif defined(__APPLE__) && defined(__MACH__)
 					char* file_start = strrchr( tmp_buffer, '(');
 					if( file_start )
 					{
@@ -296,24 +7718,214 @@ static const char* alloc_string( callstack_string_buffer_t* buf, const char* str
 							*line_start = '\0';
 							++line_start;
 
-							out_syms[i].file = alloc_string( &outbuf, file_start, strlen( file_start ) );
-							out_syms[i].line = (unsigned int)strtoll( line_start, 0x0, 10 );
+							sym.file = file_start;
+							sym.line = (unsigned int)strtoll( line_start, 0x0, 10 );
 						}
 					}
-				#else
-				#  error "Unhandled platform"
-				#endif
 				}
 			}
 
 			++num_translated;
+			if( callback( &sym, i, userdata ) != 0 )
+				break;
 		}
 		free( syms );
-		free( tmp_buffer );
-		fclose( addr2line );
+		if( addr2line != 0x0 )
+			pclose( addr2line );
 		return num_translated;
 	}
 
+	int callstack_symbolizer_symbolize( callstack_symbolizer_t* symbolizer, void** addresses, callstack_symbol_t* out_syms, int num_addresses, char* memory, int mem_size )
+	{
+		callstack_symbol_copy_t copy = { out_syms, 0, num_addresses, { memory, memory + mem_size } };
+		callstack_symbolizer_symbolize_foreach( symbolizer, addresses, num_addresses, 0, symbol_copy_callback, &copy );
+		return copy.num_syms;
+	}
+
+	// ... atos does not report inlined functions, one symbol per address ...
+	int callstack_symbolizer_symbolize_inlined( callstack_symbolizer_t* symbolizer, void** addresses, callstack_symbol_t* out_syms, int num_addresses, int max_syms, char* memory, int mem_size )
+	{
+		return callstack_symbolizer_symbolize( symbolizer, addresses, out_syms, num_addresses < max_syms ? num_addresses : max_syms, memory, mem_size );
+	}
+
+	// ... atos is run in a separate process so there is no way to do this in a signal-handler ...
+	int callstack_symbolizer_symbolize_signal_safe( callstack_symbolizer_t*, void**, callstack_symbol_t*, int, char*, int )
+	{
+		return 0;
+	}
+
+	int callstack_symbolizer_symbolize_batch( callstack_symbolizer_t*, void* const*, callstack_symbol_t*, int )
+	{
+		return 0;
+	}
+
+	int callstack_symbolizer_symbolize_parallel( callstack_symbolizer_t*, void* const*, callstack_symbol_t*, int, int )
+	{
+		return 0;
+	}
+
+	int callstack_dump_write( void* const*, const int*, int, void*, int )
+	{
+		return 0;
+	}
+
+	int callstack_dump_read( const void*, int, callstack_dump_callback, void* )
+	{
+		return -1;
+	}
+
+	callstack_symbolizer_t* callstack_symbolizer_create_from_dump( const void*, int, const char* )
+	{
+		return 0x0;
+	}
+
+	int callstack_index_write( const char*, const char* )
+	{
+		return -1;
+	}
+
+	callstack_symbol_server_t* callstack_symbol_server_create( const char* )
+	{
+		return 0x0;
+	}
+
+	int callstack_symbol_server_update( callstack_symbol_server_t*, int )
+	{
+		return -1;
+	}
+
+	void callstack_symbol_server_destroy( callstack_symbol_server_t* )
+	{
+	}
+#else
+#   error "Unhandled platform"
+#endif
+
+	// ... default symbolizer used by callstack_symbols(), guarded by a lock since a symbolizer is single-threaded ...
+	static callstack_symbolizer_t* g_default_symbolizer = 0x0;
+	static pthread_once_t          g_default_symbolizer_once = PTHREAD_ONCE_INIT;
+	static pthread_mutex_t         g_default_symbolizer_lock = PTHREAD_MUTEX_INITIALIZER;
+
+	static enum callstack_demangle g_default_demangle = CALLSTACK_DEMANGLE_FULL;
+
+	// ... settings are read and the symbolizer published under the lock so that a setter either lands before creation or fails ...
+	static void default_symbolizer_create()
+	{
+		pthread_mutex_lock( &g_default_symbolizer_lock );
+		callstack_symbolizer_t* symbolizer = callstack_symbolizer_create();
+		if( symbolizer )
+			callstack_symbolizer_set_demangle( symbolizer, g_default_demangle );
+	#if defined(__linux)
+		symbol_cache_create();
+	#endif
+		g_default_symbolizer = symbolizer;
+		pthread_mutex_unlock( &g_default_symbolizer_lock );
+	}
+
+	int callstack_symbols_set_demangle( enum callstack_demangle mode )
+	{
+		pthread_mutex_lock( &g_default_symbolizer_lock );
+		int res = g_default_symbolizer == 0x0 ? 0 : -1;
+	#if !defined(__linux)
+		if( mode != CALLSTACK_DEMANGLE_FULL )
+			res = -1;
+	#endif
+		if( res == 0 )
+			__atomic_store_n( &g_default_demangle, mode, __ATOMIC_RELAXED );
+		pthread_mutex_unlock( &g_default_symbolizer_lock );
+		return res;
+	}
+
+#if defined(__linux)
+	int callstack_symbols_set_cache_size( unsigned int max_bytes )
+	{
+		pthread_mutex_lock( &g_default_symbolizer_lock );
+		int res = g_default_symbolizer == 0x0 ? 0 : -1;
+		if( res == 0 )
+			g_symbol_cache.max_bytes = max_bytes;
+		pthread_mutex_unlock( &g_default_symbolizer_lock );
+		return res;
+	}
+#else
+	int callstack_symbols_set_cache_size( unsigned int )
+	{
+		return -1;
+	}
+
+	int callstack_symbols_set_server( const char* )
+	{
+		return -1;
+	}
+#endif
+
+	int callstack_symbols( void** addresses, callstack_symbol_t* out_syms, int num_addresses, char* memory, int mem_size )
+	{
+	#if defined(__linux)
+		// ... strings from a symbol-server only live in the response so they are copied to memory ...
+		callstack_symbol_copy_t copy = { out_syms, 0, num_addresses, { memory, memory + mem_size } };
+		if( symbol_server_foreach( addresses, num_addresses, 0, __atomic_load_n( &g_default_demangle, __ATOMIC_RELAXED ) == CALLSTACK_DEMANGLE_SHORT, symbol_copy_callback, &copy ) >= 0 )
+			return copy.num_syms;
+	#endif
+
+		pthread_once( &g_default_symbolizer_once, default_symbolizer_create );
+		if( g_default_symbolizer == 0x0 )
+			return 0;
+
+	#if defined(__linux)
+		// ... all strings are owned by the default symbolizer so memory is not needed ...
+		(void)memory; (void)mem_size;
+		return symbol_cache_symbolize( g_default_symbolizer, &g_default_symbolizer_lock, addresses, out_syms, num_addresses );
+	#else
+		pthread_mutex_lock( &g_default_symbolizer_lock );
+		int res = callstack_symbolizer_symbolize( g_default_symbolizer, addresses, out_syms, num_addresses, memory, mem_size );
+		pthread_mutex_unlock( &g_default_symbolizer_lock );
+		return res;
+	#endif
+	}
+
+	int callstack_symbols_inlined( void** addresses, callstack_symbol_t* out_syms, int num_addresses, int max_syms, char* memory, int mem_size )
+	{
+	#if defined(__linux)
+		callstack_symbol_copy_t copy = { out_syms, 0, max_syms, { memory, memory + mem_size } };
+		if( symbol_server_foreach( addresses, num_addresses, CALLSTACK_SYMBOLS_INLINED, __atomic_load_n( &g_default_demangle, __ATOMIC_RELAXED ) == CALLSTACK_DEMANGLE_SHORT, symbol_copy_callback, &copy ) >= 0 )
+			return copy.num_syms;
+	#endif
+
+		pthread_once( &g_default_symbolizer_once, default_symbolizer_create );
+		if( g_default_symbolizer == 0x0 )
+			return 0;
+
+		// ... inlined frames are not cached, the cache only holds one symbol per address ...
+		pthread_mutex_lock( &g_default_symbolizer_lock );
+		int res = callstack_symbolizer_symbolize_inlined( g_default_symbolizer, addresses, out_syms, num_addresses, max_syms, memory, mem_size );
+		pthread_mutex_unlock( &g_default_symbolizer_lock );
+		return res;
+	}
+
+	int callstack_symbols_foreach( void** addresses, int num_addresses, unsigned int flags, callstack_symbol_callback callback, void* userdata )
+	{
+	#if defined(__linux)
+		int res = callback ? symbol_server_foreach( addresses, num_addresses, flags, __atomic_load_n( &g_default_demangle, __ATOMIC_RELAXED ) == CALLSTACK_DEMANGLE_SHORT, callback, userdata ) : 0;
+		if( res >= 0 )
+			return res;
+	#endif
+
+		pthread_once( &g_default_symbolizer_once, default_symbolizer_create );
+		if( g_default_symbolizer == 0x0 )
+			return 0;
+
+	#if defined(__linux)
+		return symbolizer_foreach( g_default_symbolizer, &g_default_symbolizer_lock, addresses, num_addresses, flags, callback, userdata );
+	#else
+		// ... strings only live in the symbolizers scratch-buffers until the next call so the lock is held during callback ...
+		pthread_mutex_lock( &g_default_symbolizer_lock );
+		int res = callstack_symbolizer_symbolize_foreach( g_default_symbolizer, addresses, num_addresses, flags, callback, userdata );
+		pthread_mutex_unlock( &g_default_symbolizer_lock );
+		return res;
+	#endif
+	}
+
+
 #elif defined(_MSC_VER)
 #  if defined(__clang__)
 	// when compiling with clang on windows, silence warnings from windows-code
@@ -326,12 +7938,73 @@ static const char* alloc_string( callstack_string_buffer_t* buf, const char* str
 #    pragma clang diagnostic pop
 #  endif
 	#include <Dbghelp.h>
+	#include <stdlib.h>
 
 	int callstack( int skip_frames, void** addresses, int num_addresses )
 	{
 		return RtlCaptureStackBackTrace( skip_frames + 1, num_addresses, addresses, 0 );
 	}
 
+	int callstack_set_unwinder( enum callstack_unwinder unwinder )
+	{
+		// ... RtlCaptureStackBackTrace() is the only supported unwinder on windows ...
+		return unwinder == CALLSTACK_UNWINDER_DEFAULT ? 0 : -1;
+	}
+
+	int callstack_from_context( void* /*context*/, void** /*addresses*/, int /*num_addresses*/ )
+	{
+		return 0;
+	}
+
+	int callstack_symbolizer_symbolize_signal_safe( callstack_symbolizer_t*, void**, callstack_symbol_t*, int, char*, int )
+	{
+		return 0;
+	}
+
+	int callstack_symbolizer_symbolize_batch( callstack_symbolizer_t*, void* const*, callstack_symbol_t*, int )
+	{
+		return 0;
+	}
+
+	int callstack_symbolizer_symbolize_parallel( callstack_symbolizer_t*, void* const*, callstack_symbol_t*, int, int )
+	{
+		return 0;
+	}
+
+	int callstack_dump_write( void* const*, const int*, int, void*, int )
+	{
+		return 0;
+	}
+
+	int callstack_dump_read( const void*, int, callstack_dump_callback, void* )
+	{
+		return -1;
+	}
+
+	callstack_symbolizer_t* callstack_symbolizer_create_from_dump( const void*, int, const char* )
+	{
+		return 0x0;
+	}
+
+	int callstack_index_write( const char*, const char* )
+	{
+		return -1;
+	}
+
+	callstack_symbol_server_t* callstack_symbol_server_create( const char* )
+	{
+		return 0x0;
+	}
+
+	int callstack_symbol_server_update( callstack_symbol_server_t*, int )
+	{
+		return -1;
+	}
+
+	void callstack_symbol_server_destroy( callstack_symbol_server_t* )
+	{
+	}
+
 	typedef BOOL  (__stdcall *SymInitialize_f)( _In_ HANDLE hProcess, _In_opt_ PCSTR UserSearchPath, _In_ BOOL fInvadeProcess );
 	typedef BOOL  (__stdcall *SymFromAddr_f)( _In_ HANDLE hProcess, _In_ DWORD64 Address, _Out_opt_ PDWORD64 Displacement, _Inout_ PSYMBOL_INFO Symbol );
 	typedef BOOL  (__stdcall *SymGetLineFromAddr64_f)( _In_ HANDLE hProcess, _In_ DWORD64 qwAddr, _Out_ PDWORD pdwDisplacement, _Out_ PIMAGEHLP_LINE64 Line64 );
@@ -485,28 +8158,85 @@ static const char* alloc_string( callstack_string_buffer_t* buf, const char* str
 		return dbghelp.init_ok;
 	}
 
+	// ... all state is kept in the global dbghelp-struct on windows ...
+	struct callstack_symbolizer
+	{
+		int unused;
+	};
+
+	callstack_symbolizer_t* callstack_symbolizer_create()
+	{
+		callstack_symbolizer_t* symbolizer = (callstack_symbolizer_t*)malloc( sizeof(callstack_symbolizer_t) );
+		if( symbolizer )
+			callstack_symbols_initialize();
+		return symbolizer;
+	}
+
+	void callstack_symbolizer_destroy( callstack_symbolizer_t* symbolizer )
+	{
+		free( symbolizer );
+	}
+
+	// ... names are undecorated by dbghelp ...
+	int callstack_symbolizer_set_demangle( callstack_symbolizer_t* /*symbolizer*/, enum callstack_demangle mode )
+	{
+		return mode == CALLSTACK_DEMANGLE_FULL ? 0 : -1;
+	}
+
+	int callstack_symbols_set_demangle( enum callstack_demangle mode )
+	{
+		return mode == CALLSTACK_DEMANGLE_FULL ? 0 : -1;
+	}
+
 	int callstack_symbols( void** addresses, callstack_symbol_t* out_syms, int num_addresses, char* memory, int mem_size )
 	{
-		HANDLE          process;
-		DWORD64         offset;
-		DWORD           line_dis;
-		BOOL            res;
-		IMAGEHLP_LINE64 line;
-		PSYMBOL_INFO    sym_info;
+		return callstack_symbolizer_symbolize( 0x0, addresses, out_syms, num_addresses, memory, mem_size );
+	}
+
+	// ... inlined frames are not expanded on windows, one symbol per address ...
+	int callstack_symbols_inlined( void** addresses, callstack_symbol_t* out_syms, int num_addresses, int max_syms, char* memory, int mem_size )
+	{
+		return callstack_symbols( addresses, out_syms, num_addresses < max_syms ? num_addresses : max_syms, memory, mem_size );
+	}
+
+	int callstack_symbolizer_symbolize_inlined( callstack_symbolizer_t* symbolizer, void** addresses, callstack_symbol_t* out_syms, int num_addresses, int max_syms, char* memory, int mem_size )
+	{
+		return callstack_symbolizer_symbolize( symbolizer, addresses, out_syms, num_addresses < max_syms ? num_addresses : max_syms, memory, mem_size );
+	}
+
+	int callstack_symbols_set_cache_size( unsigned int /*max_bytes*/ )
+	{
+		return -1;
+	}
+
+	int callstack_symbols_set_server( const char* /*socket_path*/ )
+	{
+		return -1;
+	}
+
+	// ... inlined frames are not expanded on windows, one symbol per address ...
+	int callstack_symbolizer_symbolize_foreach( callstack_symbolizer_t* /*symbolizer*/, void** addresses, int num_addresses, unsigned int /*flags*/, callstack_symbol_callback callback, void* userdata )
+	{
+		HANDLE             process;
+		DWORD64            offset;
+		DWORD              line_dis;
+		BOOL               res;
+		IMAGEHLP_LINE64    line;
+		PSYMBOL_INFO       sym_info;
+		callstack_symbol_t sym;
 		char buffer[sizeof(SYMBOL_INFO) + MAX_SYM_NAME * sizeof(TCHAR)];
 		int num_translated = 0;
-		callstack_string_buffer_t outbuf = { memory, memory + mem_size };
-
-		memset( out_syms, 0x0, (size_t)num_addresses * sizeof(callstack_symbol_t) );
 
+		if( callback == 0x0 )
+			return 0;
 
+		memset( &sym, 0x0, sizeof(callstack_symbol_t) );
 
 		if( !callstack_symbols_initialize() )
 		{
-			out_syms[0].function = "failed to initialize dbghelp.dll";
-			out_syms[0].offset   = 0;
-			out_syms[0].file     = "";
-			out_syms[0].line     = 0;
+			sym.function = "failed to initialize dbghelp.dll";
+			sym.file     = "";
+			callback( &sym, 0, userdata );
 			return 1;
 		}
 
@@ -521,29 +8251,43 @@ static const char* alloc_string( callstack_string_buffer_t* buf, const char* str
 		{
 			res = dbghelp.SymFromAddr( process, (DWORD64)addresses[i], &offset, sym_info );
 			if( res == 0 )
-				out_syms[i].function = "failed to lookup symbol";
+				sym.function = "failed to lookup symbol";
 			else
-				out_syms[i].function = alloc_string( &outbuf, sym_info->Name, sym_info->NameLen );
+				sym.function = sym_info->Name;
 
 			res = dbghelp.SymGetLineFromAddr64( process, (DWORD64)addresses[i], &line_dis, &line );
 			if( res == 0 )
 			{
-				out_syms[i].offset = 0;
-				out_syms[i].file   = "failed to lookup file";
-				out_syms[i].line   = 0;
+				sym.offset = 0;
+				sym.file   = "failed to lookup file";
+				sym.line   = 0;
 			}
 			else
 			{
-				out_syms[i].offset = (unsigned int)line_dis;
-				out_syms[i].file   = alloc_string( &outbuf, line.FileName, strlen( line.FileName ) );
-				out_syms[i].line   = (unsigned int)line.LineNumber;
+				sym.offset = (unsigned int)line_dis;
+				sym.file   = line.FileName;
+				sym.line   = (unsigned int)line.LineNumber;
 			}
 
 			++num_translated;
+			if( callback( &sym, i, userdata ) != 0 )
+				break;
 		}
 		return num_translated;
 	}
 
+	int callstack_symbolizer_symbolize( callstack_symbolizer_t* symbolizer, void** addresses, callstack_symbol_t* out_syms, int num_addresses, char* memory, int mem_size )
+	{
+		callstack_symbol_copy_t copy = { out_syms, 0, num_addresses, { memory, memory + mem_size } };
+		callstack_symbolizer_symbolize_foreach( symbolizer, addresses, num_addresses, 0, symbol_copy_callback, &copy );
+		return copy.num_syms;
+	}
+
+	int callstack_symbols_foreach( void** addresses, int num_addresses, unsigned int flags, callstack_symbol_callback callback, void* userdata )
+	{
+		return callstack_symbolizer_symbolize_foreach( 0x0, addresses, num_addresses, flags, callback, userdata );
+	}
+
 #else
 
 	int callstack( int skip_frames, void** addresses, int num_addresses )
@@ -552,12 +8296,163 @@ static const char* alloc_string( callstack_string_buffer_t* buf, const char* str
 		return 0;
 	}
 
+	int callstack_set_unwinder( enum callstack_unwinder unwinder )
+	{
+		(void)unwinder;
+		return -1;
+	}
+
+	int callstack_from_context( void* context, void** addresses, int num_addresses )
+	{
+		(void)context; (void)addresses; (void)num_addresses;
+		return 0;
+	}
+
 	int callstack_symbols( void** addresses, callstack_symbol_t* out_syms, int num_addresses, char* memory, int mem_size )
 	{
 		(void)addresses; (void)out_syms; (void)num_addresses; (void)memory; (void)mem_size;
 		return 0;
 	}
 
+	int callstack_symbols_inlined( void** addresses, callstack_symbol_t* out_syms, int num_addresses, int max_syms, char* memory, int mem_size )
+	{
+		(void)addresses; (void)out_syms; (void)num_addresses; (void)max_syms; (void)memory; (void)mem_size;
+		return 0;
+	}
+
+	int callstack_symbolizer_symbolize_inlined( callstack_symbolizer_t* symbolizer, void** addresses, callstack_symbol_t* out_syms, int num_addresses, int max_syms, char* memory, int mem_size )
+	{
+		(void)symbolizer; (void)addresses; (void)out_syms; (void)num_addresses; (void)max_syms; (void)memory; (void)mem_size;
+		return 0;
+	}
+
+	int callstack_symbols_set_cache_size( unsigned int max_bytes )
+	{
+		(void)max_bytes;
+		return -1;
+	}
+
+	callstack_symbolizer_t* callstack_symbolizer_create()
+	{
+		return 0x0;
+	}
+
+	void callstack_symbolizer_destroy( callstack_symbolizer_t* symbolizer )
+	{
+		(void)symbolizer;
+	}
+
+	int callstack_symbolizer_set_demangle( callstack_symbolizer_t* symbolizer, enum callstack_demangle mode )
+	{
+		(void)symbolizer; (void)mode;
+		return -1;
+	}
+
+	int callstack_symbols_set_demangle( enum callstack_demangle mode )
+	{
+		(void)mode;
+		return -1;
+	}
+
+	int callstack_symbolizer_symbolize( callstack_symbolizer_t* symbolizer, void** addresses, callstack_symbol_t* out_syms, int num_addresses, char* memory, int mem_size )
+	{
+		(void)symbolizer; (void)addresses; (void)out_syms; (void)num_addresses; (void)memory; (void)mem_size;
+		return 0;
+	}
+
+	int callstack_symbolizer_symbolize_signal_safe( callstack_symbolizer_t* symbolizer, void** addresses, callstack_symbol_t* out_syms, int num_addresses, char* memory, int mem_size )
+	{
+		(void)symbolizer; (void)addresses; (void)out_syms; (void)num_addresses; (void)memory; (void)mem_size;
+		return 0;
+	}
+
+	int callstack_symbolizer_symbolize_batch( callstack_symbolizer_t* symbolizer, void* const* addresses, callstack_symbol_t* out_syms, int num_addresses )
+	{
+		(void)symbolizer; (void)addresses; (void)out_syms; (void)num_addresses;
+		return 0;
+	}
+
+	int callstack_symbolizer_symbolize_parallel( callstack_symbolizer_t* symbolizer, void* const* addresses, callstack_symbol_t* out_syms, int num_addresses, int num_threads )
+	{
+		(void)symbolizer; (void)addresses; (void)out_syms; (void)num_addresses; (void)num_threads;
+		return 0;
+	}
+
+	int callstack_symbolizer_symbolize_foreach( callstack_symbolizer_t* symbolizer, void** addresses, int num_addresses, unsigned int flags, callstack_symbol_callback callback, void* userdata )
+	{
+		(void)symbolizer; (void)addresses; (void)num_addresses; (void)flags; (void)callback; (void)userdata;
+		return 0;
+	}
+
+	int callstack_symbols_foreach( void** addresses, int num_addresses, unsigned int flags, callstack_symbol_callback callback, void* userdata )
+	{
+		(void)addresses; (void)num_addresses; (void)flags; (void)callback; (void)userdata;
+		return 0;
+	}
+
+	int callstack_symbolizer_mem_size( callstack_symbolizer_t* symbolizer, void** addresses, int num_addresses, unsigned int flags, int* num_syms )
+	{
+		(void)symbolizer; (void)addresses; (void)num_addresses; (void)flags;
+		if( num_syms )
+			*num_syms = 0;
+		return 0;
+	}
+
+	int callstack_symbols_mem_size( void** addresses, int num_addresses, unsigned int flags, int* num_syms )
+	{
+		(void)addresses; (void)num_addresses; (void)flags;
+		if( num_syms )
+			*num_syms = 0;
+		return 0;
+	}
+
+	int callstack_dump_write( void* const* addresses, const int* num_frames, int num_stacks, void* out, int out_size )
+	{
+		(void)addresses; (void)num_frames; (void)num_stacks; (void)out; (void)out_size;
+		return 0;
+	}
+
+	int callstack_dump_read( const void* dump, int dump_size, callstack_dump_callback callback, void* userdata )
+	{
+		(void)dump; (void)dump_size; (void)callback; (void)userdata;
+		return -1;
+	}
+
+	callstack_symbolizer_t* callstack_symbolizer_create_from_dump( const void* dump, int dump_size, const char* sysroot )
+	{
+		(void)dump; (void)dump_size; (void)sysroot;
+		return 0x0;
+	}
+
+	int callstack_index_write( const char* module_path, const char* index_path )
+	{
+		(void)module_path; (void)index_path;
+		return -1;
+	}
+
+	callstack_symbol_server_t* callstack_symbol_server_create( const char* socket_path )
+	{
+		(void)socket_path;
+		return 0x0;
+	}
+
+	int callstack_symbol_server_update( callstack_symbol_server_t* server, int timeout_ms )
+	{
+		(void)server; (void)timeout_ms;
+		return -1;
+	}
+
+	void callstack_symbol_server_destroy( callstack_symbol_server_t* server )
+	{
+		(void)server;
+	}
+
+	int callstack_symbols_set_server( const char* socket_path )
+	{
+		(void)socket_path;
+		return -1;
+	}
+
 #endif
 
 #if defined( DBG_TOOLS_CALLSTACK_UNIX )
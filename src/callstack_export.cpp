@@ -0,0 +1,715 @@
+/*
+	dbgtools - platform independent wrapping of "nice to have" debug functions.
+
+	https://github.com/wc-duck/dbgtools
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+#include <dbgtools/callstack_export.h>
+#include <dbgtools/callstack_intern.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+
+	static uint64_t callstack_atomic_load_u64( volatile uint64_t* ptr )             { return (uint64_t)_InterlockedCompareExchange64( (volatile long long*)ptr, 0, 0 ); }
+	static void     callstack_atomic_add_u64( volatile uint64_t* ptr, uint64_t v )  { _InterlockedExchangeAdd64( (volatile long long*)ptr, (long long)v ); }
+#else
+	static uint64_t callstack_atomic_load_u64( volatile uint64_t* ptr )             { return __atomic_load_n( ptr, __ATOMIC_ACQUIRE ); }
+	static void     callstack_atomic_add_u64( volatile uint64_t* ptr, uint64_t v )  { __atomic_fetch_add( ptr, v, __ATOMIC_RELAXED ); }
+#endif
+
+static const uint32_t CALLSTACK_EXPORT_NOT_FOUND = 0xffffffffu;
+
+typedef struct
+{
+	uint32_t function; ///< index in functions.
+	uint32_t line;
+} callstack_export_line_t;
+
+typedef struct
+{
+	uint32_t first_line; ///< index in lines.
+	uint32_t num_lines;  ///< innermost inlined function first, 0 if the address was not symbolized.
+} callstack_export_location_t;
+
+typedef struct
+{
+	uint32_t name; ///< index in string-table.
+	uint32_t file; ///< index in string-table.
+} callstack_export_function_t;
+
+/**
+ * Open addressed hash-table from 64-bit keys to 32-bit values, grows when half full.
+ */
+typedef struct
+{
+	uint64_t* keys;
+	uint32_t* values; ///< CALLSTACK_EXPORT_NOT_FOUND in empty slots.
+	uint32_t  mask;
+	uint32_t  count;
+} callstack_export_map_t;
+
+struct callstack_export
+{
+	callstack_symbolizer_t* symbolizer;
+	callstack_intern_t*     stacks;
+	volatile uint64_t*      weights; ///< weights[id - 1]
+	volatile uint64_t       total;
+
+	// ... symbolization-cache, locations are only appended as new addresses are added until flags change ...
+	int                          resolved_flags; ///< flags the cache was built with, -1 if empty.
+	int                          error;
+	callstack_export_map_t       address_map;    ///< address to index in locations.
+	void**                       addresses;      ///< address of each location.
+	uint32_t                     cap_addresses;
+	callstack_export_location_t* locations;
+	uint32_t                     num_locations;
+	uint32_t                     cap_locations;
+	callstack_export_line_t*     lines;
+	uint32_t                     num_lines;
+	uint32_t                     cap_lines;
+	callstack_export_function_t* functions;
+	uint32_t                     num_functions;
+	uint32_t                     cap_functions;
+	callstack_export_map_t       function_map;   ///< name << 32 | file to index in functions.
+
+	char*                        strings;        ///< all strings in the string-table, 0-terminated.
+	uint32_t                     strings_size;
+	uint32_t                     strings_cap;
+	uint32_t*                    string_offsets; ///< offset in strings of each string.
+	uint32_t                     num_strings;
+	uint32_t                     cap_strings;
+	uint32_t*                    string_slots;   ///< open addressed hash-table of string-index + 1, 0 is an empty slot.
+	uint32_t                     string_mask;
+};
+
+// ... make room for need elements in ptr, returns the possibly moved array or 0x0 on failure with ptr left as is ...
+static void* callstack_export_grow( void* ptr, uint32_t* cap, uint32_t need, size_t elem_size )
+{
+	if( need <= *cap )
+		return ptr;
+	uint32_t new_cap = *cap < 64 ? 64 : *cap;
+	while( new_cap < need )
+	{
+		if( new_cap > 0x7fffffff )
+			return 0x0;
+		new_cap *= 2;
+	}
+	void* p = realloc( ptr, (size_t)new_cap * elem_size );
+	if( p == 0x0 )
+		return 0x0;
+	*cap = new_cap;
+	return p;
+}
+
+static uint32_t callstack_export_hash( uint64_t key )
+{
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdull;
+	key ^= key >> 33;
+	return (uint32_t)key;
+}
+
+static void callstack_export_map_free( callstack_export_map_t* map )
+{
+	free( map->keys );
+	free( map->values );
+	memset( map, 0x0, sizeof(callstack_export_map_t) );
+}
+
+static uint32_t callstack_export_map_find( const callstack_export_map_t* map, uint64_t key )
+{
+	if( map->keys == 0x0 )
+		return CALLSTACK_EXPORT_NOT_FOUND;
+	for( uint32_t slot = callstack_export_hash( key ) & map->mask; ; slot = ( slot + 1 ) & map->mask )
+	{
+		if( map->values[slot] == CALLSTACK_EXPORT_NOT_FOUND || map->keys[slot] == key )
+			return map->values[slot];
+	}
+}
+
+static int callstack_export_map_insert( callstack_export_map_t* map, uint64_t key, uint32_t value )
+{
+	if( map->keys == 0x0 || ( map->count + 1 ) * 2 > map->mask + 1 )
+	{
+		callstack_export_map_t grown;
+		grown.mask   = map->keys ? map->mask * 2 + 1 : 1023;
+		grown.count  = 0;
+		grown.keys   = (uint64_t*)malloc( ( (size_t)grown.mask + 1 ) * sizeof(uint64_t) );
+		grown.values = (uint32_t*)malloc( ( (size_t)grown.mask + 1 ) * sizeof(uint32_t) );
+		if( grown.keys == 0x0 || grown.values == 0x0 || grown.mask >= 0x7fffffff )
+		{
+			callstack_export_map_free( &grown );
+			return 0;
+		}
+		memset( grown.values, 0xff, ( (size_t)grown.mask + 1 ) * sizeof(uint32_t) );
+		for( uint32_t i = 0; map->keys && i <= map->mask; ++i )
+			if( map->values[i] != CALLSTACK_EXPORT_NOT_FOUND )
+				callstack_export_map_insert( &grown, map->keys[i], map->values[i] );
+		callstack_export_map_free( map );
+		*map = grown;
+	}
+
+	uint32_t slot = callstack_export_hash( key ) & map->mask;
+	while( map->values[slot] != CALLSTACK_EXPORT_NOT_FOUND )
+		slot = ( slot + 1 ) & map->mask;
+	map->keys[slot]   = key;
+	map->values[slot] = value;
+	++map->count;
+	return 1;
+}
+
+static uint32_t callstack_export_string_hash( const char* str )
+{
+	uint32_t h = 2166136261u;
+	for( ; *str; ++str )
+		h = ( h ^ (uint8_t)*str ) * 16777619u;
+	return h;
+}
+
+// ... index of str in the string-table, added if not found ...
+static uint32_t callstack_export_string( callstack_export_t* exp, const char* str )
+{
+	if( ( exp->num_strings + 1 ) * 2 > exp->string_mask + 1 )
+	{
+		uint32_t  mask  = exp->string_slots ? exp->string_mask * 2 + 1 : 1023;
+		uint32_t* slots = (uint32_t*)calloc( (size_t)mask + 1, sizeof(uint32_t) );
+		if( slots == 0x0 )
+		{
+			exp->error = 1;
+			return 0;
+		}
+		for( uint32_t i = 0; i < exp->num_strings; ++i )
+		{
+			uint32_t slot = callstack_export_string_hash( exp->strings + exp->string_offsets[i] ) & mask;
+			while( slots[slot] != 0 )
+				slot = ( slot + 1 ) & mask;
+			slots[slot] = i + 1;
+		}
+		free( exp->string_slots );
+		exp->string_slots = slots;
+		exp->string_mask  = mask;
+	}
+
+	uint32_t slot = callstack_export_string_hash( str ) & exp->string_mask;
+	for( ; exp->string_slots[slot] != 0; slot = ( slot + 1 ) & exp->string_mask )
+	{
+		uint32_t index = exp->string_slots[slot] - 1;
+		if( strcmp( exp->strings + exp->string_offsets[index], str ) == 0 )
+			return index;
+	}
+
+	size_t len = strlen( str ) + 1;
+	char*     strings = len > 0x7fffffff - exp->strings_size ? 0x0 : (char*)callstack_export_grow( exp->strings, &exp->strings_cap, exp->strings_size + (uint32_t)len, 1 );
+	uint32_t* offsets = strings == 0x0 ? 0x0 : (uint32_t*)callstack_export_grow( exp->string_offsets, &exp->cap_strings, exp->num_strings + 1, sizeof(uint32_t) );
+	if( strings != 0x0 )
+		exp->strings = strings;
+	if( offsets == 0x0 )
+	{
+		exp->error = 1;
+		return 0;
+	}
+	exp->string_offsets = offsets;
+	memcpy( exp->strings + exp->strings_size, str, len );
+	exp->string_offsets[exp->num_strings] = exp->strings_size;
+	exp->strings_size += (uint32_t)len;
+	exp->string_slots[slot] = exp->num_strings + 1;
+	return exp->num_strings++;
+}
+
+static void callstack_export_clear_cache( callstack_export_t* exp )
+{
+	callstack_export_map_free( &exp->address_map );
+	callstack_export_map_free( &exp->function_map );
+	free( exp->addresses );
+	free( exp->locations );
+	free( exp->lines );
+	free( exp->functions );
+	free( exp->strings );
+	free( exp->string_offsets );
+	free( exp->string_slots );
+	exp->addresses      = 0x0;
+	exp->locations      = 0x0;
+	exp->lines          = 0x0;
+	exp->functions      = 0x0;
+	exp->strings        = 0x0;
+	exp->string_offsets = 0x0;
+	exp->string_slots   = 0x0;
+	exp->num_locations  = exp->cap_locations = exp->cap_addresses = 0;
+	exp->num_lines      = exp->cap_lines     = 0;
+	exp->num_functions  = exp->cap_functions = 0;
+	exp->strings_size   = exp->strings_cap   = 0;
+	exp->num_strings    = exp->cap_strings   = 0;
+	exp->string_mask    = 0;
+	exp->resolved_flags = -1;
+	exp->error          = 0;
+}
+
+callstack_export_t* callstack_export_create( callstack_symbolizer_t* symbolizer, unsigned int max_stacks, unsigned int max_frames )
+{
+	callstack_export_t* exp = (callstack_export_t*)calloc( 1, sizeof(callstack_export_t) );
+	if( exp == 0x0 )
+		return 0x0;
+	exp->symbolizer     = symbolizer;
+	exp->resolved_flags = -1;
+	exp->stacks         = callstack_intern_create( max_stacks, max_frames );
+	exp->weights        = (volatile uint64_t*)calloc( max_stacks > 0 ? max_stacks : 1, sizeof(uint64_t) );
+	if( exp->stacks == 0x0 || exp->weights == 0x0 )
+	{
+		callstack_export_destroy( exp );
+		return 0x0;
+	}
+	return exp;
+}
+
+void callstack_export_destroy( callstack_export_t* exp )
+{
+	if( exp == 0x0 )
+		return;
+	callstack_export_clear_cache( exp );
+	if( exp->stacks )
+		callstack_intern_destroy( exp->stacks );
+	free( (void*)exp->weights );
+	free( exp );
+}
+
+int callstack_export_add( callstack_export_t* exp, void** addresses, int num_addresses, unsigned long long weight )
+{
+	unsigned int id = callstack_intern( exp->stacks, addresses, num_addresses );
+	if( id == CALLSTACK_INTERN_INVALID_ID )
+		return -1;
+	callstack_atomic_add_u64( &exp->weights[id - 1], weight );
+	callstack_atomic_add_u64( &exp->total, weight );
+	return 0;
+}
+
+unsigned long long callstack_export_total( callstack_export_t* exp )
+{
+	return callstack_atomic_load_u64( &exp->total );
+}
+
+typedef struct
+{
+	callstack_export_t* exp;
+	uint32_t            first_location; ///< location of index 0 passed to the callback.
+} callstack_export_resolve_ctx_t;
+
+static int callstack_export_add_symbol( const callstack_symbol_t* sym, int index, void* userdata )
+{
+	callstack_export_resolve_ctx_t* ctx = (callstack_export_resolve_ctx_t*)userdata;
+	callstack_export_t* exp = ctx->exp;
+	uint32_t loc_index = ctx->first_location + (uint32_t)index;
+	if( loc_index >= exp->num_locations )
+		return 1;
+
+	// ... unresolved addresses are named by address so that they do not all fold into one function ...
+	char unknown[32];
+	const char* name = sym->function;
+	const char* file = sym->file;
+	if( strcmp( name, "failed to lookup symbol" ) == 0 )
+	{
+		snprintf( unknown, sizeof(unknown), "0x%llx", (unsigned long long)(uintptr_t)exp->addresses[loc_index] );
+		name = unknown;
+	}
+	if( strcmp( file, "failed to lookup file" ) == 0 )
+		file = "";
+
+	uint32_t name_index = callstack_export_string( exp, name );
+	uint32_t file_index = callstack_export_string( exp, file );
+	uint64_t fn_key     = (uint64_t)name_index << 32 | file_index;
+	uint32_t fn_index   = callstack_export_map_find( &exp->function_map, fn_key );
+	if( fn_index == CALLSTACK_EXPORT_NOT_FOUND )
+	{
+		callstack_export_function_t* functions = (callstack_export_function_t*)callstack_export_grow( exp->functions, &exp->cap_functions, exp->num_functions + 1, sizeof(callstack_export_function_t) );
+		if( functions == 0x0 || !callstack_export_map_insert( &exp->function_map, fn_key, exp->num_functions ) )
+		{
+			exp->error = 1;
+			return 1;
+		}
+		exp->functions = functions;
+		fn_index = exp->num_functions++;
+		exp->functions[fn_index].name = name_index;
+		exp->functions[fn_index].file = file_index;
+	}
+
+	callstack_export_line_t* lines = (callstack_export_line_t*)callstack_export_grow( exp->lines, &exp->cap_lines, exp->num_lines + 1, sizeof(callstack_export_line_t) );
+	if( lines == 0x0 )
+	{
+		exp->error = 1;
+		return 1;
+	}
+	exp->lines = lines;
+	// ... all symbols of an address are passed after each other ...
+	callstack_export_location_t* loc = &exp->locations[loc_index];
+	if( loc->num_lines == 0 )
+		loc->first_line = exp->num_lines;
+	exp->lines[exp->num_lines].function = fn_index;
+	exp->lines[exp->num_lines].line     = sym->line;
+	++exp->num_lines;
+	++loc->num_lines;
+	return exp->error;
+}
+
+// ... symbolize all addresses not yet in the cache ...
+static int callstack_export_resolve( callstack_export_t* exp, unsigned int flags )
+{
+	if( exp->resolved_flags != (int)flags || exp->error )
+	{
+		callstack_export_clear_cache( exp );
+		exp->resolved_flags = (int)flags;
+		callstack_export_string( exp, "" ); // ... pprof require the first string to be "" ...
+	}
+
+	uint32_t first_new = exp->num_locations;
+	unsigned int num_ids = callstack_intern_count( exp->stacks );
+	for( unsigned int id = 1; id <= num_ids && !exp->error; ++id )
+	{
+		void* const* addresses;
+		int num_addresses = callstack_intern_lookup( exp->stacks, id, &addresses );
+		for( int i = 0; i < num_addresses; ++i )
+		{
+			uint64_t key = (uint64_t)(uintptr_t)addresses[i];
+			if( callstack_export_map_find( &exp->address_map, key ) != CALLSTACK_EXPORT_NOT_FOUND )
+				continue;
+			callstack_export_location_t* locations = (callstack_export_location_t*)callstack_export_grow( exp->locations, &exp->cap_locations, exp->num_locations + 1, sizeof(callstack_export_location_t) );
+			if( locations != 0x0 )
+				exp->locations = locations;
+			void** addrs = locations == 0x0 ? 0x0 : (void**)callstack_export_grow( exp->addresses, &exp->cap_addresses, exp->num_locations + 1, sizeof(void*) );
+			if( addrs != 0x0 )
+				exp->addresses = addrs;
+			if( addrs == 0x0 || !callstack_export_map_insert( &exp->address_map, key, exp->num_locations ) )
+			{
+				exp->error = 1;
+				break;
+			}
+			exp->addresses[exp->num_locations] = addresses[i];
+			exp->locations[exp->num_locations].first_line = 0;
+			exp->locations[exp->num_locations].num_lines  = 0;
+			++exp->num_locations;
+		}
+	}
+	if( exp->error )
+		return -1;
+	if( first_new == exp->num_locations )
+		return 0;
+
+	// ... all new addresses are symbolized in one batch so that each module is only looked up once ...
+	callstack_export_resolve_ctx_t ctx = { exp, first_new };
+	int num_new = (int)( exp->num_locations - first_new );
+	if( exp->symbolizer )
+		callstack_symbolizer_symbolize_foreach( exp->symbolizer, exp->addresses + first_new, num_new, flags, callstack_export_add_symbol, &ctx );
+	else
+		callstack_symbols_foreach( exp->addresses + first_new, num_new, flags, callstack_export_add_symbol, &ctx );
+	return exp->error ? -1 : 0;
+}
+
+/**
+ * Output is collected in blocks before being passed to the write-callback.
+ */
+typedef struct
+{
+	callstack_export_write_callback write;
+	void*                           userdata;
+	int                             error;
+	size_t                          pos;
+	uint8_t                         data[16 * 1024];
+} callstack_export_stream_t;
+
+static void callstack_export_flush( callstack_export_stream_t* s )
+{
+	if( s->pos > 0 && !s->error && s->write( s->data, s->pos, s->userdata ) != 0 )
+		s->error = 1;
+	s->pos = 0;
+}
+
+static void callstack_export_put( callstack_export_stream_t* s, const void* data, size_t size )
+{
+	const uint8_t* in = (const uint8_t*)data;
+	while( size > 0 && !s->error )
+	{
+		if( s->pos == sizeof(s->data) )
+			callstack_export_flush( s );
+		size_t n = sizeof(s->data) - s->pos < size ? sizeof(s->data) - s->pos : size;
+		memcpy( s->data + s->pos, in, n );
+		s->pos += n;
+		in     += n;
+		size   -= n;
+	}
+}
+
+static int callstack_export_append( char** buffer, uint32_t* cap, uint32_t* pos, const char* str, int sanitize )
+{
+	size_t len = strlen( str );
+	char* grown = len > 0x7fffffff - *pos - 2 ? 0x0 : (char*)callstack_export_grow( *buffer, cap, *pos + (uint32_t)len + 2, 1 );
+	if( grown == 0x0 )
+		return 0;
+	*buffer = grown;
+	for( size_t i = 0; i < len; ++i )
+	{
+		char c = str[i];
+		if( sanitize && c == ';' )
+			c = ':';
+		else if( sanitize && ( c == '\n' || c == '\r' ) )
+			c = ' ';
+		( *buffer )[( *pos )++] = c;
+	}
+	( *buffer )[*pos] = '\0';
+	return 1;
+}
+
+int callstack_export_folded_foreach( callstack_export_t* exp, unsigned int flags, callstack_export_folded_callback callback, void* userdata )
+{
+	if( callstack_export_resolve( exp, flags ) != 0 )
+		return -1;
+
+	char*    folded     = 0x0;
+	uint32_t folded_cap = 0;
+	int      num_stacks = 0;
+	int      ok         = 1;
+
+	unsigned int num_ids = callstack_intern_count( exp->stacks );
+	for( unsigned int id = 1; id <= num_ids && ok; ++id )
+	{
+		uint64_t weight = callstack_atomic_load_u64( &exp->weights[id - 1] );
+		void* const* addresses;
+		int num_addresses = callstack_intern_lookup( exp->stacks, id, &addresses );
+		if( weight == 0 || num_addresses < 0 )
+			continue;
+
+		// ... root first, i.e. the last address and the outermost function of each address first ...
+		uint32_t pos = 0;
+		ok = callstack_export_append( &folded, &folded_cap, &pos, "", 0 );
+		for( int i = num_addresses - 1; i >= 0 && ok; --i )
+		{
+			const callstack_export_location_t* loc = &exp->locations[callstack_export_map_find( &exp->address_map, (uint64_t)(uintptr_t)addresses[i] )];
+			for( uint32_t l = loc->num_lines; l > 0 && ok; --l )
+			{
+				const callstack_export_function_t* fn = &exp->functions[exp->lines[loc->first_line + l - 1].function];
+				ok = ( pos == 0 || callstack_export_append( &folded, &folded_cap, &pos, ";", 0 ) ) &&
+					 callstack_export_append( &folded, &folded_cap, &pos, exp->strings + exp->string_offsets[fn->name], 1 );
+			}
+		}
+		if( !ok )
+			break;
+
+		++num_stacks;
+		if( callback( folded, (unsigned long long)weight, userdata ) != 0 )
+			break;
+	}
+
+	free( folded );
+	return ok ? num_stacks : -1;
+}
+
+static int callstack_export_write_folded_stack( const char* stack, unsigned long long weight, void* userdata )
+{
+	callstack_export_stream_t* s = (callstack_export_stream_t*)userdata;
+	char weight_str[32];
+	int  len = snprintf( weight_str, sizeof(weight_str), " %llu\n", weight );
+	callstack_export_put( s, stack, strlen( stack ) );
+	callstack_export_put( s, weight_str, (size_t)len );
+	return s->error;
+}
+
+int callstack_export_write_folded( callstack_export_t* exp, unsigned int flags, callstack_export_write_callback write, void* userdata )
+{
+	callstack_export_stream_t* s = (callstack_export_stream_t*)malloc( sizeof(callstack_export_stream_t) );
+	if( s == 0x0 )
+		return -1;
+	s->write    = write;
+	s->userdata = userdata;
+	s->error    = 0;
+	s->pos      = 0;
+
+	int res = callstack_export_folded_foreach( exp, flags, callstack_export_write_folded_stack, s );
+	callstack_export_flush( s );
+	res = res < 0 || s->error ? -1 : 0;
+	free( s );
+	return res;
+}
+
+/**
+ * Protobuf encoding of the messages of profile.proto used by pprof, all messages are written with their
+ * size calculated up front so that nothing needs to be buffered.
+ */
+enum
+{
+	PPROF_WIRE_VARINT = 0,
+	PPROF_WIRE_LEN    = 2,
+};
+
+static uint64_t pprof_varint_size( uint64_t v )
+{
+	uint64_t size = 1;
+	while( v >= 0x80 )
+	{
+		v >>= 7;
+		++size;
+	}
+	return size;
+}
+
+static void pprof_put_varint( callstack_export_stream_t* s, uint64_t v )
+{
+	uint8_t buf[10];
+	size_t  len = 0;
+	do
+	{
+		buf[len] = (uint8_t)( v & 0x7f );
+		v >>= 7;
+		if( v != 0 )
+			buf[len] |= 0x80;
+		++len;
+	} while( v != 0 );
+	callstack_export_put( s, buf, len );
+}
+
+static void pprof_put_key( callstack_export_stream_t* s, uint32_t field, uint32_t wire )
+{
+	pprof_put_varint( s, (uint64_t)( field << 3 | wire ) );
+}
+
+// ... size of a varint-field with a one byte key, 0 if the value is 0 since that is the default ...
+static uint64_t pprof_field_size( uint64_t v )
+{
+	return v == 0 ? 0 : 1 + pprof_varint_size( v );
+}
+
+static void pprof_put_field( callstack_export_stream_t* s, uint32_t field, uint64_t v )
+{
+	if( v == 0 )
+		return;
+	pprof_put_key( s, field, PPROF_WIRE_VARINT );
+	pprof_put_varint( s, v );
+}
+
+int callstack_export_write_pprof( callstack_export_t* exp, unsigned int flags, const char* sample_type, const char* sample_unit, callstack_export_write_callback write, void* userdata )
+{
+	if( callstack_export_resolve( exp, flags ) != 0 )
+		return -1;
+	uint32_t type_index = callstack_export_string( exp, sample_type ? sample_type : "samples" );
+	uint32_t unit_index = callstack_export_string( exp, sample_unit ? sample_unit : "count" );
+	if( exp->error )
+		return -1;
+
+	callstack_export_stream_t* s = (callstack_export_stream_t*)malloc( sizeof(callstack_export_stream_t) );
+	if( s == 0x0 )
+		return -1;
+	s->write    = write;
+	s->userdata = userdata;
+	s->error    = 0;
+	s->pos      = 0;
+
+	// ... Profile.sample_type = 1, ValueType { type = 1, unit = 2 } ...
+	pprof_put_key( s, 1, PPROF_WIRE_LEN );
+	pprof_put_varint( s, pprof_field_size( type_index ) + pprof_field_size( unit_index ) );
+	pprof_put_field( s, 1, type_index );
+	pprof_put_field( s, 2, unit_index );
+
+	// ... Profile.sample = 2, Sample { location_id = 1 packed, value = 2 packed }, leaf first ...
+	unsigned int num_ids = callstack_intern_count( exp->stacks );
+	for( unsigned int id = 1; id <= num_ids && !s->error; ++id )
+	{
+		uint64_t weight = callstack_atomic_load_u64( &exp->weights[id - 1] );
+		void* const* addresses;
+		int num_addresses = callstack_intern_lookup( exp->stacks, id, &addresses );
+		if( weight == 0 || num_addresses < 0 )
+			continue;
+
+		uint64_t locations_size = 0;
+		for( int i = 0; i < num_addresses; ++i )
+			locations_size += pprof_varint_size( (uint64_t)callstack_export_map_find( &exp->address_map, (uint64_t)(uintptr_t)addresses[i] ) + 1 );
+		uint64_t values_size = pprof_varint_size( weight );
+		uint64_t sample_size = 1 + pprof_varint_size( locations_size ) + locations_size + 1 + pprof_varint_size( values_size ) + values_size;
+
+		pprof_put_key( s, 2, PPROF_WIRE_LEN );
+		pprof_put_varint( s, sample_size );
+		pprof_put_key( s, 1, PPROF_WIRE_LEN );
+		pprof_put_varint( s, locations_size );
+		for( int i = 0; i < num_addresses; ++i )
+			pprof_put_varint( s, (uint64_t)callstack_export_map_find( &exp->address_map, (uint64_t)(uintptr_t)addresses[i] ) + 1 );
+		pprof_put_key( s, 2, PPROF_WIRE_LEN );
+		pprof_put_varint( s, values_size );
+		pprof_put_varint( s, weight );
+	}
+
+	// ... Profile.location = 4, Location { id = 1, address = 3, line = 4 repeated Line { function_id = 1, line = 2 } }, innermost inlined first ...
+	for( uint32_t i = 0; i < exp->num_locations && !s->error; ++i )
+	{
+		const callstack_export_location_t* loc = &exp->locations[i];
+		uint64_t address  = (uint64_t)(uintptr_t)exp->addresses[i];
+		uint64_t loc_size = pprof_field_size( i + 1 ) + pprof_field_size( address );
+		for( uint32_t l = 0; l < loc->num_lines; ++l )
+		{
+			const callstack_export_line_t* line = &exp->lines[loc->first_line + l];
+			uint64_t line_size = pprof_field_size( line->function + 1 ) + pprof_field_size( line->line );
+			loc_size += 1 + pprof_varint_size( line_size ) + line_size;
+		}
+
+		pprof_put_key( s, 4, PPROF_WIRE_LEN );
+		pprof_put_varint( s, loc_size );
+		pprof_put_field( s, 1, i + 1 );
+		pprof_put_field( s, 3, address );
+		for( uint32_t l = 0; l < loc->num_lines; ++l )
+		{
+			const callstack_export_line_t* line = &exp->lines[loc->first_line + l];
+			pprof_put_key( s, 4, PPROF_WIRE_LEN );
+			pprof_put_varint( s, pprof_field_size( line->function + 1 ) + pprof_field_size( line->line ) );
+			pprof_put_field( s, 1, line->function + 1 );
+			pprof_put_field( s, 2, line->line );
+		}
+	}
+
+	// ... Profile.function = 5, Function { id = 1, name = 2, system_name = 3, filename = 4 } ...
+	for( uint32_t i = 0; i < exp->num_functions && !s->error; ++i )
+	{
+		const callstack_export_function_t* fn = &exp->functions[i];
+		pprof_put_key( s, 5, PPROF_WIRE_LEN );
+		pprof_put_varint( s, pprof_field_size( i + 1 ) + 2 * pprof_field_size( fn->name ) + pprof_field_size( fn->file ) );
+		pprof_put_field( s, 1, i + 1 );
+		pprof_put_field( s, 2, fn->name );
+		pprof_put_field( s, 3, fn->name );
+		pprof_put_field( s, 4, fn->file );
+	}
+
+	// ... Profile.string_table = 6 ...
+	for( uint32_t i = 0; i < exp->num_strings && !s->error; ++i )
+	{
+		const char* str = exp->strings + exp->string_offsets[i];
+		size_t      len = strlen( str );
+		pprof_put_key( s, 6, PPROF_WIRE_LEN );
+		pprof_put_varint( s, len );
+		callstack_export_put( s, str, len );
+	}
+
+	callstack_export_flush( s );
+	int res = s->error ? -1 : 0;
+	free( s );
+	return res;
+}
@@ -0,0 +1,274 @@
+/*
+	dbgtools - platform independent wrapping of "nice to have" debug functions.
+
+	https://github.com/wc-duck/dbgtools
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+#include <dbgtools/callstack_intern.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+
+	static uint32_t callstack_atomic_load_u32( volatile uint32_t* ptr )                          { return (uint32_t)_InterlockedCompareExchange( (volatile long*)ptr, 0, 0 ); }
+	static void     callstack_atomic_store_u32( volatile uint32_t* ptr, uint32_t v )             { _InterlockedExchange( (volatile long*)ptr, (long)v ); }
+	static uint32_t callstack_atomic_add_u32( volatile uint32_t* ptr, uint32_t v )               { return (uint32_t)_InterlockedExchangeAdd( (volatile long*)ptr, (long)v ); }
+	static int      callstack_atomic_cas_u32( volatile uint32_t* ptr, uint32_t cmp, uint32_t v ) { return (uint32_t)_InterlockedCompareExchange( (volatile long*)ptr, (long)v, (long)cmp ) == cmp; }
+	static void*    callstack_atomic_load_ptr( void* volatile* ptr )                             { return _InterlockedCompareExchangePointer( ptr, 0, 0 ); }
+	static int      callstack_atomic_cas_ptr( void* volatile* ptr, void* cmp, void* v )          { return _InterlockedCompareExchangePointer( ptr, v, cmp ) == cmp; }
+#else
+	static uint32_t callstack_atomic_load_u32( volatile uint32_t* ptr )                          { return __atomic_load_n( ptr, __ATOMIC_ACQUIRE ); }
+	static void     callstack_atomic_store_u32( volatile uint32_t* ptr, uint32_t v )             { __atomic_store_n( ptr, v, __ATOMIC_RELEASE ); }
+	static uint32_t callstack_atomic_add_u32( volatile uint32_t* ptr, uint32_t v )               { return __atomic_fetch_add( ptr, v, __ATOMIC_RELAXED ); }
+	static int      callstack_atomic_cas_u32( volatile uint32_t* ptr, uint32_t cmp, uint32_t v ) { return __atomic_compare_exchange_n( ptr, &cmp, v, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ); }
+	static void*    callstack_atomic_load_ptr( void* volatile* ptr )                             { return __atomic_load_n( ptr, __ATOMIC_ACQUIRE ); }
+	static int      callstack_atomic_cas_ptr( void* volatile* ptr, void* cmp, void* v )          { return __atomic_compare_exchange_n( ptr, &cmp, v, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ); }
+#endif
+
+enum
+{
+	CALLSTACK_INTERN_ENTRY_FILLING, ///< reserved but not completely written yet.
+	CALLSTACK_INTERN_ENTRY_LIVE,
+	CALLSTACK_INTERN_ENTRY_DEAD,    ///< lost an insert-race to an equal callstack.
+};
+
+typedef struct
+{
+	int                num_symbols;
+	callstack_symbol_t symbols[1]; ///< [num_symbols] followed by string-memory.
+} callstack_intern_symbols_t;
+
+typedef struct
+{
+	volatile uint32_t state;
+	uint32_t hash;
+	uint32_t first_frame;
+	uint32_t num_frames;
+	void* volatile symbols; ///< callstack_intern_symbols_t, set on first call to callstack_intern_symbols().
+} callstack_intern_entry_t;
+
+struct callstack_intern
+{
+	uint32_t max_stacks;
+	uint32_t max_frames;
+	uint32_t slot_mask;
+
+	volatile uint32_t num_stacks;
+	volatile uint32_t num_frames;
+
+	volatile uint32_t*        slots;   ///< open addressed hash-table of ids, 0 is an empty slot.
+	callstack_intern_entry_t* entries; ///< entries[id - 1]
+	void**                    frames;
+};
+
+static uint32_t callstack_intern_hash( void** addresses, int num_addresses )
+{
+	uint64_t h = (uint64_t)num_addresses * 0x9e3779b97f4a7c15ull;
+	for( int i = 0; i < num_addresses; ++i )
+	{
+		h ^= (uint64_t)(uintptr_t)addresses[i];
+		h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 32;
+	}
+	return (uint32_t)h;
+}
+
+callstack_intern_t* callstack_intern_create( unsigned int max_stacks, unsigned int max_frames )
+{
+	if( max_stacks == 0 || max_stacks > 0x40000000 )
+		return 0x0;
+
+	// ... keep load-factor below 0.5 ...
+	uint32_t num_slots = 16;
+	while( num_slots < max_stacks * 2 )
+		num_slots *= 2;
+
+	callstack_intern_t* table = (callstack_intern_t*)malloc( sizeof(callstack_intern_t) );
+	if( table == 0x0 )
+		return 0x0;
+
+	table->max_stacks = max_stacks;
+	table->max_frames = max_frames;
+	table->slot_mask  = num_slots - 1;
+	table->num_stacks = 0;
+	table->num_frames = 0;
+	table->slots      = (volatile uint32_t*)calloc( num_slots, sizeof(uint32_t) );
+	table->entries    = (callstack_intern_entry_t*)calloc( max_stacks, sizeof(callstack_intern_entry_t) );
+	table->frames     = (void**)malloc( ( max_frames > 0 ? max_frames : 1 ) * sizeof(void*) );
+
+	if( table->slots == 0x0 || table->entries == 0x0 || table->frames == 0x0 )
+	{
+		callstack_intern_destroy( table );
+		return 0x0;
+	}
+	return table;
+}
+
+void callstack_intern_destroy( callstack_intern_t* table )
+{
+	if( table == 0x0 )
+		return;
+	if( table->entries )
+	{
+		for( uint32_t i = 0; i < table->max_stacks; ++i )
+			free( table->entries[i].symbols );
+	}
+	free( (void*)table->slots );
+	free( table->entries );
+	free( table->frames );
+	free( table );
+}
+
+static int callstack_intern_equal( callstack_intern_t* table, uint32_t id, uint32_t hash, void** addresses, int num_addresses )
+{
+	const callstack_intern_entry_t* e = &table->entries[id - 1];
+	return e->hash == hash &&
+		   e->num_frames == (uint32_t)num_addresses &&
+		   memcmp( table->frames + e->first_frame, addresses, (size_t)num_addresses * sizeof(void*) ) == 0;
+}
+
+// ... reserve and fill an entry that is not yet visible in the hash-table ...
+static uint32_t callstack_intern_alloc( callstack_intern_t* table, uint32_t hash, void** addresses, int num_addresses )
+{
+	if( callstack_atomic_load_u32( &table->num_stacks ) >= table->max_stacks ||
+		callstack_atomic_load_u32( &table->num_frames ) + (uint32_t)num_addresses > table->max_frames )
+		return CALLSTACK_INTERN_INVALID_ID;
+
+	uint32_t first_frame = callstack_atomic_add_u32( &table->num_frames, (uint32_t)num_addresses );
+	if( first_frame + (uint32_t)num_addresses > table->max_frames )
+		return CALLSTACK_INTERN_INVALID_ID;
+
+	uint32_t index = callstack_atomic_add_u32( &table->num_stacks, 1 );
+	if( index >= table->max_stacks )
+		return CALLSTACK_INTERN_INVALID_ID;
+
+	memcpy( table->frames + first_frame, addresses, (size_t)num_addresses * sizeof(void*) );
+
+	callstack_intern_entry_t* e = &table->entries[index];
+	e->hash        = hash;
+	e->first_frame = first_frame;
+	e->num_frames  = (uint32_t)num_addresses;
+	callstack_atomic_store_u32( &e->state, CALLSTACK_INTERN_ENTRY_LIVE );
+	return index + 1;
+}
+
+unsigned int callstack_intern( callstack_intern_t* table, void** addresses, int num_addresses )
+{
+	if( num_addresses < 0 )
+		return CALLSTACK_INTERN_INVALID_ID;
+
+	uint32_t hash   = callstack_intern_hash( addresses, num_addresses );
+	uint32_t new_id = CALLSTACK_INTERN_INVALID_ID;
+
+	for( uint32_t probe = 0; probe <= table->slot_mask; ++probe )
+	{
+		volatile uint32_t* slot = &table->slots[( hash + probe ) & table->slot_mask];
+		uint32_t id = callstack_atomic_load_u32( slot );
+
+		if( id == CALLSTACK_INTERN_INVALID_ID )
+		{
+			// ... entry is filled before it is published in the slot so that other threads see a complete entry ...
+			if( new_id == CALLSTACK_INTERN_INVALID_ID )
+			{
+				new_id = callstack_intern_alloc( table, hash, addresses, num_addresses );
+				if( new_id == CALLSTACK_INTERN_INVALID_ID )
+					return CALLSTACK_INTERN_INVALID_ID;
+			}
+
+			if( callstack_atomic_cas_u32( slot, CALLSTACK_INTERN_INVALID_ID, new_id ) )
+				return new_id;
+
+			// ... someone else got the slot first, check what they inserted ...
+			id = callstack_atomic_load_u32( slot );
+		}
+
+		if( callstack_intern_equal( table, id, hash, addresses, num_addresses ) )
+		{
+			if( new_id != CALLSTACK_INTERN_INVALID_ID )
+				callstack_atomic_store_u32( &table->entries[new_id - 1].state, CALLSTACK_INTERN_ENTRY_DEAD );
+			return id;
+		}
+	}
+
+	return CALLSTACK_INTERN_INVALID_ID;
+}
+
+int callstack_intern_lookup( callstack_intern_t* table, unsigned int id, void* const** addresses )
+{
+	if( id == CALLSTACK_INTERN_INVALID_ID || id > callstack_atomic_load_u32( &table->num_stacks ) || id > table->max_stacks )
+		return -1;
+
+	callstack_intern_entry_t* e = &table->entries[id - 1];
+	if( callstack_atomic_load_u32( &e->state ) != CALLSTACK_INTERN_ENTRY_LIVE )
+		return -1;
+
+	*addresses = table->frames + e->first_frame;
+	return (int)e->num_frames;
+}
+
+const callstack_symbol_t* callstack_intern_symbols( callstack_intern_t* table, unsigned int id, int* num_symbols )
+{
+	void* const* addresses;
+	int num_addresses = callstack_intern_lookup( table, id, &addresses );
+	if( num_addresses < 0 )
+		return 0x0;
+
+	callstack_intern_entry_t* e = &table->entries[id - 1];
+	callstack_intern_symbols_t* symbols = (callstack_intern_symbols_t*)callstack_atomic_load_ptr( &e->symbols );
+	if( symbols == 0x0 )
+	{
+		// ... symbolize into one block, if another thread beat us to it we just throw our result away ...
+		int mem_size = callstack_symbols_mem_size( (void**)addresses, num_addresses, 0, 0x0 );
+		if( mem_size < 0 )
+			return 0x0;
+		size_t str_mem = (size_t)mem_size;
+		size_t syms    = sizeof(callstack_intern_symbols_t) + (size_t)num_addresses * sizeof(callstack_symbol_t);
+		callstack_intern_symbols_t* new_syms = (callstack_intern_symbols_t*)malloc( syms + str_mem );
+		if( new_syms == 0x0 )
+			return 0x0;
+
+		new_syms->num_symbols = callstack_symbols( (void**)addresses, new_syms->symbols, num_addresses, (char*)new_syms + syms, (int)str_mem );
+
+		if( callstack_atomic_cas_ptr( &e->symbols, 0x0, new_syms ) )
+			symbols = new_syms;
+		else
+		{
+			free( new_syms );
+			symbols = (callstack_intern_symbols_t*)callstack_atomic_load_ptr( &e->symbols );
+		}
+	}
+
+	*num_symbols = symbols->num_symbols;
+	return symbols->symbols;
+}
+
+unsigned int callstack_intern_count( callstack_intern_t* table )
+{
+	uint32_t count = callstack_atomic_load_u32( &table->num_stacks );
+	return count > table->max_stacks ? table->max_stacks : count;
+}
@@ -0,0 +1,944 @@
+/*
+	dbgtools - platform independent wrapping of "nice to have" debug functions.
+
+	https://github.com/wc-duck/dbgtools
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+#include <dbgtools/callstack_profiler.h>
+#include <dbgtools/callstack_intern.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux)
+
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+/**
+ * perf-events depend on having linux-headers installed, same as hw_breakpoint.cpp, if the compiler do not
+ * support __has_include() but linux-headers are installed this can be manually defined.
+ */
+#if !defined(DBG_TOOLS_CALLSTACK_PROFILER_HAS_PERF_EVENT)
+#  if defined(__has_include)
+#    if __has_include(<linux/perf_event.h>)
+#      define DBG_TOOLS_CALLSTACK_PROFILER_HAS_PERF_EVENT
+#    endif
+#  endif
+#endif
+
+#if defined(DBG_TOOLS_CALLSTACK_PROFILER_HAS_PERF_EVENT)
+#  include <sys/ioctl.h>
+#  include <linux/perf_event.h>
+#endif
+
+enum
+{
+	CALLSTACK_PROFILER_MAX_FRAMES = 128, ///< max addresses captured per sample.
+};
+
+enum
+{
+	CALLSTACK_PROFILER_THREAD_FREE,    ///< slot unused, ring may still be allocated and is then reused.
+	CALLSTACK_PROFILER_THREAD_ACTIVE,  ///< thread is profiled and its timer is running.
+	CALLSTACK_PROFILER_THREAD_STOPPED, ///< timer is deleted but the ring has not been drained since.
+};
+
+/**
+ * Per-thread state, the ring is a single-producer single-consumer queue of samples where the producer is
+ * the SIGPROF-handler running on the profiled thread and the consumer is whoever holds profiler->lock.
+ * Each sample is stored as the number of frames followed by the frames, wrapping at the end of the ring.
+ *
+ * For perf-events the ring is instead the one mapped from perf_fd and the kernel is the producer.
+ */
+typedef struct
+{
+	volatile uint64_t head;    ///< in words, only written by the signal-handler.
+	volatile uint64_t tail;    ///< in words, only written when draining.
+	volatile uint64_t dropped; ///< samples dropped since the ring was full.
+	uintptr_t*        ring;
+	uint64_t          mask;    ///< words in ring - 1.
+	timer_t           timer;
+	pid_t             tid;
+	uint32_t          state;
+
+	int               perf_fd;   ///< -1 if not sampling a perf-event.
+	void*             perf_map;  ///< metadata-page followed by the data-pages of the perf-ring.
+	size_t            perf_size; ///< size of the data-pages.
+} callstack_profiler_thread_t;
+
+struct callstack_profiler
+{
+	callstack_profiler_config_t config;
+
+	pthread_mutex_t lock;   ///< protects everything below except what the signal-handler touches.
+	pthread_cond_t  wakeup;
+	pthread_t       background;
+	int             quit;
+
+	callstack_profiler_thread_t* threads; ///< [config.max_threads]
+	callstack_intern_t*          stacks;
+	uint64_t*                    counts;  ///< samples per callstack, counts[id - 1]
+	uint64_t                     samples;
+	uint64_t                     dropped;
+};
+
+static pthread_mutex_t  g_profiler_handler_lock = PTHREAD_MUTEX_INITIALIZER;
+static int              g_profiler_handler_refs = 0;
+static struct sigaction g_profiler_prev_action;
+
+// ... threads of destroyed profilers that might still get a SIGPROF, kept for the life-time of the process ...
+typedef struct callstack_profiler_abandoned
+{
+	struct callstack_profiler_abandoned* next;
+	callstack_profiler_thread_t*         threads;
+} callstack_profiler_abandoned_t;
+static callstack_profiler_abandoned_t* g_profiler_abandoned = 0x0;
+
+static void callstack_profiler_signal( int sig, siginfo_t* info, void* context )
+{
+	(void)sig;
+	if( info == 0x0 || info->si_code != SI_TIMER || info->si_value.sival_ptr == 0x0 )
+		return;
+
+	// ... only async-signal-safe code in here, the ring is only read by the consumer so no locks are needed ...
+	int saved_errno = errno;
+	callstack_profiler_thread_t* thread = (callstack_profiler_thread_t*)info->si_value.sival_ptr;
+
+	void* frames[CALLSTACK_PROFILER_MAX_FRAMES];
+	int num_frames = callstack_from_context( context, frames, CALLSTACK_PROFILER_MAX_FRAMES );
+
+	uint64_t head = __atomic_load_n( &thread->head, __ATOMIC_RELAXED );
+	uint64_t tail = __atomic_load_n( &thread->tail, __ATOMIC_ACQUIRE );
+	if( num_frames > 0 && thread->mask + 1 - ( head - tail ) >= (uint64_t)num_frames + 1 )
+	{
+		thread->ring[head & thread->mask] = (uintptr_t)num_frames;
+		for( int i = 0; i < num_frames; ++i )
+			thread->ring[( head + 1 + (uint64_t)i ) & thread->mask] = (uintptr_t)frames[i];
+		__atomic_store_n( &thread->head, head + 1 + (uint64_t)num_frames, __ATOMIC_RELEASE );
+	}
+	else
+		__atomic_fetch_add( &thread->dropped, 1, __ATOMIC_RELAXED );
+
+	errno = saved_errno;
+}
+
+static int callstack_profiler_install_handler()
+{
+	pthread_mutex_lock( &g_profiler_handler_lock );
+	int res = 0;
+	if( g_profiler_handler_refs == 0 )
+	{
+		struct sigaction action;
+		memset( &action, 0x0, sizeof(action) );
+		action.sa_sigaction = callstack_profiler_signal;
+		action.sa_flags     = SA_SIGINFO | SA_RESTART;
+		sigemptyset( &action.sa_mask );
+		res = sigaction( SIGPROF, &action, &g_profiler_prev_action );
+	}
+	if( res == 0 )
+		++g_profiler_handler_refs;
+	pthread_mutex_unlock( &g_profiler_handler_lock );
+	return res;
+}
+
+static void callstack_profiler_uninstall_handler()
+{
+	pthread_mutex_lock( &g_profiler_handler_lock );
+	if( --g_profiler_handler_refs == 0 )
+		sigaction( SIGPROF, &g_profiler_prev_action, 0x0 );
+	pthread_mutex_unlock( &g_profiler_handler_lock );
+}
+
+static void callstack_profiler_add_sample( callstack_profiler_t* profiler, void** frames, int num_frames )
+{
+	unsigned int id = callstack_intern( profiler->stacks, frames, num_frames );
+	if( id == CALLSTACK_INTERN_INVALID_ID )
+		++profiler->dropped;
+	else
+	{
+		++profiler->counts[id - 1];
+		++profiler->samples;
+	}
+}
+
+// ... move all samples in the ring of thread to the profile, profiler->lock must be held ...
+static int callstack_profiler_drain_thread( callstack_profiler_t* profiler, callstack_profiler_thread_t* thread )
+{
+	void*    frames[CALLSTACK_PROFILER_MAX_FRAMES];
+	int      num_samples = 0;
+	uint64_t head = __atomic_load_n( &thread->head, __ATOMIC_ACQUIRE );
+	uint64_t tail = thread->tail;
+	while( tail < head )
+	{
+		uint64_t num_frames = thread->ring[tail & thread->mask];
+		if( num_frames == 0 || num_frames > CALLSTACK_PROFILER_MAX_FRAMES || tail + 1 + num_frames > head )
+		{
+			// ... can not happen unless the ring is corrupt, drop everything ...
+			++profiler->dropped;
+			tail = head;
+			break;
+		}
+		for( uint64_t i = 0; i < num_frames; ++i )
+			frames[i] = (void*)thread->ring[( tail + 1 + i ) & thread->mask];
+		tail += 1 + num_frames;
+
+		callstack_profiler_add_sample( profiler, frames, (int)num_frames );
+		++num_samples;
+	}
+	__atomic_store_n( &thread->tail, tail, __ATOMIC_RELEASE );
+	profiler->dropped += __atomic_exchange_n( &thread->dropped, 0, __ATOMIC_RELAXED );
+	return num_samples;
+}
+
+#if defined(DBG_TOOLS_CALLSTACK_PROFILER_HAS_PERF_EVENT)
+
+static int callstack_profiler_perf_open( callstack_profiler_t* profiler, callstack_profiler_thread_t* thread, pid_t tid, unsigned int frequency )
+{
+	struct perf_event_attr attr;
+	memset( &attr, 0x0, sizeof(attr) );
+	attr.size        = sizeof(attr);
+	attr.type        = PERF_TYPE_SOFTWARE;
+	attr.sample_type = PERF_SAMPLE_CALLCHAIN;
+	attr.exclude_hv  = 1;
+	attr.exclude_callchain_kernel = 1;
+
+	switch( profiler->config.event )
+	{
+		case CALLSTACK_PROFILER_EVENT_CPU_CLOCK:        attr.config = PERF_COUNT_SW_CPU_CLOCK;        break;
+		case CALLSTACK_PROFILER_EVENT_TASK_CLOCK:       attr.config = PERF_COUNT_SW_TASK_CLOCK;       break;
+		case CALLSTACK_PROFILER_EVENT_PAGE_FAULTS:      attr.config = PERF_COUNT_SW_PAGE_FAULTS;      break;
+		case CALLSTACK_PROFILER_EVENT_CONTEXT_SWITCHES: attr.config = PERF_COUNT_SW_CONTEXT_SWITCHES; break;
+		default:
+			return -1;
+	}
+
+	if( attr.config == PERF_COUNT_SW_CPU_CLOCK || attr.config == PERF_COUNT_SW_TASK_CLOCK )
+	{
+		attr.freq        = 1;
+		attr.sample_freq = frequency;
+	}
+	else
+		attr.sample_period = frequency;
+
+	// ... context-switches, and clock-samples in syscalls, happen in the kernel, only exclude the kernel if not allowed to profile it ...
+	int fd = (int)syscall( __NR_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC );
+	if( fd < 0 && ( errno == EACCES || errno == EPERM ) )
+	{
+		attr.exclude_kernel = 1;
+		fd = (int)syscall( __NR_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC );
+	}
+	if( fd < 0 )
+		return -1;
+
+	size_t page_size = (size_t)sysconf( _SC_PAGESIZE );
+	size_t data_size = page_size;
+	while( data_size < profiler->config.ring_size )
+		data_size *= 2;
+
+	void* map = mmap( 0x0, page_size + data_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+	if( map == MAP_FAILED )
+	{
+		close( fd );
+		return -1;
+	}
+
+	thread->perf_fd   = fd;
+	thread->perf_map  = map;
+	thread->perf_size = data_size;
+	return 0;
+}
+
+static void callstack_profiler_perf_disable( callstack_profiler_thread_t* thread )
+{
+	ioctl( thread->perf_fd, PERF_EVENT_IOC_DISABLE, 0 );
+}
+
+static void callstack_profiler_perf_close( callstack_profiler_thread_t* thread )
+{
+	munmap( thread->perf_map, (size_t)sysconf( _SC_PAGESIZE ) + thread->perf_size );
+	close( thread->perf_fd );
+	thread->perf_fd  = -1;
+	thread->perf_map = 0x0;
+}
+
+static void callstack_profiler_perf_read( const uint8_t* data, size_t size, uint64_t pos, void* out, size_t out_size )
+{
+	size_t offset = (size_t)( pos & ( size - 1 ) );
+	size_t first  = size - offset < out_size ? size - offset : out_size;
+	memcpy( out, data + offset, first );
+	memcpy( (uint8_t*)out + first, data, out_size - first );
+}
+
+// ... move all records in the perf-ring of thread to the profile, profiler->lock must be held ...
+static int callstack_profiler_drain_perf( callstack_profiler_t* profiler, callstack_profiler_thread_t* thread )
+{
+	struct perf_event_mmap_page* meta = (struct perf_event_mmap_page*)thread->perf_map;
+	const uint8_t* data = (const uint8_t*)thread->perf_map + sysconf( _SC_PAGESIZE );
+	size_t         size = thread->perf_size;
+
+	void* frames[CALLSTACK_PROFILER_MAX_FRAMES];
+	int   num_samples = 0;
+
+	uint64_t head = __atomic_load_n( &meta->data_head, __ATOMIC_ACQUIRE );
+	uint64_t tail = meta->data_tail;
+	while( tail + sizeof(struct perf_event_header) <= head )
+	{
+		struct perf_event_header hdr;
+		callstack_profiler_perf_read( data, size, tail, &hdr, sizeof(hdr) );
+		if( hdr.size < sizeof(hdr) || tail + hdr.size > head )
+			break;
+
+		if( hdr.type == PERF_RECORD_SAMPLE && hdr.size >= sizeof(hdr) + sizeof(uint64_t) )
+		{
+			// ... { header, nr, ips[nr] } since PERF_SAMPLE_CALLCHAIN is the only sample_type ...
+			uint64_t nr;
+			callstack_profiler_perf_read( data, size, tail + sizeof(hdr), &nr, sizeof(nr) );
+			if( nr > ( hdr.size - sizeof(hdr) - sizeof(nr) ) / sizeof(uint64_t) )
+				nr = ( hdr.size - sizeof(hdr) - sizeof(nr) ) / sizeof(uint64_t);
+
+			int num_frames = 0;
+			for( uint64_t i = 0; i < nr && num_frames < CALLSTACK_PROFILER_MAX_FRAMES; ++i )
+			{
+				uint64_t ip;
+				callstack_profiler_perf_read( data, size, tail + sizeof(hdr) + sizeof(nr) + i * sizeof(uint64_t), &ip, sizeof(ip) );
+				if( ip >= (uint64_t)PERF_CONTEXT_MAX ) // ... PERF_CONTEXT_USER and friends separating the parts of the chain ...
+					continue;
+				frames[num_frames++] = (void*)(uintptr_t)ip;
+			}
+			if( num_frames > 0 )
+			{
+				callstack_profiler_add_sample( profiler, frames, num_frames );
+				++num_samples;
+			}
+		}
+		else if( hdr.type == PERF_RECORD_LOST && hdr.size >= sizeof(hdr) + 2 * sizeof(uint64_t) )
+		{
+			uint64_t lost; // ... { header, id, lost } ...
+			callstack_profiler_perf_read( data, size, tail + sizeof(hdr) + sizeof(uint64_t), &lost, sizeof(lost) );
+			profiler->dropped += lost;
+		}
+		tail += hdr.size;
+	}
+	__atomic_store_n( &meta->data_tail, tail, __ATOMIC_RELEASE );
+	return num_samples;
+}
+
+#else
+
+static int  callstack_profiler_perf_open( callstack_profiler_t*, callstack_profiler_thread_t*, pid_t, unsigned int ) { return -1; }
+static void callstack_profiler_perf_disable( callstack_profiler_thread_t* ) {}
+static void callstack_profiler_perf_close( callstack_profiler_thread_t* ) {}
+static int  callstack_profiler_drain_perf( callstack_profiler_t*, callstack_profiler_thread_t* ) { return 0; }
+
+#endif
+
+static int callstack_profiler_drain( callstack_profiler_t* profiler )
+{
+	int num_samples = 0;
+	for( unsigned int i = 0; i < profiler->config.max_threads; ++i )
+	{
+		callstack_profiler_thread_t* thread = &profiler->threads[i];
+		if( thread->state == CALLSTACK_PROFILER_THREAD_FREE )
+			continue;
+		if( thread->perf_fd >= 0 )
+			num_samples += callstack_profiler_drain_perf( profiler, thread );
+		else
+			num_samples += callstack_profiler_drain_thread( profiler, thread );
+		if( thread->state == CALLSTACK_PROFILER_THREAD_STOPPED )
+		{
+			if( thread->perf_fd >= 0 )
+				callstack_profiler_perf_close( thread );
+			thread->state = CALLSTACK_PROFILER_THREAD_FREE;
+		}
+	}
+	return num_samples;
+}
+
+static uint8_t* callstack_profiler_write_uleb( uint8_t* out, uint8_t* end, uint64_t v )
+{
+	do
+	{
+		uint8_t b = (uint8_t)( v & 0x7f );
+		v >>= 7;
+		if( out < end )
+			*out = (uint8_t)( b | ( v != 0 ? 0x80 : 0 ) );
+		++out;
+	} while( v != 0 );
+	return out;
+}
+
+static size_t callstack_profiler_uleb_size( uint64_t v )
+{
+	size_t size = 1;
+	while( v >= 0x80 )
+	{
+		v >>= 7;
+		++size;
+	}
+	return size;
+}
+
+static const uint8_t* callstack_profiler_read_uleb( const uint8_t* in, const uint8_t* end, uint64_t* v )
+{
+	*v = 0;
+	for( unsigned int shift = 0; in != 0x0 && in < end && shift < 64; shift += 7 )
+	{
+		uint8_t b = *in++;
+		*v |= (uint64_t)( b & 0x7f ) << shift;
+		if( ( b & 0x80 ) == 0 )
+			return in;
+	}
+	return 0x0;
+}
+
+// ... serialize the profile, profiler->lock must be held ...
+static int callstack_profiler_write_locked( callstack_profiler_t* profiler, void* out, int out_size )
+{
+	unsigned int num_ids = callstack_intern_count( profiler->stacks );
+
+	void**    addresses  = (void**)malloc( ( profiler->config.max_frames > 0 ? profiler->config.max_frames : 1 ) * sizeof(void*) );
+	int*      num_frames = (int*)malloc( ( num_ids > 0 ? num_ids : 1 ) * sizeof(int) );
+	uint64_t* counts     = (uint64_t*)malloc( ( num_ids > 0 ? num_ids : 1 ) * sizeof(uint64_t) );
+	if( addresses == 0x0 || num_frames == 0x0 || counts == 0x0 )
+	{
+		free( addresses );
+		free( num_frames );
+		free( counts );
+		return 0;
+	}
+
+	int num_stacks = 0;
+	size_t num_addresses = 0;
+	for( unsigned int id = 1; id <= num_ids; ++id )
+	{
+		void* const* frames;
+		int n = callstack_intern_lookup( profiler->stacks, id, &frames );
+		if( n < 0 || profiler->counts[id - 1] == 0 )
+			continue;
+		memcpy( addresses + num_addresses, frames, (size_t)n * sizeof(void*) );
+		num_addresses += (size_t)n;
+		num_frames[num_stacks] = n;
+		counts[num_stacks]     = profiler->counts[id - 1];
+		++num_stacks;
+	}
+
+	uint8_t header[64];
+	uint8_t* end = header + sizeof(header);
+	uint8_t* pos = header;
+	pos = callstack_profiler_write_uleb( pos, end, (uint64_t)profiler->config.event );
+	pos = callstack_profiler_write_uleb( pos, end, profiler->config.frequency );
+	pos = callstack_profiler_write_uleb( pos, end, profiler->samples );
+	pos = callstack_profiler_write_uleb( pos, end, profiler->dropped );
+	pos = callstack_profiler_write_uleb( pos, end, (uint64_t)num_stacks );
+
+	size_t counts_size = 0;
+	for( int i = 0; i < num_stacks; ++i )
+		counts_size += callstack_profiler_uleb_size( counts[i] );
+
+	int dump_size = callstack_dump_write( addresses, num_frames, num_stacks, 0x0, 0 );
+	uint8_t dump_size_uleb[16];
+	size_t  dump_size_len = callstack_profiler_uleb_size( (uint64_t)dump_size );
+	callstack_profiler_write_uleb( dump_size_uleb, dump_size_uleb + sizeof(dump_size_uleb), (uint64_t)dump_size );
+
+	size_t total = 4 + (size_t)( pos - header ) + counts_size + dump_size_len + (size_t)dump_size;
+	if( dump_size <= 0 || total > 0x7fffffff )
+		total = 0;
+	else if( out != 0x0 && total <= (size_t)out_size )
+	{
+		uint8_t* o = (uint8_t*)out;
+		memcpy( o, "CSP\2", 4 );                              o += 4;
+		memcpy( o, header, (size_t)( pos - header ) );        o += pos - header;
+		for( int i = 0; i < num_stacks; ++i )
+			o = callstack_profiler_write_uleb( o, (uint8_t*)out + out_size, counts[i] );
+		memcpy( o, dump_size_uleb, dump_size_len );           o += dump_size_len;
+		if( callstack_dump_write( addresses, num_frames, num_stacks, o, dump_size ) != dump_size )
+			total = 0;
+	}
+
+	free( addresses );
+	free( num_frames );
+	free( counts );
+	return (int)total;
+}
+
+// ... write the profile to config.output_path, via a temporary file so that readers never see a partial profile ...
+static void callstack_profiler_write_file( callstack_profiler_t* profiler )
+{
+	pthread_mutex_lock( &profiler->lock );
+	int   size = callstack_profiler_write_locked( profiler, 0x0, 0 );
+	void* data = size > 0 ? malloc( (size_t)size ) : 0x0;
+	if( data && callstack_profiler_write_locked( profiler, data, size ) != size )
+	{
+		free( data );
+		data = 0x0;
+	}
+	pthread_mutex_unlock( &profiler->lock );
+	if( data == 0x0 )
+		return;
+
+	char tmp_path[4096];
+	if( snprintf( tmp_path, sizeof(tmp_path), "%s.tmp%d", profiler->config.output_path, (int)getpid() ) < (int)sizeof(tmp_path) )
+	{
+		FILE* f = fopen( tmp_path, "wb" );
+		if( f != 0x0 )
+		{
+			int ok = fwrite( data, 1, (size_t)size, f ) == (size_t)size;
+			ok = fclose( f ) == 0 && ok;
+			if( !ok || rename( tmp_path, profiler->config.output_path ) != 0 )
+				unlink( tmp_path );
+		}
+	}
+	free( data );
+}
+
+static uint64_t callstack_profiler_now_ms()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static void* callstack_profiler_background( void* arg )
+{
+	callstack_profiler_t* profiler = (callstack_profiler_t*)arg;
+	uint64_t last_write = callstack_profiler_now_ms();
+
+	pthread_mutex_lock( &profiler->lock );
+	while( !profiler->quit )
+	{
+		struct timespec ts;
+		clock_gettime( CLOCK_MONOTONIC, &ts );
+		uint64_t ns = (uint64_t)ts.tv_nsec + (uint64_t)profiler->config.flush_interval_ms * 1000000;
+		ts.tv_sec  += (time_t)( ns / 1000000000 );
+		ts.tv_nsec  = (long)( ns % 1000000000 );
+		pthread_cond_timedwait( &profiler->wakeup, &profiler->lock, &ts );
+		if( profiler->quit )
+			break;
+
+		callstack_profiler_drain( profiler );
+
+		if( profiler->config.output_path != 0x0 && callstack_profiler_now_ms() - last_write >= profiler->config.write_interval_ms )
+		{
+			pthread_mutex_unlock( &profiler->lock );
+			callstack_profiler_write_file( profiler );
+			last_write = callstack_profiler_now_ms();
+			pthread_mutex_lock( &profiler->lock );
+		}
+	}
+	pthread_mutex_unlock( &profiler->lock );
+	return 0x0;
+}
+
+static void callstack_profiler_free( callstack_profiler_t* profiler )
+{
+	if( profiler->threads )
+	{
+		for( unsigned int i = 0; i < profiler->config.max_threads; ++i )
+		{
+			if( profiler->threads[i].perf_fd >= 0 )
+				callstack_profiler_perf_close( &profiler->threads[i] );
+			free( profiler->threads[i].ring );
+		}
+	}
+	if( profiler->stacks )
+		callstack_intern_destroy( profiler->stacks );
+	free( profiler->threads );
+	free( profiler->counts );
+	free( (void*)profiler->config.output_path );
+	free( profiler );
+}
+
+callstack_profiler_t* callstack_profiler_create( const callstack_profiler_config_t* config )
+{
+	callstack_profiler_t* profiler = (callstack_profiler_t*)calloc( 1, sizeof(callstack_profiler_t) );
+	if( profiler == 0x0 )
+		return 0x0;
+
+	if( config )
+		profiler->config = *config;
+	callstack_profiler_config_t* c = &profiler->config;
+	int use_timer = c->event == CALLSTACK_PROFILER_EVENT_TIMER;
+	int is_clock  = use_timer || c->event == CALLSTACK_PROFILER_EVENT_CPU_CLOCK || c->event == CALLSTACK_PROFILER_EVENT_TASK_CLOCK;
+	if( c->frequency == 0 )         c->frequency = is_clock ? 99 : 1;
+	if( c->ring_size == 0 )         c->ring_size = 64 * 1024;
+	if( c->max_threads == 0 )       c->max_threads = 256;
+	if( c->max_stacks == 0 )        c->max_stacks = 65536;
+	if( c->max_frames == 0 )        c->max_frames = 1024 * 1024;
+	if( c->flush_interval_ms == 0 ) c->flush_interval_ms = 100;
+	if( c->write_interval_ms == 0 ) c->write_interval_ms = 10000;
+	c->output_path = c->output_path ? strdup( c->output_path ) : 0x0;
+
+	// ... the ring must be a power of 2 that fit at least one sample of max size ...
+	uint32_t ring_size = 1;
+	while( ( ring_size < c->ring_size || ring_size < ( CALLSTACK_PROFILER_MAX_FRAMES + 1 ) * sizeof(uintptr_t) ) && ring_size < 0x40000000 )
+		ring_size *= 2;
+	c->ring_size = ring_size;
+
+	profiler->threads = (callstack_profiler_thread_t*)calloc( c->max_threads, sizeof(callstack_profiler_thread_t) );
+	profiler->counts  = (uint64_t*)calloc( c->max_stacks, sizeof(uint64_t) );
+	profiler->stacks  = callstack_intern_create( c->max_stacks, c->max_frames );
+	if( profiler->threads )
+	{
+		for( unsigned int i = 0; i < c->max_threads; ++i )
+			profiler->threads[i].perf_fd = -1;
+	}
+	if( profiler->threads == 0x0 || profiler->counts == 0x0 || profiler->stacks == 0x0 || c->event > CALLSTACK_PROFILER_EVENT_CONTEXT_SWITCHES ||
+		( use_timer && callstack_profiler_install_handler() != 0 ) )
+	{
+		callstack_profiler_free( profiler );
+		return 0x0;
+	}
+
+	pthread_condattr_t attr;
+	pthread_condattr_init( &attr );
+	pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+	pthread_cond_init( &profiler->wakeup, &attr );
+	pthread_condattr_destroy( &attr );
+	pthread_mutex_init( &profiler->lock, 0x0 );
+
+	// ... the background thread should never be interrupted by samples of other threads ...
+	sigset_t block, prev;
+	sigemptyset( &block );
+	sigaddset( &block, SIGPROF );
+	pthread_sigmask( SIG_BLOCK, &block, &prev );
+	int res = pthread_create( &profiler->background, 0x0, callstack_profiler_background, profiler );
+	pthread_sigmask( SIG_SETMASK, &prev, 0x0 );
+	if( res != 0 )
+	{
+		if( use_timer )
+			callstack_profiler_uninstall_handler();
+		pthread_cond_destroy( &profiler->wakeup );
+		pthread_mutex_destroy( &profiler->lock );
+		callstack_profiler_free( profiler );
+		return 0x0;
+	}
+	return profiler;
+}
+
+void callstack_profiler_destroy( callstack_profiler_t* profiler )
+{
+	if( profiler == 0x0 )
+		return;
+
+	pthread_mutex_lock( &profiler->lock );
+	profiler->quit = 1;
+	pthread_cond_signal( &profiler->wakeup );
+	pthread_mutex_unlock( &profiler->lock );
+	pthread_join( profiler->background, 0x0 );
+
+	// ... threads that never called callstack_profiler_thread_stop() still have a timer pointing at profiler, a SIGPROF
+	//     already queued for such a thread may be delivered at any time after timer_delete() returns to us since we are
+	//     not that thread, so its ring and the signal-handler have to outlive the profiler ...
+	int abandoned = 0;
+	for( unsigned int i = 0; i < profiler->config.max_threads; ++i )
+	{
+		callstack_profiler_thread_t* thread = &profiler->threads[i];
+		if( thread->state != CALLSTACK_PROFILER_THREAD_ACTIVE )
+			continue;
+		if( thread->perf_fd >= 0 )
+			callstack_profiler_perf_disable( thread );
+		else
+		{
+			timer_delete( thread->timer );
+			abandoned = 1;
+		}
+		thread->state = CALLSTACK_PROFILER_THREAD_STOPPED;
+	}
+
+	pthread_mutex_lock( &profiler->lock );
+	callstack_profiler_drain( profiler );
+	pthread_mutex_unlock( &profiler->lock );
+	if( profiler->config.output_path != 0x0 )
+		callstack_profiler_write_file( profiler );
+
+	if( abandoned )
+	{
+		// ... the handler is never uninstalled and the threads with their rings are kept ...
+		callstack_profiler_abandoned_t* node = (callstack_profiler_abandoned_t*)malloc( sizeof(callstack_profiler_abandoned_t) );
+		if( node )
+		{
+			pthread_mutex_lock( &g_profiler_handler_lock );
+			node->next    = g_profiler_abandoned;
+			node->threads = profiler->threads;
+			g_profiler_abandoned = node;
+			pthread_mutex_unlock( &g_profiler_handler_lock );
+		}
+		profiler->threads = 0x0;
+	}
+	else if( profiler->config.event == CALLSTACK_PROFILER_EVENT_TIMER )
+		callstack_profiler_uninstall_handler();
+	pthread_cond_destroy( &profiler->wakeup );
+	pthread_mutex_destroy( &profiler->lock );
+	callstack_profiler_free( profiler );
+}
+
+int callstack_profiler_thread_start( callstack_profiler_t* profiler, unsigned int frequency )
+{
+	pid_t tid = (pid_t)syscall( SYS_gettid );
+	if( frequency == 0 )
+		frequency = profiler->config.frequency;
+
+	pthread_mutex_lock( &profiler->lock );
+
+	callstack_profiler_thread_t* thread = 0x0;
+	for( unsigned int i = 0; i < profiler->config.max_threads; ++i )
+	{
+		callstack_profiler_thread_t* t = &profiler->threads[i];
+		if( t->state == CALLSTACK_PROFILER_THREAD_ACTIVE && t->tid == tid )
+		{
+			thread = 0x0;
+			break;
+		}
+		if( t->state == CALLSTACK_PROFILER_THREAD_FREE && thread == 0x0 )
+			thread = t;
+	}
+
+	int res = -1;
+	if( thread != 0x0 && profiler->config.event != CALLSTACK_PROFILER_EVENT_TIMER )
+	{
+		// ... the kernel captures callstacks into the perf-ring, nothing to setup in this thread ...
+		if( callstack_profiler_perf_open( profiler, thread, tid, frequency ) == 0 )
+		{
+			thread->tid   = tid;
+			thread->state = CALLSTACK_PROFILER_THREAD_ACTIVE;
+			res = 0;
+		}
+	}
+	else if( thread != 0x0 )
+	{
+		if( thread->ring == 0x0 )
+		{
+			thread->ring = (uintptr_t*)malloc( profiler->config.ring_size );
+			thread->mask = profiler->config.ring_size / sizeof(uintptr_t) - 1;
+			thread->head = 0;
+			thread->tail = 0;
+		}
+
+		// ... a timer on the cpu-time of this thread only, delivered to this thread only ...
+		struct sigevent sev;
+		memset( &sev, 0x0, sizeof(sev) );
+		sev.sigev_notify          = SIGEV_THREAD_ID;
+		sev.sigev_signo           = SIGPROF;
+		sev.sigev_value.sival_ptr = thread;
+	#if defined(sigev_notify_thread_id)
+		sev.sigev_notify_thread_id = tid;
+	#else
+		sev._sigev_un._tid = tid;
+	#endif
+
+		if( thread->ring != 0x0 && timer_create( CLOCK_THREAD_CPUTIME_ID, &sev, &thread->timer ) == 0 )
+		{
+			uint64_t interval_ns = 1000000000ull / frequency;
+			struct itimerspec its;
+			its.it_interval.tv_sec  = (time_t)( interval_ns / 1000000000 );
+			its.it_interval.tv_nsec = (long)( interval_ns % 1000000000 );
+			its.it_value            = its.it_interval;
+
+			thread->tid   = tid;
+			thread->state = CALLSTACK_PROFILER_THREAD_ACTIVE;
+			if( timer_settime( thread->timer, 0, &its, 0x0 ) == 0 )
+				res = 0;
+			else
+			{
+				timer_delete( thread->timer );
+				thread->state = CALLSTACK_PROFILER_THREAD_FREE;
+			}
+		}
+	}
+
+	pthread_mutex_unlock( &profiler->lock );
+	return res;
+}
+
+int callstack_profiler_thread_stop( callstack_profiler_t* profiler )
+{
+	pid_t tid = (pid_t)syscall( SYS_gettid );
+	int res = -1;
+
+	pthread_mutex_lock( &profiler->lock );
+	for( unsigned int i = 0; i < profiler->config.max_threads; ++i )
+	{
+		callstack_profiler_thread_t* t = &profiler->threads[i];
+		if( t->state == CALLSTACK_PROFILER_THREAD_ACTIVE && t->tid == tid )
+		{
+			// ... a signal pending for this thread is delivered before timer_delete() returns to us, after it the ring is not written again ...
+			if( t->perf_fd >= 0 )
+				callstack_profiler_perf_disable( t );
+			else
+				timer_delete( t->timer );
+			t->state = CALLSTACK_PROFILER_THREAD_STOPPED;
+			res = 0;
+			break;
+		}
+	}
+	pthread_mutex_unlock( &profiler->lock );
+	return res;
+}
+
+int callstack_profiler_flush( callstack_profiler_t* profiler )
+{
+	pthread_mutex_lock( &profiler->lock );
+	int num_samples = callstack_profiler_drain( profiler );
+	pthread_mutex_unlock( &profiler->lock );
+	return num_samples;
+}
+
+void callstack_profiler_stats( callstack_profiler_t* profiler, callstack_profiler_stats_t* stats )
+{
+	pthread_mutex_lock( &profiler->lock );
+	stats->samples         = profiler->samples;
+	stats->dropped_samples = profiler->dropped;
+	stats->num_stacks      = 0;
+	stats->num_threads     = 0;
+	unsigned int num_ids = callstack_intern_count( profiler->stacks );
+	for( unsigned int id = 1; id <= num_ids; ++id )
+		stats->num_stacks += profiler->counts[id - 1] != 0;
+	for( unsigned int i = 0; i < profiler->config.max_threads; ++i )
+		stats->num_threads += profiler->threads[i].state == CALLSTACK_PROFILER_THREAD_ACTIVE;
+	pthread_mutex_unlock( &profiler->lock );
+}
+
+int callstack_profiler_write( callstack_profiler_t* profiler, void* out, int out_size )
+{
+	pthread_mutex_lock( &profiler->lock );
+	int res = callstack_profiler_write_locked( profiler, out, out_size );
+	pthread_mutex_unlock( &profiler->lock );
+	return res;
+}
+
+// ... parse the header of a profile, returns pointer to the first count ...
+static const uint8_t* callstack_profile_header( const void* profile, int profile_size, callstack_profile_info_t* info, const uint8_t** dump, uint64_t* dump_size )
+{
+	const uint8_t* in  = (const uint8_t*)profile;
+	const uint8_t* end = in + ( profile_size > 0 ? profile_size : 0 );
+	if( profile == 0x0 || profile_size < 4 || memcmp( in, "CSP\2", 4 ) != 0 )
+		return 0x0;
+	in += 4;
+
+	uint64_t event, frequency, samples, dropped, num_stacks;
+	in = callstack_profiler_read_uleb( in, end, &event );
+	in = callstack_profiler_read_uleb( in, end, &frequency );
+	in = callstack_profiler_read_uleb( in, end, &samples );
+	in = callstack_profiler_read_uleb( in, end, &dropped );
+	in = callstack_profiler_read_uleb( in, end, &num_stacks );
+	if( in == 0x0 || event > CALLSTACK_PROFILER_EVENT_CONTEXT_SWITCHES || frequency > 0xffffffff || num_stacks > 0x7fffffff )
+		return 0x0;
+
+	info->event           = (enum callstack_profiler_event)event;
+	info->frequency       = (unsigned int)frequency;
+	info->samples         = samples;
+	info->dropped_samples = dropped;
+	info->num_stacks      = (unsigned int)num_stacks;
+
+	const uint8_t* counts = in;
+	for( uint64_t i = 0; in != 0x0 && i < num_stacks; ++i )
+	{
+		uint64_t count;
+		in = callstack_profiler_read_uleb( in, end, &count );
+	}
+	in = callstack_profiler_read_uleb( in, end, dump_size );
+	if( in == 0x0 || *dump_size > (uint64_t)( end - in ) )
+		return 0x0;
+	*dump = in;
+	return counts;
+}
+
+typedef struct
+{
+	const uint8_t*             counts;
+	const uint8_t*             counts_end;
+	uint64_t                   num_left;
+	callstack_profile_callback callback;
+	void*                      userdata;
+} callstack_profile_read_ctx_t;
+
+static int callstack_profile_read_stack( void** addresses, int num_addresses, void* userdata )
+{
+	callstack_profile_read_ctx_t* ctx = (callstack_profile_read_ctx_t*)userdata;
+	uint64_t count;
+	if( ctx->num_left == 0 )
+		return 1;
+	ctx->counts = callstack_profiler_read_uleb( ctx->counts, ctx->counts_end, &count );
+	--ctx->num_left;
+	return ctx->callback ? ctx->callback( addresses, num_addresses, (unsigned long long)count, ctx->userdata ) : 0;
+}
+
+int callstack_profile_read( const void* profile, int profile_size, callstack_profile_callback callback, void* userdata )
+{
+	callstack_profile_info_t info;
+	uint64_t dump_size;
+	const uint8_t* dump;
+	const uint8_t* counts = callstack_profile_header( profile, profile_size, &info, &dump, &dump_size );
+	if( counts == 0x0 )
+		return -1;
+
+	// ... all stacks are checked to be in the dump before any is passed to callback ...
+	if( callstack_dump_read( dump, (int)dump_size, 0x0, 0x0 ) != (int)info.num_stacks )
+		return -1;
+
+	callstack_profile_read_ctx_t ctx = { counts, dump, info.num_stacks, callback, userdata };
+	return callstack_dump_read( dump, (int)dump_size, callstack_profile_read_stack, &ctx );
+}
+
+int callstack_profile_info( const void* profile, int profile_size, callstack_profile_info_t* info )
+{
+	uint64_t dump_size;
+	const uint8_t* dump;
+	return callstack_profile_header( profile, profile_size, info, &dump, &dump_size ) != 0x0 ? 0 : -1;
+}
+
+const void* callstack_profile_dump( const void* profile, int profile_size, int* dump_size )
+{
+	callstack_profile_info_t info;
+	uint64_t size;
+	const uint8_t* dump;
+	if( callstack_profile_header( profile, profile_size, &info, &dump, &size ) == 0x0 )
+		return 0x0;
+	*dump_size = (int)size;
+	return dump;
+}
+
+#else
+
+callstack_profiler_t* callstack_profiler_create( const callstack_profiler_config_t* config ) { (void)config; return 0x0; }
+void callstack_profiler_destroy( callstack_profiler_t* profiler ) { (void)profiler; }
+int  callstack_profiler_thread_start( callstack_profiler_t* profiler, unsigned int frequency ) { (void)profiler; (void)frequency; return -1; }
+int  callstack_profiler_thread_stop( callstack_profiler_t* profiler ) { (void)profiler; return -1; }
+int  callstack_profiler_flush( callstack_profiler_t* profiler ) { (void)profiler; return 0; }
+void callstack_profiler_stats( callstack_profiler_t* profiler, callstack_profiler_stats_t* stats ) { (void)profiler; memset( stats, 0x0, sizeof(callstack_profiler_stats_t) ); }
+int  callstack_profiler_write( callstack_profiler_t* profiler, void* out, int out_size ) { (void)profiler; (void)out; (void)out_size; return 0; }
+int  callstack_profile_read( const void* profile, int profile_size, callstack_profile_callback callback, void* userdata ) { (void)profile; (void)profile_size; (void)callback; (void)userdata; return -1; }
+int  callstack_profile_info( const void* profile, int profile_size, callstack_profile_info_t* info ) { (void)profile; (void)profile_size; (void)info; return -1; }
+const void* callstack_profile_dump( const void* profile, int profile_size, int* dump_size ) { (void)profile; (void)profile_size; (void)dump_size; return 0x0; }
+
+#endif
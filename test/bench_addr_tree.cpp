@@ -0,0 +1,166 @@
+/*
+	Simple benchmark of callstack() and callstack_symbols() from dbgtools.
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+#include <dbgtools/callstack.h>
+
+/**
+ * Compares the search-tree used for address-lookups in callstack.cpp to binary search with
+ * std::upper_bound(), both over a plain array of addresses and over an array with the stride
+ * of the elf-symbol table.
+ *
+ * usage: bench_addr_tree [<lookups>]
+ */
+
+// ... the tree is internal to callstack.cpp, this bench is linked without callstack_obj ...
+#include "../src/callstack.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined( __linux )
+
+#include <time.h>
+#include <algorithm>
+
+static double bench_now_ns()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (double)ts.tv_sec * 1000000000.0 + (double)ts.tv_nsec;
+}
+
+static uint64_t bench_rand_state = 0x9e3779b97f4a7c15ull;
+
+static uint64_t bench_rand()
+{
+	// ... xorshift64*, std::rand() is too slow and too narrow to generate a million addresses ...
+	bench_rand_state ^= bench_rand_state >> 12;
+	bench_rand_state ^= bench_rand_state << 25;
+	bench_rand_state ^= bench_rand_state >> 27;
+	return bench_rand_state * 0x2545f4914f6cdd1dull;
+}
+
+static bool sym_addr_less( uint64_t addr, const callstack_elf_sym_t& sym ) { return addr < sym.addr; }
+
+static int bench_size( size_t num, size_t num_lookups )
+{
+	uint64_t*            addrs   = (uint64_t*)malloc( num * sizeof(uint64_t) );
+	callstack_elf_sym_t* syms    = (callstack_elf_sym_t*)calloc( num, sizeof(callstack_elf_sym_t) );
+	uint64_t*            lookups = (uint64_t*)malloc( num_lookups * sizeof(uint64_t) );
+
+	// ... addresses spread out like functions in a big binary, 16 to 1040 bytes apart ...
+	uint64_t addr = 0x400000;
+	for( size_t i = 0; i < num; ++i )
+	{
+		addr += 16 + bench_rand() % 1024;
+		addrs[i]     = addr;
+		syms[i].addr = addr;
+	}
+	for( size_t i = 0; i < num_lookups; ++i )
+		lookups[i] = 0x400000 + bench_rand() % ( addr - 0x400000 + 2048 );
+
+	callstack_addr_tree_t addrs_tree;
+	callstack_addr_tree_t syms_tree;
+	addr_tree_build( &addrs_tree, addrs, sizeof(uint64_t), num );
+	addr_tree_build( &syms_tree, syms, sizeof(callstack_elf_sym_t), num );
+
+	int errors = 0;
+	size_t sum_tree = 0, sum_bsearch = 0, sum_syms_tree = 0, sum_syms_bsearch = 0;
+
+	double t0 = bench_now_ns();
+	for( size_t i = 0; i < num_lookups; ++i )
+		sum_bsearch += (size_t)( std::upper_bound( addrs, addrs + num, lookups[i] ) - addrs );
+	double bsearch_ns = ( bench_now_ns() - t0 ) / (double)num_lookups;
+
+	t0 = bench_now_ns();
+	for( size_t i = 0; i < num_lookups; ++i )
+		sum_tree += addr_tree_upper_bound( &addrs_tree, lookups[i] );
+	double tree_ns = ( bench_now_ns() - t0 ) / (double)num_lookups;
+
+	t0 = bench_now_ns();
+	for( size_t i = 0; i < num_lookups; ++i )
+		sum_syms_bsearch += (size_t)( std::upper_bound( syms, syms + num, lookups[i], sym_addr_less ) - syms );
+	double syms_bsearch_ns = ( bench_now_ns() - t0 ) / (double)num_lookups;
+
+	t0 = bench_now_ns();
+	for( size_t i = 0; i < num_lookups; ++i )
+		sum_syms_tree += addr_tree_upper_bound( &syms_tree, lookups[i] );
+	double syms_tree_ns = ( bench_now_ns() - t0 ) / (double)num_lookups;
+
+	// ... check each lookup, including the edges, against std::upper_bound() ...
+	for( size_t i = 0; i < num_lookups + 4 && errors < 10; ++i )
+	{
+		uint64_t a = i < num_lookups ? lookups[i] : i == num_lookups ? 0 : i == num_lookups + 1 ? addrs[0] : i == num_lookups + 2 ? addrs[num - 1] : ~(uint64_t)0;
+		size_t expect = (size_t)( std::upper_bound( addrs, addrs + num, a ) - addrs );
+		size_t got    = addr_tree_upper_bound( &addrs_tree, a );
+		size_t got_syms = addr_tree_upper_bound( &syms_tree, a );
+		if( got != expect || got_syms != expect )
+		{
+			printf( "lookup of 0x%llx gave %zu and %zu, expected %zu\n", (unsigned long long)a, got, got_syms, expect );
+			++errors;
+		}
+	}
+	if( sum_tree != sum_bsearch || sum_syms_tree != sum_syms_bsearch )
+		++errors;
+
+	printf( "%8zu addresses, uint64_t:            std::upper_bound() %6.1f ns, tree %6.1f ns (%d levels)\n", num, bsearch_ns, tree_ns, addrs_tree.num_levels );
+	printf( "%8zu addresses, callstack_elf_sym_t: std::upper_bound() %6.1f ns, tree %6.1f ns\n", num, syms_bsearch_ns, syms_tree_ns );
+
+	addr_tree_free( &addrs_tree );
+	addr_tree_free( &syms_tree );
+	free( lookups );
+	free( syms );
+	free( addrs );
+	return errors;
+}
+
+int main( int argc, const char** argv )
+{
+	size_t num_lookups = argc > 1 ? (size_t)atoi( argv[1] ) : 4000000;
+
+#if defined(__AVX2__)
+	printf( "node-search: avx2\n" );
+#else
+	printf( "node-search: scalar\n" );
+#endif
+
+	int errors = 0;
+	errors += bench_size( 1000, num_lookups );
+	errors += bench_size( 64 * 1000, num_lookups );
+	errors += bench_size( 1000 * 1000, num_lookups );
+	errors += bench_size( 16 * 1000 * 1000, num_lookups / 4 );
+	return errors == 0 ? 0 : 1;
+}
+
+#else
+
+int main( int, const char** )
+{
+	printf( "bench_addr_tree is only implemented on linux\n" );
+	return 0;
+}
+
+#endif
@@ -0,0 +1,242 @@
+/*
+	Simple benchmark of callstack() and callstack_symbols() from dbgtools.
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+#include <dbgtools/callstack.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined( __linux )
+
+#include <time.h>
+#include <unistd.h>
+#include <link.h>
+#include <pthread.h>
+
+static double bench_now_us()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (double)ts.tv_sec * 1000000.0 + (double)ts.tv_nsec / 1000.0;
+}
+
+static void* stack[256];
+static int   stack_size = 0;
+
+static void __attribute__((noinline)) capture( int depth )
+{
+	if( depth == 0 )
+		stack_size = callstack( 0, stack, 256 );
+	else
+		capture( depth - 1 );
+	__asm__ volatile( "" ); // ... avoid tail-call so that all frames are in the stack ...
+}
+
+// ... time callstack() at a given depth ...
+static double __attribute__((noinline)) bench_unwind( int depth, int* frames )
+{
+	double res = 0.0;
+	if( depth == 0 )
+	{
+		double t0 = bench_now_us();
+		for( int i = 0; i < 10000; ++i )
+		{
+			void* addresses[256];
+			*frames = callstack( 0, addresses, 256 );
+		}
+		res = ( bench_now_us() - t0 ) / 10000.0;
+	}
+	else
+		res = bench_unwind( depth - 1, frames );
+	__asm__ volatile( "" );
+	return res;
+}
+
+static int find_main_bias( struct dl_phdr_info* info, size_t, void* data )
+{
+	*(uintptr_t*)data = (uintptr_t)info->dlpi_addr;
+	return 1;
+}
+
+/**
+ * Reference implementation of what callstack_symbols() used to do, i.e. spawn addr2line
+ * for each stack.
+ */
+static void symbolize_with_addr2line( void** addresses, int num_addresses, uintptr_t bias )
+{
+	char cmd[8192];
+	size_t start = (size_t)snprintf( cmd, sizeof(cmd), "addr2line -f -C -e /proc/%u/exe", getpid() );
+	for( int i = 0; i < num_addresses; ++i )
+		start += (size_t)snprintf( cmd + start, sizeof(cmd) - start, " %p", (void*)( (uintptr_t)addresses[i] - bias ) );
+
+	FILE* f = popen( cmd, "r" );
+	if( f == 0x0 )
+		return;
+	char line[4096];
+	while( fgets( line, sizeof(line), f ) != 0x0 ) {}
+	pclose( f );
+}
+
+// ... builds a corpus of num_stacks stacks concatenated into one array, stacks are captured at different depths to get some variation ...
+static void* batch_corpus[4096 * 64];
+static int   batch_stack_size[4096];
+
+static int build_batch_corpus( int num_stacks )
+{
+	int num_addresses = 0;
+	for( int i = 0; i < num_stacks; ++i )
+	{
+		capture( i % 32 );
+		int n = stack_size < 64 ? stack_size : 64;
+		for( int j = 0; j < n; ++j )
+			batch_corpus[num_addresses + j] = stack[j];
+		batch_stack_size[i] = n;
+		num_addresses += n;
+	}
+	return num_addresses;
+}
+
+static int bench_thread_iterations = 0;
+
+static void* bench_symbols_thread( void* )
+{
+	callstack_symbol_t symbols[256];
+	char symbols_buffer[16 * 1024];
+	for( int i = 0; i < bench_thread_iterations; ++i )
+		callstack_symbols( stack, symbols, stack_size, symbols_buffer, sizeof(symbols_buffer) );
+	return 0x0;
+}
+
+// ... returns us per stack over all threads ...
+static double bench_symbols_threaded( int num_threads, int iterations )
+{
+	pthread_t threads[64];
+	bench_thread_iterations = iterations;
+	double t0 = bench_now_us();
+	for( int t = 0; t < num_threads; ++t )
+		pthread_create( &threads[t], 0x0, bench_symbols_thread, 0x0 );
+	for( int t = 0; t < num_threads; ++t )
+		pthread_join( threads[t], 0x0 );
+	return ( bench_now_us() - t0 ) / (double)( iterations * num_threads );
+}
+
+int main( int argc, const char** argv )
+{
+	int iterations = argc > 1 ? atoi( argv[1] ) : 10000;
+	int addr2line_iterations = argc > 2 ? atoi( argv[2] ) : 20;
+
+	const int batch_stacks = 4096;
+	int batch_addresses = build_batch_corpus( batch_stacks );
+
+	capture( 16 );
+
+	callstack_symbol_t symbols[256];
+	char symbols_buffer[16 * 1024];
+
+	int    frames;
+	double callstack_us    = bench_unwind( 16, &frames );
+	callstack_set_unwinder( CALLSTACK_UNWINDER_FRAME_POINTER );
+	int    fp_frames;
+	double callstack_fp_us = bench_unwind( 16, &fp_frames );
+	callstack_set_unwinder( CALLSTACK_UNWINDER_DEFAULT );
+
+	double t0;
+
+	// ... first call includes loading of the executable ...
+	t0 = bench_now_us();
+	callstack_symbols( stack, symbols, stack_size, symbols_buffer, sizeof(symbols_buffer) );
+	double first_us = bench_now_us() - t0;
+
+	t0 = bench_now_us();
+	for( int i = 0; i < iterations; ++i )
+		callstack_symbols( stack, symbols, stack_size, symbols_buffer, sizeof(symbols_buffer) );
+	double in_process_us = ( bench_now_us() - t0 ) / (double)iterations;
+
+	double threaded_us = bench_symbols_threaded( 4, iterations );
+
+	callstack_symbolizer_t* symbolizer = callstack_symbolizer_create();
+	t0 = bench_now_us();
+	for( int i = 0; i < iterations; ++i )
+		callstack_symbolizer_symbolize( symbolizer, stack, symbols, stack_size, symbols_buffer, sizeof(symbols_buffer) );
+	double symbolizer_us = ( bench_now_us() - t0 ) / (double)iterations;
+
+	// ... symbolize a big set of stacks, per stack vs. in one batch ...
+	static char batch_buffer[256 * 1024];
+	t0 = bench_now_us();
+	for( int i = 0, offset = 0; i < batch_stacks; offset += batch_stack_size[i], ++i )
+		callstack_symbolizer_symbolize( symbolizer, batch_corpus + offset, symbols, batch_stack_size[i], batch_buffer, sizeof(batch_buffer) );
+	double per_stack_us = ( bench_now_us() - t0 ) / (double)batch_stacks;
+
+	callstack_symbol_t* batch_symbols = (callstack_symbol_t*)malloc( (size_t)batch_addresses * sizeof(callstack_symbol_t) );
+	t0 = bench_now_us();
+	callstack_symbolizer_symbolize_batch( symbolizer, batch_corpus, batch_symbols, batch_addresses );
+	double batch_us = ( bench_now_us() - t0 ) / (double)batch_stacks;
+	callstack_symbolizer_destroy( symbolizer );
+
+	// ... parallel symbolization with a fresh symbolizer to include loading ...
+	symbolizer = callstack_symbolizer_create();
+	t0 = bench_now_us();
+	callstack_symbolizer_symbolize_parallel( symbolizer, batch_corpus, batch_symbols, batch_addresses, 4 );
+	double parallel_us = ( bench_now_us() - t0 ) / (double)batch_stacks;
+	t0 = bench_now_us();
+	callstack_symbolizer_symbolize_parallel( symbolizer, batch_corpus, batch_symbols, batch_addresses, 4 );
+	double parallel_warm_us = ( bench_now_us() - t0 ) / (double)batch_stacks;
+	free( batch_symbols );
+
+	callstack_symbolizer_destroy( symbolizer );
+
+	uintptr_t bias = 0;
+	dl_iterate_phdr( find_main_bias, &bias );
+
+	t0 = bench_now_us();
+	for( int i = 0; i < addr2line_iterations; ++i )
+		symbolize_with_addr2line( stack, stack_size, bias );
+	double addr2line_us = ( bench_now_us() - t0 ) / (double)addr2line_iterations;
+
+	printf( "frames per stack:                %d\n", stack_size );
+	printf( "callstack():                     %10.2f us/stack (%d frames)\n", callstack_us, frames );
+	printf( "callstack(), frame-pointer:      %10.2f us/stack (%d frames)\n", callstack_fp_us, fp_frames );
+	printf( "callstack_symbols(), first call: %10.2f us/stack\n", first_us );
+	printf( "callstack_symbols():             %10.2f us/stack\n", in_process_us );
+	printf( "callstack_symbols(), 4 threads:  %10.2f us/stack\n", threaded_us );
+	printf( "callstack_symbolizer_symbolize(): %9.2f us/stack\n", symbolizer_us );
+	printf( "%d stacks, per stack:           %10.2f us/stack\n", batch_stacks, per_stack_us );
+	printf( "%d stacks, batch:               %10.2f us/stack\n", batch_stacks, batch_us );
+	printf( "%d stacks, 4 threads, cold:     %10.2f us/stack\n", batch_stacks, parallel_us );
+	printf( "%d stacks, 4 threads:           %10.2f us/stack\n", batch_stacks, parallel_warm_us );
+	printf( "popen( \"addr2line\" ):            %10.2f us/stack\n", addr2line_us );
+	return 0;
+}
+
+#else
+
+int main( int, const char** )
+{
+	printf( "bench_callstack is only implemented on linux\n" );
+	return 0;
+}
+
+#endif
@@ -0,0 +1,36 @@
+/*
+	Shared library used by test_callstack_shlib.
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+/* ... shared library loaded by test_callstack_shlib, capture is passed in so that this does not need to link dbgtools ... */
+
+typedef int (*callstack_shlib_capture_func)( int skip_frames, void** addresses, int num_addresses );
+
+int __attribute__((noinline)) callstack_shlib_capture( callstack_shlib_capture_func capture, void** addresses, int num_addresses )
+{
+	int num = capture( 0, addresses, num_addresses );
+	__asm__ volatile( "" ); /* ... avoid tail-call so that this frame is in the stack ... */
+	return num;
+}
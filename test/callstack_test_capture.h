@@ -0,0 +1,74 @@
+/*
+	dbgtools - platform independent wrapping of "nice to have" debug functions.
+
+	https://github.com/wc-duck/dbgtools
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+/* ... stack-capture shared by the callstack-tests, to be included in exactly one file per test ...
+ *
+ * capture_stack( depth ) captures a stack with depth + 1 frames of capture_stack on top of the caller and appends it to
+ * stacks, frame-count in num_frames[num_stacks]. It is kept from being inlined and from being turned into a loop so that
+ * every level shows up in the stack also when optimized. */
+
+#ifndef DBGTOOLS_CALLSTACK_TEST_CAPTURE_H_INCLUDED
+#define DBGTOOLS_CALLSTACK_TEST_CAPTURE_H_INCLUDED
+
+#include <dbgtools/callstack.h>
+
+#if defined( _MSC_VER )
+#  define TEST_NOINLINE __declspec(noinline)
+#else
+#  define TEST_NOINLINE __attribute__((noinline))
+#endif
+
+#define CAPTURE_MAX_STACKS 4
+#define CAPTURE_MAX_FRAMES 256
+
+static void* stacks[CAPTURE_MAX_STACKS * CAPTURE_MAX_FRAMES];
+static int   num_frames[CAPTURE_MAX_STACKS];
+static int   num_stacks = 0;
+static volatile int sink = 0;
+
+TEST_NOINLINE void capture_stack( int depth );
+
+TEST_NOINLINE void capture_stack( int depth )
+{
+	if( depth == 0 )
+	{
+		void** addresses = stacks;
+		int i;
+		if( num_stacks == CAPTURE_MAX_STACKS )
+			return;
+		for( i = 0; i < num_stacks; ++i )
+			addresses += num_frames[i];
+		num_frames[num_stacks] = callstack( 0, addresses, CAPTURE_MAX_FRAMES );
+		++num_stacks;
+		return;
+	}
+	capture_stack( depth - 1 );
+	++sink; // ... keep the recursion from being turned into a loop ...
+}
+
+#endif // DBGTOOLS_CALLSTACK_TEST_CAPTURE_H_INCLUDED
@@ -27,6 +27,11 @@
 #include <dbgtools/callstack.h>
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void* last_addresses[256];
+static int   last_num_addresses = 0;
 
 void print_callstack()
 {
@@ -34,6 +39,9 @@ void print_callstack()
 	int i;
 	int num_addresses = callstack( 0, addresses, 256 );
 
+	memcpy( last_addresses, addresses, (size_t)num_addresses * sizeof(void*) );
+	last_num_addresses = num_addresses;
+
 	callstack_symbol_t symbols[256];
 	char  symbols_buffer[1024];
 	num_addresses = callstack_symbols( addresses, symbols, num_addresses, symbols_buffer, 1024 );
@@ -80,9 +88,100 @@ void func3( int call_me, int depth )
 	funcs[call_me]( 1, depth - 1 );
 }
 
+typedef struct
+{
+	callstack_symbol_t* expect;
+	int                 num_syms;
+	int                 errors;
+} foreach_check_t;
+
+static int check_symbol( const callstack_symbol_t* sym, int index, void* userdata )
+{
+	foreach_check_t* check = (foreach_check_t*)userdata;
+	const callstack_symbol_t* expect = &check->expect[check->num_syms++];
+	if( index != check->num_syms - 1 || strcmp( sym->function, expect->function ) != 0 || strcmp( sym->file, expect->file ) != 0 || sym->line != expect->line )
+	{
+		printf( "foreach symbol %d, %s(%u) differs from %s(%u)\n", index, sym->function, sym->line, expect->function, expect->line );
+		++check->errors;
+	}
+	return 0;
+}
+
+static int stop_after_first( const callstack_symbol_t* sym, int index, void* userdata )
+{
+	(void)sym; (void)index; (void)userdata;
+	return 1;
+}
+
+// ... the streamed symbols should match the buffer-based ones, and the buffer sized by the query should be exactly enough ...
+static int check_foreach()
+{
+	callstack_symbol_t symbols[256];
+	char  symbols_buffer[1024];
+	int num_syms = callstack_symbols( last_addresses, symbols, last_num_addresses, symbols_buffer, 1024 );
+
+	foreach_check_t check = { symbols, 0, 0 };
+	if( callstack_symbols_foreach( last_addresses, last_num_addresses, 0, check_symbol, &check ) != num_syms || check.num_syms != num_syms )
+		++check.errors;
+
+	callstack_symbolizer_t* symbolizer = callstack_symbolizer_create();
+	if( symbolizer == 0x0 )
+		return check.errors;
+
+	int flags;
+	for( flags = 0; flags <= CALLSTACK_SYMBOLS_INLINED; flags += CALLSTACK_SYMBOLS_INLINED )
+	{
+		int num_expected = 0;
+		int mem_size = callstack_symbolizer_mem_size( symbolizer, last_addresses, last_num_addresses, (unsigned int)flags, &num_expected );
+		char* memory = (char*)malloc( (size_t)mem_size );
+		if( flags & CALLSTACK_SYMBOLS_INLINED )
+			num_syms = callstack_symbolizer_symbolize_inlined( symbolizer, last_addresses, symbols, last_num_addresses, 256, memory, mem_size );
+		else
+			num_syms = callstack_symbolizer_symbolize( symbolizer, last_addresses, symbols, last_num_addresses, memory, mem_size );
+
+		int i;
+		for( i = 0; i < num_syms; ++i )
+			if( symbols[i].function < memory || symbols[i].file >= memory + mem_size )
+				++check.errors; // ... all strings should be copied to memory ...
+		if( num_syms != num_expected || num_syms == 0 || symbols[num_syms - 1].file + strlen( symbols[num_syms - 1].file ) + 1 != memory + mem_size )
+		{
+			printf( "callstack_symbolizer_mem_size() returned %d bytes for %d symbols, got %d symbols\n", mem_size, num_expected, num_syms );
+			++check.errors;
+		}
+		free( memory );
+	}
+
+	// ... returning non-zero stops the iteration ...
+	check.num_syms = 0;
+	if( callstack_symbolizer_symbolize_foreach( symbolizer, last_addresses, last_num_addresses, 0, stop_after_first, &check ) != 1 )
+		++check.errors;
+
+	callstack_symbolizer_destroy( symbolizer );
+	return check.errors;
+}
+
 int main( int argc, const char** argv )
 {
 	(void)argc; (void) argv;
 	func1( 1, 5 );
+
+	if( check_foreach() != 0 )
+		return 1;
+
+	// ... a null frame should be symbolized as unknown, not be a cache-hit on an empty entry ...
+	void* null_frame[1] = { 0x0 };
+	callstack_symbol_t null_sym;
+	char null_buffer[256];
+	if( callstack_symbols( null_frame, &null_sym, 1, null_buffer, sizeof(null_buffer) ) == 1 && ( null_sym.function == 0x0 || null_sym.file == 0x0 ) )
+	{
+		printf( "null frame symbolized without function or file\n" );
+		return 1;
+	}
+
+	if( callstack_set_unwinder( CALLSTACK_UNWINDER_FRAME_POINTER ) == 0 )
+	{
+		printf( "\nframe-pointer unwinder:\n" );
+		func1( 1, 5 );
+	}
 	return 0;
 }
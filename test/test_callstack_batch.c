@@ -0,0 +1,186 @@
+/*
+	Test-program for async-signal-safe callstack_from_context() and callstack_symbolizer_symbolize_signal_safe() from dbgtools.
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+#if defined( __linux ) && !defined( _GNU_SOURCE )
+#  define _GNU_SOURCE /* ... for dl_iterate_phdr() ... */
+#endif
+
+#include <dbgtools/callstack.h>
+
+#include <dbgtools/callstack.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( __linux )
+
+#include <link.h>
+
+/* ... addresses sampled from the executable segments of all loaded modules, each repeated a few times ... */
+#define SAMPLES_PER_SEGMENT 512
+#define REPEATS             4
+#define MAX_ADDRESSES       ( 64 * SAMPLES_PER_SEGMENT * REPEATS )
+
+static void* addresses[MAX_ADDRESSES];
+static int   num_addresses = 0;
+static int   num_modules   = 0;
+
+static int sample_module( struct dl_phdr_info* info, size_t size, void* userdata )
+{
+	int i, j, r;
+	(void)size; (void)userdata;
+	int sampled = 0;
+	for( i = 0; i < info->dlpi_phnum; ++i )
+	{
+		const ElfW(Phdr)* ph = &info->dlpi_phdr[i];
+		if( ph->p_type != PT_LOAD || ( ph->p_flags & PF_X ) == 0 || ph->p_memsz == 0 )
+			continue;
+		uintptr_t begin = (uintptr_t)info->dlpi_addr + ph->p_vaddr;
+		for( j = 0; j < SAMPLES_PER_SEGMENT && num_addresses + REPEATS <= MAX_ADDRESSES; ++j )
+			for( r = 0; r < REPEATS; ++r )
+				addresses[num_addresses++] = (void*)( begin + (uintptr_t)( (uint64_t)ph->p_memsz * (uint64_t)j / SAMPLES_PER_SEGMENT ) );
+		sampled = 1;
+	}
+	num_modules += sampled;
+	return 0;
+}
+
+static int same_symbol( const callstack_symbol_t* a, const callstack_symbol_t* b )
+{
+	return strcmp( a->function, b->function ) == 0 && strcmp( a->file, b->file ) == 0 && a->line == b->line && a->offset == b->offset;
+}
+
+static int compare( const char* what, const callstack_symbol_t* expect, const callstack_symbol_t* syms, int num_syms )
+{
+	int i;
+	int errors = 0;
+	if( num_syms != num_addresses )
+	{
+		printf( "%s: translated %d of %d addresses\n", what, num_syms, num_addresses );
+		return 1;
+	}
+	for( i = 0; i < num_syms; ++i )
+	{
+		if( same_symbol( &expect[i], &syms[i] ) )
+			continue;
+		if( errors++ < 10 )
+			printf( "%s %6d) %p %s+%u %s(%u) expected %s+%u %s(%u)\n", what, i, addresses[i], syms[i].function, syms[i].offset, syms[i].file, syms[i].line,
+					expect[i].function, expect[i].offset, expect[i].file, expect[i].line );
+	}
+	if( errors )
+		printf( "%s: %d symbols differ\n", what, errors );
+	return errors;
+}
+
+int main( int argc, const char** argv )
+{
+	int i;
+	int errors = 0;
+	(void)argc; (void)argv;
+
+	dl_iterate_phdr( sample_module, 0x0 );
+
+	/* ... addresses that are not in any module ... */
+	addresses[num_addresses++] = (void*)(uintptr_t)16;
+	addresses[num_addresses++] = (void*)&num_addresses;
+
+	/* ... shuffle so that duplicates and modules are interleaved, fixed seed to be reproducible ... */
+	unsigned int seed = 1234567u;
+	for( i = num_addresses - 1; i > 0; --i )
+	{
+		seed = seed * 1103515245u + 12345u;
+		int j = (int)( ( seed >> 8 ) % (unsigned int)( i + 1 ) );
+		void* tmp = addresses[i];
+		addresses[i] = addresses[j];
+		addresses[j] = tmp;
+	}
+	printf( "%d addresses in %d modules\n", num_addresses, num_modules );
+
+	callstack_symbol_t* expect = (callstack_symbol_t*)malloc( (size_t)num_addresses * sizeof(callstack_symbol_t) );
+	callstack_symbol_t* syms   = (callstack_symbol_t*)malloc( (size_t)num_addresses * sizeof(callstack_symbol_t) );
+
+	/* ... reference through the plain symbolizer ... */
+	callstack_symbolizer_t* reference = callstack_symbolizer_create();
+	int   mem_size = callstack_symbolizer_mem_size( reference, addresses, num_addresses, 0, 0x0 );
+	char* memory   = (char*)malloc( (size_t)mem_size + 1 );
+	if( callstack_symbolizer_symbolize( reference, addresses, expect, num_addresses, memory, mem_size ) != num_addresses )
+	{
+		printf( "callstack_symbolizer_symbolize() not supported\n" );
+		return 0;
+	}
+
+	/* ... most sampled addresses should be inside some function, or the comparisons below prove nothing ... */
+	int resolved = 0;
+	for( i = 0; i < num_addresses; ++i )
+		resolved += strcmp( expect[i].function, "failed to lookup symbol" ) != 0;
+	printf( "%d addresses resolved to a function\n", resolved );
+	if( resolved < num_addresses / 4 )
+		++errors;
+
+	/* ... a fresh symbolizer per variant so that modules are also loaded by the batch and parallel paths ... */
+	callstack_symbolizer_t* batch = callstack_symbolizer_create();
+	int num_syms = callstack_symbolizer_symbolize_batch( batch, addresses, syms, num_addresses );
+	if( num_syms == 0 )
+	{
+		printf( "callstack_symbolizer_symbolize_batch() not supported\n" );
+		return 0;
+	}
+	errors += compare( "batch", expect, syms, num_syms );
+	callstack_symbolizer_destroy( batch );
+
+	int threads[] = { 2, 4, 7, 0 };
+	for( i = 0; i < (int)( sizeof(threads) / sizeof(threads[0]) ); ++i )
+	{
+		char what[64];
+		callstack_symbolizer_t* parallel = callstack_symbolizer_create();
+		memset( syms, 0x0, (size_t)num_addresses * sizeof(callstack_symbol_t) );
+		snprintf( what, sizeof(what), "parallel(%d)", threads[i] );
+		errors += compare( what, expect, syms, callstack_symbolizer_symbolize_parallel( parallel, addresses, syms, num_addresses, threads[i] ) );
+
+		/* ... and again with all modules already loaded ... */
+		memset( syms, 0x0, (size_t)num_addresses * sizeof(callstack_symbol_t) );
+		snprintf( what, sizeof(what), "parallel(%d) warm", threads[i] );
+		errors += compare( what, expect, syms, callstack_symbolizer_symbolize_parallel( parallel, addresses, syms, num_addresses, threads[i] ) );
+		callstack_symbolizer_destroy( parallel );
+	}
+
+	callstack_symbolizer_destroy( reference );
+	free( memory );
+	free( expect );
+	free( syms );
+	return errors == 0 ? 0 : 1;
+}
+
+#else
+
+int main( int argc, const char** argv )
+{
+	(void)argc; (void)argv;
+	return 0;
+}
+
+#endif
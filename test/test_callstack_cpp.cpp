@@ -27,12 +27,19 @@
 #include <dbgtools/callstack.h>
 
 #include <stdio.h>
+#include <string.h>
+
+static void* last_addresses[256];
+static int   last_num_addresses = 0;
 
 void print_callstack()
 {
 	void* addresses[256];
 	int num_addresses = callstack( 0, addresses, 256 );
 
+	memcpy( last_addresses, addresses, (size_t)num_addresses * sizeof(void*) );
+	last_num_addresses = num_addresses;
+
 	callstack_symbol_t symbols[256];
 	char  symbols_buffer[2048];
 	num_addresses = callstack_symbols( addresses, symbols, num_addresses, symbols_buffer, 2048 );
@@ -46,11 +53,22 @@ typedef void (*cb)( int, int );
 
 cb funcs[3];
 
+// ... keep the functions checked for as real frames in optimized builds, not inlined nor tail-called ...
+#if defined( _MSC_VER )
+#  define TEST_NOINLINE __declspec(noinline)
+#elif defined( __clang__ )
+#  define TEST_NOINLINE __attribute__((noinline))
+#else
+#  define TEST_NOINLINE __attribute__((noinline, noclone)) // ... noclone keeps names free of .isra-suffixes ...
+#endif
+
+static volatile int sink = 0;
+
 template < typename T >
 class my_class
 {
 public:
-	void a_member_func( int call_me, int depth )
+	TEST_NOINLINE void a_member_func( int call_me, int depth )
 	{
 		if( depth == 0 )
 		{
@@ -58,9 +76,10 @@ public:
 			return;
 		}
 		funcs[call_me]( 1, depth - 1 );
+		++sink;
 	}
 
-	static void a_static_func( int call_me, int depth )
+	TEST_NOINLINE static void a_static_func( int call_me, int depth )
 	{
 		if( depth == 0 )
 		{
@@ -68,14 +87,43 @@ public:
 			return;
 		}
 		funcs[call_me]( 2, depth - 1 );
+		++sink;
 	}
 };
 
 template< typename T >
-void a_static_func( int call_me, int depth )
+TEST_NOINLINE void a_static_func( int call_me, int depth )
 {
 	my_class<T> c;
 	c.a_member_func( call_me, depth );
+	++sink;
+}
+
+// ... symbolize the last printed callstack with mode and check that both names are found ...
+static bool check_names( enum callstack_demangle mode, const char* name1, const char* name2 )
+{
+	callstack_symbolizer_t* symbolizer = callstack_symbolizer_create();
+	if( callstack_symbolizer_set_demangle( symbolizer, mode ) != 0 )
+	{
+		callstack_symbolizer_destroy( symbolizer );
+		return true; // ... not supported on this platform ...
+	}
+
+	callstack_symbol_t symbols[256];
+	char symbols_buffer[8192];
+	int num_symbols = callstack_symbolizer_symbolize( symbolizer, last_addresses, symbols, last_num_addresses, symbols_buffer, sizeof(symbols_buffer) );
+
+	bool found1 = false, found2 = false;
+	for( int i = 0; i < num_symbols; ++i )
+	{
+		found1 |= strcmp( symbols[i].function, name1 ) == 0;
+		found2 |= strcmp( symbols[i].function, name2 ) == 0;
+	}
+	callstack_symbolizer_destroy( symbolizer );
+
+	if( !found1 || !found2 )
+		printf( "expected to find \"%s\" and \"%s\" in callstack\n", name1, name2 );
+	return found1 && found2;
 }
 
 int main( int, const char** )
@@ -85,5 +133,9 @@ int main( int, const char** )
 	funcs[2] = a_static_func<double>;
 
 	a_static_func<char>( 0, 6 );
+
+	if( !check_names( CALLSTACK_DEMANGLE_FULL,  "my_class<char>::a_member_func(int, int)", "void a_static_func<double>(int, int)" ) ||
+		!check_names( CALLSTACK_DEMANGLE_SHORT, "my_class::a_member_func(int, int)",       "a_static_func(int, int)" ) )
+		return 1;
 	return 0;
 }
@@ -0,0 +1,131 @@
+/*
+	dbgtools - platform independent wrapping of "nice to have" debug functions.
+
+	https://github.com/wc-duck/dbgtools
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+#include <dbgtools/callstack.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "callstack_test_capture.h"
+
+typedef struct
+{
+	void** expect;
+	int    stack;
+	int    errors;
+} read_check_t;
+
+static int check_stack( void** addresses, int num_addresses, void* userdata )
+{
+	read_check_t* check = (read_check_t*)userdata;
+	if( num_addresses != num_frames[check->stack] || memcmp( addresses, check->expect, (size_t)num_addresses * sizeof(void*) ) != 0 )
+	{
+		printf( "stack %d read back from dump differs from the one written\n", check->stack );
+		++check->errors;
+	}
+	check->expect += num_addresses;
+	++check->stack;
+	return 0;
+}
+
+int main( int argc, const char** argv )
+{
+	(void)argc; (void)argv;
+
+	capture_stack( 2 );
+	capture_stack( 5 );
+	capture_stack( 3 );
+
+	// ... dump with a fake address in the middle of the last stack ...
+	stacks[num_frames[0] + num_frames[1] + 1] = (void*)(size_t)16;
+
+	int size = callstack_dump_write( stacks, num_frames, num_stacks, 0x0, 0 );
+	if( size == 0 )
+	{
+		printf( "callstack_dump_write() not supported\n" );
+		return 0;
+	}
+
+	char* dump = (char*)malloc( (size_t)size );
+	if( callstack_dump_write( stacks, num_frames, num_stacks, dump, size ) != size )
+	{
+		printf( "callstack_dump_write() returned different sizes\n" );
+		return 1;
+	}
+	printf( "%d stacks stored in %d bytes\n", num_stacks, size );
+
+	read_check_t check = { stacks, 0, 0 };
+	if( callstack_dump_read( dump, size, check_stack, &check ) != num_stacks || check.errors != 0 )
+		return 1;
+
+	// ... a truncated dump should be detected ...
+	if( callstack_dump_read( dump, size - 1, 0x0, 0x0 ) != -1 )
+	{
+		printf( "truncated dump was not detected\n" );
+		return 1;
+	}
+
+	// ... symbolizing offline should give the same result as in the process ...
+	callstack_symbolizer_t* live    = callstack_symbolizer_create();
+	callstack_symbolizer_t* offline = callstack_symbolizer_create_from_dump( dump, size, 0x0 );
+	if( live == 0x0 || offline == 0x0 )
+	{
+		printf( "failed to create symbolizers\n" );
+		return 1;
+	}
+
+	int num_addresses = num_frames[0] + num_frames[1] + num_frames[2];
+	callstack_symbol_t live_syms[4 * 256];
+	callstack_symbol_t offline_syms[4 * 256];
+	callstack_symbolizer_symbolize_batch( live, stacks, live_syms, num_addresses );
+	callstack_symbolizer_symbolize_batch( offline, stacks, offline_syms, num_addresses );
+
+	int i;
+	int errors = 0;
+	int found  = 0;
+	for( i = 0; i < num_addresses; ++i )
+	{
+		if( strcmp( live_syms[i].function, offline_syms[i].function ) != 0 || strcmp( live_syms[i].file, offline_syms[i].file ) != 0 || live_syms[i].line != offline_syms[i].line )
+		{
+			printf( "%3d) %s %s(%u) symbolized as %s %s(%u) from dump\n", i, live_syms[i].function, live_syms[i].file, live_syms[i].line, offline_syms[i].function, offline_syms[i].file, offline_syms[i].line );
+			++errors;
+		}
+		found += strcmp( offline_syms[i].function, "capture_stack" ) == 0;
+	}
+	if( found != 12 ) // ... depth + 1 frames per stack minus the one replaced ...
+	{
+		printf( "expected to find capture_stack 12 times, found it %d times\n", found );
+		++errors;
+	}
+
+	callstack_symbolizer_destroy( live );
+	callstack_symbolizer_destroy( offline );
+	free( dump );
+	return errors == 0 ? 0 : 1;
+}
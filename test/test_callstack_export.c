@@ -0,0 +1,274 @@
+/*
+	dbgtools - platform independent wrapping of "nice to have" debug functions.
+
+	https://github.com/wc-duck/dbgtools
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+#include <dbgtools/callstack.h>
+#include <dbgtools/callstack_export.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "callstack_test_capture.h"
+
+typedef struct
+{
+	unsigned long long total;
+	int                stacks;
+	int                errors;
+} folded_check_t;
+
+static int check_folded( const char* stack, unsigned long long weight, void* userdata )
+{
+	folded_check_t* check = (folded_check_t*)userdata;
+	check->total += weight;
+	++check->stacks;
+
+	// ... the root is first, so capture_stack should always be called from main ...
+	if( strstr( stack, ";main;capture_stack;" ) == 0x0 || strchr( stack, '\n' ) != 0x0 )
+	{
+		printf( "unexpected folded stack: %s\n", stack );
+		++check->errors;
+	}
+	return 0;
+}
+
+typedef struct
+{
+	char*  data;
+	size_t size;
+	size_t cap;
+} buffer_t;
+
+static int write_buffer( const void* data, size_t size, void* userdata )
+{
+	buffer_t* buf = (buffer_t*)userdata;
+	if( buf->size + size > buf->cap )
+		return -1;
+	memcpy( buf->data + buf->size, data, size );
+	buf->size += size;
+	return 0;
+}
+
+// ... just enough of a protobuf-decoder to check the fields written ...
+static int read_varint( const unsigned char** p, const unsigned char* end, unsigned long long* value )
+{
+	*value = 0;
+	for( int shift = 0; *p < end && shift < 64; shift += 7 )
+	{
+		unsigned char b = *(*p)++;
+		*value |= (unsigned long long)( b & 0x7f ) << shift;
+		if( ( b & 0x80 ) == 0 )
+			return 0;
+	}
+	return -1;
+}
+
+typedef struct
+{
+	int                samples;
+	int                strings;
+	int                found_func; ///< capture_stack found in the string-table.
+	int                first_empty;
+	unsigned long long total;
+} pprof_check_t;
+
+static int check_pprof_sample( const unsigned char* p, const unsigned char* end, pprof_check_t* check )
+{
+	while( p < end )
+	{
+		unsigned long long key, len;
+		if( read_varint( &p, end, &key ) != 0 || ( key & 7 ) != 2 || read_varint( &p, end, &len ) != 0 || len > (unsigned long long)( end - p ) )
+			return -1;
+		const unsigned char* field_end = p + len;
+		if( ( key >> 3 ) == 2 ) // ... value, packed ...
+		{
+			unsigned long long value;
+			while( p < field_end )
+			{
+				if( read_varint( &p, field_end, &value ) != 0 )
+					return -1;
+				check->total += value;
+			}
+		}
+		p = field_end;
+	}
+	return 0;
+}
+
+static int check_pprof( const unsigned char* p, const unsigned char* end, pprof_check_t* check )
+{
+	while( p < end )
+	{
+		unsigned long long key, len;
+		if( read_varint( &p, end, &key ) != 0 )
+			return -1;
+		if( ( key & 7 ) == 0 )
+		{
+			if( read_varint( &p, end, &len ) != 0 )
+				return -1;
+			continue;
+		}
+		if( ( key & 7 ) != 2 || read_varint( &p, end, &len ) != 0 || len > (unsigned long long)( end - p ) )
+			return -1;
+
+		switch( key >> 3 )
+		{
+			case 2:
+				if( check_pprof_sample( p, p + len, check ) != 0 )
+					return -1;
+				++check->samples;
+				break;
+			case 6:
+				if( check->strings == 0 )
+					check->first_empty = len == 0;
+				if( len == strlen( "capture_stack" ) && memcmp( p, "capture_stack", (size_t)len ) == 0 )
+					check->found_func = 1;
+				++check->strings;
+				break;
+		}
+		p += len;
+	}
+	return 0;
+}
+
+int main( int argc, const char** argv )
+{
+	(void)argc; (void)argv;
+
+	capture_stack( 2 );
+	capture_stack( 5 );
+	capture_stack( 3 );
+	if( num_frames[0] <= 0 )
+	{
+		printf( "callstack() not supported\n" );
+		return 0;
+	}
+
+	callstack_export_t* exp = callstack_export_create( 0x0, 16, 4 * 256 );
+	if( exp == 0x0 )
+	{
+		printf( "failed to create export\n" );
+		return 1;
+	}
+
+	// ... add the same stacks multiple times, these should be merged ...
+	int errors = 0;
+	int round, i;
+	for( round = 0; round < 3; ++round )
+	{
+		void** addresses = stacks;
+		for( i = 0; i < num_stacks; ++i )
+		{
+			errors += callstack_export_add( exp, addresses, num_frames[i], (unsigned long long)( i + 1 ) ) != 0;
+			addresses += num_frames[i];
+		}
+	}
+	if( callstack_export_total( exp ) != 18 )
+	{
+		printf( "expected a total weight of 18, got %llu\n", callstack_export_total( exp ) );
+		++errors;
+	}
+
+	folded_check_t folded = { 0, 0, 0 };
+	if( callstack_export_folded_foreach( exp, 0, check_folded, &folded ) != num_stacks || folded.stacks != num_stacks || folded.total != 18 )
+	{
+		printf( "expected %d folded stacks with a total of 18, got %d with %llu\n", num_stacks, folded.stacks, folded.total );
+		++errors;
+	}
+	errors += folded.errors;
+
+	char mem[64 * 1024];
+	buffer_t buf = { mem, 0, sizeof(mem) - 1 };
+	if( callstack_export_write_folded( exp, 0, write_buffer, &buf ) != 0 )
+	{
+		printf( "failed to write folded stacks\n" );
+		++errors;
+	}
+	else
+	{
+		// ... one line per stack ending with the weight of the stack ...
+		mem[buf.size] = '\0';
+		int lines = 0;
+		for( char* line = mem; *line; ++lines )
+		{
+			char* end = strchr( line, '\n' );
+			if( end != 0x0 )
+				*end = '\0';
+			char* weight = strrchr( line, ' ' );
+			if( end == 0x0 || weight == 0x0 || strtoul( weight + 1, 0x0, 10 ) % 3 != 0 )
+			{
+				printf( "bad folded line %d: %s\n", lines, line );
+				++errors;
+				break;
+			}
+			line = end + 1;
+		}
+		if( lines != num_stacks )
+		{
+			printf( "expected %d folded lines, got %d\n", num_stacks, lines );
+			++errors;
+		}
+	}
+
+	// ... a failing write should abort ...
+	buffer_t small = { mem, 0, 4 };
+	if( callstack_export_write_folded( exp, 0, write_buffer, &small ) != -1 )
+	{
+		printf( "failed write was not reported\n" );
+		++errors;
+	}
+
+	buf.size = 0;
+	pprof_check_t pprof = { 0, 0, 0, 0, 0 };
+	if( callstack_export_write_pprof( exp, CALLSTACK_SYMBOLS_INLINED, "samples", "count", write_buffer, &buf ) != 0 ||
+		check_pprof( (const unsigned char*)mem, (const unsigned char*)mem + buf.size, &pprof ) != 0 )
+	{
+		printf( "failed to write or parse pprof\n" );
+		++errors;
+	}
+	else if( pprof.samples != num_stacks || pprof.total != 18 || !pprof.first_empty || !pprof.found_func )
+	{
+		printf( "unexpected pprof: %d samples, total %llu, first string %s, capture_stack %s\n",
+				pprof.samples, pprof.total, pprof.first_empty ? "empty" : "not empty", pprof.found_func ? "found" : "not found" );
+		++errors;
+	}
+
+	// ... adding more unique stacks than max_stacks should fail ...
+	callstack_export_t* full = callstack_export_create( 0x0, 1, 256 );
+	if( callstack_export_add( full, stacks, num_frames[0], 1 ) != 0 ||
+		callstack_export_add( full, stacks + num_frames[0], num_frames[1], 1 ) != -1 ||
+		callstack_export_add( full, stacks, num_frames[0], 1 ) != 0 )
+	{
+		printf( "max_stacks not respected\n" );
+		++errors;
+	}
+
+	callstack_export_destroy( full );
+	callstack_export_destroy( exp );
+	return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+/*
+	dbgtools - platform independent wrapping of "nice to have" debug functions.
+
+	https://github.com/wc-duck/dbgtools
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+
+#include <dbgtools/callstack.h>
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "callstack_test_capture.h"
+
+static int compare_syms( const char* what, callstack_symbol_t* expect, int num_expect, callstack_symbol_t* syms, int num_syms )
+{
+	int i;
+	int errors = 0;
+	if( num_syms != num_expect )
+	{
+		printf( "%s: got %d symbols, expected %d\n", what, num_syms, num_expect );
+		return 1;
+	}
+	for( i = 0; i < num_syms; ++i )
+	{
+		if( strcmp( expect[i].function, syms[i].function ) != 0 || strcmp( expect[i].file, syms[i].file ) != 0 || expect[i].line != syms[i].line || expect[i].offset != syms[i].offset )
+		{
+			printf( "%s %3d) %s+%u %s(%u) resolved as %s+%u %s(%u) with index\n", what, i, expect[i].function, expect[i].offset, expect[i].file, expect[i].line, syms[i].function, syms[i].offset, syms[i].file, syms[i].line );
+			++errors;
+		}
+	}
+	return errors;
+}
+
+static int symbolize_all( callstack_symbol_t* syms, callstack_symbol_t* short_syms, callstack_symbol_t* inlined, int* num_inlined, char* memory, int mem_size )
+{
+	callstack_symbolizer_t* symbolizer = callstack_symbolizer_create();
+	if( symbolizer == 0x0 )
+		return 0;
+
+	int third = mem_size / 3;
+	callstack_symbolizer_symbolize( symbolizer, stacks, syms, num_frames[0], memory, third );
+	*num_inlined = callstack_symbolizer_symbolize_inlined( symbolizer, stacks, inlined, num_frames[0], 512, memory + third, third );
+	callstack_symbolizer_set_demangle( symbolizer, CALLSTACK_DEMANGLE_SHORT );
+	callstack_symbolizer_symbolize( symbolizer, stacks, short_syms, num_frames[0], memory + 2 * third, third );
+	callstack_symbolizer_destroy( symbolizer );
+	return 1;
+}
+
+int main( int argc, const char** argv )
+{
+	(void)argc; (void)argv;
+
+	char index_path[PATH_MAX + 16];
+	if( realpath( "/proc/self/exe", index_path ) == 0x0 )
+	{
+		printf( "callstack_index_write() not supported\n" );
+		return 0;
+	}
+	strcat( index_path, ".csidx" );
+	unlink( index_path );
+
+	capture_stack( 4 );
+
+	static char memory[2][3 * 64 * 1024];
+	static callstack_symbol_t syms[2][256];
+	static callstack_symbol_t short_syms[2][256];
+	static callstack_symbol_t inlined[2][512];
+	int num_inlined[2];
+	if( !symbolize_all( syms[0], short_syms[0], inlined[0], &num_inlined[0], memory[0], (int)sizeof(memory[0]) ) )
+	{
+		printf( "failed to create symbolizer\n" );
+		return 1;
+	}
+
+	if( callstack_index_write( "/proc/self/exe", 0x0 ) != 0 )
+	{
+		printf( "callstack_index_write() not supported\n" );
+		return 0;
+	}
+
+	// ... a new symbolizer picks up the index written next to the executable ...
+	symbolize_all( syms[1], short_syms[1], inlined[1], &num_inlined[1], memory[1], (int)sizeof(memory[1]) );
+	unlink( index_path );
+
+	int errors = 0;
+	errors += compare_syms( "symbolize", syms[0], num_frames[0], syms[1], num_frames[0] );
+	errors += compare_syms( "short", short_syms[0], num_frames[0], short_syms[1], num_frames[0] );
+	errors += compare_syms( "inlined", inlined[0], num_inlined[0], inlined[1], num_inlined[1] );
+
+	int i;
+	int found = 0;
+	for( i = 0; i < num_frames[0]; ++i )
+		found += strcmp( syms[1][i].function, "capture_stack" ) == 0;
+	if( found != 5 )
+	{
+		printf( "expected to find capture_stack 5 times, found it %d times\n", found );
+		++errors;
+	}
+
+	// ... an index written for another module is not used ...
+	if( callstack_index_write( "/bin/sh", index_path ) == 0 )
+	{
+		symbolize_all( syms[1], short_syms[1], inlined[1], &num_inlined[1], memory[1], (int)sizeof(memory[1]) );
+		unlink( index_path );
+		errors += compare_syms( "other index", syms[0], num_frames[0], syms[1], num_frames[0] );
+	}
+
+	return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+/*
+	Test-program for callstack_symbols_inlined() from dbgtools.
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+#include <dbgtools/callstack.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined( __linux )
+
+static void*              addresses[64];
+static int                num_addresses = 0;
+static callstack_symbol_t symbols[256];
+static char               symbols_buffer[8192];
+
+static inline __attribute__((always_inline)) void inlined_inner( void )
+{
+	num_addresses = callstack( 0, addresses, 64 );
+}
+
+static inline __attribute__((always_inline)) void inlined_middle( void )
+{
+	inlined_inner();
+	__asm__ volatile( "" );
+}
+
+void __attribute__((noinline)) real_outer( void )
+{
+	inlined_middle();
+	__asm__ volatile( "" );
+}
+
+int main( int argc, const char** argv )
+{
+	int i, first, num_symbols;
+	(void)argc; (void)argv;
+
+	real_outer();
+
+	num_symbols = callstack_symbols_inlined( addresses, symbols, num_addresses, 256, symbols_buffer, sizeof(symbols_buffer) );
+	for( i = 0; i < num_symbols; ++i )
+		printf( "%3d) %-50s %s(%u)%s\n", i, symbols[i].function, symbols[i].file, symbols[i].line, symbols[i].inlined ? " [inlined]" : "" );
+
+	/* ... the address in real_outer should be expanded to inlined_inner and inlined_middle in front of it ... */
+	for( first = 0; first < num_symbols; ++first )
+		if( strcmp( symbols[first].function, "inlined_inner" ) == 0 )
+			break;
+
+	if( first + 3 > num_symbols ||
+		!symbols[first].inlined ||
+		strcmp( symbols[first + 1].function, "inlined_middle" ) != 0 || !symbols[first + 1].inlined ||
+		strcmp( symbols[first + 2].function, "real_outer" )     != 0 ||  symbols[first + 2].inlined )
+	{
+		printf( "failed to expand inlined frames!\n" );
+		return 1;
+	}
+
+	if( strstr( symbols[first + 1].file, "test_callstack_inline.c" ) == 0x0 || strstr( symbols[first + 2].file, "test_callstack_inline.c" ) == 0x0 )
+	{
+		printf( "failed to find call-sites of inlined frames!\n" );
+		return 1;
+	}
+	return 0;
+}
+
+#else
+
+int main( int argc, const char** argv )
+{
+	(void)argc; (void)argv;
+	return 0;
+}
+
+#endif
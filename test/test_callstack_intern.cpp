@@ -0,0 +1,175 @@
+/*
+	Test-program for callstack_intern() from dbgtools.
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+#include <dbgtools/callstack_intern.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "greatest.h"
+
+int same_stack_same_id()
+{
+	callstack_intern_t* table = callstack_intern_create( 64, 64 * 64 );
+	GREATEST_ASSERT( table != 0x0 );
+
+	void* a[] = { (void*)0x1000, (void*)0x2000, (void*)0x3000 };
+	void* b[] = { (void*)0x1000, (void*)0x2000, (void*)0x3001 };
+
+	unsigned int id_a1 = callstack_intern( table, a, 3 );
+	unsigned int id_b  = callstack_intern( table, b, 3 );
+	unsigned int id_a2 = callstack_intern( table, a, 3 );
+	unsigned int id_a3 = callstack_intern( table, a, 2 );
+
+	GREATEST_ASSERT( id_a1 != CALLSTACK_INTERN_INVALID_ID );
+	GREATEST_ASSERT( id_b  != CALLSTACK_INTERN_INVALID_ID );
+	GREATEST_ASSERT_EQ( id_a1, id_a2 );
+	GREATEST_ASSERT( id_a1 != id_b );
+	GREATEST_ASSERT( id_a1 != id_a3 );
+	GREATEST_ASSERT_EQ( 3u, callstack_intern_count( table ) );
+
+	callstack_intern_destroy( table );
+	return 0;
+}
+
+int lookup_returns_frames()
+{
+	callstack_intern_t* table = callstack_intern_create( 64, 64 * 64 );
+
+	void* a[] = { (void*)0x1000, (void*)0x2000, (void*)0x3000 };
+	unsigned int id = callstack_intern( table, a, 3 );
+
+	void* const* frames;
+	GREATEST_ASSERT_EQ( 3, callstack_intern_lookup( table, id, &frames ) );
+	GREATEST_ASSERT( memcmp( frames, a, sizeof(a) ) == 0 );
+
+	GREATEST_ASSERT_EQ( -1, callstack_intern_lookup( table, CALLSTACK_INTERN_INVALID_ID, &frames ) );
+	GREATEST_ASSERT_EQ( -1, callstack_intern_lookup( table, id + 1, &frames ) );
+
+	callstack_intern_destroy( table );
+	return 0;
+}
+
+int full_table()
+{
+	callstack_intern_t* table = callstack_intern_create( 2, 4 );
+
+	void* a[] = { (void*)0x1000, (void*)0x2000 };
+	void* b[] = { (void*)0x1000, (void*)0x2001 };
+	void* c[] = { (void*)0x1000, (void*)0x2002 };
+
+	GREATEST_ASSERT( callstack_intern( table, a, 2 ) != CALLSTACK_INTERN_INVALID_ID );
+	GREATEST_ASSERT( callstack_intern( table, b, 2 ) != CALLSTACK_INTERN_INVALID_ID );
+	GREATEST_ASSERT_EQ( CALLSTACK_INTERN_INVALID_ID, callstack_intern( table, c, 2 ) );
+
+	// ... existing stacks can still be found ...
+	GREATEST_ASSERT( callstack_intern( table, a, 2 ) != CALLSTACK_INTERN_INVALID_ID );
+
+	callstack_intern_destroy( table );
+	return 0;
+}
+
+int symbols_are_cached()
+{
+	callstack_intern_t* table = callstack_intern_create( 64, 64 * 64 );
+
+	// ... intern one captured callstack twice, capturing twice would give different return-addresses if the compiler duplicates the call ...
+	void* addresses[64];
+	int num_addresses = callstack( 0, addresses, 64 );
+	GREATEST_ASSERT( num_addresses > 0 );
+	unsigned int id1 = callstack_intern( table, addresses, num_addresses );
+	GREATEST_ASSERT_EQ( id1, callstack_intern( table, addresses, num_addresses ) );
+
+	int num_syms1 = 0, num_syms2 = 0;
+	const callstack_symbol_t* syms1 = callstack_intern_symbols( table, id1, &num_syms1 );
+	const callstack_symbol_t* syms2 = callstack_intern_symbols( table, id1, &num_syms2 );
+
+	GREATEST_ASSERT( syms1 != 0x0 );
+	GREATEST_ASSERT_EQ( syms1, syms2 );
+	GREATEST_ASSERT_EQ( num_syms1, num_syms2 );
+	GREATEST_ASSERT( num_syms1 > 0 );
+
+	callstack_intern_destroy( table );
+	return 0;
+}
+
+#if defined( __unix__ )
+#include <pthread.h>
+
+static callstack_intern_t* thread_table = 0x0;
+static unsigned int        thread_ids[8][64];
+
+static void* intern_thread( void* arg )
+{
+	int t = (int)(size_t)arg;
+	for( int round = 0; round < 100; ++round )
+	{
+		for( int i = 0; i < 64; ++i )
+		{
+			void* stack[] = { (void*)0x1000, (void*)(size_t)( 0x2000 + i ), (void*)0x3000 };
+			thread_ids[t][i] = callstack_intern( thread_table, stack, 3 );
+		}
+	}
+	return 0x0;
+}
+
+int concurrent_intern()
+{
+	thread_table = callstack_intern_create( 1024, 1024 * 3 );
+
+	pthread_t threads[8];
+	for( int t = 0; t < 8; ++t )
+		pthread_create( &threads[t], 0x0, intern_thread, (void*)(size_t)t );
+	for( int t = 0; t < 8; ++t )
+		pthread_join( threads[t], 0x0 );
+
+	for( int t = 1; t < 8; ++t )
+		for( int i = 0; i < 64; ++i )
+			GREATEST_ASSERT_EQ( thread_ids[0][i], thread_ids[t][i] );
+
+	callstack_intern_destroy( thread_table );
+	return 0;
+}
+#endif
+
+GREATEST_SUITE(callstack_intern)
+{
+	RUN_TEST( same_stack_same_id );
+	RUN_TEST( lookup_returns_frames );
+	RUN_TEST( full_table );
+	RUN_TEST( symbols_are_cached );
+#if defined( __unix__ )
+	RUN_TEST( concurrent_intern );
+#endif
+}
+
+GREATEST_MAIN_DEFS();
+
+int main( int argc, char** argv )
+{
+	GREATEST_MAIN_BEGIN();
+	RUN_SUITE( callstack_intern );
+	GREATEST_MAIN_END();
+}
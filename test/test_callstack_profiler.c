@@ -0,0 +1,327 @@
+/*
+	dbgtools - platform independent wrapping of "nice to have" debug functions.
+
+	https://github.com/wc-duck/dbgtools
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+#include <dbgtools/callstack_profiler.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( __linux )
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static double cpu_time_ms( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts );
+	return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static volatile unsigned int sink = 0;
+
+void __attribute__((noinline)) burn_main( double ms );
+void __attribute__((noinline)) burn_worker( double ms );
+void __attribute__((noinline)) touch_pages( volatile char* pages, int num_pages );
+void __attribute__((noinline)) sleepy( void );
+void __attribute__((noinline)) sleepy_outer( int times );
+
+/* ... the check of the time is done in the loop itself so that the burn-function is always the leaf ... */
+void __attribute__((noinline)) burn_main( double ms )
+{
+	double end = cpu_time_ms() + ms;
+	while( cpu_time_ms() < end )
+	{
+		unsigned int i;
+		for( i = 0; i < 100000; ++i )
+			sink += i;
+	}
+}
+
+void __attribute__((noinline)) burn_worker( double ms )
+{
+	double end = cpu_time_ms() + ms;
+	while( cpu_time_ms() < end )
+	{
+		unsigned int i;
+		for( i = 0; i < 100000; ++i )
+			sink ^= i;
+	}
+}
+
+void __attribute__((noinline)) touch_pages( volatile char* pages, int num_pages )
+{
+	int i;
+	for( i = 0; i < num_pages; ++i )
+		pages[i * 4096] = 1;
+}
+
+/* ... libc might not keep frame-pointers in usleep(), so the caller of sleepy() is the frame that is always found ... */
+void __attribute__((noinline)) sleepy( void ) { usleep( 1000 ); __asm__ volatile( "" ); }
+void __attribute__((noinline)) sleepy_outer( int times ) { int i; for( i = 0; i < times; ++i ) sleepy(); __asm__ volatile( "" ); }
+
+static void* worker( void* arg )
+{
+	callstack_profiler_t* profiler = (callstack_profiler_t*)arg;
+	if( callstack_profiler_thread_start( profiler, 500 ) != 0 )
+		return (void*)1;
+	burn_worker( 200.0 );
+	callstack_profiler_thread_stop( profiler );
+	return 0x0;
+}
+
+typedef struct
+{
+	callstack_symbolizer_t* symbolizer;
+	const char*             func[2];
+	unsigned long long      total;
+	unsigned long long      in_func[2]; ///< samples with func[i] in the callstack.
+} count_ctx_t;
+
+static int count_stack( void** addresses, int num_addresses, unsigned long long count, void* userdata )
+{
+	count_ctx_t* ctx = (count_ctx_t*)userdata;
+	callstack_symbol_t syms[128];
+	char buffer[16 * 1024];
+	int found[2] = { 0, 0 };
+	int i, j;
+	int num_syms = callstack_symbolizer_symbolize( ctx->symbolizer, addresses, syms, num_addresses < 128 ? num_addresses : 128, buffer, sizeof(buffer) );
+	for( i = 0; i < num_syms; ++i )
+		for( j = 0; j < 2; ++j )
+			found[j] |= ctx->func[j] && strcmp( syms[i].function, ctx->func[j] ) == 0;
+
+	ctx->total += count;
+	for( j = 0; j < 2; ++j )
+		ctx->in_func[j] += found[j] ? count : 0;
+	return 0;
+}
+
+/* ... write and read back the profile, counting samples in func0 and func1 ... */
+static int check_profile( callstack_profiler_t* profiler, count_ctx_t* ctx )
+{
+	callstack_profiler_flush( profiler );
+
+	callstack_profiler_stats_t stats;
+	callstack_profiler_stats( profiler, &stats );
+	printf( "%llu samples, %llu dropped, %u stacks\n", stats.samples, stats.dropped_samples, stats.num_stacks );
+
+	int size = callstack_profiler_write( profiler, 0x0, 0 );
+	char* profile = (char*)malloc( size > 0 ? (size_t)size : 1 );
+	if( size <= 0 || callstack_profiler_write( profiler, profile, size ) != size )
+	{
+		printf( "callstack_profiler_write() failed\n" );
+		free( profile );
+		return 1;
+	}
+
+	int errors = 0;
+	int dump_size;
+	const void* dump = callstack_profile_dump( profile, size, &dump_size );
+	ctx->symbolizer = dump ? callstack_symbolizer_create_from_dump( dump, dump_size, 0x0 ) : 0x0;
+	if( ctx->symbolizer == 0x0 || callstack_profile_read( profile, size, count_stack, ctx ) != (int)stats.num_stacks || ctx->total != stats.samples )
+	{
+		printf( "failed to read back profile\n" );
+		++errors;
+	}
+	if( callstack_profile_read( profile, size - 1, 0x0, 0x0 ) != -1 )
+	{
+		printf( "truncated profile was not detected\n" );
+		++errors;
+	}
+	callstack_symbolizer_destroy( ctx->symbolizer );
+	free( profile );
+	printf( "%llu samples in profile, %llu in %s, %llu in %s\n", ctx->total, ctx->in_func[0], ctx->func[0], ctx->in_func[1], ctx->func[1] ? ctx->func[1] : "-" );
+	return errors;
+}
+
+static int test_timer( void )
+{
+	char path[256];
+	snprintf( path, sizeof(path), "/tmp/test_callstack_profiler.%d.csp", (int)getpid() );
+
+	callstack_profiler_config_t config;
+	memset( &config, 0x0, sizeof(config) );
+	config.frequency   = 1000;
+	config.output_path = path;
+
+	callstack_profiler_t* profiler = callstack_profiler_create( &config );
+	if( profiler == 0x0 )
+	{
+		printf( "callstack_profiler_create() failed\n" );
+		return 1;
+	}
+
+	if( callstack_profiler_thread_start( profiler, 0 ) != 0 || callstack_profiler_thread_start( profiler, 0 ) != -1 )
+	{
+		printf( "callstack_profiler_thread_start() should succeed once per thread\n" );
+		return 1;
+	}
+
+	pthread_t thread;
+	pthread_create( &thread, 0x0, worker, profiler );
+	burn_main( 300.0 );
+	void* worker_res;
+	pthread_join( thread, &worker_res );
+
+	if( callstack_profiler_thread_stop( profiler ) != 0 || callstack_profiler_thread_stop( profiler ) != -1 || worker_res != 0x0 )
+	{
+		printf( "failed to start or stop profiling of threads\n" );
+		return 1;
+	}
+
+	count_ctx_t ctx;
+	memset( &ctx, 0x0, sizeof(ctx) );
+	ctx.func[0] = "burn_main";
+	ctx.func[1] = "burn_worker";
+	int errors = check_profile( profiler, &ctx );
+
+	/* ... 300ms at 1000Hz and 200ms at 500Hz, but capped by the tick-rate of the kernel that might be as low as 100Hz ... */
+	if( ctx.in_func[0] < 15 || ctx.in_func[1] < 10 )
+		++errors;
+
+	/* ... profile should be written to output_path when destroyed ... */
+	callstack_profiler_destroy( profiler );
+	FILE* f = fopen( path, "rb" );
+	if( f == 0x0 )
+	{
+		printf( "profile was not written to %s\n", path );
+		++errors;
+	}
+	else
+	{
+		fclose( f );
+		unlink( path );
+	}
+	return errors;
+}
+
+/* ... sample event while running work, min_samples are expected to have func in the callstack ... */
+static int test_perf_event( const char* name, enum callstack_profiler_event event, unsigned int frequency, void (*work)( void ), const char* func, unsigned long long min_samples )
+{
+	printf( "%s:\n", name );
+	callstack_profiler_config_t config;
+	memset( &config, 0x0, sizeof(config) );
+	config.event     = event;
+	config.frequency = frequency;
+
+	callstack_profiler_t* profiler = callstack_profiler_create( &config );
+	if( profiler == 0x0 )
+	{
+		printf( "callstack_profiler_create() failed\n" );
+		return 1;
+	}
+
+	if( callstack_profiler_thread_start( profiler, 0 ) != 0 )
+	{
+		/* ... perf_event_open() is often not allowed in containers or by perf_event_paranoid ... */
+		printf( "perf-event not available, skipping\n" );
+		callstack_profiler_destroy( profiler );
+		return 0;
+	}
+	work();
+	callstack_profiler_thread_stop( profiler );
+
+	count_ctx_t ctx;
+	memset( &ctx, 0x0, sizeof(ctx) );
+	ctx.func[0] = func;
+	int errors = check_profile( profiler, &ctx );
+	if( ctx.in_func[0] < min_samples )
+	{
+		printf( "expected at least %llu samples in %s\n", min_samples, func );
+		++errors;
+	}
+	callstack_profiler_destroy( profiler );
+	return errors;
+}
+
+static void burn_200ms( void ) { burn_main( 200.0 ); }
+static void sleep_50( void ) { sleepy_outer( 50 ); }
+static void touch_256( void )
+{
+	void* pages = mmap( 0x0, 256 * 4096, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+	touch_pages( (volatile char*)pages, 256 );
+	munmap( pages, 256 * 4096 );
+}
+
+/* ... destroying a profiler while a thread is still profiled should neither crash on a late SIGPROF nor break the next profiler ... */
+static int test_destroy_active( void )
+{
+	callstack_profiler_config_t config;
+	memset( &config, 0x0, sizeof(config) );
+	config.frequency = 1000;
+
+	int round;
+	for( round = 0; round < 2; ++round )
+	{
+		callstack_profiler_t* profiler = callstack_profiler_create( &config );
+		if( profiler == 0x0 || callstack_profiler_thread_start( profiler, 0 ) != 0 )
+		{
+			printf( "failed to start profiling\n" );
+			return 1;
+		}
+		burn_main( 20.0 );
+		if( round == 0 )
+			callstack_profiler_destroy( profiler );
+		else
+		{
+			callstack_profiler_thread_stop( profiler );
+			callstack_profiler_destroy( profiler );
+		}
+		burn_main( 20.0 );
+	}
+	return 0;
+}
+
+int main( int argc, const char** argv )
+{
+	(void)argc; (void)argv;
+
+	int errors = 0;
+	errors += test_timer();
+	errors += test_destroy_active();
+	/* ... perf clocks are not limited by the tick-rate, 200ms at 1000Hz ... */
+	errors += test_perf_event( "task-clock",       CALLSTACK_PROFILER_EVENT_TASK_CLOCK,       1000, burn_200ms, "burn_main",    50 );
+	errors += test_perf_event( "cpu-clock",        CALLSTACK_PROFILER_EVENT_CPU_CLOCK,        1000, burn_200ms, "burn_main",    50 );
+	errors += test_perf_event( "page-faults",      CALLSTACK_PROFILER_EVENT_PAGE_FAULTS,      1,    touch_256,  "touch_pages",  128 );
+	errors += test_perf_event( "context-switches", CALLSTACK_PROFILER_EVENT_CONTEXT_SWITCHES, 1,    sleep_50,   "sleepy_outer", 25 );
+	return errors == 0 ? 0 : 1;
+}
+
+#else
+
+int main( int argc, const char** argv )
+{
+	(void)argc; (void)argv;
+	printf( "callstack_profiler is only implemented on linux\n" );
+	return 0;
+}
+
+#endif
@@ -0,0 +1,173 @@
+/*
+	dbgtools - platform independent wrapping of "nice to have" debug functions.
+
+	https://github.com/wc-duck/dbgtools
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+
+#include <dbgtools/callstack.h>
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "callstack_test_capture.h"
+
+static int compare_syms( const char* what, callstack_symbol_t* expect, callstack_symbol_t* syms, int num_syms )
+{
+	int i;
+	int errors = 0;
+	for( i = 0; i < num_syms; ++i )
+	{
+		if( strcmp( expect[i].function, syms[i].function ) != 0 || strcmp( expect[i].file, syms[i].file ) != 0 || expect[i].line != syms[i].line || expect[i].inlined != syms[i].inlined )
+		{
+			printf( "%s %3d) %s %s(%u) symbolized as %s %s(%u)\n", what, i, expect[i].function, expect[i].file, expect[i].line, syms[i].function, syms[i].file, syms[i].line );
+			++errors;
+		}
+	}
+	return errors;
+}
+
+int main( int argc, const char** argv )
+{
+	(void)argc; (void)argv;
+
+	char socket_path[64];
+	snprintf( socket_path, sizeof(socket_path), "/tmp/test_callstack_server.%d", (int)getpid() );
+
+	callstack_symbol_server_t* server = callstack_symbol_server_create( socket_path );
+	if( server == 0x0 )
+	{
+		printf( "callstack_symbol_server_create() not supported\n" );
+		return 0;
+	}
+
+	// ... serve from another process, as it would be used ...
+	pid_t child = fork();
+	if( child == 0 )
+	{
+		while( callstack_symbol_server_update( server, 100 ) >= 0 )
+			;
+		_exit( 1 );
+	}
+
+	capture_stack( 4 );
+
+	callstack_symbolizer_t* live = callstack_symbolizer_create();
+	callstack_symbol_t expect[256];
+	callstack_symbol_t expect_inl[512];
+	callstack_symbol_t syms[512];
+	char memory[64 * 1024];
+	char live_memory[64 * 1024];
+	int  num_expect     = callstack_symbolizer_symbolize( live, stacks, expect, num_frames[0], live_memory, (int)sizeof(live_memory) );
+	int  num_expect_inl = callstack_symbolizer_symbolize_inlined( live, stacks, expect_inl, num_frames[0], 512, live_memory + sizeof(live_memory) / 2, (int)sizeof(live_memory) / 2 );
+
+	int errors = 0;
+	if( callstack_symbols_set_server( socket_path ) != 0 )
+	{
+		printf( "callstack_symbols_set_server() failed\n" );
+		++errors;
+	}
+
+	// ... strings from the server need memory ...
+	int num_syms = 0;
+	int mem_size = callstack_symbols_mem_size( stacks, num_frames[0], 0, &num_syms );
+	if( mem_size <= 0 || mem_size > (int)sizeof(memory) || num_syms != num_frames[0] )
+	{
+		printf( "callstack_symbols_mem_size() returned %d bytes for %d symbols\n", mem_size, num_syms );
+		++errors;
+	}
+
+	// ... twice to also use the already loaded modules in the server ...
+	int i;
+	for( i = 0; i < 2; ++i )
+	{
+		num_syms = callstack_symbols( stacks, syms, num_frames[0], memory, mem_size );
+		if( num_syms != num_expect )
+		{
+			printf( "callstack_symbols() returned %d symbols, expected %d\n", num_syms, num_expect );
+			++errors;
+		}
+		errors += compare_syms( "server", expect, syms, num_syms < num_expect ? num_syms : num_expect );
+	}
+
+	num_syms = callstack_symbols_inlined( stacks, syms, num_frames[0], 512, memory, (int)sizeof(memory) );
+	if( num_syms != num_expect_inl )
+	{
+		printf( "callstack_symbols_inlined() returned %d symbols, expected %d\n", num_syms, num_expect_inl );
+		++errors;
+	}
+	errors += compare_syms( "server inlined", expect_inl, syms, num_syms < num_expect_inl ? num_syms : num_expect_inl );
+
+	// ... a client stalling half-way through a request should not hold up others, they would time out and fall back to symbolizing locally ...
+	int staller = socket( AF_UNIX, SOCK_STREAM, 0 );
+	union { struct sockaddr sa; struct sockaddr_un un; } addr;
+	memset( &addr, 0x0, sizeof(addr) );
+	addr.un.sun_family = AF_UNIX;
+	strcpy( addr.un.sun_path, socket_path );
+	if( staller < 0 || connect( staller, &addr.sa, sizeof(addr.un) ) != 0 || send( staller, "CSRQ", 4, 0 ) != 4 )
+	{
+		printf( "failed to connect stalling client\n" );
+		++errors;
+	}
+	usleep( 200 * 1000 ); // ... let the server accept it and start reading the request ...
+
+	struct timespec start, end;
+	clock_gettime( CLOCK_MONOTONIC, &start );
+	num_syms = callstack_symbols( stacks, syms, num_frames[0], memory, mem_size );
+	clock_gettime( CLOCK_MONOTONIC, &end );
+	long elapsed_ms = ( end.tv_sec - start.tv_sec ) * 1000 + ( end.tv_nsec - start.tv_nsec ) / 1000000;
+	if( num_syms != num_expect || elapsed_ms > 500 )
+	{
+		printf( "callstack_symbols() with a stalling client returned %d symbols in %ld ms, expected %d\n", num_syms, elapsed_ms, num_expect );
+		++errors;
+	}
+	errors += compare_syms( "server stalled", expect, syms, num_syms < num_expect ? num_syms : num_expect );
+	if( staller >= 0 )
+		close( staller );
+
+	// ... with the server gone symbolization should fall back to the current process ...
+	kill( child, SIGKILL );
+	waitpid( child, 0x0, 0 );
+	callstack_symbol_server_destroy( server );
+
+	num_syms = callstack_symbols( stacks, syms, num_frames[0], memory, (int)sizeof(memory) );
+	if( num_syms != num_expect )
+	{
+		printf( "callstack_symbols() returned %d symbols after server was gone, expected %d\n", num_syms, num_expect );
+		++errors;
+	}
+	errors += compare_syms( "fallback", expect, syms, num_syms < num_expect ? num_syms : num_expect );
+
+	callstack_symbols_set_server( 0x0 );
+	callstack_symbolizer_destroy( live );
+	return errors == 0 ? 0 : 1;
+}
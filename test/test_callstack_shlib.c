@@ -0,0 +1,114 @@
+/*
+	Test-program for symbolizing frames in shared libraries loaded after the first call to callstack_symbols().
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+#include <dbgtools/callstack.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined( __linux )
+
+#include <dlfcn.h>
+#include <unistd.h>
+
+typedef int (*callstack_shlib_capture_func)( int skip_frames, void** addresses, int num_addresses );
+typedef int (*callstack_shlib_capture_t)( callstack_shlib_capture_func capture, void** addresses, int num_addresses );
+
+static void*              addresses[64];
+static callstack_symbol_t symbols[64];
+static char               symbols_buffer[4096];
+
+static int print_and_find( int num_addresses, const char* function, const char* file )
+{
+	int i, found = 0;
+	int num_symbols = callstack_symbols( addresses, symbols, num_addresses, symbols_buffer, sizeof(symbols_buffer) );
+	for( i = 0; i < num_symbols; ++i )
+	{
+		printf( "%3d) %-50s %s(%u)\n", i, symbols[i].function, symbols[i].file, symbols[i].line );
+		if( strcmp( symbols[i].function, function ) == 0 && strstr( symbols[i].file, file ) != 0x0 )
+			found = 1;
+	}
+	return found;
+}
+
+int main( int argc, const char** argv )
+{
+	char path[4096];
+	size_t dir_len;
+	ssize_t len;
+	void* lib;
+	callstack_shlib_capture_t capture;
+	int num_addresses;
+	int res = 0;
+
+	/* ... library is expected next to the executable if not passed on the command-line ... */
+	if( argc > 1 )
+		snprintf( path, sizeof(path), "%s", argv[1] );
+	else
+	{
+		len = readlink( "/proc/self/exe", path, sizeof(path) - 1 );
+		path[len > 0 ? len : 0] = '\0';
+		dir_len = strrchr( path, '/' ) ? (size_t)( strrchr( path, '/' ) - path + 1 ) : 0;
+		snprintf( path + dir_len, sizeof(path) - dir_len, "libcallstack_shlib.so" );
+	}
+
+	/* ... symbolize once before the library is loaded to test that the module-table is refreshed ... */
+	num_addresses = callstack( 0, addresses, 64 );
+	if( !print_and_find( num_addresses, "main", "test_callstack_shlib.c" ) )
+	{
+		printf( "failed to symbolize main!\n" );
+		res = 1;
+	}
+
+	lib = dlopen( path, RTLD_NOW );
+	if( lib == 0x0 )
+	{
+		printf( "failed to load %s: %s\n", path, dlerror() );
+		return 1;
+	}
+
+	capture = (callstack_shlib_capture_t)dlsym( lib, "callstack_shlib_capture" );
+	num_addresses = capture( callstack, addresses, 64 );
+	printf( "\n" );
+	if( !print_and_find( num_addresses, "callstack_shlib_capture", "callstack_shlib.c" ) )
+	{
+		printf( "failed to symbolize frame in shared library!\n" );
+		res = 1;
+	}
+
+	dlclose( lib );
+	return res;
+}
+
+#else
+
+int main( int argc, const char** argv )
+{
+	(void)argc; (void)argv;
+	return 0;
+}
+
+#endif
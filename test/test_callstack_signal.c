@@ -0,0 +1,113 @@
+/*
+	Test-program for async-signal-safe callstack_from_context() and callstack_symbolizer_symbolize_signal_safe() from dbgtools.
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+#include <dbgtools/callstack.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined( __linux )
+
+#include <signal.h>
+#include <unistd.h>
+
+static callstack_symbolizer_t* symbolizer = 0x0;
+
+static void*              addresses[64];
+static int                num_addresses = 0;
+static callstack_symbol_t symbols[64];
+static char               symbols_buffer[4096];
+static int                num_symbols = 0;
+
+static void write_str( const char* str )
+{
+	ssize_t res = write( 1, str, strlen( str ) );
+	(void)res;
+}
+
+static void signal_handler( int sig, siginfo_t* info, void* context )
+{
+	int i;
+	(void)sig; (void)info;
+
+	/* ... only async-signal-safe functions in here ... */
+	num_addresses = callstack_from_context( context, addresses, 64 );
+	num_symbols   = callstack_symbolizer_symbolize_signal_safe( symbolizer, addresses, symbols, num_addresses, symbols_buffer, sizeof(symbols_buffer) );
+
+	for( i = 0; i < num_symbols; ++i )
+	{
+		write_str( "  " );
+		write_str( symbols[i].function );
+		write_str( "\n" );
+	}
+}
+
+void __attribute__((noinline)) func3( void ) { raise( SIGUSR1 ); __asm__ volatile( "" ); }
+void __attribute__((noinline)) func2( void ) { func3(); __asm__ volatile( "" ); }
+void __attribute__((noinline)) func1( void ) { func2(); __asm__ volatile( "" ); }
+
+static int has_function( const char* name )
+{
+	int i;
+	for( i = 0; i < num_symbols; ++i )
+		if( strcmp( symbols[i].function, name ) == 0 )
+			return 1;
+	return 0;
+}
+
+int main( int argc, const char** argv )
+{
+	struct sigaction sa;
+	(void)argc; (void)argv;
+
+	symbolizer = callstack_symbolizer_create();
+
+	memset( &sa, 0x0, sizeof(sa) );
+	sa.sa_sigaction = signal_handler;
+	sa.sa_flags     = SA_SIGINFO;
+	sigaction( SIGUSR1, &sa, 0x0 );
+
+	func1();
+
+	callstack_symbolizer_destroy( symbolizer );
+
+	if( !has_function( "func2" ) || !has_function( "func1" ) || !has_function( "main" ) )
+	{
+		printf( "failed to unwind from signal context!\n" );
+		return 1;
+	}
+	return 0;
+}
+
+#else
+
+int main( int argc, const char** argv )
+{
+	(void)argc; (void)argv;
+	return 0;
+}
+
+#endif
@@ -0,0 +1,54 @@
+/*
+	dbgtools - platform independent wrapping of "nice to have" debug functions.
+
+	https://github.com/wc-duck/dbgtools
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+/**
+ * Write the precomputed symbol-index of an executable or shared library, see callstack_index_write().
+ *
+ * usage: callstack_index <module> [<index>]
+ */
+
+#include <dbgtools/callstack.h>
+
+#include <stdio.h>
+
+int main( int argc, const char** argv )
+{
+	if( argc < 2 || argc > 3 || argv[1][0] == '-' )
+	{
+		fprintf( stderr, "usage: callstack_index <module> [<index>]\n"
+						 "  writes the symbol-index of module to index, <module>.csidx by default.\n" );
+		return 1;
+	}
+
+	if( callstack_index_write( argv[1], argc == 3 ? argv[2] : 0x0 ) != 0 )
+	{
+		fprintf( stderr, "failed to write symbol-index for %s, it needs to exist and have a build-id\n", argv[1] );
+		return 1;
+	}
+	return 0;
+}
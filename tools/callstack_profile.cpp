@@ -0,0 +1,355 @@
+/*
+	dbgtools - platform independent wrapping of "nice to have" debug functions.
+
+	https://github.com/wc-duck/dbgtools
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+/**
+ * Converts profiles written by callstack_profiler_write() to folded stacks or pprof and diffs two profiles,
+ * for example from two releases, by the share of samples in each function.
+ *
+ * usage: callstack_profile [options] folded <profile> [<out>]
+ *        callstack_profile [options] pprof <profile> <out>
+ *        callstack_profile [options] diff <base-profile> <new-profile>
+ */
+
+#include <dbgtools/callstack.h>
+#include <dbgtools/callstack_export.h>
+#include <dbgtools/callstack_profiler.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef struct
+{
+	char*                    data;
+	int                      size;
+	callstack_profile_info_t info;
+	callstack_symbolizer_t*  symbolizer;
+	callstack_export_t*      exp;
+} loaded_profile_t;
+
+static char* read_file( const char* path, int* size )
+{
+	FILE* f = fopen( path, "rb" );
+	if( f == 0x0 )
+		return 0x0;
+
+	char* data = 0x0;
+	long  len  = fseek( f, 0, SEEK_END ) == 0 ? ftell( f ) : -1;
+	if( len >= 0 && len < 0x7fffffff && fseek( f, 0, SEEK_SET ) == 0 )
+	{
+		data = (char*)malloc( (size_t)len + 1 );
+		if( data && fread( data, 1, (size_t)len, f ) != (size_t)len )
+		{
+			free( data );
+			data = 0x0;
+		}
+		*size = (int)len;
+	}
+	fclose( f );
+	return data;
+}
+
+static int count_frames( void**, int num_addresses, unsigned long long, void* userdata )
+{
+	*(unsigned long long*)userdata += (unsigned long long)num_addresses;
+	return 0;
+}
+
+static int add_stack( void** addresses, int num_addresses, unsigned long long count, void* userdata )
+{
+	return callstack_export_add( (callstack_export_t*)userdata, addresses, num_addresses, count );
+}
+
+static void unload_profile( loaded_profile_t* p )
+{
+	callstack_export_destroy( p->exp );
+	callstack_symbolizer_destroy( p->symbolizer );
+	free( p->data );
+}
+
+static int load_profile( const char* path, const char* sysroot, int short_names, loaded_profile_t* p )
+{
+	memset( p, 0x0, sizeof(loaded_profile_t) );
+	p->data = read_file( path, &p->size );
+	if( p->data == 0x0 )
+	{
+		fprintf( stderr, "failed to read %s\n", path );
+		return -1;
+	}
+
+	unsigned long long num_frames = 0;
+	int dump_size = 0;
+	const void* dump = callstack_profile_dump( p->data, p->size, &dump_size );
+	if( dump == 0x0 ||
+		callstack_profile_info( p->data, p->size, &p->info ) != 0 ||
+		callstack_profile_read( p->data, p->size, count_frames, &num_frames ) != (int)p->info.num_stacks ||
+		num_frames > 0xffffffff )
+	{
+		fprintf( stderr, "%s is not a valid profile\n", path );
+		return -1;
+	}
+
+	p->symbolizer = callstack_symbolizer_create_from_dump( dump, dump_size, sysroot );
+	p->exp        = callstack_export_create( p->symbolizer, p->info.num_stacks > 0 ? p->info.num_stacks : 1, (unsigned int)num_frames );
+	if( p->symbolizer == 0x0 || p->exp == 0x0 || callstack_profile_read( p->data, p->size, add_stack, p->exp ) != (int)p->info.num_stacks )
+	{
+		fprintf( stderr, "failed to load %s\n", path );
+		return -1;
+	}
+	if( short_names )
+		callstack_symbolizer_set_demangle( p->symbolizer, CALLSTACK_DEMANGLE_SHORT );
+	return 0;
+}
+
+static const char* event_name( enum callstack_profiler_event event )
+{
+	switch( event )
+	{
+		case CALLSTACK_PROFILER_EVENT_TIMER:            return "samples";
+		case CALLSTACK_PROFILER_EVENT_CPU_CLOCK:        return "cpu-clock";
+		case CALLSTACK_PROFILER_EVENT_TASK_CLOCK:       return "task-clock";
+		case CALLSTACK_PROFILER_EVENT_PAGE_FAULTS:      return "page-faults";
+		case CALLSTACK_PROFILER_EVENT_CONTEXT_SWITCHES: return "context-switches";
+	}
+	return "samples";
+}
+
+static int write_file( const void* data, size_t size, void* userdata )
+{
+	return fwrite( data, 1, size, (FILE*)userdata ) == size ? 0 : -1;
+}
+
+typedef struct
+{
+	unsigned long long weight[2];
+} diff_weights_t;
+
+typedef struct
+{
+	std::unordered_map<std::string, diff_weights_t>* stacks;
+	int                                              side;
+} diff_ctx_t;
+
+static int diff_add_stack( const char* stack, unsigned long long weight, void* userdata )
+{
+	diff_ctx_t* ctx = (diff_ctx_t*)userdata;
+
+	// ... frames that could not be symbolized are named by address, that differ between runs, so they are all merged ...
+	std::string folded;
+	while( *stack )
+	{
+		size_t len = strcspn( stack, ";" );
+		if( len > 2 && stack[0] == '0' && stack[1] == 'x' && strspn( stack + 2, "0123456789abcdef" ) == len - 2 )
+			folded += "[unknown]";
+		else
+			folded.append( stack, len );
+		stack += len;
+		if( *stack == ';' )
+			folded += *stack++;
+	}
+
+	diff_weights_t& w = ( *ctx->stacks )[folded];
+	w.weight[ctx->side] += weight;
+	return 0;
+}
+
+typedef struct
+{
+	std::string        name;
+	unsigned long long total[2]; ///< samples with the function anywhere in the callstack.
+	unsigned long long self[2];  ///< samples with the function as the leaf.
+} diff_function_t;
+
+static double share( unsigned long long weight, unsigned long long total )
+{
+	return total > 0 ? 100.0 * (double)weight / (double)total : 0.0;
+}
+
+static int diff_profiles( loaded_profile_t* profiles, unsigned int flags, int folded, size_t top )
+{
+	std::unordered_map<std::string, diff_weights_t> stacks;
+	for( int side = 0; side < 2; ++side )
+	{
+		diff_ctx_t ctx = { &stacks, side };
+		if( callstack_export_folded_foreach( profiles[side].exp, flags, diff_add_stack, &ctx ) < 0 )
+			return 1;
+	}
+
+	// ... the format read by flamegraph.pl to draw a differential flame-graph ...
+	if( folded )
+	{
+		for( auto& s : stacks )
+			printf( "%s %llu %llu\n", s.first.c_str(), s.second.weight[0], s.second.weight[1] );
+		return 0;
+	}
+
+	std::unordered_map<std::string, diff_function_t> functions;
+	std::vector<std::string> seen;
+	for( auto& s : stacks )
+	{
+		seen.clear();
+		const char* frame = s.first.c_str();
+		while( *frame )
+		{
+			const char* end = strchr( frame, ';' );
+			std::string name( frame, end ? (size_t)( end - frame ) : strlen( frame ) );
+			frame = end ? end + 1 : frame + name.size();
+
+			diff_function_t& fn = functions[name];
+			fn.name = name;
+			if( *frame == '\0' )
+			{
+				fn.self[0] += s.second.weight[0];
+				fn.self[1] += s.second.weight[1];
+			}
+			// ... recursive functions should only count once per callstack ...
+			if( std::find( seen.begin(), seen.end(), name ) != seen.end() )
+				continue;
+			seen.push_back( name );
+			fn.total[0] += s.second.weight[0];
+			fn.total[1] += s.second.weight[1];
+		}
+	}
+
+	unsigned long long totals[2] = { callstack_export_total( profiles[0].exp ), callstack_export_total( profiles[1].exp ) };
+	std::vector<diff_function_t> sorted;
+	for( auto& f : functions )
+		sorted.push_back( f.second );
+	std::sort( sorted.begin(), sorted.end(), [&]( const diff_function_t& a, const diff_function_t& b ) {
+		double da = share( a.total[1], totals[1] ) - share( a.total[0], totals[0] );
+		double db = share( b.total[1], totals[1] ) - share( b.total[0], totals[0] );
+		da = da < 0.0 ? -da : da;
+		db = db < 0.0 ? -db : db;
+		return da != db ? da > db : a.name < b.name;
+	} );
+
+	printf( "base: %llu %s, %llu dropped\n", profiles[0].info.samples, event_name( profiles[0].info.event ), profiles[0].info.dropped_samples );
+	printf( "new:  %llu %s, %llu dropped\n", profiles[1].info.samples, event_name( profiles[1].info.event ), profiles[1].info.dropped_samples );
+	if( profiles[0].info.event != profiles[1].info.event )
+		printf( "warning: the profiles sampled different events\n" );
+	printf( "\n%10s %10s %10s %10s %10s %10s  %s\n", "total-base", "total-new", "delta", "self-base", "self-new", "delta", "function" );
+	for( size_t i = 0; i < sorted.size() && i < top; ++i )
+	{
+		const diff_function_t& fn = sorted[i];
+		double total_base = share( fn.total[0], totals[0] ), total_new = share( fn.total[1], totals[1] );
+		double self_base  = share( fn.self[0], totals[0] ),  self_new  = share( fn.self[1], totals[1] );
+		printf( "%9.2f%% %9.2f%% %+9.2f%% %9.2f%% %9.2f%% %+9.2f%%  %s\n", total_base, total_new, total_new - total_base, self_base, self_new, self_new - self_base, fn.name.c_str() );
+	}
+	return 0;
+}
+
+static int usage()
+{
+	fprintf( stderr, "usage: callstack_profile [options] folded <profile> [<out>]\n"
+					 "       callstack_profile [options] pprof <profile> <out>\n"
+					 "       callstack_profile [options] diff <base-profile> <new-profile>\n"
+					 "  --inlined   expand inlined functions.\n"
+					 "  --short     drop template-arguments from C++ names.\n"
+					 "  --sysroot   directory to find the modules of the profiles in, the recorded paths are used as is by default.\n"
+					 "  --top <n>   number of functions printed by diff, sorted by the change of their share of the samples, default 30.\n"
+					 "  --folded    diff prints each folded stack followed by its samples in both profiles, as read by flamegraph.pl.\n" );
+	return 1;
+}
+
+int main( int argc, const char** argv )
+{
+	const char*  sysroot     = 0x0;
+	const char*  args[3]     = { 0x0, 0x0, 0x0 };
+	int          num_args    = 0;
+	int          short_names = 0;
+	int          folded      = 0;
+	size_t       top         = 30;
+	unsigned int flags       = 0;
+	for( int i = 1; i < argc; ++i )
+	{
+		if( strcmp( argv[i], "--inlined" ) == 0 )
+			flags |= CALLSTACK_SYMBOLS_INLINED;
+		else if( strcmp( argv[i], "--short" ) == 0 )
+			short_names = 1;
+		else if( strcmp( argv[i], "--folded" ) == 0 )
+			folded = 1;
+		else if( strcmp( argv[i], "--sysroot" ) == 0 && i + 1 < argc )
+			sysroot = argv[++i];
+		else if( strcmp( argv[i], "--top" ) == 0 && i + 1 < argc )
+			top = (size_t)strtoul( argv[++i], 0x0, 10 );
+		else if( argv[i][0] != '-' && num_args < 3 )
+			args[num_args++] = argv[i];
+		else
+			return usage();
+	}
+	if( num_args < 2 )
+		return usage();
+
+	const char* cmd = args[0];
+	if( strcmp( cmd, "diff" ) == 0 && num_args == 3 )
+	{
+		loaded_profile_t profiles[2];
+		memset( profiles, 0x0, sizeof(profiles) );
+		int res = 1;
+		if( load_profile( args[1], sysroot, short_names, &profiles[0] ) == 0 && load_profile( args[2], sysroot, short_names, &profiles[1] ) == 0 )
+			res = diff_profiles( profiles, flags, folded, top );
+		unload_profile( &profiles[0] );
+		unload_profile( &profiles[1] );
+		return res;
+	}
+
+	int is_pprof = strcmp( cmd, "pprof" ) == 0;
+	if( ( !is_pprof && strcmp( cmd, "folded" ) != 0 ) || ( is_pprof && num_args != 3 ) )
+		return usage();
+
+	loaded_profile_t profile;
+	if( load_profile( args[1], sysroot, short_names, &profile ) != 0 )
+	{
+		unload_profile( &profile );
+		return 1;
+	}
+
+	FILE* out = num_args == 3 ? fopen( args[2], is_pprof ? "wb" : "w" ) : stdout;
+	int   res = 1;
+	if( out == 0x0 )
+		fprintf( stderr, "failed to open %s\n", args[2] );
+	else
+	{
+		if( is_pprof )
+			res = callstack_export_write_pprof( profile.exp, flags, event_name( profile.info.event ), "count", write_file, out );
+		else
+			res = callstack_export_write_folded( profile.exp, flags, write_file, out );
+		if( ( out != stdout && fclose( out ) != 0 ) || res != 0 )
+		{
+			fprintf( stderr, "failed to write %s\n", num_args == 3 ? args[2] : "stdout" );
+			res = 1;
+		}
+	}
+	unload_profile( &profile );
+	return res;
+}
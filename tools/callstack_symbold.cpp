@@ -0,0 +1,77 @@
+/*
+	dbgtools - platform independent wrapping of "nice to have" debug functions.
+
+	https://github.com/wc-duck/dbgtools
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+/**
+ * Symbol-server daemon, symbolizes callstacks for processes that has called callstack_symbols_set_server()
+ * with the same socket-path. Runs until interrupted.
+ *
+ * usage: callstack_symbold <socket-path>
+ */
+
+#include <dbgtools/callstack.h>
+
+#include <signal.h>
+#include <stdio.h>
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_signal( int )
+{
+	g_stop = 1;
+}
+
+int main( int argc, const char** argv )
+{
+	if( argc != 2 || argv[1][0] == '-' )
+	{
+		fprintf( stderr, "usage: callstack_symbold <socket-path>\n" );
+		return 1;
+	}
+
+	callstack_symbol_server_t* server = callstack_symbol_server_create( argv[1] );
+	if( server == 0x0 )
+	{
+		fprintf( stderr, "failed to listen on %s\n", argv[1] );
+		return 1;
+	}
+
+	signal( SIGINT,  on_signal );
+	signal( SIGTERM, on_signal );
+
+	int res = 0;
+	while( !g_stop && res >= 0 )
+		res = callstack_symbol_server_update( server, 500 );
+
+	callstack_symbol_server_destroy( server );
+	if( res < 0 )
+	{
+		fprintf( stderr, "symbol-server failed\n" );
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,198 @@
+/*
+	dbgtools - platform independent wrapping of "nice to have" debug functions.
+
+	https://github.com/wc-duck/dbgtools
+
+	version 0.1, october, 2013
+
+	Copyright (C) 2013- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+ */
+
+/**
+ * Offline symbolizer for dumps written by callstack_dump_write(), prints all callstacks in a dump as
+ * text or json.
+ *
+ * usage: callstack_symbolize [--json] [--inlined] [--short] [--sysroot <dir>] <dump>
+ */
+
+#include <dbgtools/callstack.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+	callstack_symbolizer_t* symbolizer;
+	unsigned int            flags;
+	int                     json;
+	int                     num_stacks;
+	int                     num_frames; ///< frames printed in current stack.
+} symbolize_ctx_t;
+
+static void print_json_string( const char* str )
+{
+	putchar( '"' );
+	for( const unsigned char* c = (const unsigned char*)str; *c; ++c )
+	{
+		switch( *c )
+		{
+			case '"':  fputs( "\\\"", stdout ); break;
+			case '\\': fputs( "\\\\", stdout ); break;
+			case '\n': fputs( "\\n", stdout ); break;
+			case '\t': fputs( "\\t", stdout ); break;
+			default:
+				if( *c < 0x20 )
+					printf( "\\u%04x", *c );
+				else
+					putchar( *c );
+				break;
+		}
+	}
+	putchar( '"' );
+}
+
+static int print_symbol( const callstack_symbol_t* sym, int index, void* userdata )
+{
+	symbolize_ctx_t* ctx = (symbolize_ctx_t*)userdata;
+	if( ctx->json )
+	{
+		printf( "%s\n    { \"frame\": %d, \"function\": ", ctx->num_frames == 0 ? "" : ",", index );
+		print_json_string( sym->function );
+		printf( ", \"file\": " );
+		print_json_string( sym->file );
+		printf( ", \"line\": %u, \"offset\": %u, \"inlined\": %s }", sym->line, sym->offset, sym->inlined ? "true" : "false" );
+	}
+	else
+		printf( "%3d) %-50s %s(%u)%s\n", index, sym->function, sym->file, sym->line, sym->inlined ? " [inlined]" : "" );
+	++ctx->num_frames;
+	return 0;
+}
+
+static int print_stack( void** addresses, int num_addresses, void* userdata )
+{
+	symbolize_ctx_t* ctx = (symbolize_ctx_t*)userdata;
+	if( ctx->json )
+		printf( "%s\n  [", ctx->num_stacks == 0 ? "" : "," );
+	else
+		printf( "%sstack %d:\n", ctx->num_stacks == 0 ? "" : "\n", ctx->num_stacks );
+
+	ctx->num_frames = 0;
+	callstack_symbolizer_symbolize_foreach( ctx->symbolizer, addresses, num_addresses, ctx->flags, print_symbol, ctx );
+
+	if( ctx->json )
+		printf( "\n  ]" );
+	++ctx->num_stacks;
+	return 0;
+}
+
+static char* read_file( const char* path, int* size )
+{
+	FILE* f = fopen( path, "rb" );
+	if( f == 0x0 )
+		return 0x0;
+
+	char* data = 0x0;
+	long  len  = fseek( f, 0, SEEK_END ) == 0 ? ftell( f ) : -1;
+	if( len >= 0 && len < 0x7fffffff && fseek( f, 0, SEEK_SET ) == 0 )
+	{
+		data = (char*)malloc( (size_t)len + 1 );
+		if( data && fread( data, 1, (size_t)len, f ) != (size_t)len )
+		{
+			free( data );
+			data = 0x0;
+		}
+		*size = (int)len;
+	}
+	fclose( f );
+	return data;
+}
+
+static int usage()
+{
+	fprintf( stderr, "usage: callstack_symbolize [--json] [--inlined] [--short] [--sysroot <dir>] <dump>\n"
+					 "  --json      print callstacks as a json-array of arrays of frames.\n"
+					 "  --inlined   expand inlined functions.\n"
+					 "  --short     drop template-arguments from C++ names.\n"
+					 "  --sysroot   directory to find the modules of the dump in, the recorded paths are used as is by default.\n" );
+	return 1;
+}
+
+int main( int argc, const char** argv )
+{
+	symbolize_ctx_t ctx;
+	memset( &ctx, 0x0, sizeof(ctx) );
+
+	const char* sysroot = 0x0;
+	const char* path    = 0x0;
+	int short_names = 0;
+	for( int i = 1; i < argc; ++i )
+	{
+		if( strcmp( argv[i], "--json" ) == 0 )
+			ctx.json = 1;
+		else if( strcmp( argv[i], "--inlined" ) == 0 )
+			ctx.flags |= CALLSTACK_SYMBOLS_INLINED;
+		else if( strcmp( argv[i], "--short" ) == 0 )
+			short_names = 1;
+		else if( strcmp( argv[i], "--sysroot" ) == 0 && i + 1 < argc )
+			sysroot = argv[++i];
+		else if( argv[i][0] != '-' && path == 0x0 )
+			path = argv[i];
+		else
+			return usage();
+	}
+	if( path == 0x0 )
+		return usage();
+
+	int   dump_size = 0;
+	char* dump      = read_file( path, &dump_size );
+	if( dump == 0x0 )
+	{
+		fprintf( stderr, "failed to read %s\n", path );
+		return 1;
+	}
+
+	ctx.symbolizer = callstack_symbolizer_create_from_dump( dump, dump_size, sysroot );
+	if( ctx.symbolizer == 0x0 )
+	{
+		fprintf( stderr, "%s is not a valid callstack-dump\n", path );
+		free( dump );
+		return 1;
+	}
+	if( short_names )
+		callstack_symbolizer_set_demangle( ctx.symbolizer, CALLSTACK_DEMANGLE_SHORT );
+
+	if( ctx.json )
+		printf( "[" );
+	int res = callstack_dump_read( dump, dump_size, print_stack, &ctx );
+	if( ctx.json )
+		printf( "\n]\n" );
+
+	callstack_symbolizer_destroy( ctx.symbolizer );
+	free( dump );
+
+	if( res < 0 )
+	{
+		fprintf( stderr, "%s is not a valid callstack-dump\n", path );
+		return 1;
+	}
+	return 0;
+}